@@ -0,0 +1,598 @@
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Linq;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Passes;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAACPUCullingTests
+    {
+        private const float MeshLODErrorThreshold = 1.0f;
+
+        [Test] [Category("AAAA RP")]
+        [TestCase(1u)]
+        [TestCase(2u)]
+        [TestCase(3u)]
+        public void BasicPass_MatchesScalarReference(uint seed)
+        {
+            using var scene = new AAAACullingTestScene(2048, 2);
+            var random = new Random(seed);
+            scene.Randomize(ref random, 200.0f);
+            scene.SetView(0, new float3(0, 0, -20), quaternion.identity, AAAAInstancePassMask.Main);
+            scene.SetView(1, new float3(100, 50, 100), quaternion.LookRotation(math.normalize(new float3(-1, -0.5f, -1)), math.up()),
+                AAAAInstancePassMask.Shadows
+            );
+
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(scene.ToInputs(), settings);
+
+            List<ReferenceRequest> expected = ReferenceCulling.Run(scene, settings);
+            Assert.IsNotEmpty(expected, "The test scene is expected to have visible meshlets.");
+
+            for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    AAAACPUCullingPipeline.RendererListRange range = pipeline.GetRendererListRange(contextIndex, (AAAARendererListID) rendererListID);
+                    ulong[] actualRequests = pipeline.RenderRequests.GetSubArray(range.StartIndex, range.Count).Select(Pack).OrderBy(r => r).ToArray();
+                    ulong[] expectedRequests = expected
+                        .Where(r => r.ContextIndex == contextIndex && (int) r.RendererListID == rendererListID)
+                        .Select(r => Pack(r.Request))
+                        .OrderBy(r => r)
+                        .ToArray();
+                    CollectionAssert.AreEqual(expectedRequests, actualRequests, $"Context {contextIndex}, renderer list {(AAAARendererListID) rendererListID}");
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void MultiView_MatchesPerViewCulling([Values(1u, 2u, 3u)] uint seed)
+        {
+            const int contextCount = 12;
+
+            using var scene = new AAAACullingTestScene(2048, contextCount);
+            var random = new Random(seed);
+            scene.Randomize(ref random, 200.0f);
+
+            for (int contextIndex = 0; contextIndex < contextCount; contextIndex++)
+            {
+                float3 position = random.NextFloat3(-150.0f, 150.0f);
+                quaternion rotation = quaternion.LookRotation(math.normalize(-position), math.up());
+                AAAAInstancePassMask passMask = contextIndex == 0 ? AAAAInstancePassMask.Main : AAAAInstancePassMask.Shadows;
+                scene.SetView(contextIndex, position, rotation, passMask);
+            }
+
+            // Shadow contexts select LODs with the main camera.
+            for (int contextIndex = 1; contextIndex < contextCount; contextIndex++)
+            {
+                scene.LODSelectionContexts[contextIndex] = scene.LODSelectionContexts[0];
+            }
+
+            AAAACPUCullingPipeline.Inputs inputs = scene.ToInputs();
+            AAAACPUCullingPipeline.Settings perViewSettings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            AAAACPUCullingPipeline.Settings multiViewSettings = perViewSettings;
+            multiViewSettings.MultiView = true;
+
+            using var perViewPipeline = new AAAACPUCullingPipeline();
+            perViewPipeline.Run(inputs, perViewSettings);
+            using var multiViewPipeline = new AAAACPUCullingPipeline();
+            multiViewPipeline.Run(inputs, multiViewSettings);
+
+            AssertSameRequests(perViewPipeline, multiViewPipeline, contextCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void MultiView_ShadowMapTexelLOD_MatchesPerViewCulling([Values(1u, 2u, 3u)] uint seed, [Values(false, true)] bool conservative)
+        {
+            using AAAACullingTestScene scene = CreateCascadeScene(seed, out ShadowCascade[] cascades);
+
+            // Every cascade selects LODs from its own texels, so the contexts of one multi-view job disagree on the LOD cut.
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, conservative);
+            }
+
+            AAAACPUCullingPipeline.Inputs inputs = scene.ToInputs();
+            AAAACPUCullingPipeline.Settings perViewSettings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            AAAACPUCullingPipeline.Settings multiViewSettings = perViewSettings;
+            multiViewSettings.MultiView = true;
+
+            using var perViewPipeline = new AAAACPUCullingPipeline();
+            perViewPipeline.Run(inputs, perViewSettings);
+            using var multiViewPipeline = new AAAACPUCullingPipeline();
+            multiViewPipeline.Run(inputs, multiViewSettings);
+
+            AssertSameRequests(perViewPipeline, multiViewPipeline, scene.ContextCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ShadowMapTexelLOD_MatchesScalarReference([Values(1u, 2u, 3u)] uint seed, [Values(false, true)] bool conservative)
+        {
+            using AAAACullingTestScene scene = CreateCascadeScene(seed, out ShadowCascade[] cascades);
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, conservative);
+            }
+
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(scene.ToInputs(), settings);
+
+            List<ReferenceRequest> expected = ReferenceCulling.Run(scene, settings);
+            Assert.IsNotEmpty(expected, "The test scene is expected to have visible meshlets.");
+
+            for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    ulong[] expectedRequests = expected
+                        .Where(r => r.ContextIndex == contextIndex && (int) r.RendererListID == rendererListID)
+                        .Select(r => Pack(r.Request))
+                        .OrderBy(r => r)
+                        .ToArray();
+                    CollectionAssert.AreEqual(expectedRequests, GetSortedRequests(pipeline, contextIndex, (AAAARendererListID) rendererListID),
+                        $"Context {contextIndex}, renderer list {(AAAARendererListID) rendererListID}"
+                    );
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ShadowMapTexelLOD_TrianglesPerSplit([Values(1u, 2u, 3u)] uint seed)
+        {
+            using AAAACullingTestScene scene = CreateCascadeScene(seed, out ShadowCascade[] cascades);
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            using var pipeline = new AAAACPUCullingPipeline();
+
+            pipeline.Run(scene.ToInputs(), settings);
+            long[] mainViewLODTriangles = CountTrianglesPerContext(scene, pipeline);
+
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, false);
+            }
+
+            pipeline.Run(scene.ToInputs(), settings);
+            long[] texelLODTriangles = CountTrianglesPerContext(scene, pipeline);
+
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, true);
+            }
+
+            pipeline.Run(scene.ToInputs(), settings);
+            long[] conservativeLODTriangles = CountTrianglesPerContext(scene, pipeline);
+
+            var report = new System.Text.StringBuilder($"Shadow caster triangles per split (seed {seed}): main view LOD / shadow map texel LOD / conservative.");
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                int contextIndex = 1 + i;
+                report.Append($"\nSplit {i} ({cascades[i].Resolution}px over {cascades[i].HalfSize * 2.0f:F0}m): " +
+                              $"{mainViewLODTriangles[contextIndex]} / {texelLODTriangles[contextIndex]} / {conservativeLODTriangles[contextIndex]}"
+                );
+
+                // The conservative cut is at least as fine as both of the others.
+                Assert.GreaterOrEqual(conservativeLODTriangles[contextIndex], mainViewLODTriangles[contextIndex], $"Split {i}");
+                Assert.GreaterOrEqual(conservativeLODTriangles[contextIndex], texelLODTriangles[contextIndex], $"Split {i}");
+            }
+
+            Debug.Log(report.ToString());
+
+            // The main view is untouched, while the far cascade covers far more world per texel than the camera covers per pixel up close.
+            Assert.AreEqual(mainViewLODTriangles[0], texelLODTriangles[0]);
+            Assert.AreEqual(mainViewLODTriangles[0], conservativeLODTriangles[0]);
+            Assert.Less(texelLODTriangles[cascades.Length], mainViewLODTriangles[cascades.Length]);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ShadowMapTexelLOD_DoesNotDependOnCameraPosition([Values(1u, 2u, 3u)] uint seed)
+        {
+            using AAAACullingTestScene scene = CreateCascadeScene(seed, out ShadowCascade[] cascades);
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            using var pipeline = new AAAACPUCullingPipeline();
+
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, false);
+            }
+
+            pipeline.Run(scene.ToInputs(), settings);
+            long[] trianglesBefore = CountTrianglesPerContext(scene, pipeline);
+            var requestsBefore = new ulong[scene.ContextCount, (int) AAAARendererListID.Count][];
+            for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    requestsBefore[contextIndex, rendererListID] = GetSortedRequests(pipeline, contextIndex, (AAAARendererListID) rendererListID);
+                }
+            }
+
+            // The cascades keep their matrices, as the far cascades do between two fits, so that their cached shadow map tiles can be reused.
+            scene.SetView(0, new float3(20, 3, 40), quaternion.RotateY(0.5f), AAAAInstancePassMask.Main);
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                scene.SetShadowMapTexelLOD(1 + i, cascades[i].Resolution, 1.0f, false);
+            }
+
+            pipeline.Run(scene.ToInputs(), settings);
+
+            Assert.AreNotEqual(trianglesBefore[0], CountTrianglesPerContext(scene, pipeline)[0], "The main view is expected to change.");
+
+            for (int contextIndex = 1; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    CollectionAssert.AreEqual(requestsBefore[contextIndex, rendererListID],
+                        GetSortedRequests(pipeline, contextIndex, (AAAARendererListID) rendererListID),
+                        $"Context {contextIndex}, renderer list {(AAAARendererListID) rendererListID}"
+                    );
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void FrustumCulling_CullsInstancesBehindCamera()
+        {
+            using var scene = new AAAACullingTestScene(1, 1);
+            scene.SetInstance(0, float4x4.Translate(new float3(0, 0, -10)), 0, AAAAInstanceFlags.None);
+            scene.SetView(0, float3.zero, quaternion.identity, AAAAInstancePassMask.Main);
+
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(scene.ToInputs(), AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold));
+
+            Assert.AreEqual(0, pipeline.GetInitialMeshletCount(0));
+            Assert.AreEqual(0, pipeline.RenderRequests.Length);
+            Assert.AreEqual(1, pipeline.DebugData.Sum(d => (long) d.FrustumCulledInstances));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ForcedMeshLODNodeDepth_SelectsOnlyRequestedLevel()
+        {
+            using var scene = new AAAACullingTestScene(1, 1);
+            scene.SetInstance(0, float4x4.Translate(new float3(0, 0, 5)), 0, AAAAInstanceFlags.None);
+            scene.SetView(0, float3.zero, quaternion.identity, AAAAInstancePassMask.Main);
+
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+
+            using var pipeline = new AAAACPUCullingPipeline();
+
+            settings.ForcedMeshLODNodeDepth = 0;
+            pipeline.Run(scene.ToInputs(), settings);
+            Assert.AreEqual(AAAACullingTestScene.RootMeshletCount, pipeline.GetInitialMeshletCount(0));
+            Assert.IsTrue(pipeline.RenderRequests.All(r => r.MeshletID < AAAACullingTestScene.RootMeshletCount));
+
+            settings.ForcedMeshLODNodeDepth = 1;
+            pipeline.Run(scene.ToInputs(), settings);
+            Assert.AreEqual(AAAACullingTestScene.MeshletCount - AAAACullingTestScene.RootMeshletCount, pipeline.GetInitialMeshletCount(0));
+            Assert.IsTrue(pipeline.RenderRequests.All(r => r.MeshletID >= AAAACullingTestScene.RootMeshletCount));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void FlipWindingOrder_TogglesCullFront()
+        {
+            using var scene = new AAAACullingTestScene(2, 1);
+            scene.SetInstance(0, float4x4.Translate(new float3(-2, 0, 10)), 0, AAAAInstanceFlags.FlipWindingOrder);
+            scene.SetInstance(1, float4x4.Translate(new float3(2, 0, 10)), 1, AAAAInstanceFlags.FlipWindingOrder);
+            scene.SetView(0, float3.zero, quaternion.identity, AAAAInstancePassMask.Main);
+
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(scene.ToInputs(), AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold));
+
+            AAAACPUCullingPipeline.RendererListRange cullFront = pipeline.GetRendererListRange(0, AAAARendererListID.CullFront);
+            AAAACPUCullingPipeline.RendererListRange cullOff = pipeline.GetRendererListRange(0, AAAARendererListID.CullOff);
+            Assert.AreEqual(0, pipeline.GetRendererListRange(0, AAAARendererListID.Default).Count);
+            Assert.Greater(cullFront.Count, 0);
+            Assert.Greater(cullOff.Count, 0);
+            Assert.IsTrue(pipeline.RenderRequests.GetSubArray(cullFront.StartIndex, cullFront.Count).All(r => r.InstanceID_LOD == 0));
+            Assert.IsTrue(pipeline.RenderRequests.GetSubArray(cullOff.StartIndex, cullOff.Count).All(r => r.InstanceID_LOD == 1));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void MainPass_SkipsInstancesNotVisibleLastFrame()
+        {
+            using var scene = new AAAACullingTestScene(2, 1);
+            scene.SetInstance(0, float4x4.Translate(new float3(-2, 0, 10)), 0, AAAAInstanceFlags.None);
+            scene.SetInstance(1, float4x4.Translate(new float3(2, 0, 10)), 0, AAAAInstanceFlags.None);
+            scene.SetView(0, float3.zero, quaternion.identity, AAAAInstancePassMask.Main);
+
+            var prevInstanceVisibilityMask = new NativeArray<uint>(1, Allocator.TempJob);
+            prevInstanceVisibilityMask[0] = 1u << 1;
+
+            AAAACPUCullingPipeline.Inputs inputs = scene.ToInputs();
+            inputs.PrevInstanceVisibilityMask = prevInstanceVisibilityMask;
+
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(inputs, AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Main, MeshLODErrorThreshold));
+
+            Assert.Greater(pipeline.RenderRequests.Length, 0);
+            Assert.IsTrue(pipeline.RenderRequests.All(r => r.InstanceID_LOD == 1));
+            Assert.AreEqual(1u << 1, pipeline.InstanceVisibilityMask[0]);
+
+            prevInstanceVisibilityMask.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_100KInstances()
+        {
+            const int instanceCount = 100_000;
+            const int iterations = 10;
+
+            using var scene = new AAAACullingTestScene(instanceCount, 1);
+            var random = new Random(42);
+            scene.Randomize(ref random, 1000.0f);
+            scene.SetView(0, float3.zero, quaternion.identity, AAAAInstancePassMask.Main);
+
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            AAAACPUCullingPipeline.Inputs inputs = scene.ToInputs();
+
+            using var pipeline = new AAAACPUCullingPipeline();
+
+            // Warm up Burst compilation and the internal lists.
+            pipeline.Run(inputs, settings);
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                pipeline.Run(inputs, settings);
+            }
+
+            stopwatch.Stop();
+
+            Assert.Greater(pipeline.RenderRequests.Length, 0);
+            Debug.Log($"CPU culling of {instanceCount} instances: {stopwatch.Elapsed.TotalMilliseconds / iterations:F3} ms, " +
+                      $"{pipeline.GetInitialMeshletCount(0)} meshlets selected, {pipeline.RenderRequests.Length} meshlets visible."
+            );
+        }
+
+        private static ulong Pack(AAAAMeshletRenderRequestPacked request) => (ulong) request.InstanceID_LOD << 32 | request.MeshletID;
+
+        // A main view and four orthographic cascades along it, with the meshlet culling of AAAACullingTestScene left out,
+        // so that the triangle counts only depend on frustum culling and LOD selection.
+        private static AAAACullingTestScene CreateCascadeScene(uint seed, out ShadowCascade[] cascades)
+        {
+            cascades = new ShadowCascade[]
+            {
+                new() { Distance = 10.0f, HalfSize = 15.0f, Resolution = 1024 },
+                new() { Distance = 30.0f, HalfSize = 30.0f, Resolution = 1024 },
+                new() { Distance = 70.0f, HalfSize = 60.0f, Resolution = 512 },
+                new() { Distance = 150.0f, HalfSize = 120.0f, Resolution = 256 },
+            };
+
+            var scene = new AAAACullingTestScene(2048, 1 + cascades.Length);
+            var random = new Random(seed);
+
+            for (int i = 0; i < scene.Instances.Length; i++)
+            {
+                float4x4 objectToWorld = float4x4.TRS(random.NextFloat3(new float3(-150, -5, -20), new float3(150, 5, 250)), random.NextQuaternionRotation(),
+                    random.NextFloat(0.5f, 3.0f)
+                );
+                scene.SetInstance(i, objectToWorld, random.NextInt(AAAACullingTestScene.MaterialRendererListIDs.Length), AAAAInstanceFlags.None);
+            }
+
+            var cameraPosition = new float3(0, 0, -20);
+            scene.SetView(0, cameraPosition, quaternion.identity, AAAAInstancePassMask.Main);
+
+            quaternion lightRotation = quaternion.LookRotation(math.normalize(new float3(-1, -2, 1)), math.up());
+            float3 lightForward = math.rotate(lightRotation, math.forward());
+
+            for (int i = 0; i < cascades.Length; i++)
+            {
+                const float depth = 1000.0f;
+                float3 center = cameraPosition + math.forward() * cascades[i].Distance;
+                scene.SetOrthographicView(1 + i, center - lightForward * depth * 0.5f, lightRotation, cascades[i].HalfSize, depth,
+                    AAAAInstancePassMask.Shadows
+                );
+            }
+
+            return scene;
+        }
+
+        private static long[] CountTrianglesPerContext(AAAACullingTestScene scene, AAAACPUCullingPipeline pipeline)
+        {
+            var triangles = new long[scene.ContextCount];
+
+            for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    AAAACPUCullingPipeline.RendererListRange range = pipeline.GetRendererListRange(contextIndex, (AAAARendererListID) rendererListID);
+                    foreach (AAAAMeshletRenderRequestPacked request in pipeline.RenderRequests.GetSubArray(range.StartIndex, range.Count))
+                    {
+                        triangles[contextIndex] += scene.Meshlets[(int) request.MeshletID].TriangleCount;
+                    }
+                }
+            }
+
+            return triangles;
+        }
+
+        private struct ShadowCascade
+        {
+            public float Distance;
+            public float HalfSize;
+            public int Resolution;
+        }
+
+        private static void AssertSameRequests(AAAACPUCullingPipeline perViewPipeline, AAAACPUCullingPipeline multiViewPipeline, int contextCount)
+        {
+            Assert.Greater(perViewPipeline.RenderRequests.Length, 0, "The test scene is expected to have visible meshlets.");
+            Assert.AreEqual(perViewPipeline.RenderRequests.Length, multiViewPipeline.RenderRequests.Length);
+
+            for (int contextIndex = 0; contextIndex < contextCount; contextIndex++)
+            {
+                Assert.AreEqual(perViewPipeline.GetInitialMeshletCount(contextIndex), multiViewPipeline.GetInitialMeshletCount(contextIndex),
+                    $"Context {contextIndex}"
+                );
+
+                for (int rendererListID = 0; rendererListID < (int) AAAARendererListID.Count; rendererListID++)
+                {
+                    CollectionAssert.AreEqual(GetSortedRequests(perViewPipeline, contextIndex, (AAAARendererListID) rendererListID),
+                        GetSortedRequests(multiViewPipeline, contextIndex, (AAAARendererListID) rendererListID),
+                        $"Context {contextIndex}, renderer list {(AAAARendererListID) rendererListID}"
+                    );
+                }
+            }
+        }
+
+        private static ulong[] GetSortedRequests(AAAACPUCullingPipeline pipeline, int contextIndex, AAAARendererListID rendererListID)
+        {
+            AAAACPUCullingPipeline.RendererListRange range = pipeline.GetRendererListRange(contextIndex, rendererListID);
+            return pipeline.RenderRequests.GetSubArray(range.StartIndex, range.Count).Select(Pack).OrderBy(r => r).ToArray();
+        }
+
+        private struct ReferenceRequest
+        {
+            public int ContextIndex;
+            public AAAARendererListID RendererListID;
+            public AAAAMeshletRenderRequestPacked Request;
+        }
+
+        // Straightforward single-threaded version of the basic pass, written directly against the compute shaders.
+        private static class ReferenceCulling
+        {
+            public static List<ReferenceRequest> Run(AAAACullingTestScene scene, in AAAACPUCullingPipeline.Settings settings)
+            {
+                var result = new List<ReferenceRequest>();
+
+                for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+                {
+                    GPUCullingContext cullingContext = scene.CullingContexts[contextIndex];
+                    GPULODSelectionContext lodSelectionContext = scene.LODSelectionContexts[contextIndex];
+                    float4[] frustumPlanes = GetFrustumPlanes(cullingContext);
+
+                    foreach (int instanceID in scene.InstanceIndices)
+                    {
+                        AAAAInstanceData instanceData = scene.Instances[instanceID];
+                        if ((instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 || (instanceData.PassMask & (AAAAInstancePassMask) cullingContext.PassMask) == 0)
+                        {
+                            continue;
+                        }
+
+                        AAAACullingMath.TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                            out float3 aabbMinWS, out float3 aabbMaxWS
+                        );
+                        if (!IsInsideFrustum(frustumPlanes, AAAACullingMath.AABBToBoundingSphere(aabbMinWS, aabbMaxWS)))
+                        {
+                            continue;
+                        }
+
+                        float3 boundsCenter = (instanceData.AABBMin.xyz + instanceData.AABBMax.xyz) * 0.5f;
+                        float distanceToViewSq = lodSelectionContext.FixedDistanceSq > 0.0f
+                            ? lodSelectionContext.FixedDistanceSq
+                            : math.distancesq(lodSelectionContext.CameraPosition.xyz, boundsCenter);
+                        float conservativeDistanceScale = lodSelectionContext.Conservative != 0
+                            ? distanceToViewSq / math.distancesq(lodSelectionContext.ConservativeCameraPosition.xyz, boundsCenter)
+                            : 0.0f;
+
+                        for (uint nodeIndex = 0; nodeIndex < instanceData.TotalMeshLODCount; nodeIndex++)
+                        {
+                            AAAAMeshLODNode node = scene.MeshLODNodes[(int) (instanceData.TopMeshLODStartIndex + nodeIndex)];
+                            if (!IsLODSelected(lodSelectionContext, instanceData, node, distanceToViewSq, conservativeDistanceScale,
+                                    settings.MeshLODErrorThreshold
+                                ))
+                            {
+                                continue;
+                            }
+
+                            for (uint i = 0; i < node.MeshletCount; i++)
+                            {
+                                uint meshletID = node.MeshletStartIndex + i;
+                                AAAAMeshlet meshlet = scene.Meshlets[(int) meshletID];
+                                AAAARendererListID rendererListID = scene.Materials[(int) instanceData.MaterialIndex].RendererListID;
+                                if ((instanceData.Flags & AAAAInstanceFlags.FlipWindingOrder) != 0 && (rendererListID & AAAARendererListID.CullOff) == 0)
+                                {
+                                    rendererListID ^= AAAARendererListID.CullFront;
+                                }
+
+                                float4 boundingSphereWS = AAAACullingMath.TransformBoundingSphere(meshlet.BoundingSphere, instanceData.ObjectToWorldMatrix);
+                                if (!IsInsideFrustum(frustumPlanes, boundingSphereWS))
+                                {
+                                    continue;
+                                }
+
+                                if ((rendererListID & AAAARendererListID.CullOff) == 0 &&
+                                    !AAAACullingMath.ConeCulling(cullingContext.CameraPosition.xyz,
+                                        AAAACullingMath.GetViewForwardDir(cullingContext.ViewMatrix), cullingContext.CameraIsPerspective != 0, instanceData,
+                                        meshlet
+                                    ))
+                                {
+                                    continue;
+                                }
+
+                                result.Add(new ReferenceRequest
+                                    {
+                                        ContextIndex = contextIndex,
+                                        RendererListID = rendererListID,
+                                        Request = new AAAAMeshletRenderRequestPacked
+                                        {
+                                            InstanceID_LOD = (uint) instanceID,
+                                            MeshletID = meshletID,
+                                        },
+                                    }
+                                );
+                            }
+                        }
+                    }
+                }
+
+                return result;
+            }
+
+            private static unsafe float4[] GetFrustumPlanes(GPUCullingContext cullingContext)
+            {
+                var frustumPlanes = new float4[6];
+
+                for (int i = 0; i < frustumPlanes.Length; i++)
+                {
+                    frustumPlanes[i] = new float4(cullingContext.FrustumPlanes[i * 4 + 0], cullingContext.FrustumPlanes[i * 4 + 1],
+                        cullingContext.FrustumPlanes[i * 4 + 2], cullingContext.FrustumPlanes[i * 4 + 3]
+                    );
+                }
+
+                return frustumPlanes;
+            }
+
+            private static bool IsInsideFrustum(float4[] frustumPlanes, float4 boundingSphere)
+            {
+                foreach (float4 plane in frustumPlanes)
+                {
+                    if (math.dot(plane.xyz, boundingSphere.xyz) + plane.w + boundingSphere.w <= 0.0f)
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            private static bool IsLODSelected(in GPULODSelectionContext lodSelectionContext, in AAAAInstanceData instanceData, in AAAAMeshLODNode node,
+                float distanceToViewSq, float conservativeDistanceScale, float errorThreshold)
+            {
+                float4 boundsWS = AAAACullingMath.TransformBoundingSphere(node.Bounds, instanceData.ObjectToWorldMatrix);
+                float error = node.Error * AAAACullingMath.GetLODScreenBoundRadiusSq(lodSelectionContext, boundsWS, conservativeDistanceScale);
+                float parentError = float.PositiveInfinity;
+                if (node.ParentError >= 0)
+                {
+                    float4 parentBoundsWS = AAAACullingMath.TransformBoundingSphere(node.ParentBounds, instanceData.ObjectToWorldMatrix);
+                    parentError = node.ParentError * AAAACullingMath.GetLODScreenBoundRadiusSq(lodSelectionContext, parentBoundsWS,
+                        conservativeDistanceScale
+                    );
+                }
+
+                float threshold = errorThreshold * distanceToViewSq * instanceData.LODErrorScale;
+                return parentError > threshold && error <= threshold;
+            }
+        }
+    }
+}
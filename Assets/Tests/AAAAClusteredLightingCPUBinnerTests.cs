@@ -0,0 +1,360 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Lighting;
+using DELTation.AAAARP.Passes.ClusteredLighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAClusteredLightingCPUBinnerTests
+    {
+        private const int TotalClusters = AAAAClusteredLightingConstantBuffer.TotalClusters;
+        private const float NearPlane = 0.3f;
+        private const float FarPlane = 100.0f;
+        private const int ClustersX = AAAAClusteredLightingConstantBuffer.ClustersX;
+        private const int ClustersY = AAAAClusteredLightingConstantBuffer.ClustersY;
+        private const int ClustersZ = AAAAClusteredLightingConstantBuffer.ClustersZ;
+
+        private static readonly int2 DepthSize = math.int2(320, 180);
+
+        // The camera sits at the origin and looks down -Z, so world space is view space.
+        private static readonly float4x4 ViewMatrix = float4x4.identity;
+
+        [Test] [Category("AAAA RP")]
+        public void LightLists_MatchBruteForce([Values(1u, 2u, 3u)] uint seed)
+        {
+            using NativeArray<AAAAClusterBounds> clusterBounds = BuildClusterBounds();
+            using NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(seed, 200);
+            using var lightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var lightIndexList = new NativeList<uint>(Allocator.Temp);
+
+            uint totalCount = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, int.MaxValue, lightGrid, lightIndexList);
+
+            Assert.That(lightIndexList.Length, Is.EqualTo(totalCount));
+
+            uint expectedOffset = 0;
+            var expectedLights = new List<uint>();
+            var actualLights = new List<uint>();
+
+            for (int clusterIndex = 0; clusterIndex < TotalClusters; clusterIndex++)
+            {
+                expectedLights.Clear();
+                for (int lightIndex = 0; lightIndex < lights.Length; lightIndex++)
+                {
+                    if (AAAAClusteredLightingCPUBinner.IsLightVisible(lights[lightIndex], ViewMatrix, clusterBounds[clusterIndex]))
+                    {
+                        expectedLights.Add((uint) lightIndex);
+                    }
+                }
+
+                AAAAClusteredLightingGridCell cell = lightGrid[clusterIndex];
+                actualLights.Clear();
+                for (int i = 0; i < cell.Count; i++)
+                {
+                    actualLights.Add(lightIndexList[(int) cell.Offset + i]);
+                }
+
+                // Lists are packed back to back, with no reserved slots in between.
+                Assert.That(cell.Offset, Is.EqualTo(expectedOffset));
+                Assert.That(actualLights, Is.EqualTo(expectedLights));
+                expectedOffset += cell.Count;
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void OverlappingLights_AreNotCapped()
+        {
+            const int lightCount = 300;
+            using NativeArray<AAAAClusterBounds> clusterBounds = BuildClusterBounds();
+            var lights = new NativeArray<AAAAPunctualLightData>(lightCount, Allocator.Temp);
+            using var lightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var lightIndexList = new NativeList<uint>(Allocator.Temp);
+
+            for (int i = 0; i < lightCount; i++)
+            {
+                lights[i] = CreatePointLight(math.float3(0.0f, 0.0f, -10.0f), 1.0f);
+            }
+
+            AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, int.MaxValue, lightGrid, lightIndexList);
+
+            uint maxCount = 0;
+            foreach (AAAAClusteredLightingGridCell cell in lightGrid)
+            {
+                maxCount = math.max(maxCount, cell.Count);
+            }
+
+            Assert.That(maxCount, Is.EqualTo(lightCount));
+
+            lights.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SmallCapacity_KeepsCellsWithinTheList([Values(1u, 2u, 3u)] uint seed)
+        {
+            using NativeArray<AAAAClusterBounds> clusterBounds = BuildClusterBounds();
+            using NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(seed, 200);
+            using var fullLightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var fullLightIndexList = new NativeList<uint>(Allocator.Temp);
+            using var lightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var lightIndexList = new NativeList<uint>(Allocator.Temp);
+
+            uint totalCount = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, int.MaxValue, fullLightGrid, fullLightIndexList);
+            int capacity = (int) totalCount / 2;
+            uint reportedCount = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, capacity, lightGrid, lightIndexList);
+
+            // The reported count is what the list has to grow to.
+            Assert.That(reportedCount, Is.EqualTo(totalCount));
+            Assert.That(lightIndexList.Length, Is.EqualTo(capacity));
+
+            for (int clusterIndex = 0; clusterIndex < TotalClusters; clusterIndex++)
+            {
+                AAAAClusteredLightingGridCell cell = lightGrid[clusterIndex];
+                AAAAClusteredLightingGridCell fullCell = fullLightGrid[clusterIndex];
+                Assert.That(cell.Offset + cell.Count, Is.LessThanOrEqualTo(capacity));
+                Assert.That(cell.Count, Is.LessThanOrEqualTo(fullCell.Count));
+
+                // Clusters keep a prefix of their full list.
+                for (int i = 0; i < cell.Count; i++)
+                {
+                    Assert.That(lightIndexList[(int) cell.Offset + i], Is.EqualTo(fullLightIndexList[(int) fullCell.Offset + i]));
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SparseScene_UsesLessMemoryThanFixedLayout([Values(1u, 2u, 3u)] uint seed)
+        {
+            using NativeArray<AAAAClusterBounds> clusterBounds = BuildClusterBounds();
+            using NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(seed, 64);
+            using var lightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var lightIndexList = new NativeList<uint>(Allocator.Temp);
+
+            uint totalCount = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, int.MaxValue, lightGrid, lightIndexList);
+
+            long compactBytes = AAAAClusteredLightingCPUBinner.GetCompactLayoutByteSize((int) totalCount);
+            long fixedBytes = AAAAClusteredLightingCPUBinner.GetFixedLayoutByteSize(128);
+            Debug.Log($"Indices: {totalCount}, compact: {compactBytes} B, fixed (128 per cluster): {fixedBytes} B.");
+
+            Assert.That(totalCount, Is.GreaterThan(0));
+            Assert.That(compactBytes * 10, Is.LessThan(fixedBytes));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void DepthCullingOff_MarksAllClusters()
+        {
+            using NativeArray<float> depth = CreateRandomDepth(1u);
+            using var activeClusterIndices = new NativeList<int>(Allocator.Temp);
+
+            AAAAClusteredLightingCPUBinner.ComputeActiveClusters(depth, DepthSize, NearPlane, FarPlane, AAAAClusterDepthCullingMode.Off,
+                activeClusterIndices
+            );
+
+            Assert.That(activeClusterIndices.Length, Is.EqualTo(TotalClusters));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void EveryPixel_FindsItsClusterActive([Values(AAAAClusterDepthCullingMode.Conservative, AAAAClusterDepthCullingMode.Opaque)]
+            AAAAClusterDepthCullingMode depthCullingMode, [Values(1u, 2u, 3u)] uint seed)
+        {
+            using NativeArray<float> depth = CreateRandomDepth(seed);
+            using var activeClusterIndices = new NativeList<int>(Allocator.Temp);
+
+            AAAAClusteredLightingCPUBinner.ComputeActiveClusters(depth, DepthSize, NearPlane, FarPlane, depthCullingMode, activeClusterIndices);
+
+            var activeClusters = new HashSet<int>();
+            foreach (int flatClusterIndex in activeClusterIndices)
+            {
+                activeClusters.Add(flatClusterIndex);
+            }
+
+            int missingClusterCount = 0;
+
+            for (int y = 0; y < DepthSize.y; y++)
+            {
+                for (int x = 0; x < DepthSize.x; x++)
+                {
+                    // Same lookup as ClusteredLighting.hlsl.
+                    float2 screenUV = (math.float2(x, y) + 0.5f) / DepthSize;
+                    int2 tileIndex = math.clamp((int2) (screenUV * math.float2(ClustersX, ClustersY)), 0, math.int2(ClustersX, ClustersY) - 1);
+                    int slice = AAAAClusteredLightingCPUBinner.ViewSpaceZToClusterIndex(-depth[y * DepthSize.x + x], NearPlane, FarPlane);
+                    slice = math.clamp(slice, 0, ClustersZ - 1);
+
+                    if (!activeClusters.Contains(FlattenClusterIndex(tileIndex, slice)))
+                    {
+                        ++missingClusterCount;
+                    }
+
+                    if (depthCullingMode == AAAAClusterDepthCullingMode.Conservative)
+                    {
+                        // Transparent surfaces in front of the pixel.
+                        for (int frontSlice = 0; frontSlice < slice; frontSlice++)
+                        {
+                            if (!activeClusters.Contains(FlattenClusterIndex(tileIndex, frontSlice)))
+                            {
+                                ++missingClusterCount;
+                            }
+                        }
+                    }
+                }
+            }
+
+            Assert.That(missingClusterCount, Is.Zero);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ActiveClusters_KeepTheirFullLightLists([Values(1u, 2u, 3u)] uint seed)
+        {
+            using NativeArray<AAAAClusterBounds> clusterBounds = BuildClusterBounds();
+            using NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(seed, 200);
+            using NativeArray<float> depth = CreateRandomDepth(seed);
+            using var activeClusterIndices = new NativeList<int>(Allocator.Temp);
+            using var fullLightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var fullLightIndexList = new NativeList<uint>(Allocator.Temp);
+            using var lightGrid = new NativeArray<AAAAClusteredLightingGridCell>(TotalClusters, Allocator.Temp);
+            using var lightIndexList = new NativeList<uint>(Allocator.Temp);
+
+            AAAAClusteredLightingCPUBinner.ComputeActiveClusters(depth, DepthSize, NearPlane, FarPlane, AAAAClusterDepthCullingMode.Opaque,
+                activeClusterIndices
+            );
+            uint fullCount = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, int.MaxValue, fullLightGrid, fullLightIndexList);
+            uint count = AAAAClusteredLightingCPUBinner.BinLights(clusterBounds, lights, ViewMatrix, activeClusterIndices.AsArray(), int.MaxValue,
+                lightGrid, lightIndexList
+            );
+
+            Debug.Log($"Active clusters: {activeClusterIndices.Length}/{TotalClusters}, indices: {count}/{fullCount}.");
+            Assert.That(count, Is.LessThan(fullCount));
+
+            var activeClusters = new HashSet<int>();
+            foreach (int flatClusterIndex in activeClusterIndices)
+            {
+                activeClusters.Add(flatClusterIndex);
+            }
+
+            for (int clusterIndex = 0; clusterIndex < TotalClusters; clusterIndex++)
+            {
+                AAAAClusteredLightingGridCell cell = lightGrid[clusterIndex];
+                AAAAClusteredLightingGridCell fullCell = fullLightGrid[clusterIndex];
+
+                if (!activeClusters.Contains(clusterIndex))
+                {
+                    Assert.That(cell.Count, Is.Zero);
+                    continue;
+                }
+
+                Assert.That(cell.Count, Is.EqualTo(fullCell.Count));
+                for (int i = 0; i < cell.Count; i++)
+                {
+                    Assert.That(lightIndexList[(int) cell.Offset + i], Is.EqualTo(fullLightIndexList[(int) fullCell.Offset + i]));
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Wall_ActivatesFewClusters()
+        {
+            using var depth = new NativeArray<float>(DepthSize.x * DepthSize.y, Allocator.Temp);
+            using var conservativeClusterIndices = new NativeList<int>(Allocator.Temp);
+            using var opaqueClusterIndices = new NativeList<int>(Allocator.Temp);
+
+            FillDepth(depth, 20.0f);
+            AAAAClusteredLightingCPUBinner.ComputeActiveClusters(depth, DepthSize, NearPlane, FarPlane, AAAAClusterDepthCullingMode.Conservative,
+                conservativeClusterIndices
+            );
+            AAAAClusteredLightingCPUBinner.ComputeActiveClusters(depth, DepthSize, NearPlane, FarPlane, AAAAClusterDepthCullingMode.Opaque,
+                opaqueClusterIndices
+            );
+
+            int wallSlice = AAAAClusteredLightingCPUBinner.ViewSpaceZToClusterIndex(-20.0f, NearPlane, FarPlane);
+            const int tileCount = ClustersX * ClustersY;
+
+            // The margin around the depth range may add the neighboring slice.
+            Assert.That(opaqueClusterIndices.Length, Is.InRange(tileCount, 2 * tileCount));
+            Assert.That(conservativeClusterIndices.Length, Is.InRange((wallSlice + 1) * tileCount, (wallSlice + 2) * tileCount));
+            Assert.That(conservativeClusterIndices.Length, Is.LessThan(TotalClusters));
+        }
+
+        private static NativeArray<AAAAClusterBounds> BuildClusterBounds()
+        {
+            var clusterBounds = new NativeArray<AAAAClusterBounds>(TotalClusters, Allocator.Temp);
+            float4x4 projectionMatrix = float4x4.PerspectiveFov(math.radians(60.0f), 16.0f / 9.0f, NearPlane, FarPlane);
+            AAAAClusteredLightingCPUBinner.BuildClusterBounds(projectionMatrix, math.float2(1920, 1080), NearPlane, FarPlane, clusterBounds);
+            return clusterBounds;
+        }
+
+        private static NativeArray<AAAAPunctualLightData> CreateRandomLights(uint seed, int count)
+        {
+            var random = new Random(seed);
+            var lights = new NativeArray<AAAAPunctualLightData>(count, Allocator.Temp);
+
+            for (int i = 0; i < count; i++)
+            {
+                float3 position = random.NextFloat3(math.float3(-30, -20, -80), math.float3(30, 20, -1));
+                float radius = random.NextFloat(0.5f, 4.0f);
+                AAAAPunctualLightData light = CreatePointLight(position, radius);
+
+                if (random.NextBool())
+                {
+                    light.SpotDirection_Angle = math.float4(random.NextFloat3Direction(), math.radians(random.NextFloat(10.0f, 60.0f)));
+                }
+
+                lights[i] = light;
+            }
+
+            return lights;
+        }
+
+        // A floor going into the distance, boxes standing on it, and the sky above the horizon.
+        private static NativeArray<float> CreateRandomDepth(uint seed)
+        {
+            var random = new Random(seed);
+            var depth = new NativeArray<float>(DepthSize.x * DepthSize.y, Allocator.Temp);
+            int horizon = DepthSize.y * 2 / 3;
+
+            for (int y = 0; y < DepthSize.y; y++)
+            {
+                for (int x = 0; x < DepthSize.x; x++)
+                {
+                    depth[y * DepthSize.x + x] = y < horizon ? math.lerp(1.0f, 80.0f, math.pow((float) y / horizon, 3.0f)) : FarPlane;
+                }
+            }
+
+            for (int boxIndex = 0; boxIndex < 12; boxIndex++)
+            {
+                int2 min = random.NextInt2(int2.zero, DepthSize);
+                int2 max = math.min(DepthSize, min + random.NextInt2(math.int2(4, 4), DepthSize / 4));
+                float boxDepth = random.NextFloat(2.0f, 60.0f);
+
+                for (int y = min.y; y < max.y; y++)
+                {
+                    for (int x = min.x; x < max.x; x++)
+                    {
+                        int index = y * DepthSize.x + x;
+                        depth[index] = math.min(depth[index], boxDepth);
+                    }
+                }
+            }
+
+            return depth;
+        }
+
+        private static void FillDepth(NativeArray<float> depth, float value)
+        {
+            for (int i = 0; i < depth.Length; i++)
+            {
+                depth[i] = value;
+            }
+        }
+
+        private static int FlattenClusterIndex(int2 tileIndex, int slice) => tileIndex.x + tileIndex.y * ClustersX + slice * ClustersX * ClustersY;
+
+        private static AAAAPunctualLightData CreatePointLight(float3 position, float radius) =>
+            new()
+            {
+                Color_Radius = math.float4(1, 1, 1, radius),
+                PositionWS = math.float4(position, 1),
+            };
+    }
+}
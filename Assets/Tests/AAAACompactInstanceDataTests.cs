@@ -0,0 +1,94 @@
+using DELTation.AAAARP;
+using NUnit.Framework;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAACompactInstanceDataTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void Size_IsAtMost96Bytes()
+        {
+            Assert.LessOrEqual(UnsafeUtility.SizeOf<AAAACompactInstanceData>(), 96);
+            Assert.AreEqual(0, UnsafeUtility.SizeOf<AAAACompactInstanceData>() % 16);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void PackUnpack_PreservesTransformAndFields([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+
+            for (int i = 0; i < 1000; i++)
+            {
+                AAAAInstanceData instanceData = CreateRandomInstance(ref random);
+                AAAAInstanceData unpacked = AAAACompactInstanceData.Pack(instanceData).Unpack();
+
+                Assert.AreEqual(instanceData.ObjectToWorldMatrix, unpacked.ObjectToWorldMatrix);
+                Assert.IsTrue(IsIdentity(math.mul(unpacked.ObjectToWorldMatrix, unpacked.WorldToObjectMatrix)));
+                Assert.AreEqual(instanceData.TopMeshLODStartIndex, unpacked.TopMeshLODStartIndex);
+                Assert.AreEqual(instanceData.TotalMeshLODCount, unpacked.TotalMeshLODCount);
+                Assert.AreEqual(instanceData.MaterialIndex, unpacked.MaterialIndex);
+                Assert.AreEqual(instanceData.MeshLODLevelCount, unpacked.MeshLODLevelCount);
+                Assert.AreEqual(instanceData.LODErrorScale, unpacked.LODErrorScale);
+                Assert.AreEqual(instanceData.PassMask, unpacked.PassMask);
+                Assert.AreEqual(instanceData.Flags, unpacked.Flags);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void PackUnpack_AABBIsConservative([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+
+            for (int i = 0; i < 1000; i++)
+            {
+                AAAAInstanceData instanceData = CreateRandomInstance(ref random);
+                AAAAInstanceData unpacked = AAAACompactInstanceData.Pack(instanceData).Unpack();
+
+                Assert.IsTrue(math.all(unpacked.AABBMin.xyz <= instanceData.AABBMin.xyz));
+                Assert.IsTrue(math.all(unpacked.AABBMax.xyz >= instanceData.AABBMax.xyz));
+
+                // Half precision has an 11-bit mantissa.
+                float3 extent = math.max(math.abs(instanceData.AABBMin.xyz), math.abs(instanceData.AABBMax.xyz));
+                float3 tolerance = extent / 512.0f + 1e-3f;
+                Assert.IsTrue(math.all(instanceData.AABBMin.xyz - unpacked.AABBMin.xyz <= tolerance));
+                Assert.IsTrue(math.all(unpacked.AABBMax.xyz - instanceData.AABBMax.xyz <= tolerance));
+            }
+        }
+
+        private static AAAAInstanceData CreateRandomInstance(ref Random random)
+        {
+            float4x4 objectToWorldMatrix = float4x4.TRS(random.NextFloat3(-100, 100), random.NextQuaternionRotation(),
+                random.NextFloat3(0.1f, 4.0f) * math.select(1.0f, -1.0f, random.NextBool3())
+            );
+            float3 aabbMin = random.NextFloat3(-100, 100);
+            float3 aabbMax = aabbMin + random.NextFloat3(0.001f, 50);
+
+            return new AAAAInstanceData
+            {
+                ObjectToWorldMatrix = objectToWorldMatrix,
+                WorldToObjectMatrix = math.fastinverse(objectToWorldMatrix),
+                AABBMin = math.float4(aabbMin, 0),
+                AABBMax = math.float4(aabbMax, 0),
+                TopMeshLODStartIndex = random.NextUInt(),
+                TotalMeshLODCount = random.NextUInt(1, 100_000),
+                MaterialIndex = random.NextUInt(0, 4096),
+                MeshLODLevelCount = random.NextUInt(1, 16),
+                LODErrorScale = random.NextFloat(0.1f, 10),
+                PassMask = (AAAAInstancePassMask) random.NextInt(1, 4),
+                Flags = (AAAAInstanceFlags) random.NextInt(0, 4),
+            };
+        }
+
+        private static bool IsIdentity(float4x4 matrix)
+        {
+            const float epsilon = 1e-4f;
+            return math.all(math.abs(matrix.c0 - new float4(1, 0, 0, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c1 - new float4(0, 1, 0, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c2 - new float4(0, 0, 1, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c3 - new float4(0, 0, 0, 1)) < epsilon);
+        }
+    }
+}
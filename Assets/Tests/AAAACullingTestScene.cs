@@ -0,0 +1,316 @@
+using System;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Passes;
+using Unity.Collections;
+using Unity.Mathematics;
+using UnityEngine;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    // Instances, views and geometry for the culling tests.
+    // Every instance shares a two-level DAG: a coarse root with two meshlets and two leaves with one meshlet each.
+    internal sealed class AAAACullingTestScene : IDisposable
+    {
+        public const int RootMeshletCount = 2;
+        public const int MeshletCount = RootMeshletCount + 2;
+        public const int RootMeshletTriangleCount = 16;
+        public const int LeafMeshletTriangleCount = 64;
+        private const float RootError = 0.5f;
+
+        public static readonly AAAARendererListID[] MaterialRendererListIDs =
+        {
+            AAAARendererListID.Default,
+            AAAARendererListID.CullOff,
+            AAAARendererListID.AlphaTest,
+            AAAARendererListID.CullFront | AAAARendererListID.AlphaTest,
+        };
+
+        public NativeArray<GPUCullingContext> CullingContexts;
+        public NativeArray<int> InstanceIndices;
+        public NativeArray<AAAAInstanceData> Instances;
+        public NativeArray<GPULODSelectionContext> LODSelectionContexts;
+        public NativeArray<AAAAMaterialData> Materials;
+        public NativeArray<AAAAMeshlet> Meshlets;
+        public NativeArray<AAAAMeshLODNode> MeshLODNodes;
+
+        private readonly OrthographicView[] _orthographicViews;
+
+        public AAAACullingTestScene(int instanceCount, int contextCount)
+        {
+            _orthographicViews = new OrthographicView[contextCount];
+            Instances = new NativeArray<AAAAInstanceData>(instanceCount, Allocator.Persistent);
+            InstanceIndices = new NativeArray<int>(instanceCount, Allocator.Persistent);
+            CullingContexts = new NativeArray<GPUCullingContext>(contextCount, Allocator.Persistent);
+            LODSelectionContexts = new NativeArray<GPULODSelectionContext>(contextCount, Allocator.Persistent);
+            Materials = new NativeArray<AAAAMaterialData>(MaterialRendererListIDs.Length, Allocator.Persistent);
+            Meshlets = new NativeArray<AAAAMeshlet>(MeshletCount, Allocator.Persistent);
+            MeshLODNodes = new NativeArray<AAAAMeshLODNode>(3, Allocator.Persistent);
+
+            for (int i = 0; i < instanceCount; i++)
+            {
+                InstanceIndices[i] = i;
+            }
+
+            for (int i = 0; i < Materials.Length; i++)
+            {
+                Materials[i] = new AAAAMaterialData { RendererListID = MaterialRendererListIDs[i] };
+            }
+
+            var rootBounds = new float4(0, 0, 0, 1);
+            MeshLODNodes[0] = new AAAAMeshLODNode
+            {
+                Bounds = rootBounds,
+                ParentBounds = rootBounds,
+                Error = RootError,
+                ParentError = -1.0f,
+                MeshletStartIndex = 0,
+                MeshletCount = RootMeshletCount,
+                LevelIndex = 0,
+            };
+
+            for (int i = 0; i < 2; i++)
+            {
+                MeshLODNodes[1 + i] = new AAAAMeshLODNode
+                {
+                    Bounds = new float4(i == 0 ? -0.5f : 0.5f, 0, 0, 0.6f),
+                    ParentBounds = rootBounds,
+                    Error = 0.0f,
+                    ParentError = RootError,
+                    MeshletStartIndex = (uint) (RootMeshletCount + i),
+                    MeshletCount = 1,
+                    LevelIndex = 1,
+                };
+            }
+
+            for (int i = 0; i < MeshletCount; i++)
+            {
+                float x = i % 2 == 0 ? -0.5f : 0.5f;
+                Meshlets[i] = new AAAAMeshlet
+                {
+                    BoundingSphere = new float4(x, 0, 0, 0.6f),
+                    // Cutoff above 1 never culls.
+                    ConeApexCutoff = new float4(x, 0, 0, 2.0f),
+                    ConeAxis = new float4(0, 0, 1, 0),
+                    TriangleCount = (uint) (i < RootMeshletCount ? RootMeshletTriangleCount : LeafMeshletTriangleCount),
+                };
+            }
+        }
+
+        // Unit boxes scattered over a 200 m cube, without the meshlet culling inputs. Used by the instance-level culling tests.
+        public static AAAACullingTestScene CreateScattered(int instanceCount, Random random)
+        {
+            var scene = new AAAACullingTestScene(instanceCount, 0);
+
+            for (int i = 0; i < instanceCount; i++)
+            {
+                scene.Instances[i] = new AAAAInstanceData
+                {
+                    ObjectToWorldMatrix = float4x4.TRS(random.NextFloat3(-100, 100), random.NextQuaternionRotation(), random.NextFloat(0.5f, 3.0f)),
+                    AABBMin = new float4(-0.5f, -0.5f, -0.5f, 0),
+                    AABBMax = new float4(0.5f, 0.5f, 0.5f, 0),
+                    PassMask = random.NextFloat() < 0.8f ? AAAAInstancePassMask.Main | AAAAInstancePassMask.Shadows :
+                        random.NextBool() ? AAAAInstancePassMask.Main : AAAAInstancePassMask.Shadows,
+                    Flags = random.NextFloat() < 0.05f ? AAAAInstanceFlags.Disabled : AAAAInstanceFlags.None,
+                };
+            }
+
+            return scene;
+        }
+
+        public int ContextCount => CullingContexts.Length;
+
+        public void Dispose()
+        {
+            CullingContexts.Dispose();
+            InstanceIndices.Dispose();
+            Instances.Dispose();
+            LODSelectionContexts.Dispose();
+            Materials.Dispose();
+            Meshlets.Dispose();
+            MeshLODNodes.Dispose();
+        }
+
+        public void Randomize(ref Random random, float extents)
+        {
+            for (int i = 0; i < Meshlets.Length; i++)
+            {
+                AAAAMeshlet meshlet = Meshlets[i];
+                meshlet.ConeAxis = new float4(random.NextFloat3Direction(), 0);
+                meshlet.ConeApexCutoff.w = random.NextFloat(-0.5f, 1.5f);
+                Meshlets[i] = meshlet;
+            }
+
+            for (int i = 0; i < Instances.Length; i++)
+            {
+                float4x4 objectToWorld = float4x4.TRS(random.NextFloat3(-extents, extents), random.NextQuaternionRotation(),
+                    random.NextFloat(0.5f, 3.0f)
+                );
+                AAAAInstanceFlags flags = random.NextFloat() < 0.25f ? AAAAInstanceFlags.FlipWindingOrder : AAAAInstanceFlags.None;
+                if (random.NextFloat() < 0.05f)
+                {
+                    flags |= AAAAInstanceFlags.Disabled;
+                }
+
+                SetInstance(i, objectToWorld, random.NextInt(Materials.Length), flags);
+
+                AAAAInstanceData instanceData = Instances[i];
+                instanceData.PassMask = random.NextFloat() < 0.8f ? AAAAInstancePassMask.Main | AAAAInstancePassMask.Shadows : AAAAInstancePassMask.Main;
+                Instances[i] = instanceData;
+            }
+        }
+
+        public void SetInstance(int index, float4x4 objectToWorld, int materialIndex, AAAAInstanceFlags flags)
+        {
+            Instances[index] = new AAAAInstanceData
+            {
+                ObjectToWorldMatrix = objectToWorld,
+                WorldToObjectMatrix = math.inverse(objectToWorld),
+                AABBMin = new float4(-1.1f, -0.6f, -0.6f, 0),
+                AABBMax = new float4(1.1f, 0.6f, 0.6f, 0),
+                TopMeshLODStartIndex = 0,
+                TotalMeshLODCount = (uint) MeshLODNodes.Length,
+                MaterialIndex = (uint) materialIndex,
+                MeshLODLevelCount = 2,
+                LODErrorScale = 1.0f,
+                PassMask = AAAAInstancePassMask.Main | AAAAInstancePassMask.Shadows,
+                Flags = flags,
+            };
+        }
+
+        public void Move(int instanceIndex, float3 offset)
+        {
+            AAAAInstanceData instanceData = Instances[instanceIndex];
+            instanceData.ObjectToWorldMatrix = math.mul(float4x4.Translate(offset), instanceData.ObjectToWorldMatrix);
+            Instances[instanceIndex] = instanceData;
+        }
+
+        // Removed instances are no longer expected to be visible.
+        public void Disable(int instanceIndex)
+        {
+            AAAAInstanceData instanceData = Instances[instanceIndex];
+            instanceData.Flags |= AAAAInstanceFlags.Disabled;
+            Instances[instanceIndex] = instanceData;
+        }
+
+        public unsafe void SetView(int contextIndex, float3 position, quaternion rotation, AAAAInstancePassMask passMask)
+        {
+            // Camera space looks down -Z, same as Camera.worldToCameraMatrix.
+            float4x4 viewMatrix = math.mul(float4x4.Scale(1, 1, -1), math.inverse(float4x4.TRS(position, rotation, 1)));
+            float4x4 projectionMatrix = float4x4.PerspectiveFov(math.radians(60.0f), 16.0f / 9.0f, 0.1f, 2000.0f);
+            float4x4 viewProjectionMatrix = math.mul(projectionMatrix, viewMatrix);
+
+            var cullingContext = new GPUCullingContext
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                ViewMatrix = viewMatrix,
+                CameraPosition = new float4(position, 1),
+                PassMask = (int) passMask,
+                CameraIsPerspective = 1,
+            };
+
+            Plane[] frustumPlanes = GeometryUtility.CalculateFrustumPlanes(viewProjectionMatrix);
+            for (int i = 0; i < frustumPlanes.Length; i++)
+            {
+                cullingContext.FrustumPlanes[i * 4 + 0] = frustumPlanes[i].normal.x;
+                cullingContext.FrustumPlanes[i * 4 + 1] = frustumPlanes[i].normal.y;
+                cullingContext.FrustumPlanes[i * 4 + 2] = frustumPlanes[i].normal.z;
+                cullingContext.FrustumPlanes[i * 4 + 3] = frustumPlanes[i].distance;
+            }
+
+            CullingContexts[contextIndex] = cullingContext;
+            LODSelectionContexts[contextIndex] = new GPULODSelectionContext
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                CameraPosition = new float4(position, 1),
+                CameraUp = new float4(math.rotate(rotation, math.up()), 0),
+                CameraRight = new float4(math.rotate(rotation, math.right()), 0),
+                ScreenSizePixels = new float2(1920, 1080),
+                ErrorScale = 1.0f,
+            };
+        }
+
+        // LOD selection still follows the main camera, as in GPUCullingPass by default.
+        public unsafe void SetOrthographicView(int contextIndex, float3 position, quaternion rotation, float halfSize, float depth,
+            AAAAInstancePassMask passMask)
+        {
+            float4x4 viewMatrix = math.mul(float4x4.Scale(1, 1, -1), math.inverse(float4x4.TRS(position, rotation, 1)));
+            float4x4 projectionMatrix = float4x4.Ortho(halfSize * 2.0f, halfSize * 2.0f, 0.1f, depth);
+            float4x4 viewProjectionMatrix = math.mul(projectionMatrix, viewMatrix);
+
+            var cullingContext = new GPUCullingContext
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                ViewMatrix = viewMatrix,
+                CameraPosition = new float4(position, 1),
+                PassMask = (int) passMask,
+                CameraIsPerspective = 0,
+            };
+
+            Plane[] frustumPlanes = GeometryUtility.CalculateFrustumPlanes(viewProjectionMatrix);
+            for (int i = 0; i < frustumPlanes.Length; i++)
+            {
+                cullingContext.FrustumPlanes[i * 4 + 0] = frustumPlanes[i].normal.x;
+                cullingContext.FrustumPlanes[i * 4 + 1] = frustumPlanes[i].normal.y;
+                cullingContext.FrustumPlanes[i * 4 + 2] = frustumPlanes[i].normal.z;
+                cullingContext.FrustumPlanes[i * 4 + 3] = frustumPlanes[i].distance;
+            }
+
+            CullingContexts[contextIndex] = cullingContext;
+            LODSelectionContexts[contextIndex] = LODSelectionContexts[0];
+            _orthographicViews[contextIndex] = new OrthographicView
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                Position = position,
+                Up = math.rotate(rotation, math.up()),
+                Right = math.rotate(rotation, math.right()),
+            };
+        }
+
+        // Same as GPUCullingPass for LODSelectionMode.ViewPixels: error and distance falloff in shadow map texels,
+        // the main camera only takes part in conservative selection.
+        public void SetShadowMapTexelLOD(int contextIndex, int resolution, float errorScale, bool conservative)
+        {
+            GPULODSelectionContext mainView = LODSelectionContexts[0];
+            OrthographicView view = _orthographicViews[contextIndex];
+
+            LODSelectionContexts[contextIndex] = new GPULODSelectionContext
+            {
+                ViewProjectionMatrix = view.ViewProjectionMatrix,
+                CameraPosition = new float4(view.Position, 1),
+                CameraUp = new float4(view.Up, 0),
+                CameraRight = new float4(view.Right, 0),
+                ScreenSizePixels = new float2(resolution, resolution),
+                ErrorScale = errorScale,
+                Conservative = conservative ? 1u : 0u,
+                FixedDistanceSq = GPUCullingPass.GetOrthographicLODDistanceSq(view.ViewProjectionMatrix),
+                ConservativeViewProjectionMatrix = mainView.ViewProjectionMatrix,
+                ConservativeCameraPosition = mainView.CameraPosition,
+                ConservativeCameraUp = mainView.CameraUp,
+                ConservativeCameraRight = mainView.CameraRight,
+                ConservativeScreenSizePixels = mainView.ScreenSizePixels,
+            };
+        }
+
+        public AAAACPUCullingPipeline.Inputs ToInputs() =>
+            new()
+            {
+                Instances = Instances,
+                InstanceIndices = InstanceIndices,
+                MeshLODNodes = MeshLODNodes,
+                Meshlets = Meshlets,
+                Materials = Materials,
+                CullingContexts = CullingContexts,
+                LODSelectionContexts = LODSelectionContexts,
+            };
+
+        private struct OrthographicView
+        {
+            public float4x4 ViewProjectionMatrix;
+            public float3 Position;
+            public float3 Up;
+            public float3 Right;
+        }
+    }
+}
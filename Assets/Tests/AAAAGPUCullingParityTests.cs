@@ -0,0 +1,255 @@
+using System.Collections.Generic;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Passes;
+using DELTation.AAAARP.RenderPipelineResources;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Rendering;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    // Dispatches GPUInstanceCulling.compute, per context and multi-view, and compares its jobs and debug counters with AAAACPUCullingPipeline.
+    // The instance data is uploaded in the layout selected by AAAAInstanceConfiguration, so this also covers the compact transforms.
+    public class AAAAGPUCullingParityTests
+    {
+        private const float MeshLODErrorThreshold = 1.0f;
+
+        [Test] [Category("AAAA RP")]
+        public void InstanceCulling_MatchesCPUPipeline([Values(1u, 2u, 3u)] uint seed, [Values] bool multiView)
+        {
+            ComputeShader instanceCullingCS = GetInstanceCullingShader();
+
+            using var scene = new AAAACullingTestScene(4096, 4);
+            var random = new Random(seed);
+            scene.Randomize(ref random, 200.0f);
+
+            for (int contextIndex = 0; contextIndex < scene.ContextCount; contextIndex++)
+            {
+                float3 position = random.NextFloat3(-150.0f, 150.0f);
+                quaternion rotation = quaternion.LookRotation(math.normalize(-position), math.up());
+                AAAAInstancePassMask passMask = contextIndex == 0 ? AAAAInstancePassMask.Main : AAAAInstancePassMask.Shadows;
+                scene.SetView(contextIndex, position, rotation, passMask);
+            }
+
+            var settings = AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, MeshLODErrorThreshold);
+            settings.MultiView = multiView;
+            using var pipeline = new AAAACPUCullingPipeline();
+            pipeline.Run(scene.ToInputs(), settings);
+
+            var expected = new HashSet<(int ContextIndex, uint InstanceID)>();
+            foreach (AAAACPUCullingPipeline.MeshletListBuildJobData job in pipeline.MeshletListBuildJobs)
+            {
+                AddVisibleInstance(expected, job.InstanceID, job.ViewMask);
+            }
+
+            var debugData = new AAAAGPUCullingDebugData[pipeline.DebugData.Length];
+            HashSet<(int ContextIndex, uint InstanceID)> actual = DispatchInstanceCulling(instanceCullingCS, scene, multiView, debugData);
+
+            Assert.IsNotEmpty(expected, "The test scene is expected to have visible instances.");
+            int mismatchCount = AssertMatchesUpToPrecision(scene, expected, actual);
+
+            // Every instance that passes the pass mask and is not visible in a context is counted as frustum culled once.
+            long expectedFrustumCulledInstances = 0;
+            foreach (AAAAGPUCullingDebugData item in pipeline.DebugData)
+            {
+                expectedFrustumCulledInstances += item.FrustumCulledInstances;
+            }
+
+            long actualFrustumCulledInstances = 0;
+            foreach (AAAAGPUCullingDebugData item in debugData)
+            {
+                actualFrustumCulledInstances += item.FrustumCulledInstances;
+            }
+
+            Assert.Greater(expectedFrustumCulledInstances, 0);
+            Assert.LessOrEqual(math.abs(expectedFrustumCulledInstances - actualFrustumCulledInstances), mismatchCount);
+        }
+
+        private static ComputeShader GetInstanceCullingShader()
+        {
+            if (!SystemInfo.supportsComputeShaders)
+            {
+                Assert.Ignore("Compute shaders are not supported.");
+            }
+
+            if (!GraphicsSettings.TryGetRenderPipelineSettings(out AAAARenderPipelineRuntimeShaders shaders) || shaders.GPUInstanceCullingCS == null)
+            {
+                Assert.Ignore("AAAA RP runtime shaders are not available.");
+            }
+
+            return shaders.GPUInstanceCullingCS;
+        }
+
+        private static HashSet<(int ContextIndex, uint InstanceID)> DispatchInstanceCulling(ComputeShader shader, AAAACullingTestScene scene,
+            bool multiView, AAAAGPUCullingDebugData[] debugData)
+        {
+            int instanceCount = scene.Instances.Length;
+            int contextCount = scene.ContextCount;
+
+            int maxJobsPerContext = 0;
+            foreach (AAAAInstanceData instanceData in scene.Instances)
+            {
+                maxJobsPerContext += (int) math.ceil((float) instanceData.TotalMeshLODCount / AAAAMeshletListBuildJob.MaxLODNodesPerThreadGroup);
+            }
+
+            var cullingContexts = new NativeArray<GPUCullingContext>(GPUCullingContext.MaxCullingContextsPerBatch, Allocator.Temp);
+
+            for (int contextIndex = 0; contextIndex < contextCount; contextIndex++)
+            {
+                GPUCullingContext cullingContext = scene.CullingContexts[contextIndex];
+                cullingContext.InstanceIndicesOffset = 0;
+                cullingContext.InstanceIndicesCount = (uint) instanceCount;
+                cullingContext.MeshletListBuildJobsOffset = (uint) (contextIndex * maxJobsPerContext);
+                cullingContexts[contextIndex] = cullingContext;
+            }
+
+            using var cullingContextBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Constant, cullingContexts.Length,
+                UnsafeUtility.SizeOf<GPUCullingContext>()
+            );
+            cullingContextBuffer.SetData(cullingContexts);
+            cullingContexts.Dispose();
+
+            using var instanceIndicesBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw, instanceCount, sizeof(int));
+            instanceIndicesBuffer.SetData(scene.InstanceIndices);
+
+            using GraphicsBuffer instanceDataBuffer = CreateInstanceDataBuffer(scene.Instances);
+
+            using var jobsBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, contextCount * maxJobsPerContext,
+                UnsafeUtility.SizeOf<AAAAMeshletListBuildJob>()
+            );
+            using var jobCountersBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw, GPUCullingContext.MaxCullingContextsPerBatch, sizeof(uint));
+            jobCountersBuffer.SetData(new uint[GPUCullingContext.MaxCullingContextsPerBatch]);
+            using var indirectArgsBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw, 3, sizeof(uint));
+            indirectArgsBuffer.SetData(new uint[3]);
+            using var visibilityMaskBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw, (instanceCount + 31) / 32, sizeof(uint));
+            visibilityMaskBuffer.SetData(new uint[visibilityMaskBuffer.count]);
+            using var debugDataBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, debugData.Length, UnsafeUtility.SizeOf<AAAAGPUCullingDebugData>());
+            debugDataBuffer.SetData(new AAAAGPUCullingDebugData[debugData.Length]);
+
+            const int kernelIndex = 0;
+
+            CoreUtils.SetKeyword(shader, "MAIN_PASS", false);
+            CoreUtils.SetKeyword(shader, "FALSE_NEGATIVE_PASS", false);
+            CoreUtils.SetKeyword(shader, "VOXELIZATION_PASS", false);
+            CoreUtils.SetKeyword(shader, "DISABLE_OCCLUSION_CULLING", false);
+            CoreUtils.SetKeyword(shader, "MULTI_VIEW", multiView);
+            CoreUtils.SetKeyword(shader, "DEBUG_GPU_CULLING", true);
+
+            shader.SetConstantBuffer("_CullingContexts", cullingContextBuffer, 0, contextCount * UnsafeUtility.SizeOf<GPUCullingContext>());
+            shader.SetInt("_CullingContextCount", contextCount);
+            shader.SetBuffer(kernelIndex, "_InstanceIndices", instanceIndicesBuffer);
+            shader.SetBuffer(kernelIndex, "_InstanceData", instanceDataBuffer);
+            shader.SetBuffer(kernelIndex, "_Jobs", jobsBuffer);
+            shader.SetBuffer(kernelIndex, "_JobCounters", jobCountersBuffer);
+            shader.SetBuffer(kernelIndex, "_MeshletListBuildIndirectArgs", indirectArgsBuffer);
+            shader.SetBuffer(kernelIndex, "_OcclusionCulling_InstanceVisibilityMask", visibilityMaskBuffer);
+            shader.SetBuffer(kernelIndex, "_OcclusionCulling_PrevInstanceVisibilityMask", visibilityMaskBuffer);
+            shader.SetBuffer(kernelIndex, "_GPUCullingDebugDataBuffer", debugDataBuffer);
+
+            const int groupSize = (int) AAAAMeshletComputeShaders.GPUInstanceCullingThreadGroupSize;
+            shader.Dispatch(kernelIndex, (instanceCount + groupSize - 1) / groupSize, multiView ? 1 : contextCount, 1);
+
+            var jobCounters = new uint[GPUCullingContext.MaxCullingContextsPerBatch];
+            jobCountersBuffer.GetData(jobCounters);
+            var jobs = new AAAAMeshletListBuildJob[jobsBuffer.count];
+            jobsBuffer.GetData(jobs);
+            debugDataBuffer.GetData(debugData);
+
+            var visibleInstances = new HashSet<(int ContextIndex, uint InstanceID)>();
+
+            for (int contextIndex = 0; contextIndex < contextCount; contextIndex++)
+            {
+                Assert.LessOrEqual(jobCounters[contextIndex], maxJobsPerContext);
+
+                for (int jobIndex = 0; jobIndex < jobCounters[contextIndex]; jobIndex++)
+                {
+                    AAAAMeshletListBuildJob job = jobs[contextIndex * maxJobsPerContext + jobIndex];
+                    AddVisibleInstance(visibleInstances, job.InstanceID, job.ViewMask);
+                }
+            }
+
+            return visibleInstances;
+        }
+
+        private static GraphicsBuffer CreateInstanceDataBuffer(NativeArray<AAAAInstanceData> instances)
+        {
+            if (!AAAAInstanceConfiguration.CompactInstanceDataEnabled)
+            {
+                var buffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, instances.Length, UnsafeUtility.SizeOf<AAAAInstanceData>());
+                buffer.SetData(instances);
+                return buffer;
+            }
+
+            var compactInstances = new NativeArray<AAAACompactInstanceData>(instances.Length, Allocator.Temp);
+
+            for (int i = 0; i < instances.Length; i++)
+            {
+                compactInstances[i] = AAAACompactInstanceData.Pack(instances[i]);
+            }
+
+            var compactBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, instances.Length, UnsafeUtility.SizeOf<AAAACompactInstanceData>());
+            compactBuffer.SetData(compactInstances);
+            compactInstances.Dispose();
+            return compactBuffer;
+        }
+
+        // Multi-view jobs are all emitted to the first context, with a bit per context that sees the instance.
+        private static void AddVisibleInstance(HashSet<(int ContextIndex, uint InstanceID)> visibleInstances, uint instanceID, uint viewMask)
+        {
+            for (int contextIndex = 0; contextIndex < GPUCullingContext.MaxCullingContextsPerBatch; contextIndex++)
+            {
+                if ((viewMask & 1u << contextIndex) != 0)
+                {
+                    visibleInstances.Add((contextIndex, instanceID));
+                }
+            }
+        }
+
+        // The GPU may round the bounding sphere test differently, and compact instance data rounds the AABB outwards.
+        // Mismatches are only accepted for instances that touch a culling plane.
+        private static int AssertMatchesUpToPrecision(AAAACullingTestScene scene, HashSet<(int ContextIndex, uint InstanceID)> expected,
+            HashSet<(int ContextIndex, uint InstanceID)> actual)
+        {
+            var mismatches = new HashSet<(int ContextIndex, uint InstanceID)>(expected);
+            mismatches.SymmetricExceptWith(actual);
+
+            foreach ((int contextIndex, uint instanceID) in mismatches)
+            {
+                Assert.IsTrue(IsOnCullingBoundary(scene, contextIndex, instanceID),
+                    $"Instance {instanceID} in context {contextIndex}: CPU {expected.Contains((contextIndex, instanceID))}, " +
+                    $"GPU {actual.Contains((contextIndex, instanceID))}."
+                );
+            }
+
+            Assert.LessOrEqual(mismatches.Count, math.max(1, expected.Count / 100));
+            return mismatches.Count;
+        }
+
+        private static bool IsOnCullingBoundary(AAAACullingTestScene scene, int contextIndex, uint instanceID)
+        {
+            AAAAInstanceData instanceData = scene.Instances[(int) instanceID];
+            AAAACullingMath.TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                out float3 aabbMinWS, out float3 aabbMaxWS
+            );
+            float4 boundingSphereWS = AAAACullingMath.AABBToBoundingSphere(aabbMinWS, aabbMaxWS);
+            float epsilon = 1e-3f + boundingSphereWS.w * 1e-2f;
+
+            return IsSphereVisible(scene, contextIndex, boundingSphereWS + new float4(0, 0, 0, epsilon)) !=
+                   IsSphereVisible(scene, contextIndex, boundingSphereWS - new float4(0, 0, 0, epsilon));
+        }
+
+        private static bool IsSphereVisible(AAAACullingTestScene scene, int contextIndex, float4 boundingSphereWS)
+        {
+            var view = AAAACPUCullingPipeline.CullingView.Create(scene.CullingContexts[contextIndex]);
+            return view.FrustumVsSphereCulling(boundingSphereWS) &&
+                   AAAACullingMath.LightSphereCulling(view.CullingSphereLS, view.ViewMatrix, boundingSphereWS);
+        }
+    }
+}
@@ -0,0 +1,297 @@
+using System.Collections.Generic;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Passes;
+using NUnit.Framework;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAGeometryBudgetControllerTests
+    {
+        private const uint TargetTriangles = 2_000_000;
+
+        // Visible triangles (in millions) at the authored LOD error threshold. Hand-authored to resemble a camera flying into a dense area,
+        // out of it and back in. The test against AAAACPUCullingPipeline below measures real LOD selection instead.
+        private static readonly float[] SyntheticCameraSweep =
+        {
+            1.2f, 1.4f, 1.9f, 2.6f, 3.4f, 4.5f, 5.6f, 6.8f, 7.6f, 7.8f, 7.2f, 6.1f, 5.0f, 4.2f, 3.9f, 4.1f,
+            4.8f, 5.5f, 5.9f, 5.7f, 5.0f, 4.1f, 3.2f, 2.6f, 2.2f, 2.0f, 2.1f, 2.3f, 2.4f, 2.4f, 2.3f, 2.2f,
+        };
+
+        [Test] [Category("AAAA RP")]
+        public void ConstantScene_ConvergesWithoutOscillation([Values(1.0f, 2.0f)] float lodResponse, [Values(0, 3)] int readbackLatency)
+        {
+            var controller = new AAAAGeometryBudgetController(CreateSettings());
+            var scene = new SimulatedScene(controller, lodResponse, readbackLatency, 0.02f, 1u);
+
+            for (int frame = 0; frame < 150; frame++)
+            {
+                scene.Step(6_000_000);
+            }
+
+            Assert.That(scene.CountDirectionReversals(), Is.LessThanOrEqualTo(2));
+            Assert.That(scene.MaxAbsLogError(30), Is.LessThanOrEqualTo(controller.ControllerSettings.ReleaseBand));
+            Assert.That(controller.IsSettled, Is.True);
+            Assert.That(controller.ErrorMultiplier, Is.GreaterThan(1.0f));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SyntheticCameraSweep_StaysWithinBudget([Values(1.0f, 2.0f)] float lodResponse, [Values(0, 3)] int readbackLatency)
+        {
+            var controller = new AAAAGeometryBudgetController(CreateSettings());
+            var scene = new SimulatedScene(controller, lodResponse, readbackLatency, 0.02f, 1u);
+
+            const int framesPerSample = 8;
+            for (int i = 0; i < SyntheticCameraSweep.Length - 1; i++)
+            {
+                for (int frame = 0; frame < framesPerSample; frame++)
+                {
+                    float t = frame / (float) framesPerSample;
+                    scene.Step(math.lerp(SyntheticCameraSweep[i], SyntheticCameraSweep[i + 1], t) * 1_000_000);
+                }
+            }
+
+            for (int frame = 0; frame < 60; frame++)
+            {
+                scene.Step(SyntheticCameraSweep[SyntheticCameraSweep.Length - 1] * 1_000_000);
+            }
+
+            // The controller lags behind the camera, so a bounded overshoot while the density ramps up is expected.
+            Assert.That(scene.MaxTrianglesRatio(), Is.LessThanOrEqualTo(1.5f));
+            Assert.That(scene.CountDirectionReversals(), Is.LessThanOrEqualTo(6));
+            Assert.That(scene.MaxAbsLogError(30), Is.LessThanOrEqualTo(controller.ControllerSettings.ReleaseBand));
+            Assert.That(controller.IsSettled, Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Hysteresis_HoldsMultiplierUnderNoise([Values(1u, 2u, 3u)] uint seed)
+        {
+            var controller = new AAAAGeometryBudgetController(CreateSettings());
+            var scene = new SimulatedScene(controller, 2.0f, 3, 0.03f, seed);
+
+            for (int frame = 0; frame < 100; frame++)
+            {
+                scene.Step(4_000_000);
+            }
+
+            Assert.That(controller.IsSettled, Is.True);
+            float settledMultiplier = controller.ErrorMultiplier;
+
+            for (int frame = 0; frame < 100; frame++)
+            {
+                scene.Step(4_000_000);
+                Assert.That(controller.ErrorMultiplier, Is.EqualTo(settledMultiplier));
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void UnderBudget_KeepsAuthoredLOD()
+        {
+            var controller = new AAAAGeometryBudgetController(CreateSettings());
+            var scene = new SimulatedScene(controller, 2.0f, 3, 0.02f, 1u);
+
+            for (int frame = 0; frame < 100; frame++)
+            {
+                scene.Step(1_000_000);
+            }
+
+            Assert.That(controller.ErrorMultiplier, Is.EqualTo(1.0f));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void MeshletBudget_IsHonoured()
+        {
+            AAAAGeometryBudgetController.Settings settings = CreateSettings();
+            settings.TargetMeshletCount = 10_000;
+            var controller = new AAAAGeometryBudgetController(settings);
+            var scene = new SimulatedScene(controller, 2.0f, 3, 0.0f, 1u);
+
+            // Small meshlets: the meshlet budget is exceeded more than the triangle budget.
+            for (int frame = 0; frame < 150; frame++)
+            {
+                scene.Step(3_000_000, 32);
+            }
+
+            Assert.That(scene.LastVisibleMeshlets, Is.LessThanOrEqualTo(10_000 * math.exp(settings.ReleaseBand)));
+            Assert.That(scene.LastVisibleTriangles, Is.LessThan(TargetTriangles));
+        }
+
+        // Closes the loop through the CPU reference of GPU culling: the multiplier scales the LOD error threshold, and the visible triangles
+        // come from its GPU culling counters, delayed like async readbacks. The camera dollies towards the scene and then stops.
+        [Test] [Category("AAAA RP")]
+        public void CPUCullingPipeline_CameraDolly_ConvergesToBudget([Values(0, 3)] int readbackLatency)
+        {
+            using var scene = new AAAACullingTestScene(2048, 1);
+            var random = new Random(1u);
+            scene.Randomize(ref random, 100.0f);
+            using var pipeline = new AAAACPUCullingPipeline();
+
+            const float startDistance = 400.0f;
+            const float endDistance = 200.0f;
+            const int dollyFrameCount = 120;
+
+            // Calibrate at the final pose: start from the largest threshold that keeps nearly all leaf meshlets,
+            // and aim halfway between the authored LOD and the coarsest LOD the controller may select.
+            SetCameraDistance(scene, endDistance);
+            uint finestTriangles = CountVisibleTriangles(scene, pipeline, 1e-6f);
+            float authoredThreshold = 1e-6f;
+            while (authoredThreshold < 1e6f && CountVisibleTriangles(scene, pipeline, authoredThreshold * 2.0f) >= finestTriangles * 0.95f)
+            {
+                authoredThreshold *= 2.0f;
+            }
+
+            AAAAGeometryBudgetController.Settings settings = AAAAGeometryBudgetController.Settings.Default;
+            uint authoredTriangles = CountVisibleTriangles(scene, pipeline, authoredThreshold);
+            uint coarsestTriangles = CountVisibleTriangles(scene, pipeline, authoredThreshold * settings.MaxErrorMultiplier);
+            Assert.Greater(authoredTriangles, coarsestTriangles * 1.5f, "The scene is expected to have a useful LOD range.");
+
+            settings.TargetTriangleCount = (authoredTriangles + coarsestTriangles) / 2;
+            var controller = new AAAAGeometryBudgetController(settings);
+            var pendingReadbacks = new Queue<uint>();
+            var trianglesRatios = new List<float>();
+
+            for (int frame = 0; frame < dollyFrameCount + 90; frame++)
+            {
+                SetCameraDistance(scene, math.lerp(startDistance, endDistance, math.saturate(frame / (float) dollyFrameCount)));
+                uint visibleTriangles = CountVisibleTriangles(scene, pipeline, authoredThreshold * controller.ErrorMultiplier);
+                trianglesRatios.Add(visibleTriangles / (float) settings.TargetTriangleCount);
+
+                pendingReadbacks.Enqueue(visibleTriangles);
+                if (pendingReadbacks.Count > readbackLatency)
+                {
+                    controller.Update(0, pendingReadbacks.Dequeue());
+                }
+            }
+
+            for (int i = trianglesRatios.Count - 30; i < trianglesRatios.Count; i++)
+            {
+                Assert.That(math.abs(math.log(trianglesRatios[i])), Is.LessThanOrEqualTo(settings.ReleaseBand));
+            }
+
+            Assert.That(controller.IsSettled, Is.True);
+            Assert.That(controller.ErrorMultiplier, Is.GreaterThan(1.0f));
+        }
+
+        private static void SetCameraDistance(AAAACullingTestScene scene, float distance)
+        {
+            var position = new float3(0, 0, -distance);
+            scene.SetView(0, position, quaternion.identity, AAAAInstancePassMask.Main);
+        }
+
+        private static uint CountVisibleTriangles(AAAACullingTestScene scene, AAAACPUCullingPipeline pipeline, float meshLODErrorThreshold)
+        {
+            pipeline.Run(scene.ToInputs(), AAAACPUCullingPipeline.Settings.Create(GPUCullingPass.PassType.Basic, meshLODErrorThreshold));
+
+            uint visibleTriangles = 0;
+            foreach (AAAAGPUCullingDebugData item in pipeline.DebugData)
+            {
+                visibleTriangles += item.VisibleTriangles;
+            }
+
+            return visibleTriangles;
+        }
+
+        private static AAAAGeometryBudgetController.Settings CreateSettings()
+        {
+            AAAAGeometryBudgetController.Settings settings = AAAAGeometryBudgetController.Settings.Default;
+            settings.TargetTriangleCount = TargetTriangles;
+            return settings;
+        }
+
+        // Visible geometry falls off as a power of the error multiplier. The counters reach the controller with a delay, like async readbacks do.
+        private sealed class SimulatedScene
+        {
+            private readonly AAAAGeometryBudgetController _controller;
+            private readonly float _lodResponse;
+            private readonly float _noise;
+            private readonly Queue<(uint Meshlets, uint Triangles)> _pendingReadbacks = new();
+            private readonly int _readbackLatency;
+            private readonly List<float> _multipliers = new();
+            private readonly List<float> _trianglesRatios = new();
+            private Random _random;
+
+            public SimulatedScene(AAAAGeometryBudgetController controller, float lodResponse, int readbackLatency, float noise, uint seed)
+            {
+                _controller = controller;
+                _lodResponse = lodResponse;
+                _readbackLatency = readbackLatency;
+                _noise = noise;
+                _random = new Random(seed);
+            }
+
+            public uint LastVisibleMeshlets { get; private set; }
+            public uint LastVisibleTriangles { get; private set; }
+
+            public void Step(float trianglesAtAuthoredLOD, float trianglesPerMeshlet = 124)
+            {
+                float triangles = trianglesAtAuthoredLOD * math.pow(_controller.ErrorMultiplier, -_lodResponse);
+                triangles *= 1.0f + _random.NextFloat(-_noise, _noise);
+
+                LastVisibleTriangles = (uint) triangles;
+                LastVisibleMeshlets = (uint) (triangles / trianglesPerMeshlet);
+                _trianglesRatios.Add(triangles / TargetTriangles);
+
+                _pendingReadbacks.Enqueue((LastVisibleMeshlets, LastVisibleTriangles));
+                if (_pendingReadbacks.Count > _readbackLatency)
+                {
+                    (uint meshlets, uint visibleTriangles) = _pendingReadbacks.Dequeue();
+                    _controller.Update(meshlets, visibleTriangles);
+                }
+
+                _multipliers.Add(_controller.ErrorMultiplier);
+            }
+
+            public int CountDirectionReversals()
+            {
+                int reversals = 0;
+                int lastDirection = 0;
+
+                for (int i = 1; i < _multipliers.Count; i++)
+                {
+                    int direction = (int) math.sign(_multipliers[i] - _multipliers[i - 1]);
+                    if (direction == 0)
+                    {
+                        continue;
+                    }
+
+                    if (lastDirection != 0 && direction != lastDirection)
+                    {
+                        ++reversals;
+                    }
+
+                    lastDirection = direction;
+                }
+
+                return reversals;
+            }
+
+            public float MaxAbsLogError(int lastFrameCount)
+            {
+                float maxError = 0.0f;
+
+                for (int i = _trianglesRatios.Count - lastFrameCount; i < _trianglesRatios.Count; i++)
+                {
+                    maxError = math.max(maxError, math.abs(math.log(_trianglesRatios[i])));
+                }
+
+                return maxError;
+            }
+
+            public float MaxTrianglesRatio()
+            {
+                float maxRatio = 0.0f;
+
+                foreach (float ratio in _trianglesRatios)
+                {
+                    maxRatio = math.max(maxRatio, ratio);
+                }
+
+                return maxRatio;
+            }
+        }
+    }
+}
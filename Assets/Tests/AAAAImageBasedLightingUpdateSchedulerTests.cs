@@ -0,0 +1,225 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Mathematics;
+using Target = DELTation.AAAARP.Lighting.AAAAImageBasedLightingUpdateScheduler.Target;
+
+namespace Tests
+{
+    public class AAAAImageBasedLightingUpdateSchedulerTests
+    {
+        private const int DiffuseResolution = 32;
+        private const double DiffuseSamplesPerTexel = 1000;
+        private const int PreFilterResolution = 64;
+        private const int PreFilterMipCount = 4;
+        private const double PreFilterSamplesPerTexel = 100;
+
+        [Test] [Category("AAAA RP")]
+        public void Update_CoversEveryRowOnce_AndFinishesOnce([Values(0.01f, 0.5f, 1000.0f)] float budgetMs)
+        {
+            AAAAImageBasedLightingUpdateScheduler scheduler = CreateScheduler();
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            var coveredRows = new Dictionary<(Target, int, int), bool[]>();
+            int finishedCount = 0;
+
+            for (int frame = 0; frame < 100_000 && scheduler.IsUpdating; frame++)
+            {
+                if (scheduler.ScheduleFrame(frame, budgetMs, slices))
+                {
+                    ++finishedCount;
+                }
+
+                Assert.That(slices, Is.Not.Empty);
+
+                foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in slices)
+                {
+                    (Target, int, int) key = (slice.Target, slice.MipIndex, slice.SideIndex);
+                    if (!coveredRows.TryGetValue(key, out bool[] rows))
+                    {
+                        rows = coveredRows[key] = new bool[GetResolution(slice.Target, slice.MipIndex)];
+                    }
+
+                    for (int row = slice.FirstRow; row < slice.FirstRow + slice.RowCount; row++)
+                    {
+                        Assert.That(rows[row], Is.False);
+                        rows[row] = true;
+                    }
+                }
+            }
+
+            Assert.That(scheduler.IsUpdating, Is.False);
+            Assert.That(finishedCount, Is.EqualTo(1));
+            Assert.That(coveredRows.Count, Is.EqualTo(6 * (1 + PreFilterMipCount)));
+
+            foreach (bool[] rows in coveredRows.Values)
+            {
+                Assert.That(rows, Is.All.True);
+            }
+
+            Assert.That(scheduler.ScheduleFrame(100_000, budgetMs, slices), Is.False);
+            Assert.That(slices, Is.Empty);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Frames_StayWithinBudget_ButScheduleAtLeastOneRow()
+        {
+            AAAAImageBasedLightingUpdateScheduler scheduler = CreateScheduler();
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            const float budgetMs = 0.05f;
+            double budgetSamples = budgetMs / scheduler.EstimatedMsPerSample;
+
+            for (int frame = 0; scheduler.IsUpdating; frame++)
+            {
+                scheduler.ScheduleFrame(frame, budgetMs, slices);
+
+                double sampleCount = 0.0;
+                int rowCount = 0;
+                foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in slices)
+                {
+                    sampleCount += slice.RowCount * GetResolution(slice.Target, slice.MipIndex) * GetSamplesPerTexel(slice.Target);
+                    rowCount += slice.RowCount;
+                }
+
+                Assert.That(sampleCount <= budgetSamples || rowCount == 1, Is.True);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SlowerMeasuredGPUTime_SchedulesFewerRows()
+        {
+            var scheduler = new AAAAImageBasedLightingUpdateScheduler();
+            scheduler.AddCubemapMip(Target.DiffuseIrradiance, 0, 512, 10_000);
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            const float budgetMs = 2.0f;
+
+            scheduler.ScheduleFrame(0, budgetMs, slices);
+            int initialRowCount = CountRows(slices);
+
+            for (int frame = 1; frame <= 20; frame++)
+            {
+                // Every frame takes four times the budget on this GPU.
+                scheduler.ReportGPUTime(budgetMs * 4.0, frame - AAAAImageBasedLightingUpdateScheduler.GPUTimeLatencyFrames);
+                scheduler.ScheduleFrame(frame, budgetMs, slices);
+            }
+
+            Assert.That(scheduler.EstimatedMsPerSample, Is.GreaterThan(AAAAImageBasedLightingUpdateScheduler.InitialMsPerSample));
+            Assert.That(CountRows(slices), Is.LessThan(initialRowCount));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void LaggedGPUTime_IsMatchedToTheFrameItMeasured()
+        {
+            var scheduler = new AAAAImageBasedLightingUpdateScheduler();
+            scheduler.AddCubemapMip(Target.DiffuseIrradiance, 0, 512, 10_000);
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            const double msPerSample = AAAAImageBasedLightingUpdateScheduler.InitialMsPerSample * 2.0;
+
+            // The budget changes every frame, so that neighbouring frames do different amounts of work.
+            var frameSampleCounts = new double[8];
+            for (int frame = 0; frame < frameSampleCounts.Length; frame++)
+            {
+                scheduler.ScheduleFrame(frame, frame % 2 == 0 ? 0.5f : 4.0f, slices);
+                frameSampleCounts[frame] = CountSamples(slices, 512, 10_000);
+            }
+
+            Assert.That(frameSampleCounts[4], Is.Not.EqualTo(frameSampleCounts[5]).Within(1.0));
+
+            // Timings arrive out of step with the scheduling, but each one is divided by the work of its own frame.
+            scheduler.ReportGPUTime(frameSampleCounts[4] * msPerSample, 4);
+            scheduler.ReportGPUTime(frameSampleCounts[5] * msPerSample, 5);
+
+            double expectedEstimate = AAAAImageBasedLightingUpdateScheduler.InitialMsPerSample;
+            expectedEstimate = math.lerp(expectedEstimate, msPerSample, 0.25);
+            expectedEstimate = math.lerp(expectedEstimate, msPerSample, 0.25);
+            Assert.That(scheduler.EstimatedMsPerSample, Is.EqualTo(expectedEstimate).Within(1e-6).Percent);
+
+            // A timing is used once, and timings of frames that were never scheduled (e.g., before the first one) are ignored.
+            scheduler.ReportGPUTime(frameSampleCounts[5] * msPerSample * 10.0, 5);
+            scheduler.ReportGPUTime(1.0, 0 - AAAAImageBasedLightingUpdateScheduler.GPUTimeLatencyFrames);
+            scheduler.ReportGPUTime(1.0, 100);
+            Assert.That(scheduler.EstimatedMsPerSample, Is.EqualTo(expectedEstimate).Within(1e-6).Percent);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SeveralCameras_ScheduleOncePerFrame()
+        {
+            AAAAImageBasedLightingUpdateScheduler scheduler = CreateScheduler();
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            const float budgetMs = 0.01f;
+
+            scheduler.ScheduleFrame(1, budgetMs, slices);
+            Assert.That(slices, Is.Not.Empty);
+            AAAAImageBasedLightingUpdateScheduler.Slice lastSlice = slices[^1];
+
+            Assert.That(scheduler.ScheduleFrame(1, budgetMs, slices), Is.False);
+            Assert.That(slices, Is.Empty);
+
+            // The next frame continues right where the first camera of the previous one stopped.
+            scheduler.ScheduleFrame(2, budgetMs, slices);
+            Assert.That(slices, Is.Not.Empty);
+            Assert.That(slices[0].Target, Is.EqualTo(lastSlice.Target));
+            Assert.That(slices[0].SideIndex, Is.EqualTo(lastSlice.SideIndex));
+            Assert.That(slices[0].FirstRow, Is.EqualTo(lastSlice.FirstRow + lastSlice.RowCount));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Restart_DiscardsPendingWork()
+        {
+            AAAAImageBasedLightingUpdateScheduler scheduler = CreateScheduler();
+            var slices = new List<AAAAImageBasedLightingUpdateScheduler.Slice>();
+            scheduler.ScheduleFrame(0, 0.01f, slices);
+            Assert.That(scheduler.IsUpdating, Is.True);
+
+            scheduler.Restart();
+            Assert.That(scheduler.IsUpdating, Is.False);
+
+            scheduler.AddCubemapMip(Target.PreFilteredEnvironmentMap, 0, PreFilterResolution, PreFilterSamplesPerTexel);
+            scheduler.ScheduleFrame(1, 0.01f, slices);
+            Assert.That(slices[0].Target, Is.EqualTo(Target.PreFilteredEnvironmentMap));
+            Assert.That(slices[0].FirstRow, Is.Zero);
+        }
+
+        private static AAAAImageBasedLightingUpdateScheduler CreateScheduler()
+        {
+            var scheduler = new AAAAImageBasedLightingUpdateScheduler();
+            scheduler.AddCubemapMip(Target.DiffuseIrradiance, 0, DiffuseResolution, DiffuseSamplesPerTexel);
+
+            for (int mipIndex = 0; mipIndex < PreFilterMipCount; mipIndex++)
+            {
+                scheduler.AddCubemapMip(Target.PreFilteredEnvironmentMap, mipIndex, GetResolution(Target.PreFilteredEnvironmentMap, mipIndex),
+                    PreFilterSamplesPerTexel
+                );
+            }
+
+            return scheduler;
+        }
+
+        private static int GetResolution(Target target, int mipIndex) =>
+            target == Target.DiffuseIrradiance ? DiffuseResolution : PreFilterResolution >> mipIndex;
+
+        private static double GetSamplesPerTexel(Target target) =>
+            target == Target.DiffuseIrradiance ? DiffuseSamplesPerTexel : PreFilterSamplesPerTexel;
+
+        private static double CountSamples(List<AAAAImageBasedLightingUpdateScheduler.Slice> slices, int resolution, double samplesPerTexel)
+        {
+            double sampleCount = 0.0;
+            foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in slices)
+            {
+                sampleCount += slice.RowCount * resolution * samplesPerTexel;
+            }
+
+            return sampleCount;
+        }
+
+        private static int CountRows(List<AAAAImageBasedLightingUpdateScheduler.Slice> slices)
+        {
+            int rowCount = 0;
+            foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in slices)
+            {
+                rowCount += slice.RowCount;
+            }
+
+            return rowCount;
+        }
+    }
+}
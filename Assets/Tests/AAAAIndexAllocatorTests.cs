@@ -0,0 +1,308 @@
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Threading;
+using DELTation.AAAARP.Core;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Jobs;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAIndexAllocatorTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void AllocateBatch_MatchesSequentialAllocate([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            const bool autoGrow = true;
+            using var sequentialAllocator = new AAAAIndexAllocator(64, Allocator.Persistent, autoGrow);
+            using var batchAllocator = new AAAAIndexAllocator(64, Allocator.Persistent, autoGrow);
+            var sequentialAllocations = new List<AAAAIndexAllocator.IndexAllocation>();
+            var batchAllocations = new List<AAAAIndexAllocator.IndexAllocation>();
+
+            for (int iteration = 0; iteration < 100; iteration++)
+            {
+                if (random.NextBool() || batchAllocations.Count == 0)
+                {
+                    int count = random.NextInt(0, 100);
+                    using var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(count, Allocator.Temp);
+                    Assert.IsTrue(batchAllocator.AllocateBatch(count, allocations));
+                    batchAllocations.AddRange(allocations);
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        sequentialAllocations.Add(sequentialAllocator.Allocate());
+                    }
+                }
+                else
+                {
+                    int count = random.NextInt(1, batchAllocations.Count + 1);
+                    int start = random.NextInt(0, batchAllocations.Count - count + 1);
+                    using var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(batchAllocations.GetRange(start, count).ToArray(),
+                        Allocator.Temp
+                    );
+                    batchAllocator.FreeBatch(allocations);
+                    batchAllocations.RemoveRange(start, count);
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        sequentialAllocator.Free(sequentialAllocations[start + i]);
+                    }
+
+                    sequentialAllocations.RemoveRange(start, count);
+                }
+
+                CollectionAssert.AreEqual(sequentialAllocations, batchAllocations);
+                Assert.AreEqual(sequentialAllocator.AllocatedCount, batchAllocator.AllocatedCount);
+                AssertUnique(batchAllocations);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void AllocateBatch_FailsWithoutAllocatingWhenFull()
+        {
+            using var allocator = new AAAAIndexAllocator(16, Allocator.Persistent);
+            using var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(17, Allocator.Temp);
+
+            Assert.IsTrue(allocator.AllocateBatch(10, allocations));
+            Assert.IsFalse(allocator.AllocateBatch(7, allocations));
+            Assert.AreEqual(10, allocator.AllocatedCount);
+            Assert.IsTrue(allocator.AllocateBatch(6, allocations));
+            Assert.IsTrue(allocator.IsFull);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ForceGrow_KeepsFreeIndices()
+        {
+            using var allocator = new AAAAIndexAllocator(4, Allocator.Persistent);
+            AAAAIndexAllocator.IndexAllocation first = allocator.Allocate();
+            allocator.Allocate();
+            allocator.Free(first);
+
+            allocator.ForceGrow(8);
+
+            var indices = new HashSet<int>();
+            while (!allocator.IsFull)
+            {
+                Assert.IsTrue(indices.Add(allocator.Allocate().Index));
+            }
+
+            Assert.AreEqual(7, indices.Count);
+            Assert.IsTrue(indices.Contains(first.Index));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Concurrent_MatchesSingleThreadedSemantics()
+        {
+            using var allocator = new AAAAConcurrentIndexAllocator(8, Allocator.Persistent);
+            using var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(8, Allocator.Temp);
+
+            using var tooManyAllocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(4, Allocator.Temp);
+
+            Assert.IsTrue(allocator.AllocateBatch(5, allocations));
+            Assert.IsFalse(allocator.AllocateBatch(4, tooManyAllocations));
+            Assert.AreEqual(5, allocator.AllocatedCount);
+
+            AAAAIndexAllocator.IndexAllocation allocation = allocations[2];
+            allocator.Free(allocation);
+            Assert.IsFalse(allocator.IsValidGeneration(allocation));
+
+            AAAAIndexAllocator.IndexAllocation reallocation = allocator.Allocate();
+            Assert.AreEqual(allocation.Index, reallocation.Index);
+            Assert.AreEqual(allocation.Generation + 1, reallocation.Generation);
+
+            Assert.IsTrue(allocator.AllocateBatch(3, allocations.GetSubArray(5, 3)));
+            Assert.AreEqual(AAAAIndexAllocator.InvalidAllocationIndex, allocator.Allocate().Index);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Concurrent_StressTest_ParallelAllocateAndFree([Values(1u, 2u, 3u)] uint seed)
+        {
+            const int capacity = 256;
+            const int jobCount = 1024;
+
+            using var allocator = new AAAAConcurrentIndexAllocator(capacity, Allocator.Persistent);
+            using var owners = new NativeArray<int>(capacity, Allocator.Persistent);
+            using var errors = new NativeArray<int>(1, Allocator.Persistent);
+
+            new AllocateAndFreeJob
+                {
+                    Allocator = allocator,
+                    Owners = owners,
+                    Errors = errors,
+                    Seed = seed,
+                    Rounds = 64,
+                }
+                .Schedule(jobCount, 1).Complete();
+
+            Assert.AreEqual(0, errors[0], "An index was owned by two jobs at once.");
+            Assert.AreEqual(0, allocator.AllocatedCount);
+
+            // Nothing was lost or duplicated in the free list.
+            using var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(capacity, Allocator.Temp);
+            Assert.IsTrue(allocator.AllocateBatch(capacity, allocations));
+            AssertUnique(allocations);
+            Assert.AreEqual(AAAAIndexAllocator.InvalidAllocationIndex, allocator.Allocate().Index);
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_1MAllocations()
+        {
+            const int count = 1_000_000;
+
+            var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(count, Allocator.Persistent);
+            var stopwatch = new Stopwatch();
+
+            using (var allocator = new AAAAIndexAllocator(count, Allocator.Persistent))
+            {
+                stopwatch.Restart();
+
+                for (int i = 0; i < count; i++)
+                {
+                    allocations[i] = allocator.Allocate();
+                }
+
+                for (int i = 0; i < count; i++)
+                {
+                    allocator.Free(allocations[i]);
+                }
+
+                Debug.Log($"{count} allocations: one at a time {stopwatch.Elapsed.TotalMilliseconds:F3} ms.");
+
+                stopwatch.Restart();
+                allocator.AllocateBatch(count, allocations);
+                allocator.FreeBatch(allocations);
+                Debug.Log($"{count} allocations: batch {stopwatch.Elapsed.TotalMilliseconds:F3} ms.");
+            }
+
+            using (var allocator = new AAAAConcurrentIndexAllocator(count, Allocator.Persistent))
+            {
+                stopwatch.Restart();
+
+                for (int i = 0; i < count; i++)
+                {
+                    allocations[i] = allocator.Allocate();
+                }
+
+                for (int i = 0; i < count; i++)
+                {
+                    allocator.Free(allocations[i]);
+                }
+
+                Debug.Log($"{count} allocations: concurrent allocator, one thread {stopwatch.Elapsed.TotalMilliseconds:F3} ms.");
+
+                stopwatch.Restart();
+                new AllocateJob { Allocator = allocator, Allocations = allocations }.Schedule(count, 4096).Complete();
+                new FreeJob { Allocator = allocator, Allocations = allocations }.Schedule(count, 4096).Complete();
+                Debug.Log($"{count} allocations: concurrent allocator, parallel jobs {stopwatch.Elapsed.TotalMilliseconds:F3} ms.");
+
+                Assert.AreEqual(0, allocator.AllocatedCount);
+            }
+
+            allocations.Dispose();
+        }
+
+        private static void AssertUnique(IEnumerable<AAAAIndexAllocator.IndexAllocation> allocations)
+        {
+            var indices = new HashSet<int>();
+
+            foreach (AAAAIndexAllocator.IndexAllocation allocation in allocations)
+            {
+                Assert.AreNotEqual(AAAAIndexAllocator.InvalidAllocationIndex, allocation.Index);
+                Assert.IsTrue(indices.Add(allocation.Index), $"Index {allocation.Index} was allocated twice.");
+            }
+        }
+
+        private unsafe struct AllocateAndFreeJob : IJobParallelFor
+        {
+            public AAAAConcurrentIndexAllocator Allocator;
+            [NativeDisableParallelForRestriction]
+            public NativeArray<int> Owners;
+            [NativeDisableParallelForRestriction]
+            public NativeArray<int> Errors;
+            public uint Seed;
+            public int Rounds;
+
+            public void Execute(int index)
+            {
+                var random = Random.CreateFromIndex(Seed * 7919u + (uint) index);
+                var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(8, Unity.Collections.Allocator.Temp);
+                var pOwners = (int*) Owners.GetUnsafePtr();
+
+                for (int round = 0; round < Rounds; round++)
+                {
+                    int count = random.NextInt(1, allocations.Length + 1);
+                    bool batch = random.NextBool();
+
+                    if (batch)
+                    {
+                        if (!Allocator.AllocateBatch(count, allocations))
+                        {
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        for (int i = 0; i < count; i++)
+                        {
+                            allocations[i] = Allocator.Allocate();
+                            if (allocations[i].Index == AAAAIndexAllocator.InvalidAllocationIndex)
+                            {
+                                count = i;
+                                break;
+                            }
+                        }
+                    }
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        if (Interlocked.Increment(ref pOwners[allocations[i].Index]) != 1)
+                        {
+                            Interlocked.Increment(ref ((int*) Errors.GetUnsafePtr())[0]);
+                        }
+                    }
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        Interlocked.Decrement(ref pOwners[allocations[i].Index]);
+                    }
+
+                    if (batch)
+                    {
+                        Allocator.FreeBatch(allocations.GetSubArray(0, count));
+                    }
+                    else
+                    {
+                        for (int i = 0; i < count; i++)
+                        {
+                            Allocator.Free(allocations[i]);
+                        }
+                    }
+                }
+
+                allocations.Dispose();
+            }
+        }
+
+        private struct AllocateJob : IJobParallelFor
+        {
+            public AAAAConcurrentIndexAllocator Allocator;
+            [WriteOnly]
+            public NativeArray<AAAAIndexAllocator.IndexAllocation> Allocations;
+
+            public void Execute(int index) => Allocations[index] = Allocator.Allocate();
+        }
+
+        private struct FreeJob : IJobParallelFor
+        {
+            public AAAAConcurrentIndexAllocator Allocator;
+            [ReadOnly]
+            public NativeArray<AAAAIndexAllocator.IndexAllocation> Allocations;
+
+            public void Execute(int index) => Allocator.Free(Allocations[index]);
+        }
+    }
+}
@@ -0,0 +1,399 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Core;
+using DELTation.AAAARP.Materials;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Renderers;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Jobs;
+using UnityEngine.Rendering;
+using Debug = UnityEngine.Debug;
+using Object = UnityEngine.Object;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAInstanceDataBufferTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void TransformUpdate_UpdatesMatricesAndWindingOrder()
+        {
+            using var metadata = CreateMetadata(2, out NativeArray<int> instanceIDs);
+            using var instances = new NativeArray<AAAAInstanceData>(2, Allocator.Persistent);
+            using var dirtyInstanceIndices = new NativeList<int>(Allocator.Persistent);
+
+            using var transformedIDs = new NativeArray<int>(new[] { instanceIDs[1], 12345 }, Allocator.Persistent);
+            float4x4 mirrored = float4x4.TRS(new float3(1, 2, 3), quaternion.RotateY(0.5f), new float3(-1, 2, 1));
+            using var localToWorldMatrices = new NativeArray<float4x4>(new[] { mirrored, float4x4.identity }, Allocator.Persistent);
+
+            InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, transformedIDs, localToWorldMatrices, dirtyInstanceIndices).Complete();
+            instanceIDs.Dispose();
+
+            Assert.AreEqual(1, dirtyInstanceIndices.Length);
+            Assert.AreEqual(1, dirtyInstanceIndices[0]);
+
+            AAAAInstanceData instanceData = instances[1];
+            Assert.AreEqual(mirrored, instanceData.ObjectToWorldMatrix);
+            Assert.IsTrue(IsIdentity(math.mul(instanceData.ObjectToWorldMatrix, instanceData.WorldToObjectMatrix)));
+            Assert.AreEqual(AAAAInstanceFlags.FlipWindingOrder, instanceData.Flags & AAAAInstanceFlags.FlipWindingOrder);
+
+            Assert.AreEqual(default(AAAAInstanceData).ObjectToWorldMatrix, instances[0].ObjectToWorldMatrix);
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_100KMovingInstances()
+        {
+            const int instanceCount = 100_000;
+            const int iterations = 10;
+
+            using var metadata = CreateMetadata(instanceCount, out NativeArray<int> instanceIDs);
+            using var instances = new NativeArray<AAAAInstanceData>(instanceCount, Allocator.Persistent);
+            using var dirtyInstanceIndices = new NativeList<int>(instanceCount, Allocator.Persistent);
+            var localToWorldMatrices = new NativeArray<float4x4>(instanceCount, Allocator.Persistent);
+
+            var random = new Random(42);
+
+            for (int i = 0; i < instanceCount; i++)
+            {
+                localToWorldMatrices[i] = float4x4.TRS(random.NextFloat3(-100, 100), random.NextQuaternionRotation(), random.NextFloat3(-2, 2));
+            }
+
+            // Warm up Burst compilation.
+            InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, instanceIDs, localToWorldMatrices, dirtyInstanceIndices).Complete();
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                dirtyInstanceIndices.Clear();
+                InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, instanceIDs, localToWorldMatrices, dirtyInstanceIndices).Complete();
+            }
+
+            stopwatch.Stop();
+            instanceIDs.Dispose();
+
+            Assert.AreEqual(instanceCount, dirtyInstanceIndices.Length);
+            Debug.Log($"Transform update of {instanceCount} instances: {stopwatch.Elapsed.TotalMilliseconds / iterations:F3} ms.");
+
+            localToWorldMatrices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void StressTest_1MInstances_CostFollowsChangedInstances()
+        {
+            const int instanceCount = 1_000_000;
+            const int changedInstanceCount = instanceCount / 100;
+
+            var stopwatch = Stopwatch.StartNew();
+
+            const bool autoGrow = true;
+            using var indexAllocator = new AAAAIndexAllocator(512, Allocator.Persistent, autoGrow);
+
+            for (int i = 0; i < instanceCount; i++)
+            {
+                AAAAIndexAllocator.IndexAllocation allocation = indexAllocator.Allocate();
+                Assert.AreEqual(i, allocation.Index);
+            }
+
+            double allocationMs = stopwatch.Elapsed.TotalMilliseconds;
+            Assert.GreaterOrEqual(indexAllocator.Capacity, instanceCount);
+            Assert.Less(indexAllocator.Capacity, instanceCount * 2);
+
+            using var metadata = CreateMetadata(instanceCount, out NativeArray<int> instanceIDs);
+            using var instances = new NativeArray<AAAAInstanceData>(instanceCount, Allocator.Persistent);
+            using var dirtyInstanceIndices = new NativeList<int>(instanceCount, Allocator.Persistent);
+            var localToWorldMatrices = new NativeArray<float4x4>(instanceCount, Allocator.Persistent);
+
+            for (int i = 0; i < instanceCount; i++)
+            {
+                localToWorldMatrices[i] = float4x4.Translate(new float3(i, 0, 0));
+            }
+
+            // Warm up Burst compilation.
+            InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, instanceIDs, localToWorldMatrices, dirtyInstanceIndices).Complete();
+
+            dirtyInstanceIndices.Clear();
+            stopwatch.Restart();
+            InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, instanceIDs, localToWorldMatrices, dirtyInstanceIndices).Complete();
+            double fullUpdateMs = stopwatch.Elapsed.TotalMilliseconds;
+            Assert.AreEqual(instanceCount, dirtyInstanceIndices.Length);
+
+            dirtyInstanceIndices.Clear();
+            NativeArray<int> changedIDs = instanceIDs.GetSubArray(0, changedInstanceCount);
+            NativeArray<float4x4> changedMatrices = localToWorldMatrices.GetSubArray(0, changedInstanceCount);
+            stopwatch.Restart();
+            InstanceDataBuffer.ScheduleTransformUpdate(metadata, instances, changedIDs, changedMatrices, dirtyInstanceIndices).Complete();
+            double partialUpdateMs = stopwatch.Elapsed.TotalMilliseconds;
+            Assert.AreEqual(changedInstanceCount, dirtyInstanceIndices.Length);
+
+            instanceIDs.Dispose();
+
+            Debug.Log($"{instanceCount} instances: allocation {allocationMs:F3} ms, full transform update {fullUpdateMs:F3} ms, " +
+                      $"{changedInstanceCount} changed transforms {partialUpdateMs:F3} ms."
+            );
+
+            localToWorldMatrices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void BulkRegistration_MatchesPerObjectPath()
+        {
+            using var scene = new TestRenderers(300, 3, 2, 1u);
+            scene.Renderers[5].ShadowCastingMode = ShadowCastingMode.ShadowsOnly;
+            scene.Renderers[7].LODErrorScale = 2.0f;
+            scene.Renderers[9].enabled = false;
+
+            using var perObjectMetadata = new NativeHashMap<int, InstanceDataBuffer.InstanceMetadata>(scene.Count, Allocator.Persistent);
+            using var perObjectInstances = new NativeArray<AAAAInstanceData>(scene.Count, Allocator.Persistent);
+            RegisterPerObject(scene, perObjectMetadata, perObjectInstances);
+
+            using var bulkMetadata = new NativeHashMap<int, InstanceDataBuffer.InstanceMetadata>(scene.Count, Allocator.Persistent);
+            using var bulkInstances = new NativeArray<AAAAInstanceData>(scene.Count, Allocator.Persistent);
+            using var instanceIndices = new NativeList<int>(Allocator.Persistent);
+            RegisterBulk(scene, scene.Renderers, bulkMetadata, bulkInstances, instanceIndices);
+
+            Assert.AreEqual(scene.Count, instanceIndices.Length);
+
+            for (int i = 0; i < scene.Count; i++)
+            {
+                int instanceID = scene.InstanceIDs[i];
+                Assert.AreEqual(perObjectMetadata[instanceID].IndexAllocation, bulkMetadata[instanceID].IndexAllocation);
+                Assert.AreEqual(perObjectMetadata[instanceID].MeshInstanceID, bulkMetadata[instanceID].MeshInstanceID);
+                Assert.AreEqual(i, bulkMetadata[instanceID].DenseIndex);
+                Assert.AreEqual(i, instanceIndices[i]);
+
+                AAAAInstanceData expected = perObjectInstances[i];
+                AAAAInstanceData actual = bulkInstances[i];
+                Assert.IsTrue(math.all(math.abs(expected.ObjectToWorldMatrix.c3 - actual.ObjectToWorldMatrix.c3) < 1e-4f));
+                Assert.IsTrue(IsIdentity(math.mul(actual.ObjectToWorldMatrix, actual.WorldToObjectMatrix)));
+                Assert.AreEqual(expected.AABBMin, actual.AABBMin);
+                Assert.AreEqual(expected.AABBMax, actual.AABBMax);
+                Assert.AreEqual(expected.TopMeshLODStartIndex, actual.TopMeshLODStartIndex);
+                Assert.AreEqual(expected.TotalMeshLODCount, actual.TotalMeshLODCount);
+                Assert.AreEqual(expected.MeshLODLevelCount, actual.MeshLODLevelCount);
+                Assert.AreEqual(expected.MaterialIndex, actual.MaterialIndex);
+                Assert.AreEqual(expected.LODErrorScale, actual.LODErrorScale);
+                Assert.AreEqual(expected.PassMask, actual.PassMask);
+                Assert.AreEqual(expected.Flags, actual.Flags);
+            }
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_BulkRegistration([Values(10_000, 50_000, 100_000)] int rendererCount)
+        {
+            using var scene = new TestRenderers(rendererCount, 64, 16, 42u);
+            using var metadata = new NativeHashMap<int, InstanceDataBuffer.InstanceMetadata>(rendererCount, Allocator.Persistent);
+            using var instances = new NativeArray<AAAAInstanceData>(rendererCount, Allocator.Persistent);
+            using var instanceIndices = new NativeList<int>(rendererCount, Allocator.Persistent);
+
+            // Warm up Burst compilation.
+            RegisterBulk(scene, scene.Renderers.GetRange(0, InstanceDataBuffer.BulkRegistrationThreshold), metadata, instances, instanceIndices);
+            metadata.Clear();
+            instanceIndices.Clear();
+
+            var stopwatch = Stopwatch.StartNew();
+            RegisterPerObject(scene, metadata, instances);
+            double perObjectMs = stopwatch.Elapsed.TotalMilliseconds;
+
+            metadata.Clear();
+            stopwatch.Restart();
+            RegisterBulk(scene, scene.Renderers, metadata, instances, instanceIndices);
+            double bulkMs = stopwatch.Elapsed.TotalMilliseconds;
+
+            Assert.AreEqual(rendererCount, metadata.Count);
+            Debug.Log($"Registration of {rendererCount} renderers: per-object {perObjectMs:F3} ms, bulk {bulkMs:F3} ms.");
+        }
+
+        // Mirrors the body of InstanceDataBuffer.OnRenderersChanged for new renderers, with the renderer container and material lookups stubbed out.
+        private static void RegisterPerObject(TestRenderers scene, NativeHashMap<int, InstanceDataBuffer.InstanceMetadata> metadata,
+            NativeArray<AAAAInstanceData> instances)
+        {
+            for (int index = 0; index < scene.Count; index++)
+            {
+                var rendererAuthoring = (AAAARendererAuthoring) scene.Changed[index];
+                AAAAMaterialAsset material = rendererAuthoring.Material;
+                AAAAMeshletCollectionAsset mesh = rendererAuthoring.Mesh;
+                if (material == null || mesh == null)
+                {
+                    continue;
+                }
+
+                var instanceData = new AAAAInstanceData();
+                InstanceDataBuffer.UpdateTransform(ref instanceData, rendererAuthoring.transform.localToWorldMatrix);
+
+                InstanceDataBuffer.MeshRecord meshRecord = scene.MeshRecords[mesh.GetInstanceID()];
+                InstanceDataBuffer.RendererRecord rendererRecord = InstanceDataBuffer.CreateRendererRecord(rendererAuthoring, 0, scene.MaterialIndices[material]);
+                InstanceDataBuffer.WriteRecords(ref instanceData, meshRecord, rendererRecord);
+                instances[index] = instanceData;
+
+                metadata.Add(scene.InstanceIDs[index], new InstanceDataBuffer.InstanceMetadata
+                    {
+                        IndexAllocation = new AAAAIndexAllocator.IndexAllocation { Index = index },
+                        DenseIndex = index,
+                        MeshInstanceID = meshRecord.MeshInstanceID,
+                    }
+                );
+            }
+        }
+
+        private static void RegisterBulk(TestRenderers scene, List<AAAARendererAuthoring> renderers,
+            NativeHashMap<int, InstanceDataBuffer.InstanceMetadata> metadata, NativeArray<AAAAInstanceData> instances, NativeList<int> instanceIndices)
+        {
+            int count = renderers.Count;
+            var batch = new InstanceDataBuffer.BulkRegistrationBatch();
+            var transforms = new TransformAccessArray(count);
+            var rendererRecords = new NativeArray<InstanceDataBuffer.RendererRecord>(count, Allocator.TempJob);
+            batch.Gather(renderers, material => scene.MaterialIndices[material], rendererRecords, transforms);
+
+            var meshRecords = new NativeArray<InstanceDataBuffer.MeshRecord>(batch.Meshes.Count, Allocator.TempJob);
+            for (int meshSlot = 0; meshSlot < batch.Meshes.Count; meshSlot++)
+            {
+                meshRecords[meshSlot] = scene.MeshRecords[batch.Meshes[meshSlot].GetInstanceID()];
+            }
+
+            var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(count, Allocator.TempJob);
+            for (int i = 0; i < count; i++)
+            {
+                allocations[i] = new AAAAIndexAllocator.IndexAllocation { Index = i };
+            }
+
+            var owners = new NativeList<int>(count, Allocator.TempJob);
+            var dirtyInstanceIndices = new NativeList<int>(count, Allocator.TempJob);
+            NativeArray<int> instanceIDs = scene.InstanceIDs.GetSubArray(0, count);
+
+            JobHandle registerHandle = InstanceDataBuffer.ScheduleBulkRegistration(metadata, instanceIDs, allocations, rendererRecords, meshRecords,
+                instanceIndices, owners, dirtyInstanceIndices
+            );
+            JobHandle fillHandle = InstanceDataBuffer.ScheduleBulkInstanceFill(transforms, allocations, rendererRecords, meshRecords, instances);
+            JobHandle.CombineDependencies(registerHandle, fillHandle).Complete();
+
+            Assert.AreEqual(count, dirtyInstanceIndices.Length);
+
+            dirtyInstanceIndices.Dispose();
+            owners.Dispose();
+            allocations.Dispose();
+            meshRecords.Dispose();
+            rendererRecords.Dispose();
+            transforms.Dispose();
+        }
+
+        // Renderer instance IDs are spread out, the same way Unity object IDs are.
+        private static NativeHashMap<int, InstanceDataBuffer.InstanceMetadata> CreateMetadata(int count, out NativeArray<int> instanceIDs)
+        {
+            var metadata = new NativeHashMap<int, InstanceDataBuffer.InstanceMetadata>(count, Allocator.Persistent);
+            instanceIDs = new NativeArray<int>(count, Allocator.Persistent);
+
+            for (int i = 0; i < count; i++)
+            {
+                int instanceID = -(i * 7 + 1000);
+                instanceIDs[i] = instanceID;
+                metadata.Add(instanceID, new InstanceDataBuffer.InstanceMetadata
+                    {
+                        IndexAllocation = new AAAAIndexAllocator.IndexAllocation { Index = i },
+                        DenseIndex = i,
+                    }
+                );
+            }
+
+            return metadata;
+        }
+
+        private static bool IsIdentity(float4x4 matrix)
+        {
+            const float epsilon = 1e-4f;
+            return math.all(math.abs(matrix.c0 - new float4(1, 0, 0, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c1 - new float4(0, 1, 0, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c2 - new float4(0, 0, 1, 0)) < epsilon) &&
+                   math.all(math.abs(matrix.c3 - new float4(0, 0, 0, 1)) < epsilon);
+        }
+
+        // Renderers of the same mesh and material come in runs, as if instantiated from a few prefabs.
+        private sealed class TestRenderers : IDisposable
+        {
+            private readonly List<Object> _assets = new();
+            private readonly List<GameObject> _gameObjects = new();
+
+            public TestRenderers(int count, int meshCount, int materialCount, uint seed)
+            {
+                var random = new Random(seed);
+                var meshes = new AAAAMeshletCollectionAsset[meshCount];
+                var materials = new AAAAMaterialAsset[materialCount];
+
+                for (int i = 0; i < meshCount; i++)
+                {
+                    AAAAMeshletCollectionAsset mesh = ScriptableObject.CreateInstance<AAAAMeshletCollectionAsset>();
+                    mesh.Bounds = new Bounds(random.NextFloat3(-1, 1), random.NextFloat3(1, 4));
+                    mesh.MeshLODLevelCount = random.NextInt(1, 8);
+                    mesh.MeshLODNodes = new AAAAMeshLODNode[random.NextInt(1, 64)];
+                    meshes[i] = mesh;
+                    _assets.Add(mesh);
+                    MeshRecords.Add(mesh.GetInstanceID(), new InstanceDataBuffer.MeshRecord
+                        {
+                            AABBMin = math.float4(mesh.Bounds.min, 0.0f),
+                            AABBMax = math.float4(mesh.Bounds.max, 0.0f),
+                            TopMeshLODStartIndex = (uint) (i * 64),
+                            TotalMeshLODCount = (uint) mesh.MeshLODNodes.Length,
+                            MeshLODLevelCount = (uint) mesh.MeshLODLevelCount,
+                            MeshInstanceID = mesh.GetInstanceID(),
+                        }
+                    );
+                }
+
+                for (int i = 0; i < materialCount; i++)
+                {
+                    AAAAMaterialAsset material = ScriptableObject.CreateInstance<AAAAMaterialAsset>();
+                    materials[i] = material;
+                    _assets.Add(material);
+                    MaterialIndices.Add(material, i);
+                }
+
+                InstanceIDs = new NativeArray<int>(count, Allocator.Persistent);
+
+                for (int i = 0; i < count; i++)
+                {
+                    const int runLength = 16;
+                    var gameObject = new GameObject("Renderer");
+                    gameObject.transform.SetPositionAndRotation(random.NextFloat3(-100, 100), random.NextQuaternionRotation());
+                    gameObject.transform.localScale = random.NextFloat3(0.5f, 2.0f);
+
+                    AAAARendererAuthoring rendererAuthoring = gameObject.AddComponent<AAAARendererAuthoring>();
+                    rendererAuthoring.Mesh = meshes[i / runLength % meshCount];
+                    rendererAuthoring.Material = materials[i / runLength % materialCount];
+
+                    _gameObjects.Add(gameObject);
+                    Renderers.Add(rendererAuthoring);
+                    Changed.Add(rendererAuthoring);
+                    InstanceIDs[i] = rendererAuthoring.GetInstanceID();
+                }
+            }
+
+            public int Count => Renderers.Count;
+            public List<AAAARendererAuthoring> Renderers { get; } = new();
+            public List<Object> Changed { get; } = new();
+            public NativeArray<int> InstanceIDs { get; }
+            public Dictionary<int, InstanceDataBuffer.MeshRecord> MeshRecords { get; } = new();
+            public Dictionary<AAAAMaterialAsset, int> MaterialIndices { get; } = new();
+
+            public void Dispose()
+            {
+                foreach (GameObject gameObject in _gameObjects)
+                {
+                    Object.DestroyImmediate(gameObject);
+                }
+
+                foreach (Object asset in _assets)
+                {
+                    Object.DestroyImmediate(asset);
+                }
+
+                InstanceIDs.Dispose();
+            }
+        }
+    }
+}
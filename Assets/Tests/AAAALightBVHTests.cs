@@ -0,0 +1,212 @@
+using System.Diagnostics;
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAALightBVHTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void Query_MatchesBruteForce([Values(1u, 2u, 3u)] uint seed, [Values(false, true)] bool sortLights)
+        {
+            var random = new Random(seed);
+            NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(ref random, 2000, sortLights);
+            using var bvh = new AAAALightBVH();
+            bvh.Build(lights);
+
+            var actual = new NativeList<int>(Allocator.Persistent);
+            var expected = new NativeList<int>(Allocator.Persistent);
+            int totalLightCount = 0;
+
+            for (int queryIndex = 0; queryIndex < 500; queryIndex++)
+            {
+                float4 sphereWS = math.float4(random.NextFloat3(-60.0f, 60.0f), random.NextFloat(0.5f, 5.0f));
+
+                actual.Clear();
+                bvh.Query(lights, sphereWS, actual);
+                actual.Sort();
+
+                expected.Clear();
+                for (int lightIndex = 0; lightIndex < lights.Length; lightIndex++)
+                {
+                    if (AAAALightBVH.LightIntersectsSphere(lights[lightIndex], sphereWS))
+                    {
+                        expected.Add(lightIndex);
+                    }
+                }
+
+                Assert.That(actual.AsArray().ToArray(), Is.EqualTo(expected.AsArray().ToArray()));
+                totalLightCount += expected.Length;
+            }
+
+            Assert.That(totalLightCount, Is.GreaterThan(0));
+
+            actual.Dispose();
+            expected.Dispose();
+            lights.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Leaves_CoverEveryLightOnce_InDepthFirstOrder([Values(1u, 2u, 3u)] uint seed, [Values(1, 4, 5, 1000)] int lightCount)
+        {
+            var random = new Random(seed);
+            NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(ref random, lightCount, true);
+            using var bvh = new AAAALightBVH();
+            bvh.Build(lights);
+
+            Assert.That(bvh.NodeCount, Is.InRange(1, AAAALightBVH.GetMaxNodeCount(lightCount)));
+
+            int nextLight = 0;
+            for (int nodeIndex = 0; nodeIndex < bvh.NodeCount; nodeIndex++)
+            {
+                AAAALightBVHNode node = bvh.Nodes[nodeIndex];
+                int nodeLightCount = (int) node.AABBMin_LightCount.w;
+
+                if (nodeLightCount > 0)
+                {
+                    Assert.That(nodeLightCount, Is.LessThanOrEqualTo(AAAALightBVH.MaxLeafSize));
+                    Assert.That((int) node.AABBMax_FirstLightOrEscapeIndex.w, Is.EqualTo(nextLight));
+                    nextLight += nodeLightCount;
+                }
+                else
+                {
+                    int escapeIndex = (int) node.AABBMax_FirstLightOrEscapeIndex.w;
+                    Assert.That(escapeIndex, Is.InRange(nodeIndex + 3, bvh.NodeCount));
+
+                    // Everything up to the escape index is inside the subtree.
+                    for (int childIndex = nodeIndex + 1; childIndex < escapeIndex; childIndex++)
+                    {
+                        AAAALightBVHNode child = bvh.Nodes[childIndex];
+                        Assert.That(math.all(child.AABBMin_LightCount.xyz >= node.AABBMin_LightCount.xyz), Is.True);
+                        Assert.That(math.all(child.AABBMax_FirstLightOrEscapeIndex.xyz <= node.AABBMax_FirstLightOrEscapeIndex.xyz), Is.True);
+                    }
+                }
+            }
+
+            Assert.That(nextLight, Is.EqualTo(lightCount));
+
+            lights.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SpotLightsFacingAway_AreRejectedByTheirCone()
+        {
+            var random = new Random(42);
+            var lights = new NativeArray<AAAAPunctualLightData>(64, Allocator.Persistent);
+
+            for (int i = 0; i < lights.Length; i++)
+            {
+                // Emit roughly toward +X. The stored spot direction points back to the light.
+                float3 emissionDirection = math.normalize(math.float3(1.0f, random.NextFloat(-0.03f, 0.03f), random.NextFloat(-0.03f, 0.03f)));
+                lights[i] = CreateLight(random.NextFloat3(-0.5f, 0.5f), 20.0f, -emissionDirection, math.radians(15.0f));
+            }
+
+            using var bvh = new AAAALightBVH();
+            bvh.Build(lights);
+
+            var lightIndices = new NativeList<int>(Allocator.Persistent);
+            float4 behindSphereWS = math.float4(-12.0f, 0.0f, 0.0f, 1.0f);
+            float4 inFrontSphereWS = math.float4(12.0f, 0.0f, 0.0f, 1.0f);
+
+            Assert.That(AAAALightBVH.NodeIntersectsSphere(bvh.Nodes[0], behindSphereWS), Is.False);
+            bvh.Query(lights, behindSphereWS, lightIndices);
+            Assert.That(lightIndices.Length, Is.Zero);
+
+            bvh.Query(lights, inFrontSphereWS, lightIndices);
+            Assert.That(lightIndices.Length, Is.EqualTo(lights.Length));
+
+            lightIndices.Dispose();
+            lights.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_10KLights()
+        {
+            const int lightCount = 10_000;
+            const int queryCount = 3456;
+            const int iterations = 10;
+
+            var random = new Random(42);
+            NativeArray<AAAAPunctualLightData> lights = CreateRandomLights(ref random, lightCount, true);
+            var spheres = new NativeArray<float4>(queryCount, Allocator.Persistent);
+            for (int i = 0; i < spheres.Length; i++)
+            {
+                spheres[i] = math.float4(random.NextFloat3(-60.0f, 60.0f), random.NextFloat(0.5f, 5.0f));
+            }
+
+            using var bvh = new AAAALightBVH();
+            var lightIndices = new NativeList<int>(Allocator.Persistent);
+
+            // Warm up Burst compilation.
+            bvh.Build(lights);
+            bvh.Query(lights, spheres[0], lightIndices);
+
+            var buildStopwatch = Stopwatch.StartNew();
+            for (int i = 0; i < iterations; i++)
+            {
+                bvh.Build(lights);
+            }
+
+            buildStopwatch.Stop();
+
+            var queryStopwatch = Stopwatch.StartNew();
+            for (int i = 0; i < spheres.Length; i++)
+            {
+                bvh.Query(lights, spheres[i], lightIndices);
+            }
+
+            queryStopwatch.Stop();
+
+            Assert.That(lightIndices.Length, Is.GreaterThan(0));
+            Debug.Log($"Light BVH over {lightCount} lights: build {buildStopwatch.Elapsed.TotalMilliseconds / iterations:F3} ms, " +
+                      $"{queryCount} sphere queries {queryStopwatch.Elapsed.TotalMilliseconds:F3} ms, {bvh.NodeCount} nodes, " +
+                      $"{lightIndices.Length} hits."
+            );
+
+            lightIndices.Dispose();
+            spheres.Dispose();
+            lights.Dispose();
+        }
+
+        private static NativeArray<AAAAPunctualLightData> CreateRandomLights(ref Random random, int lightCount, bool sortLights)
+        {
+            var lights = new NativeArray<AAAAPunctualLightData>(lightCount, Allocator.Persistent);
+
+            for (int i = 0; i < lightCount; i++)
+            {
+                float3 position = random.NextFloat3(-50.0f, 50.0f);
+                float range = random.NextFloat(1.0f, 8.0f);
+                bool isSpot = random.NextBool();
+                lights[i] = isSpot
+                    ? CreateLight(position, range, random.NextFloat3Direction(), math.radians(random.NextFloat(5.0f, 60.0f)))
+                    : CreateLight(position, range, float3.zero, 0.0f);
+            }
+
+            if (sortLights)
+            {
+                // Roughly the order AAAAPunctualLightPacker produces.
+                lights.Sort(new PositionComparer());
+            }
+
+            return lights;
+        }
+
+        private static AAAAPunctualLightData CreateLight(float3 position, float range, float3 spotDirection, float spotAngle) =>
+            new()
+            {
+                Color_Radius = math.float4(1.0f, 1.0f, 1.0f, range),
+                PositionWS = math.float4(position, 1.0f),
+                SpotDirection_Angle = math.float4(spotDirection, spotAngle),
+                ShadowSliceIndex_ShadowFadeParams = math.float4(AAAAPunctualLightPacker.NoShadowSliceIndex, 0, 0, 0),
+            };
+
+        private struct PositionComparer : System.Collections.Generic.IComparer<AAAAPunctualLightData>
+        {
+            public int Compare(AAAAPunctualLightData x, AAAAPunctualLightData y) => x.PositionWS.x.CompareTo(y.PositionWS.x);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Renderers;
+using NUnit.Framework;
+
+namespace Tests
+{
+    public class AAAAPendingReleaseQueueTests
+    {
+        private const int LatencyFrames = 3;
+
+        [Test] [Category("AAAA RP")]
+        public void Release_ExpiresAfterLatency()
+        {
+            var queue = new AAAAPendingReleaseQueue(LatencyFrames);
+
+            queue.Release(7, 10);
+            Assert.IsEmpty(queue.CollectExpired(10 + LatencyFrames - 1));
+            Assert.IsTrue(queue.Contains(7));
+
+            CollectionAssert.AreEqual(new[] { 7 }, queue.CollectExpired(10 + LatencyFrames));
+            Assert.AreEqual(0, queue.Count);
+            Assert.IsEmpty(queue.CollectExpired(10 + LatencyFrames + 1));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ReleaseRetainRelease_WaitsForLatestRelease()
+        {
+            var queue = new AAAAPendingReleaseQueue(LatencyFrames);
+
+            queue.Release(7, 10);
+            Assert.IsTrue(queue.Cancel(7));
+            queue.Release(7, 12);
+            Assert.AreEqual(1, queue.Count);
+
+            // The first release would have expired here, but the GPU may still be reading the mesh since frame 12.
+            Assert.IsEmpty(queue.CollectExpired(10 + LatencyFrames));
+            Assert.IsEmpty(queue.CollectExpired(12 + LatencyFrames - 1));
+
+            CollectionAssert.AreEqual(new[] { 7 }, queue.CollectExpired(12 + LatencyFrames));
+            Assert.AreEqual(0, queue.Count);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Retain_CancelsPendingRelease()
+        {
+            var queue = new AAAAPendingReleaseQueue(LatencyFrames);
+
+            queue.Release(7, 10);
+            queue.Release(8, 10);
+            Assert.IsTrue(queue.Cancel(7));
+            Assert.IsFalse(queue.Cancel(9));
+
+            List<int> expired = queue.CollectExpired(10 + LatencyFrames);
+            CollectionAssert.AreEqual(new[] { 8 }, expired);
+        }
+    }
+}
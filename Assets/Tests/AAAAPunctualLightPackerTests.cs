@@ -0,0 +1,280 @@
+using System.Diagnostics;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Rendering;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAPunctualLightPackerTests
+    {
+        private const int MaxPunctualLights = 1024;
+
+        [Test] [Category("AAAA RP")]
+        public void PackedLights_MatchPerLightConversion([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            NativeArray<VisibleLight> visibleLights = CreateRandomLights(ref random, 256, 8);
+            var shadows = new NativeArray<AAAAPunctualLightPacker.PunctualLightShadow>(0, Allocator.TempJob);
+            var punctualLights = new NativeList<AAAAPunctualLightData>(Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(Allocator.TempJob);
+
+            AAAAPunctualLightPacker.Schedule(visibleLights, shadows, MaxPunctualLights, punctualLights, directionalLightIndices).Complete();
+
+            int punctualLightCount = 0;
+            var found = new bool[visibleLights.Length];
+
+            for (int visibleLightIndex = 0; visibleLightIndex < visibleLights.Length; visibleLightIndex++)
+            {
+                VisibleLight visibleLight = visibleLights[visibleLightIndex];
+                if (visibleLight.lightType == LightType.Directional)
+                {
+                    continue;
+                }
+
+                ++punctualLightCount;
+                AAAAPunctualLightData expected =
+                    AAAAPunctualLightPacker.ExtractPunctualLightData(visibleLight, AAAAPunctualLightPacker.PunctualLightShadow.None);
+                int packedIndex = FindByPosition(punctualLights, expected.PositionWS.xyz);
+
+                Assert.That(packedIndex, Is.Not.EqualTo(-1));
+                Assert.That(found[packedIndex], Is.False);
+                found[packedIndex] = true;
+
+                AAAAPunctualLightData actual = punctualLights[packedIndex];
+                // Burst may compute the trigonometry with a slightly different precision.
+                AssertApproximatelyEqual(actual.Color_Radius, expected.Color_Radius);
+                AssertApproximatelyEqual(actual.SpotDirection_Angle, expected.SpotDirection_Angle);
+                AssertApproximatelyEqual(actual.Attenuations, expected.Attenuations);
+                Assert.That(actual.ShadowSliceIndex_ShadowFadeParams.x, Is.EqualTo(AAAAPunctualLightPacker.NoShadowSliceIndex));
+            }
+
+            Assert.That(punctualLights.Length, Is.EqualTo(punctualLightCount));
+            Assert.That(directionalLightIndices.Length, Is.EqualTo(AAAALightingConstantBuffer.MaxDirectionalLights));
+            for (int i = 0; i < directionalLightIndices.Length; i++)
+            {
+                Assert.That(visibleLights[directionalLightIndices[i]].lightType, Is.EqualTo(LightType.Directional));
+                Assert.That(i == 0 || directionalLightIndices[i] > directionalLightIndices[i - 1], Is.True);
+            }
+
+            visibleLights.Dispose();
+            shadows.Dispose();
+            punctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void PackedLights_AreSortedByMortonCode([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            NativeArray<VisibleLight> visibleLights = CreateRandomLights(ref random, 512, 0);
+            var shadows = new NativeArray<AAAAPunctualLightPacker.PunctualLightShadow>(0, Allocator.TempJob);
+            var punctualLights = new NativeList<AAAAPunctualLightData>(Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(Allocator.TempJob);
+
+            AAAAPunctualLightPacker.Schedule(visibleLights, shadows, MaxPunctualLights, punctualLights, directionalLightIndices).Complete();
+
+            float3 min = float.MaxValue;
+            float3 max = -float.MaxValue;
+            foreach (AAAAPunctualLightData punctualLight in punctualLights)
+            {
+                min = math.min(min, punctualLight.PositionWS.xyz);
+                max = math.max(max, punctualLight.PositionWS.xyz);
+            }
+
+            uint previousMortonCode = 0;
+            foreach (AAAAPunctualLightData punctualLight in punctualLights)
+            {
+                uint mortonCode = AAAACullingMath.EncodeMorton3((punctualLight.PositionWS.xyz - min) / math.max(max - min, 1e-6f));
+                Assert.That(mortonCode, Is.GreaterThanOrEqualTo(previousMortonCode));
+                previousMortonCode = mortonCode;
+            }
+
+            visibleLights.Dispose();
+            shadows.Dispose();
+            punctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ShadowSlices_StayWithTheirLights([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            NativeArray<VisibleLight> visibleLights = CreateRandomLights(ref random, 128, 2);
+            var shadows = new NativeList<AAAAPunctualLightPacker.PunctualLightShadow>(Allocator.TempJob);
+
+            for (int visibleLightIndex = 0; visibleLightIndex < visibleLights.Length; visibleLightIndex += 3)
+            {
+                if (visibleLights[visibleLightIndex].lightType != LightType.Directional)
+                {
+                    shadows.Add(new AAAAPunctualLightPacker.PunctualLightShadow
+                        {
+                            VisibleLightIndex = visibleLightIndex,
+                            SliceIndex = shadows.Length * 6,
+                            FadeParams = math.float2(1.0f, -visibleLightIndex),
+                            IsSoftShadow = visibleLightIndex % 2 == 0,
+                            ShadowStrength = 0.5f,
+                        }
+                    );
+                }
+            }
+
+            var punctualLights = new NativeList<AAAAPunctualLightData>(Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(Allocator.TempJob);
+
+            AAAAPunctualLightPacker.Schedule(visibleLights, shadows.AsArray(), MaxPunctualLights, punctualLights, directionalLightIndices).Complete();
+
+            int shadowedLightCount = 0;
+            foreach (AAAAPunctualLightData punctualLight in punctualLights)
+            {
+                if (punctualLight.ShadowSliceIndex_ShadowFadeParams.x == AAAAPunctualLightPacker.NoShadowSliceIndex)
+                {
+                    continue;
+                }
+
+                ++shadowedLightCount;
+                int shadowIndex = (int) punctualLight.ShadowSliceIndex_ShadowFadeParams.x / 6;
+                AAAAPunctualLightPacker.PunctualLightShadow shadow = shadows[shadowIndex];
+                float3 expectedPosition = ((float4x4) visibleLights[shadow.VisibleLightIndex].localToWorldMatrix).c3.xyz;
+
+                Assert.That(punctualLight.PositionWS.xyz, Is.EqualTo(expectedPosition));
+                Assert.That(punctualLight.ShadowSliceIndex_ShadowFadeParams.zw, Is.EqualTo(shadow.FadeParams));
+                Assert.That(punctualLight.ShadowParams, Is.EqualTo(AAAAPunctualLightPacker.PackShadowParams(shadow.IsSoftShadow, shadow.ShadowStrength)));
+            }
+
+            Assert.That(shadowedLightCount, Is.EqualTo(shadows.Length));
+
+            visibleLights.Dispose();
+            shadows.Dispose();
+            punctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void PunctualLightCount_IsClampedToMax()
+        {
+            const int maxPunctualLights = 100;
+
+            var random = new Random(42);
+            NativeArray<VisibleLight> visibleLights = CreateRandomLights(ref random, 256, 0);
+            var shadows = new NativeArray<AAAAPunctualLightPacker.PunctualLightShadow>(0, Allocator.TempJob);
+            var punctualLights = new NativeList<AAAAPunctualLightData>(Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(Allocator.TempJob);
+
+            AAAAPunctualLightPacker.Schedule(visibleLights, shadows, maxPunctualLights, punctualLights, directionalLightIndices).Complete();
+
+            Assert.That(punctualLights.Length, Is.EqualTo(maxPunctualLights));
+            Assert.That(directionalLightIndices.Length, Is.Zero);
+
+            // The first lights in the visible order are kept.
+            for (int visibleLightIndex = 0; visibleLightIndex < maxPunctualLights; visibleLightIndex++)
+            {
+                float3 position = ((float4x4) visibleLights[visibleLightIndex].localToWorldMatrix).c3.xyz;
+                Assert.That(FindByPosition(punctualLights, position), Is.Not.EqualTo(-1));
+            }
+
+            visibleLights.Dispose();
+            shadows.Dispose();
+            punctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_1024PunctualLights()
+        {
+            const int lightCount = 1024;
+            const int iterations = 100;
+
+            var random = new Random(42);
+            NativeArray<VisibleLight> visibleLights = CreateRandomLights(ref random, lightCount, 0);
+            var shadows = new NativeArray<AAAAPunctualLightPacker.PunctualLightShadow>(lightCount / 16, Allocator.TempJob);
+            for (int i = 0; i < shadows.Length; i++)
+            {
+                shadows[i] = new AAAAPunctualLightPacker.PunctualLightShadow
+                {
+                    VisibleLightIndex = i * 16,
+                    SliceIndex = i,
+                    ShadowStrength = 1.0f,
+                };
+            }
+
+            var punctualLights = new NativeList<AAAAPunctualLightData>(lightCount, Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(Allocator.TempJob);
+
+            // Warm up Burst compilation.
+            AAAAPunctualLightPacker.Schedule(visibleLights, shadows, MaxPunctualLights, punctualLights, directionalLightIndices).Complete();
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                AAAAPunctualLightPacker.Schedule(visibleLights, shadows, MaxPunctualLights, punctualLights, directionalLightIndices).Complete();
+            }
+
+            stopwatch.Stop();
+
+            Assert.That(punctualLights.Length, Is.EqualTo(lightCount));
+            Debug.Log($"Packing of {lightCount} punctual lights: {stopwatch.Elapsed.TotalMilliseconds / iterations:F3} ms.");
+
+            visibleLights.Dispose();
+            shadows.Dispose();
+            punctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        private static NativeArray<VisibleLight> CreateRandomLights(ref Random random, int punctualLightCount, int directionalLightCount)
+        {
+            int lightCount = punctualLightCount + directionalLightCount;
+            var visibleLights = new NativeArray<VisibleLight>(lightCount, Allocator.TempJob);
+            int directionalLightsLeft = directionalLightCount;
+
+            for (int i = 0; i < lightCount; i++)
+            {
+                bool isDirectional = directionalLightsLeft > 0 && (random.NextInt(lightCount - i) < directionalLightsLeft);
+                if (isDirectional)
+                {
+                    --directionalLightsLeft;
+                }
+
+                float3 position = random.NextFloat3(-100.0f, 100.0f);
+                quaternion rotation = random.NextQuaternionRotation();
+                LightType lightType = isDirectional ? LightType.Directional : random.NextBool() ? LightType.Point : LightType.Spot;
+
+                visibleLights[i] = new VisibleLight
+                {
+                    lightType = lightType,
+                    finalColor = new Color(random.NextFloat(), random.NextFloat(), random.NextFloat()) * random.NextFloat(0.5f, 10.0f),
+                    localToWorldMatrix = float4x4.TRS(position, rotation, 1.0f),
+                    range = random.NextFloat(1.0f, 20.0f),
+                    spotAngle = lightType == LightType.Spot ? random.NextFloat(10.0f, 120.0f) : 0.0f,
+                };
+            }
+
+            return visibleLights;
+        }
+
+        private static void AssertApproximatelyEqual(float4 actual, float4 expected)
+        {
+            float4 tolerance = 1e-4f * math.max(1.0f, math.abs(expected));
+            Assert.That(math.all(math.abs(actual - expected) <= tolerance), Is.True, $"Expected {expected}, got {actual}.");
+        }
+
+        private static int FindByPosition(NativeList<AAAAPunctualLightData> punctualLights, float3 position)
+        {
+            for (int i = 0; i < punctualLights.Length; i++)
+            {
+                if (math.all(punctualLights[i].PositionWS.xyz == position))
+                {
+                    return i;
+                }
+            }
+
+            return -1;
+        }
+    }
+}
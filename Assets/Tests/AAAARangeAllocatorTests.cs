@@ -0,0 +1,137 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Core;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAARangeAllocatorTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void TryAllocate_WithoutFreeRanges_Fails()
+        {
+            using var allocator = new AAAARangeAllocator(Allocator.Persistent);
+
+            Assert.IsFalse(allocator.TryAllocate(1, out int offset));
+            Assert.AreEqual(-1, offset);
+            Assert.IsTrue(allocator.TryAllocate(0, out _));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void TryAllocate_UsesFirstFreeRangeThatFits()
+        {
+            using var allocator = new AAAARangeAllocator(Allocator.Persistent);
+            allocator.Free(0, 4);
+            allocator.Free(10, 16);
+            allocator.Free(40, 8);
+
+            Assert.IsTrue(allocator.TryAllocate(8, out int offset));
+            Assert.AreEqual(10, offset);
+            Assert.IsTrue(allocator.TryAllocate(4, out offset));
+            Assert.AreEqual(0, offset);
+            Assert.IsTrue(allocator.TryAllocate(8, out offset));
+            Assert.AreEqual(18, offset);
+            Assert.IsFalse(allocator.TryAllocate(16, out _));
+
+            Assert.AreEqual(8, allocator.FreeCount);
+            Assert.AreEqual(1, allocator.FreeRangeCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Free_AdjacentRanges_Coalesce()
+        {
+            using var allocator = new AAAARangeAllocator(Allocator.Persistent);
+            allocator.Free(0, 10);
+            allocator.Free(20, 10);
+            Assert.AreEqual(2, allocator.FreeRangeCount);
+
+            allocator.Free(10, 10);
+            Assert.AreEqual(1, allocator.FreeRangeCount);
+            Assert.AreEqual(30, allocator.FreeCount);
+
+            Assert.IsTrue(allocator.TryAllocate(30, out int offset));
+            Assert.AreEqual(0, offset);
+            Assert.AreEqual(0, allocator.FreeRangeCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void TrimTail_DropsOnlyTheRangeAtTheEnd()
+        {
+            using var allocator = new AAAARangeAllocator(Allocator.Persistent);
+            allocator.Free(0, 10);
+            Assert.AreEqual(30, allocator.TrimTail(30));
+
+            allocator.Free(20, 10);
+            Assert.AreEqual(20, allocator.TrimTail(30));
+            Assert.AreEqual(10, allocator.FreeCount);
+            Assert.AreEqual(1, allocator.FreeRangeCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void RandomAllocateAndFree_KeepsRangesDisjointAndReusesHoles([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            using var allocator = new AAAARangeAllocator(Allocator.Persistent);
+            var liveRanges = new List<(int Offset, int Count)>();
+            var poolUsage = new List<bool>();
+            int poolLength = 0;
+            int peakLiveCount = 0;
+
+            for (int iteration = 0; iteration < 2000; iteration++)
+            {
+                if (liveRanges.Count == 0 || random.NextFloat() < 0.55f)
+                {
+                    int count = random.NextInt(1, 64);
+                    if (!allocator.TryAllocate(count, out int offset))
+                    {
+                        offset = poolLength;
+                        poolLength += count;
+                    }
+
+                    while (poolUsage.Count < poolLength)
+                    {
+                        poolUsage.Add(false);
+                    }
+
+                    for (int i = offset; i < offset + count; i++)
+                    {
+                        Assert.IsFalse(poolUsage[i], "Allocated ranges overlap.");
+                        poolUsage[i] = true;
+                    }
+
+                    liveRanges.Add((offset, count));
+                }
+                else
+                {
+                    int rangeIndex = random.NextInt(liveRanges.Count);
+                    (int offset, int count) = liveRanges[rangeIndex];
+                    liveRanges[rangeIndex] = liveRanges[liveRanges.Count - 1];
+                    liveRanges.RemoveAt(liveRanges.Count - 1);
+
+                    for (int i = offset; i < offset + count; i++)
+                    {
+                        poolUsage[i] = false;
+                    }
+
+                    allocator.Free(offset, count);
+                    poolLength = allocator.TrimTail(poolLength);
+                    poolUsage.RemoveRange(poolLength, poolUsage.Count - poolLength);
+                }
+
+                int liveCount = 0;
+                foreach (bool used in poolUsage)
+                {
+                    liveCount += used ? 1 : 0;
+                }
+
+                peakLiveCount = math.max(peakLiveCount, liveCount);
+                Assert.AreEqual(poolLength - liveCount, allocator.FreeCount);
+            }
+
+            // Freed holes are reused, so fragmentation keeps the pool within twice the peak live size.
+            Assert.Less(poolLength, peakLiveCount * 2);
+        }
+    }
+}
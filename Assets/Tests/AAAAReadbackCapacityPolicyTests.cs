@@ -0,0 +1,230 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Utils;
+using NUnit.Framework;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAReadbackCapacityPolicyTests
+    {
+        private const int WorstCase = 1_000_000;
+
+        [Test] [Category("AAAA RP")]
+        public void UsesWorstCase_UntilFirstReadback()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+
+            Assert.That(policy.HasSamples, Is.False);
+            Assert.That(policy.GetCapacity(WorstCase), Is.EqualTo(WorstCase));
+
+            policy.Update(10_000, WorstCase);
+
+            Assert.That(policy.HasSamples, Is.True);
+            Assert.That(policy.GetCapacity(WorstCase), Is.EqualTo(ExpectedCapacity(10_000)));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Capacity_HasHeadroomAndIsRounded([Values(0u, 1u, 5000u, 123_456u)] uint peak)
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            AAAAReadbackCapacityPolicy.Settings settings = policy.PolicySettings;
+
+            int capacity = policy.Update(peak, WorstCase);
+
+            Assert.That(capacity, Is.GreaterThanOrEqualTo(peak * (1.0f + settings.Headroom)));
+            Assert.That(capacity, Is.GreaterThanOrEqualTo(settings.MinCapacity));
+            Assert.That(capacity % settings.Granularity, Is.Zero);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Capacity_NeverExceedsWorstCase()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+
+            Assert.That(policy.Update(900, 1000), Is.EqualTo(1000));
+            Assert.That(policy.Update(5000, 1000), Is.EqualTo(1000));
+
+            // Instances were removed.
+            Assert.That(policy.Update(100, 500), Is.EqualTo(500));
+            Assert.That(policy.GetCapacity(500), Is.EqualTo(500));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Overflow_GrowsOnTheNextUpdate()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            int capacity = policy.Update(10_000, WorstCase);
+
+            // The read back counts include the dropped requests, so the capacity jumps straight to the demand.
+            int grownCapacity = policy.Update((uint) capacity * 3, WorstCase);
+
+            Assert.That(grownCapacity, Is.EqualTo(ExpectedCapacity((uint) capacity * 3)));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void NearlyFull_GrowsBeforeOverflowing()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            int capacity = policy.Update(10_000, WorstCase);
+
+            uint peak = (uint) (capacity * 0.95f);
+            Assert.That(policy.Update(peak, WorstCase), Is.GreaterThan(capacity));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Shrinking_WaitsForDelay()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            AAAAReadbackCapacityPolicy.Settings settings = policy.PolicySettings;
+            int capacity = policy.Update(100_000, WorstCase);
+
+            for (int i = 0; i < settings.ShrinkDelay - 1; i++)
+            {
+                Assert.That(policy.Update(10_000, WorstCase), Is.EqualTo(capacity));
+            }
+
+            Assert.That(policy.Update(10_000, WorstCase), Is.EqualTo(ExpectedCapacity(10_000)));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Shrinking_KeepsPeakOfTheWindow()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            AAAAReadbackCapacityPolicy.Settings settings = policy.PolicySettings;
+            policy.Update(100_000, WorstCase);
+
+            for (int i = 0; i < settings.ShrinkDelay; i++)
+            {
+                policy.Update(i == settings.ShrinkDelay / 2 ? 30_000u : 10_000u, WorstCase);
+            }
+
+            Assert.That(policy.GetCapacity(WorstCase), Is.EqualTo(ExpectedCapacity(30_000)));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Shrinking_IsInterruptedByLoad()
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            AAAAReadbackCapacityPolicy.Settings settings = policy.PolicySettings;
+            int capacity = policy.Update(100_000, WorstCase);
+
+            for (int i = 0; i < settings.ShrinkDelay * 3; i++)
+            {
+                // Every so often the camera looks back at the dense part of the scene.
+                uint peak = i % (settings.ShrinkDelay / 2) == 0 ? 90_000u : 10_000u;
+                Assert.That(policy.Update(peak, WorstCase), Is.EqualTo(capacity));
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void NoisyLoad_RarelyReallocates([Values(1u, 2u, 3u)] uint seed)
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            var stream = new SimulatedReadbacks(policy, 3, seed);
+
+            for (int frame = 0; frame < 1000; frame++)
+            {
+                stream.Step(50_000, 0.1f);
+            }
+
+            Assert.That(stream.CapacityChanges, Is.LessThanOrEqualTo(2));
+            Assert.That(stream.OverflowFrames, Is.Zero);
+            Assert.That(stream.Capacity, Is.LessThan(WorstCase / 10));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void LoadSteps_OverflowOnlyUntilReadbackArrives([Values(0, 3)] int readbackLatency)
+        {
+            var policy = new AAAAReadbackCapacityPolicy();
+            var stream = new SimulatedReadbacks(policy, readbackLatency, 1u);
+            float[] loads = { 20_000, 200_000, 60_000, 400_000, 10_000 };
+
+            foreach (float load in loads)
+            {
+                for (int frame = 0; frame < 300; frame++)
+                {
+                    stream.Step(load, 0.05f);
+                }
+            }
+
+            // Each upward step overflows until the first readback of the new load reaches the policy.
+            Assert.That(stream.OverflowFrames, Is.LessThanOrEqualTo(2 * (readbackLatency + 1)));
+            // After the last step down, the capacity follows the small load again.
+            Assert.That(stream.Capacity, Is.GreaterThan(stream.LastWindowPeak));
+            Assert.That(stream.Capacity, Is.LessThan(ExpectedCapacity(20_000)));
+        }
+
+        private static int ExpectedCapacity(uint peak)
+        {
+            AAAAReadbackCapacityPolicy.Settings settings = AAAAReadbackCapacityPolicy.Settings.Default;
+            double capacity = math.ceil(peak * (1.0 + settings.Headroom));
+            capacity = math.ceil(capacity / settings.Granularity) * settings.Granularity;
+            return (int) math.min(math.max(capacity, settings.MinCapacity), WorstCase);
+        }
+
+        // Request counts reach the policy with a delay, like async readbacks do. The capacity applies from the frame after the update.
+        private sealed class SimulatedReadbacks
+        {
+            private readonly Queue<uint> _pendingReadbacks = new();
+            private readonly AAAAReadbackCapacityPolicy _policy;
+            private readonly int _readbackLatency;
+            private readonly List<uint> _recentPeaks = new();
+            private Random _random;
+
+            public SimulatedReadbacks(AAAAReadbackCapacityPolicy policy, int readbackLatency, uint seed)
+            {
+                _policy = policy;
+                _readbackLatency = readbackLatency;
+                _random = new Random(seed);
+                Capacity = policy.GetCapacity(WorstCase);
+            }
+
+            public int Capacity { get; private set; }
+            public int CapacityChanges { get; private set; }
+            public int OverflowFrames { get; private set; }
+
+            public uint LastWindowPeak
+            {
+                get
+                {
+                    uint peak = 0;
+
+                    foreach (uint recentPeak in _recentPeaks)
+                    {
+                        peak = math.max(peak, recentPeak);
+                    }
+
+                    return peak;
+                }
+            }
+
+            public void Step(float load, float noise)
+            {
+                uint requests = (uint) (load * (1.0f + _random.NextFloat(-noise, noise)));
+
+                if (requests > Capacity)
+                {
+                    ++OverflowFrames;
+                }
+
+                _recentPeaks.Add(requests);
+                if (_recentPeaks.Count > _policy.PolicySettings.ShrinkDelay)
+                {
+                    _recentPeaks.RemoveAt(0);
+                }
+
+                _pendingReadbacks.Enqueue(requests);
+                if (_pendingReadbacks.Count > _readbackLatency)
+                {
+                    int capacity = _policy.Update(_pendingReadbacks.Dequeue(), WorstCase);
+                    if (capacity != Capacity)
+                    {
+                        ++CapacityChanges;
+                        Capacity = capacity;
+                    }
+                }
+            }
+        }
+    }
+}
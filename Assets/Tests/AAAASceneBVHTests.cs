@@ -0,0 +1,290 @@
+using System.Collections.Generic;
+using System.Diagnostics;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Passes;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using UnityEngine;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAASceneBVHTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void Query_MatchesBruteForce([Values(1u, 2u, 3u)] uint seed, [Values(0.0f, 2.0f)] float margin)
+        {
+            var random = new Random(seed);
+            using var scene = AAAACullingTestScene.CreateScattered(5000, random);
+            using var bvh = new AAAASceneBVH();
+            bvh.Build(scene.Instances, scene.InstanceIndices);
+
+            for (int iteration = 0; iteration < 10; iteration++)
+            {
+                GPUCullingContext view = CreateView(random.NextFloat3(-50, 50), random.NextQuaternionRotation(), random.NextBool());
+                AssertMatchesBruteForce(bvh, scene, view, margin);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Query_WithCullingSphere_MatchesBruteForce([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            using var scene = AAAACullingTestScene.CreateScattered(5000, random);
+            using var bvh = new AAAASceneBVH();
+            bvh.Build(scene.Instances, scene.InstanceIndices);
+
+            for (int iteration = 0; iteration < 10; iteration++)
+            {
+                GPUCullingContext view = CreateView(random.NextFloat3(-50, 50), random.NextQuaternionRotation(), false);
+                view.PassMask = (int) AAAAInstancePassMask.Shadows;
+                view.CullingSphereLS = new float4(random.NextFloat3(-20, 20), random.NextFloat(5, 30));
+                AssertMatchesBruteForce(bvh, scene, view, 0.0f);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Refit_AfterMovesAndRemovals_MatchesBruteForce([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            using var scene = AAAACullingTestScene.CreateScattered(5000, random);
+            using var bvh = new AAAASceneBVH();
+            bvh.Update(scene.Instances, scene.InstanceIndices);
+            Assert.AreEqual(1, bvh.BuildCount);
+
+            var moved = new NativeArray<int>(scene.Instances.Length / 20, Allocator.Persistent);
+
+            for (int i = 0; i < moved.Length; i++)
+            {
+                int instanceIndex = random.NextInt(scene.Instances.Length);
+                moved[i] = instanceIndex;
+                scene.Move(instanceIndex, random.NextFloat3(-5, 5));
+            }
+
+            bvh.OnInstancesMoved(moved);
+
+            var removed = new List<int>();
+
+            for (int i = 0; i < 50; i++)
+            {
+                int instanceIndex = random.NextInt(scene.Instances.Length);
+                bvh.OnInstanceRemoved(instanceIndex);
+                removed.Add(instanceIndex);
+            }
+
+            bvh.Update(scene.Instances, scene.InstanceIndices);
+            Assert.AreEqual(1, bvh.BuildCount, "Small moves should be handled with a refit.");
+
+            foreach (int instanceIndex in removed)
+            {
+                scene.Disable(instanceIndex);
+            }
+
+            for (int iteration = 0; iteration < 10; iteration++)
+            {
+                GPUCullingContext view = CreateView(random.NextFloat3(-50, 50), random.NextQuaternionRotation(), true);
+                AssertMatchesBruteForce(bvh, scene, view, 0.0f);
+            }
+
+            moved.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Update_RebuildsWhenInstancesAreAdded()
+        {
+            using var scene = AAAACullingTestScene.CreateScattered(100, new Random(1));
+            using var bvh = new AAAASceneBVH();
+            bvh.Update(scene.Instances, scene.InstanceIndices.GetSubArray(0, 50));
+            Assert.AreEqual(50, bvh.PrimitiveCount);
+
+            bvh.OnInstanceChanged(10);
+            bvh.Update(scene.Instances, scene.InstanceIndices.GetSubArray(0, 50));
+            Assert.AreEqual(1, bvh.BuildCount);
+
+            bvh.OnInstanceChanged(75);
+            bvh.Update(scene.Instances, scene.InstanceIndices);
+            Assert.AreEqual(2, bvh.BuildCount);
+            Assert.AreEqual(100, bvh.PrimitiveCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Update_RebuildsWhenRefitDegradesQuality()
+        {
+            var random = new Random(4);
+            using var scene = AAAACullingTestScene.CreateScattered(2000, random);
+            using var bvh = new AAAASceneBVH();
+            bvh.Update(scene.Instances, scene.InstanceIndices);
+            float builtCost = bvh.Cost;
+
+            // Scattering every instance makes the old Morton order meaningless.
+            for (int instanceIndex = 0; instanceIndex < scene.Instances.Length; instanceIndex++)
+            {
+                scene.Move(instanceIndex, random.NextFloat3(-100, 100));
+            }
+
+            bvh.OnInstancesMoved(scene.InstanceIndices);
+            bvh.Update(scene.Instances, scene.InstanceIndices);
+
+            Assert.AreEqual(2, bvh.BuildCount);
+            Assert.Less(bvh.Cost, builtCost * AAAASceneBVH.RebuildCostRatio);
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_100KInstances_BuildRefitQuery()
+        {
+            const int iterations = 10;
+
+            var random = new Random(42);
+            using var scene = AAAACullingTestScene.CreateScattered(100_000, random);
+            using var bvh = new AAAASceneBVH();
+            using var candidates = new NativeList<int>(scene.Instances.Length, Allocator.Persistent);
+            var moved = new NativeArray<int>(scene.Instances.Length / 100, Allocator.Persistent);
+
+            for (int i = 0; i < moved.Length; i++)
+            {
+                moved[i] = random.NextInt(scene.Instances.Length);
+            }
+
+            var views = new GPUCullingContext[8];
+
+            for (int i = 0; i < views.Length; i++)
+            {
+                views[i] = CreateView(random.NextFloat3(-50, 50), random.NextQuaternionRotation(), true);
+            }
+
+            // Warm up Burst compilation.
+            bvh.Build(scene.Instances, scene.InstanceIndices);
+            bvh.OnInstancesMoved(moved);
+            bvh.Refit(scene.Instances);
+            bvh.Query(views[0], 0.0f, candidates);
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                bvh.Build(scene.Instances, scene.InstanceIndices);
+            }
+
+            double buildMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+            stopwatch.Restart();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                bvh.OnInstancesMoved(moved);
+                bvh.Refit(scene.Instances);
+            }
+
+            double refitMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+            stopwatch.Restart();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                foreach (GPUCullingContext view in views)
+                {
+                    candidates.Clear();
+                    bvh.Query(view, 0.0f, candidates);
+                }
+            }
+
+            double queryMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+            stopwatch.Restart();
+
+            int bruteForceCount = 0;
+
+            for (int i = 0; i < iterations; i++)
+            {
+                foreach (GPUCullingContext view in views)
+                {
+                    bruteForceCount = BruteForce(scene, view, 0.0f).Count;
+                }
+            }
+
+            double bruteForceMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+
+            Debug.Log($"Scene BVH over {scene.Instances.Length} instances ({bvh.NodeCount} nodes): build {buildMs:F3} ms, " +
+                      $"refit of {moved.Length} moved {refitMs:F3} ms, {views.Length} queries {queryMs:F3} ms " +
+                      $"(brute force {bruteForceMs:F3} ms), last view {candidates.Length}/{bruteForceCount} candidates."
+            );
+
+            moved.Dispose();
+        }
+
+        private static void AssertMatchesBruteForce(AAAASceneBVH bvh, AAAACullingTestScene scene, GPUCullingContext view, float margin)
+        {
+            using var candidates = new NativeList<int>(Allocator.Persistent);
+            bvh.Query(view, margin, candidates);
+
+            var candidateSet = new HashSet<int>();
+            foreach (int instanceIndex in candidates)
+            {
+                Assert.IsTrue(candidateSet.Add(instanceIndex), "Instances must not be emitted twice.");
+            }
+
+            // Subtrees fully inside the frustum skip the per-instance tests, which may differ in the last bits.
+            const float epsilon = 1e-3f;
+            Assert.IsTrue(candidateSet.IsSupersetOf(BruteForce(scene, view, margin)), "A visible instance was culled.");
+            Assert.IsTrue(candidateSet.IsSubsetOf(BruteForce(scene, view, margin + epsilon)), "An invisible instance was not culled.");
+        }
+
+        private static HashSet<int> BruteForce(AAAACullingTestScene scene, GPUCullingContext view, float margin)
+        {
+            var cullingView = AAAACPUCullingPipeline.CullingView.Create(view);
+            var result = new HashSet<int>();
+
+            foreach (int instanceIndex in scene.InstanceIndices)
+            {
+                AAAAInstanceData instanceData = scene.Instances[instanceIndex];
+                if ((instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 || (instanceData.PassMask & cullingView.PassMask) == 0)
+                {
+                    continue;
+                }
+
+                AAAACullingMath.TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                    out float3 aabbMinWS, out float3 aabbMaxWS
+                );
+                float4 boundingSphereWS = AAAACullingMath.AABBToBoundingSphere(aabbMinWS, aabbMaxWS);
+                boundingSphereWS.w += margin;
+
+                if (cullingView.FrustumVsSphereCulling(boundingSphereWS) &&
+                    AAAACullingMath.LightSphereCulling(cullingView.CullingSphereLS, cullingView.ViewMatrix, boundingSphereWS))
+                {
+                    result.Add(instanceIndex);
+                }
+            }
+
+            return result;
+        }
+
+        private static unsafe GPUCullingContext CreateView(float3 position, quaternion rotation, bool isPerspective)
+        {
+            float4x4 viewMatrix = math.mul(float4x4.Scale(1, 1, -1), math.inverse(float4x4.TRS(position, rotation, 1)));
+            float4x4 projectionMatrix = isPerspective
+                ? float4x4.PerspectiveFov(math.radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f)
+                : float4x4.OrthoOffCenter(-30, 30, -30, 30, -50, 50);
+            float4x4 viewProjectionMatrix = math.mul(projectionMatrix, viewMatrix);
+
+            var cullingContext = new GPUCullingContext
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                ViewMatrix = viewMatrix,
+                CameraPosition = new float4(position, 1),
+                PassMask = (int) AAAAInstancePassMask.Main,
+                CameraIsPerspective = isPerspective ? 1 : 0,
+            };
+
+            Plane[] frustumPlanes = GeometryUtility.CalculateFrustumPlanes(viewProjectionMatrix);
+            for (int i = 0; i < frustumPlanes.Length; i++)
+            {
+                cullingContext.FrustumPlanes[i * 4 + 0] = frustumPlanes[i].normal.x;
+                cullingContext.FrustumPlanes[i * 4 + 1] = frustumPlanes[i].normal.y;
+                cullingContext.FrustumPlanes[i * 4 + 2] = frustumPlanes[i].normal.z;
+                cullingContext.FrustumPlanes[i * 4 + 3] = frustumPlanes[i].distance;
+            }
+
+            return cullingContext;
+        }
+    }
+}
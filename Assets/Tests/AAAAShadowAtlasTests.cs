@@ -0,0 +1,357 @@
+using System.Collections.Generic;
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAShadowAtlasTests
+    {
+        private const int PageSize = 1024;
+        private const int MinTileSize = 64;
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_EmptyPage_IsOneFreeTile()
+        {
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+
+            Assert.That(packer.IsEmpty, Is.True);
+            Assert.That(packer.Occupancy, Is.Zero);
+            Assert.That(packer.Fragmentation, Is.Zero);
+            Assert.That(packer.LargestFreeTileSize, Is.EqualTo(PageSize));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_RoundsSizesUpToPowerOfTwo([Values(1, 64, 65, 300, 1024)] int size)
+        {
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+
+            Assert.That(packer.TryAllocate(size, out AAAAShadowAtlasPacker.Tile tile), Is.True);
+            Assert.That(tile.Size, Is.EqualTo(math.max(MinTileSize, math.ceilpow2(size))));
+            Assert.That(tile.Position, Is.EqualTo(int2.zero));
+            Assert.That(packer.AllocatedArea, Is.EqualTo((long) tile.Size * tile.Size));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_FillsPageCompletely()
+        {
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+            var tiles = new List<AAAAShadowAtlasPacker.Tile>();
+
+            while (packer.TryAllocate(256, out AAAAShadowAtlasPacker.Tile tile))
+            {
+                tiles.Add(tile);
+            }
+
+            Assert.That(tiles.Count, Is.EqualTo(16));
+            Assert.That(packer.Occupancy, Is.EqualTo(1.0f));
+            Assert.That(packer.Fragmentation, Is.Zero);
+            Assert.That(packer.TryAllocate(MinTileSize, out AAAAShadowAtlasPacker.Tile _), Is.False);
+            AssertNoOverlaps(tiles);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_Fragmentation_GrowsWhenFreeSpaceIsScattered()
+        {
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+            var tiles = new List<AAAAShadowAtlasPacker.Tile>();
+
+            while (packer.TryAllocate(256, out AAAAShadowAtlasPacker.Tile tile))
+            {
+                tiles.Add(tile);
+            }
+
+            // Free one tile out of each quadrant: half of the page is free, but not a single 512 tile.
+            for (int i = 0; i < tiles.Count; i += 2)
+            {
+                packer.Free(tiles[i]);
+            }
+
+            Assert.That(packer.Occupancy, Is.EqualTo(0.5f));
+            Assert.That(packer.LargestFreeTileSize, Is.EqualTo(256));
+            Assert.That(packer.Fragmentation, Is.EqualTo(1.0f - 1.0f / 8.0f).Within(1e-6f));
+            Assert.That(packer.TryAllocate(512, out AAAAShadowAtlasPacker.Tile _), Is.False);
+
+            // Freeing the rest of the first quadrant merges it back into a 512 tile.
+            packer.Free(tiles[1]);
+            packer.Free(tiles[3]);
+
+            Assert.That(packer.LargestFreeTileSize, Is.EqualTo(512));
+            Assert.That(packer.TryAllocate(512, out AAAAShadowAtlasPacker.Tile mergedTile), Is.True);
+            Assert.That(mergedTile.Position, Is.EqualTo(int2.zero));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_BestFit_KeepsLargeTilesFree()
+        {
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+
+            packer.TryAllocate(128, out AAAAShadowAtlasPacker.Tile _);
+            packer.TryAllocate(512, out AAAAShadowAtlasPacker.Tile _);
+            packer.TryAllocate(128, out AAAAShadowAtlasPacker.Tile _);
+
+            // The second 128 tile goes next to the first one instead of splitting another 512 quadrant.
+            Assert.That(packer.LargestFreeTileSize, Is.EqualTo(512));
+            Assert.That(packer.TryAllocate(512, out AAAAShadowAtlasPacker.Tile _), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_RandomAllocations_DoNotOverlapAndMergeBack([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+            var tiles = new List<AAAAShadowAtlasPacker.Tile>();
+
+            for (int iteration = 0; iteration < 1000; iteration++)
+            {
+                if (tiles.Count == 0 || random.NextFloat() < 0.6f)
+                {
+                    int size = MinTileSize << random.NextInt(0, 4);
+                    if (packer.TryAllocate(size, out AAAAShadowAtlasPacker.Tile tile))
+                    {
+                        tiles.Add(tile);
+                    }
+                    else
+                    {
+                        Assert.That(packer.LargestFreeTileSize, Is.LessThan(size));
+                    }
+                }
+                else
+                {
+                    int index = random.NextInt(0, tiles.Count);
+                    packer.Free(tiles[index]);
+                    tiles.RemoveAt(index);
+                }
+
+                Assert.That(packer.AllocatedArea, Is.EqualTo(SumArea(tiles)));
+            }
+
+            AssertNoOverlaps(tiles);
+
+            foreach (AAAAShadowAtlasPacker.Tile tile in tiles)
+            {
+                packer.Free(tile);
+            }
+
+            Assert.That(packer.IsEmpty, Is.True);
+            Assert.That(packer.Fragmentation, Is.Zero);
+            Assert.That(packer.LargestFreeTileSize, Is.EqualTo(PageSize));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Packer_IsDeterministic([Values(1u, 2u, 3u)] uint seed)
+        {
+            List<int2> first = PackRandomSequence(seed);
+            List<int2> second = PackRandomSequence(seed);
+
+            CollectionAssert.AreEqual(first, second);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Allocator_PersistentLights_KeepTheirTiles([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            var allocator = new AAAAShadowAtlasAllocator(CreateSettings(2));
+            var persistentAllocations = new Dictionary<int, AAAAShadowAtlasAllocator.Allocation>();
+
+            for (int frame = 0; frame < 200; frame++)
+            {
+                allocator.BeginFrame();
+
+                for (int lightID = 0; lightID < 4; lightID++)
+                {
+                    AAAAShadowAtlasAllocator.Allocation allocation = allocator.Allocate(Key(lightID), 256);
+                    Assert.That(allocation.IsValid, Is.True);
+
+                    if (persistentAllocations.TryGetValue(lightID, out AAAAShadowAtlasAllocator.Allocation previousAllocation))
+                    {
+                        Assert.That(allocation, Is.EqualTo(previousAllocation));
+                    }
+
+                    persistentAllocations[lightID] = allocation;
+                }
+
+                // Lights that flicker in and out of view.
+                int transientCount = random.NextInt(0, 12);
+                for (int i = 0; i < transientCount; i++)
+                {
+                    allocator.Allocate(Key(100 + random.NextInt(0, 32)), MinTileSize << random.NextInt(0, 3));
+                }
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Allocator_UnusedTiles_AreReleasedAfterRetainFrames()
+        {
+            AAAAShadowAtlasAllocator.Settings settings = CreateSettings(1);
+            var allocator = new AAAAShadowAtlasAllocator(settings);
+
+            allocator.BeginFrame();
+            allocator.Allocate(Key(0), 512);
+
+            for (int frame = 0; frame < settings.RetainFrames; frame++)
+            {
+                allocator.BeginFrame();
+                Assert.That(allocator.TileCount, Is.EqualTo(1));
+            }
+
+            allocator.BeginFrame();
+            Assert.That(allocator.TileCount, Is.Zero);
+            Assert.That(allocator.GetPage(0).IsEmpty, Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Allocator_RespectsPageBudget([Values(1, 2)] int maxPageCount)
+        {
+            var allocator = new AAAAShadowAtlasAllocator(CreateSettings(maxPageCount));
+            allocator.BeginFrame();
+
+            // Leaves three 256 tiles free in the first page, which do not fit the 512 requests.
+            allocator.Allocate(Key(-1), 256);
+
+            int validCount = 0;
+            for (int lightID = 0; lightID < 64; lightID++)
+            {
+                AAAAShadowAtlasAllocator.Allocation allocation = allocator.Allocate(Key(lightID), 512);
+                if (allocation.IsValid)
+                {
+                    Assert.That(allocation.PageIndex, Is.LessThan(maxPageCount));
+                    ++validCount;
+                }
+            }
+
+            Assert.That(allocator.PageCount, Is.EqualTo(maxPageCount));
+
+            // Once no 512 tile is left, the requests shrink to fit the remaining 256 ones.
+            Assert.That(validCount, Is.EqualTo(4 * maxPageCount - 1 + 3));
+            for (int pageIndex = 0; pageIndex < allocator.PageCount; pageIndex++)
+            {
+                Assert.That(allocator.GetPage(pageIndex).Occupancy, Is.EqualTo(1.0f));
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Allocator_EvictsStaleTilesBeforeShrinking()
+        {
+            var allocator = new AAAAShadowAtlasAllocator(CreateSettings(1));
+
+            allocator.BeginFrame();
+            for (int lightID = 0; lightID < 4; lightID++)
+            {
+                allocator.Allocate(Key(lightID), 512);
+            }
+
+            // The old lights are still retained, but they were not requested this frame.
+            allocator.BeginFrame();
+            AAAAShadowAtlasAllocator.Allocation allocation = allocator.Allocate(Key(10), 1024);
+
+            Assert.That(allocation.Size, Is.EqualTo(1024));
+            Assert.That(allocator.TileCount, Is.EqualTo(1));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Allocator_ShrunkTile_GrowsBackWhenSpaceFrees()
+        {
+            var allocator = new AAAAShadowAtlasAllocator(CreateSettings(1));
+            int retainFrames = allocator.AllocatorSettings.RetainFrames;
+
+            allocator.BeginFrame();
+            allocator.Allocate(Key(1), 512);
+            allocator.Allocate(Key(2), 512);
+            allocator.Allocate(Key(3), 512);
+            allocator.Allocate(Key(4), 256);
+
+            // Only 256 tiles are left, so the new light gets a smaller tile.
+            for (int frame = 0; frame <= retainFrames; frame++)
+            {
+                allocator.BeginFrame();
+                allocator.Allocate(Key(1), 512);
+                allocator.Allocate(Key(2), 512);
+                allocator.Allocate(Key(3), 512);
+                allocator.Allocate(Key(4), 256);
+                Assert.That(allocator.Allocate(Key(5), 512).Size, Is.EqualTo(256));
+            }
+
+            // Light 3 is gone for good: its tile is released and the new light moves to it.
+            for (int frame = 0; frame <= retainFrames; frame++)
+            {
+                allocator.BeginFrame();
+                allocator.Allocate(Key(1), 512);
+                allocator.Allocate(Key(2), 512);
+                allocator.Allocate(Key(4), 256);
+                allocator.Allocate(Key(5), 512);
+            }
+
+            Assert.That(allocator.TryGetAllocation(Key(5), out AAAAShadowAtlasAllocator.Allocation allocation), Is.True);
+            Assert.That(allocation.Size, Is.EqualTo(512));
+        }
+
+        private static AAAAShadowAtlasAllocator.Key Key(int lightID) => new(0, lightID, 0);
+
+        private static AAAAShadowAtlasAllocator.Settings CreateSettings(int maxPageCount)
+        {
+            AAAAShadowAtlasAllocator.Settings settings = AAAAShadowAtlasAllocator.Settings.Default;
+            settings.PageSize = PageSize;
+            settings.MinTileSize = MinTileSize;
+            settings.MaxPageCount = maxPageCount;
+            return settings;
+        }
+
+        private static List<int2> PackRandomSequence(uint seed)
+        {
+            var random = new Random(seed);
+            var packer = new AAAAShadowAtlasPacker(PageSize, MinTileSize);
+            var tiles = new List<AAAAShadowAtlasPacker.Tile>();
+            var positions = new List<int2>();
+
+            for (int iteration = 0; iteration < 200; iteration++)
+            {
+                if (tiles.Count == 0 || random.NextBool())
+                {
+                    if (packer.TryAllocate(MinTileSize << random.NextInt(0, 4), out AAAAShadowAtlasPacker.Tile tile))
+                    {
+                        tiles.Add(tile);
+                        positions.Add(tile.Position);
+                    }
+                }
+                else
+                {
+                    int index = random.NextInt(0, tiles.Count);
+                    packer.Free(tiles[index]);
+                    tiles.RemoveAt(index);
+                }
+            }
+
+            return positions;
+        }
+
+        private static long SumArea(List<AAAAShadowAtlasPacker.Tile> tiles)
+        {
+            long area = 0;
+
+            foreach (AAAAShadowAtlasPacker.Tile tile in tiles)
+            {
+                area += (long) tile.Size * tile.Size;
+            }
+
+            return area;
+        }
+
+        private static void AssertNoOverlaps(List<AAAAShadowAtlasPacker.Tile> tiles)
+        {
+            for (int i = 0; i < tiles.Count; i++)
+            {
+                AAAAShadowAtlasPacker.Tile tile = tiles[i];
+                Assert.That(math.all(tile.Position >= 0 & tile.Position + tile.Size <= PageSize), Is.True);
+
+                for (int j = i + 1; j < tiles.Count; j++)
+                {
+                    AAAAShadowAtlasPacker.Tile otherTile = tiles[j];
+                    bool overlaps = math.all(tile.Position < otherTile.Position + otherTile.Size & otherTile.Position < tile.Position + tile.Size);
+                    Assert.That(overlaps, Is.False, $"Tiles at {tile.Position} and {otherTile.Position} overlap.");
+                }
+            }
+        }
+    }
+}
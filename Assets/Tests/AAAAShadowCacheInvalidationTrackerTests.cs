@@ -0,0 +1,236 @@
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+
+namespace Tests
+{
+    public class AAAAShadowCacheInvalidationTrackerTests
+    {
+        // Looks down -Z from the origin: x and y in [-10, 10], z in [-100, -0.1].
+        private static readonly float4x4 ViewProjection = float4x4.Ortho(20.0f, 20.0f, 0.1f, 100.0f);
+        private static readonly float4 RenderParams = math.float4(0.1f, 0.5f, 0.0f, 0.0f);
+        private static readonly AAAAShadowAtlasAllocator.Allocation Tile = new() { PageIndex = 0, Position = math.int2(256, 0), Size = 256 };
+
+        [Test] [Category("AAAA RP")]
+        public void UnchangedSplit_IsCached()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+
+            for (int frame = 2; frame < 10; frame++)
+            {
+                tracker.BeginFrame(frame);
+                Assert.That(ShouldRender(tracker, Key(0)), Is.False);
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CasterChangesInsideFrustum_Invalidate()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+            const int casterIndex = 3;
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            // Added.
+            tracker.BeginFrame(2);
+            tracker.OnCasterChanged(casterIndex, math.float3(-1, -1, -11), math.float3(1, 1, -9), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+
+            // Moved out of the frustum: the old bounds are still inside.
+            tracker.BeginFrame(3);
+            tracker.OnCasterChanged(casterIndex, math.float3(49, -1, -11), math.float3(51, 1, -9), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+
+            // Moved again, outside of the frustum all the time.
+            tracker.BeginFrame(4);
+            tracker.OnCasterChanged(casterIndex, math.float3(59, -1, -11), math.float3(61, 1, -9), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.False);
+
+            // Moved back and removed.
+            tracker.BeginFrame(5);
+            tracker.OnCasterChanged(casterIndex, math.float3(-1, -1, -11), math.float3(1, 1, -9), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+
+            tracker.BeginFrame(6);
+            tracker.OnCasterRemoved(casterIndex);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+
+            tracker.BeginFrame(7);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.False);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CastersBehindTheNearPlane_Invalidate()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            // Directional shadows are rendered without depth clipping, so such casters still end up in the shadow map.
+            tracker.BeginFrame(2);
+            tracker.OnCasterChanged(0, math.float3(-1, -1, 5), math.float3(1, 1, 7), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void NonCasters_DoNotInvalidate()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            tracker.BeginFrame(2);
+            tracker.OnCasterChanged(0, math.float3(-1, -1, -11), math.float3(1, 1, -9), false);
+            tracker.OnCasterRemoved(0);
+            tracker.OnCasterRemoved(100);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.False);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void LightTileAndParameterChanges_Invalidate()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            tracker.BeginFrame(2);
+            float4x4 movedViewProjection = math.mul(ViewProjection, float4x4.Translate(math.float3(0.5f, 0, 0)));
+            Assert.That(tracker.ShouldRenderSplit(Key(0), movedViewProjection, Tile, RenderParams), Is.True);
+
+            tracker.BeginFrame(3);
+            AAAAShadowAtlasAllocator.Allocation movedTile = Tile;
+            movedTile.Position = math.int2(512, 0);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), movedViewProjection, movedTile, RenderParams), Is.True);
+
+            tracker.BeginFrame(4);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), movedViewProjection, movedTile, RenderParams * 2.0f), Is.True);
+
+            tracker.BeginFrame(5);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), movedViewProjection, movedTile, RenderParams * 2.0f), Is.False);
+
+            tracker.BeginFrame(6);
+            tracker.InvalidateAll();
+            Assert.That(tracker.ShouldRenderSplit(Key(0), movedViewProjection, movedTile, RenderParams * 2.0f), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CameraDependentCasterLOD_InvalidatesWhenCameraMoves()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+            // The split keeps its matrices (e.g., a far cascade between two fits), only the camera moves.
+            float4x4 cameraProjection = float4x4.PerspectiveFov(math.radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+            float4x4 cameraView0 = math.mul(float4x4.Scale(1920, 1080, 1), cameraProjection);
+            float4x4 cameraView1 = math.mul(cameraView0, float4x4.Translate(math.float3(0, 0, -1)));
+
+            tracker.BeginFrame(1);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), ViewProjection, Tile, RenderParams, cameraView0), Is.True);
+
+            tracker.BeginFrame(2);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), ViewProjection, Tile, RenderParams, cameraView0), Is.False);
+
+            // Conservative caster LOD follows the camera, so the cached depth no longer matches.
+            tracker.BeginFrame(3);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), ViewProjection, Tile, RenderParams, cameraView1), Is.True);
+
+            tracker.BeginFrame(4);
+            Assert.That(tracker.ShouldRenderSplit(Key(0), ViewProjection, Tile, RenderParams, cameraView1), Is.False);
+
+            // Switching to caster LOD that does not depend on the camera.
+            tracker.BeginFrame(5);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SkippedFrame_Invalidates()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            // The tile might have been given to another split meanwhile.
+            tracker.BeginFrame(2);
+            tracker.BeginFrame(3);
+            Assert.That(tracker.CachedSplitCount, Is.Zero);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Splits_ConsumeCasterChangesIndependently()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+            ShouldRender(tracker, Key(1));
+
+            tracker.BeginFrame(2);
+            tracker.OnCasterChanged(0, math.float3(-1, -1, -11), math.float3(1, 1, -9), true);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+            // Another camera rendered later in the frame.
+            Assert.That(ShouldRender(tracker, Key(1)), Is.True);
+            Assert.That(ShouldRender(tracker, Key(0)), Is.False);
+
+            // Everybody has seen the change.
+            tracker.BeginFrame(3);
+            Assert.That(tracker.PendingDirtyRegionCount, Is.Zero);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void DirtyRegionOverflow_InvalidatesConservatively()
+        {
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+
+            tracker.BeginFrame(1);
+            ShouldRender(tracker, Key(0));
+
+            tracker.BeginFrame(2);
+            for (int i = 0; i <= AAAAShadowCacheInvalidationTracker.MaxDirtyRegions; i++)
+            {
+                // Far outside the frustum, but the split cannot know anymore.
+                tracker.OnCasterChanged(i, math.float3(1000, 0, 0), math.float3(1001, 1, 1), true);
+            }
+
+            Assert.That(tracker.PendingDirtyRegionCount, Is.LessThanOrEqualTo(AAAAShadowCacheInvalidationTracker.MaxDirtyRegions));
+            Assert.That(ShouldRender(tracker, Key(0)), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void StaticScene_WithMovingCasterElsewhere_RendersOnce([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            using var tracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+            int renderCount = 0;
+
+            for (int frame = 1; frame <= 100; frame++)
+            {
+                tracker.BeginFrame(frame);
+
+                // Wanders around, never getting close to the split.
+                float3 position = math.float3(random.NextFloat(30, 60), random.NextFloat(-50, 50), random.NextFloat(-50, 50));
+                tracker.OnCasterChanged(0, position - 1.0f, position + 1.0f, true);
+
+                if (ShouldRender(tracker, Key(0)))
+                {
+                    ++renderCount;
+                }
+            }
+
+            Assert.That(renderCount, Is.EqualTo(1));
+            Assert.That(tracker.PendingDirtyRegionCount, Is.LessThanOrEqualTo(2));
+        }
+
+        private static bool ShouldRender(AAAAShadowCacheInvalidationTracker tracker, in AAAAShadowAtlasAllocator.Key key) =>
+            tracker.ShouldRenderSplit(key, ViewProjection, Tile, RenderParams);
+
+        private static AAAAShadowAtlasAllocator.Key Key(int cameraID) => new(cameraID, 1, 0);
+    }
+}
@@ -0,0 +1,214 @@
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+
+namespace Tests
+{
+    public class AAAAShadowCascadeSchedulerTests
+    {
+        private const int CascadeCount = 4;
+        private const int Resolution = 1024;
+        private const float NearPlane = 0.1f;
+        private const float FarPlane = 100.0f;
+        private static readonly float[] CascadeDistances = { 0.0f, 25.0f, 50.0f, 75.0f, 100.0f };
+        private static readonly quaternion LightRotation = quaternion.Euler(math.radians(50.0f), math.radians(30.0f), 0.0f);
+
+        private static readonly AAAAShadowCascadeScheduler.Settings Settings = new()
+        {
+            CascadeCount = CascadeCount,
+            NearCascadeCount = 2,
+            FarCascadeUpdateInterval = 4,
+            GuardBand = 0.1f,
+        };
+
+        [Test] [Category("AAAA RP")]
+        public void StaticCamera_FitsNearCascadesEveryFrame_AndFarCascadesRoundRobin()
+        {
+            var scheduler = new AAAAShadowCascadeScheduler();
+            var fitCounts = new int[CascadeCount];
+            const int frameCount = 40;
+
+            for (int frame = 1; frame <= frameCount; frame++)
+            {
+                scheduler.BeginFrame(frame);
+                int farFits = 0;
+
+                for (int cascadeIndex = 0; cascadeIndex < CascadeCount; cascadeIndex++)
+                {
+                    if (UpdateCascade(scheduler, Settings, cascadeIndex, float3.zero, LightRotation, out _))
+                    {
+                        ++fitCounts[cascadeIndex];
+                        if (frame > 1 && cascadeIndex >= Settings.NearCascadeCount)
+                        {
+                            ++farFits;
+                        }
+                    }
+                }
+
+                Assert.That(farFits, Is.LessThanOrEqualTo(1));
+            }
+
+            Assert.That(fitCounts[0], Is.EqualTo(frameCount));
+            Assert.That(fitCounts[1], Is.EqualTo(frameCount));
+            Assert.That(fitCounts[2], Is.InRange(frameCount / Settings.FarCascadeUpdateInterval, frameCount / Settings.FarCascadeUpdateInterval + 1));
+            Assert.That(fitCounts[3], Is.InRange(frameCount / Settings.FarCascadeUpdateInterval, frameCount / Settings.FarCascadeUpdateInterval + 1));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void KeptCascade_StillCoversTheSlice_UntilTheCameraLeavesTheGuardBand()
+        {
+            var scheduler = new AAAAShadowCascadeScheduler();
+            const int cascadeIndex = 3;
+            var settings = Settings;
+            // Never due, only camera movement triggers a fit.
+            settings.FarCascadeUpdateInterval = 1000;
+
+            scheduler.BeginFrame(1);
+            Assert.That(UpdateCascade(scheduler, settings, cascadeIndex, float3.zero, LightRotation, out float4x4 fittedViewProjection), Is.True);
+
+            float3 cameraPosition = float3.zero;
+            bool refitted = false;
+
+            for (int frame = 2; frame < 200 && !refitted; frame++)
+            {
+                scheduler.BeginFrame(frame);
+                cameraPosition.x += 0.25f;
+                refitted = UpdateCascade(scheduler, settings, cascadeIndex, cameraPosition, LightRotation, out float4x4 viewProjection);
+
+                if (!refitted)
+                {
+                    Assert.That(viewProjection, Is.EqualTo(fittedViewProjection));
+                    AssertCoversSlice(viewProjection, cascadeIndex, cameraPosition);
+                }
+            }
+
+            Assert.That(refitted, Is.True);
+            Assert.That(cameraPosition.x, Is.GreaterThan(0.5f));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void RotatedLight_IsFittedImmediately()
+        {
+            var scheduler = new AAAAShadowCascadeScheduler();
+            const int cascadeIndex = 3;
+            var settings = Settings;
+            settings.FarCascadeUpdateInterval = 1000;
+
+            scheduler.BeginFrame(1);
+            UpdateCascade(scheduler, settings, cascadeIndex, float3.zero, LightRotation, out _);
+
+            scheduler.BeginFrame(2);
+            Assert.That(UpdateCascade(scheduler, settings, cascadeIndex, float3.zero, LightRotation, out _), Is.False);
+
+            scheduler.BeginFrame(3);
+            quaternion rotatedLight = math.mul(LightRotation, quaternion.RotateY(math.radians(1.0f)));
+            Assert.That(UpdateCascade(scheduler, settings, cascadeIndex, float3.zero, rotatedLight, out _), Is.True);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void UpdateIntervalOfOne_FitsEveryCascadeEveryFrame()
+        {
+            var scheduler = new AAAAShadowCascadeScheduler();
+            var settings = Settings;
+            settings.FarCascadeUpdateInterval = 1;
+
+            for (int frame = 1; frame < 10; frame++)
+            {
+                scheduler.BeginFrame(frame);
+
+                for (int cascadeIndex = 0; cascadeIndex < CascadeCount; cascadeIndex++)
+                {
+                    Assert.That(UpdateCascade(scheduler, settings, cascadeIndex, float3.zero, LightRotation, out _), Is.True);
+                }
+            }
+
+            Assert.That(scheduler.FittedCascadeCount, Is.Zero);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CascadesOfSkippedFrames_AreForgotten()
+        {
+            var scheduler = new AAAAShadowCascadeScheduler();
+            var settings = Settings;
+            settings.FarCascadeUpdateInterval = 1000;
+
+            scheduler.BeginFrame(1);
+            UpdateCascade(scheduler, settings, 3, float3.zero, LightRotation, out _);
+            Assert.That(scheduler.FittedCascadeCount, Is.EqualTo(1));
+
+            scheduler.BeginFrame(3);
+            Assert.That(scheduler.FittedCascadeCount, Is.Zero);
+            Assert.That(UpdateCascade(scheduler, settings, 3, float3.zero, LightRotation, out _), Is.True);
+        }
+
+        // Same steps as AAAAShadowsData. Returns true if the cascade was fitted.
+        private static bool UpdateCascade(AAAAShadowCascadeScheduler scheduler, in AAAAShadowCascadeScheduler.Settings settings, int cascadeIndex,
+            float3 cameraPosition, quaternion lightRotation, out float4x4 viewProjection)
+        {
+            NativeArray<float3> frustumCorners = CreateFrustumCorners(cameraPosition);
+            var key = new AAAAShadowAtlasAllocator.Key(1, 2, cascadeIndex);
+            float splitNear = CascadeDistances[cascadeIndex];
+            float splitFar = CascadeDistances[cascadeIndex + 1];
+
+            float4x4 lightView = AAAAShadowUtils.ConstructLightView(lightRotation);
+            AAAAShadowUtils.ComputeDirectionalLightCascadeSphere(frustumCorners, cameraPosition, lightView, splitNear, splitFar,
+                out float3 centerLS, out float radius
+            );
+
+            bool shouldFit = scheduler.ShouldFitCascade(key, settings, lightView, centerLS, radius, Resolution, out float4x4 lightProjection);
+            if (shouldFit)
+            {
+                float guardBand = AAAAShadowCascadeScheduler.IsFarCascade(settings, cascadeIndex) ? settings.GuardBand : 0.0f;
+                AAAAShadowUtils.ComputeDirectionalLightShadowMatrices(frustumCorners, cameraPosition, FarPlane, Resolution, lightRotation,
+                    splitNear, splitFar, out lightView, out lightProjection, guardBand
+                );
+                scheduler.OnCascadeFitted(key, settings, lightView, lightProjection, Resolution);
+            }
+
+            viewProjection = math.mul(lightProjection, lightView);
+            frustumCorners.Dispose();
+            return shouldFit;
+        }
+
+        private static void AssertCoversSlice(float4x4 viewProjection, int cascadeIndex, float3 cameraPosition)
+        {
+            NativeArray<float3> frustumCorners = CreateFrustumCorners(cameraPosition);
+            float splitNear = math.max(NearPlane, CascadeDistances[cascadeIndex]);
+            float splitFar = CascadeDistances[cascadeIndex + 1];
+
+            for (int i = 0; i < frustumCorners.Length; i += 2)
+            {
+                float3 direction = math.normalize(frustumCorners[i + 1] - frustumCorners[i]);
+                foreach (float distance in new[] { splitNear, splitFar })
+                {
+                    float4 positionCS = math.mul(viewProjection, math.float4(cameraPosition + direction * distance, 1.0f));
+                    Assert.That(math.all(math.abs(positionCS.xy) <= 1.0f), Is.True);
+                }
+            }
+
+            frustumCorners.Dispose();
+        }
+
+        // A camera looking down +Z with a 60 degree field of view, in the order AAAAShadowsData uses.
+        private static NativeArray<float3> CreateFrustumCorners(float3 cameraPosition)
+        {
+            var corners = new NativeArray<float3>(8, Allocator.Persistent);
+            float tanHalfFov = math.tan(math.radians(30.0f));
+            int index = 0;
+
+            for (int x = 0; x < 2; x++)
+            {
+                for (int y = 0; y < 2; y++)
+                {
+                    foreach (float depth in new[] { NearPlane, FarPlane })
+                    {
+                        corners[index++] = cameraPosition + math.float3((2 * x - 1) * depth * tanHalfFov, (2 * y - 1) * depth * tanHalfFov, depth);
+                    }
+                }
+            }
+
+            return corners;
+        }
+    }
+}
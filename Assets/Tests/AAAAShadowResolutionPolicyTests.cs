@@ -0,0 +1,233 @@
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAShadowResolutionPolicyTests
+    {
+        private const int MaxResolution = 2048;
+        private const int CameraID = 1;
+
+        private static readonly AAAAShadowResolutionPolicy.ViewParameters View = new()
+        {
+            Position = float3.zero,
+            ScreenSize = math.int2(1920, 1080),
+            IsOrthographic = false,
+            TanHalfFovY = math.tan(math.radians(60.0f) * 0.5f),
+        };
+
+        [Test] [Category("AAAA RP")]
+        public void ProjectedDiameter_GrowsAsTheLightGetsCloser()
+        {
+            float far = AAAAShadowResolutionPolicy.GetProjectedDiameter(View, math.float3(0, 0, 100), 5.0f);
+            float near = AAAAShadowResolutionPolicy.GetProjectedDiameter(View, math.float3(0, 0, 20), 5.0f);
+            float inside = AAAAShadowResolutionPolicy.GetProjectedDiameter(View, math.float3(0, 0, 2), 5.0f);
+
+            Assert.That(far, Is.GreaterThan(0.0f));
+            Assert.That(near, Is.GreaterThan(far));
+            Assert.That(inside, Is.EqualTo(1920.0f));
+            Assert.That(AAAAShadowResolutionPolicy.GetScreenCoverage(View, inside), Is.EqualTo(1.0f));
+            Assert.That(AAAAShadowResolutionPolicy.GetScreenCoverage(View, far), Is.LessThan(AAAAShadowResolutionPolicy.GetScreenCoverage(View, near)));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Tier_IsClampedPowerOfTwo()
+        {
+            Assert.That(AAAAShadowResolutionPolicy.GetTier(10.0f, 128, MaxResolution), Is.EqualTo(128));
+            Assert.That(AAAAShadowResolutionPolicy.GetTier(300.0f, 128, MaxResolution), Is.EqualTo(512));
+            Assert.That(AAAAShadowResolutionPolicy.GetTier(512.0f, 128, MaxResolution), Is.EqualTo(512));
+            Assert.That(AAAAShadowResolutionPolicy.GetTier(100000.0f, 128, MaxResolution), Is.EqualTo(MaxResolution));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void LightOnTierBoundary_DoesNotPop()
+        {
+            var policy = new AAAAShadowResolutionPolicy(AAAAShadowResolutionPolicy.Settings.Default);
+            using var requests = new NativeArray<AAAAShadowResolutionPolicy.Request>(1, Allocator.Temp);
+
+            int firstResolution = Select(policy, requests, 500.0f);
+            Assert.That(firstResolution, Is.EqualTo(512));
+
+            for (int frame = 0; frame < 10; frame++)
+            {
+                Assert.That(Select(policy, requests, frame % 2 == 0 ? 530.0f : 500.0f), Is.EqualTo(512));
+            }
+
+            // Far enough past the boundary.
+            Assert.That(Select(policy, requests, 700.0f), Is.EqualTo(1024));
+            Assert.That(Select(policy, requests, 500.0f), Is.EqualTo(1024));
+            Assert.That(Select(policy, requests, 300.0f), Is.EqualTo(512));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CameraPath_ChangesTiersMonotonically([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            var policy = new AAAAShadowResolutionPolicy(AAAAShadowResolutionPolicy.Settings.Default);
+            using var requests = new NativeArray<AAAAShadowResolutionPolicy.Request>(1, Allocator.Temp);
+            var lightPosition = math.float3(3, 1, 0);
+            const float lightRange = 4.0f;
+            const int frameCount = 500;
+
+            int previousResolution = 0;
+            int tierChangeCount = 0;
+
+            // Walks toward the light with a shaky camera.
+            for (int frame = 0; frame < frameCount; frame++)
+            {
+                AAAAShadowResolutionPolicy.ViewParameters view = View;
+                float distance = math.lerp(300.0f, 6.0f, frame / (frameCount - 1.0f));
+                view.Position = lightPosition - math.float3(0, 0, distance) + random.NextFloat3(-0.5f, 0.5f);
+
+                policy.BeginFrame();
+                float diameter = AAAAShadowResolutionPolicy.GetProjectedDiameter(view, lightPosition, lightRange);
+                int resolution = Select(policy, requests, diameter);
+
+                Assert.That(resolution, Is.GreaterThanOrEqualTo(previousResolution));
+                if (resolution != previousResolution)
+                {
+                    ++tierChangeCount;
+                }
+
+                previousResolution = resolution;
+            }
+
+            // 128 -> 256 -> 512 -> 1024 -> 2048.
+            Assert.That(previousResolution, Is.EqualTo(MaxResolution));
+            Assert.That(tierChangeCount, Is.EqualTo(5));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CameraPath_StaysWithinBudget_AndIsDeterministic([Values(1u, 2u, 3u)] uint seed)
+        {
+            AAAAShadowResolutionPolicy.Settings settings = AAAAShadowResolutionPolicy.Settings.Default;
+            settings.RenderBudgetTexels = 8L * 1024 * 1024;
+            var policy1 = new AAAAShadowResolutionPolicy(settings);
+            var policy2 = new AAAAShadowResolutionPolicy(settings);
+
+            var random = new Random(seed);
+            const int lightCount = 16;
+            var lightPositions = new float3[lightCount];
+            for (int i = 0; i < lightCount; i++)
+            {
+                lightPositions[i] = random.NextFloat3(-30.0f, 30.0f);
+            }
+
+            using var requests1 = new NativeArray<AAAAShadowResolutionPolicy.Request>(lightCount + 1, Allocator.Temp);
+            using var requests2 = new NativeArray<AAAAShadowResolutionPolicy.Request>(lightCount + 1, Allocator.Temp);
+
+            for (int frame = 0; frame < 200; frame++)
+            {
+                float angle = frame * 0.05f;
+                AAAAShadowResolutionPolicy.ViewParameters view = View;
+                view.Position = math.float3(math.cos(angle), 0.1f, math.sin(angle)) * 40.0f;
+
+                FillRequests(view, lightPositions, requests1);
+                FillRequests(view, lightPositions, requests2);
+                // The order of the lights does not matter.
+                Reverse(requests2);
+
+                policy1.BeginFrame();
+                policy2.BeginFrame();
+                policy1.SelectResolutions(requests1, MaxResolution);
+                policy2.SelectResolutions(requests2, MaxResolution);
+                Reverse(requests2);
+
+                long totalTexels = 0;
+                int directionalResolution = requests1[lightCount].Resolution;
+                for (int i = 0; i < requests1.Length; i++)
+                {
+                    Assert.That(requests2[i].Resolution, Is.EqualTo(requests1[i].Resolution));
+                    Assert.That(math.ispow2(requests1[i].Resolution), Is.True);
+                    // The directional light covers the whole screen, so punctual lights lose resolution first.
+                    Assert.That(requests1[i].Resolution, Is.LessThanOrEqualTo(directionalResolution));
+                    totalTexels += requests1[i].GetTexelCount();
+                }
+
+                Assert.That(totalTexels, Is.LessThanOrEqualTo(policy1.BudgetTexels));
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void OverBudget_HalvesTheMostOverservedLightsFirst()
+        {
+            AAAAShadowResolutionPolicy.Settings settings = AAAAShadowResolutionPolicy.Settings.Default;
+            settings.RenderBudgetTexels = 1024 * 1024 + 2 * 512 * 512;
+            var policy = new AAAAShadowResolutionPolicy(settings);
+            var requests = new NativeArray<AAAAShadowResolutionPolicy.Request>(3, Allocator.Temp);
+
+            requests[0] = CreateRequest(0, 1024.0f, 1.0f, 1);
+            requests[1] = CreateRequest(1, 1000.0f, 0.5f, 1);
+            requests[2] = CreateRequest(2, 600.0f, 0.1f, 1);
+            policy.SelectResolutions(requests, MaxResolution);
+
+            Assert.That(requests[0].Resolution, Is.EqualTo(1024));
+            Assert.That(requests[1].Resolution, Is.EqualTo(512));
+            Assert.That(requests[2].Resolution, Is.EqualTo(512));
+
+            requests.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void LightsNotRequested_AreForgotten()
+        {
+            AAAAShadowResolutionPolicy.Settings settings = AAAAShadowResolutionPolicy.Settings.Default;
+            var policy = new AAAAShadowResolutionPolicy(settings);
+            using var requests = new NativeArray<AAAAShadowResolutionPolicy.Request>(1, Allocator.Temp);
+
+            policy.BeginFrame();
+            Select(policy, requests, 500.0f);
+            Assert.That(policy.TrackedLightCount, Is.EqualTo(1));
+
+            for (int frame = 0; frame <= settings.RetainFrames; frame++)
+            {
+                policy.BeginFrame();
+            }
+
+            Assert.That(policy.TrackedLightCount, Is.Zero);
+        }
+
+        private static int Select(AAAAShadowResolutionPolicy policy, NativeArray<AAAAShadowResolutionPolicy.Request> requests,
+            float desiredResolution)
+        {
+            requests[0] = CreateRequest(0, desiredResolution, 0.5f, 1);
+            policy.SelectResolutions(requests, MaxResolution);
+            return requests[0].Resolution;
+        }
+
+        private static void FillRequests(in AAAAShadowResolutionPolicy.ViewParameters view, float3[] lightPositions,
+            NativeArray<AAAAShadowResolutionPolicy.Request> requests)
+        {
+            const float lightRange = 8.0f;
+
+            for (int i = 0; i < lightPositions.Length; i++)
+            {
+                float diameter = AAAAShadowResolutionPolicy.GetProjectedDiameter(view, lightPositions[i], lightRange);
+                float coverage = AAAAShadowResolutionPolicy.GetScreenCoverage(view, diameter);
+                requests[i] = CreateRequest(i, diameter, coverage, i % 2 == 0 ? 1 : 4);
+            }
+
+            requests[lightPositions.Length] = CreateRequest(lightPositions.Length, MaxResolution, 1.0f, 2);
+        }
+
+        private static AAAAShadowResolutionPolicy.Request CreateRequest(int lightID, float desiredResolution, float screenCoverage, int splitCount) =>
+            new()
+            {
+                Key = new AAAAShadowAtlasAllocator.Key(CameraID, lightID, 0),
+                DesiredResolution = desiredResolution,
+                ScreenCoverage = screenCoverage,
+                SplitCount = splitCount,
+            };
+
+        private static void Reverse(NativeArray<AAAAShadowResolutionPolicy.Request> requests)
+        {
+            for (int i = 0, j = requests.Length - 1; i < j; i++, j--)
+            {
+                (requests[i], requests[j]) = (requests[j], requests[i]);
+            }
+        }
+    }
+}
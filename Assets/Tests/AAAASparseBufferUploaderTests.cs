@@ -0,0 +1,112 @@
+using System.Diagnostics;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Utils;
+using NUnit.Framework;
+using Unity.Collections;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAASparseBufferUploaderTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void Prepare_StagesDeduplicatedSortedRecords()
+        {
+            using var uploader = CreateUploader();
+            var source = new NativeArray<AAAAInstanceData>(100, Allocator.Persistent);
+
+            for (int i = 0; i < source.Length; i++)
+            {
+                source[i] = new AAAAInstanceData { MaterialIndex = (uint) i };
+            }
+
+            using var dirtyIndices = new NativeList<int>(Allocator.Persistent);
+
+            foreach (int index in new[] { 42, 7, 42, 99, 7 })
+            {
+                dirtyIndices.Add(index);
+            }
+
+            AAAASparseBufferUploader<AAAAInstanceData>.UploadMode uploadMode = uploader.Prepare(source, dirtyIndices, false);
+
+            Assert.AreEqual(AAAASparseBufferUploader<AAAAInstanceData>.UploadMode.Scatter, uploadMode);
+            CollectionAssert.AreEqual(new[] { 7, 42, 99 }, uploader.StagingIndices.ToArray());
+
+            for (int i = 0; i < uploader.StagingIndices.Length; i++)
+            {
+                Assert.AreEqual((uint) uploader.StagingIndices[i], uploader.StagingRecords[i].MaterialIndex);
+            }
+
+            source.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Prepare_FallsBackToBulkWhenMostRecordsChanged()
+        {
+            using var uploader = CreateUploader();
+            using var source = new NativeArray<AAAAInstanceData>(100, Allocator.Persistent);
+            using var dirtyIndices = new NativeList<int>(Allocator.Persistent);
+
+            for (int i = 0; i < 60; i++)
+            {
+                dirtyIndices.Add(i);
+            }
+
+            Assert.AreEqual(AAAASparseBufferUploader<AAAAInstanceData>.UploadMode.Bulk, uploader.Prepare(source, dirtyIndices, false));
+            Assert.AreEqual(source.Length * AAAASparseBufferUploader<AAAAInstanceData>.RecordStride, uploader.LastUploadedBytes);
+
+            dirtyIndices.Clear();
+            Assert.AreEqual(AAAASparseBufferUploader<AAAAInstanceData>.UploadMode.None, uploader.Prepare(source, dirtyIndices, false));
+            Assert.AreEqual(AAAASparseBufferUploader<AAAAInstanceData>.UploadMode.Bulk, uploader.Prepare(source, dirtyIndices, true));
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_10KInstances_1PercentMoving_UploadedBytes()
+        {
+            const int instanceCount = 10_000;
+            const int movingInstanceCount = instanceCount / 100;
+            const int frames = 100;
+
+            using var uploader = CreateUploader();
+            using var source = new NativeArray<AAAAInstanceData>(instanceCount, Allocator.Persistent);
+            using var dirtyIndices = new NativeList<int>(movingInstanceCount, Allocator.Persistent);
+
+            var random = new Random(42);
+            long sparseBytes = 0;
+            long bulkBytes = 0;
+
+            // Warm up Burst compilation.
+            dirtyIndices.Add(0);
+            uploader.Prepare(source, dirtyIndices, false);
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int frame = 0; frame < frames; frame++)
+            {
+                dirtyIndices.Clear();
+
+                for (int i = 0; i < movingInstanceCount; i++)
+                {
+                    dirtyIndices.Add(random.NextInt(0, instanceCount));
+                }
+
+                Assert.AreEqual(AAAASparseBufferUploader<AAAAInstanceData>.UploadMode.Scatter, uploader.Prepare(source, dirtyIndices, false));
+                sparseBytes += uploader.LastUploadedBytes;
+                bulkBytes += source.Length * AAAASparseBufferUploader<AAAAInstanceData>.RecordStride;
+            }
+
+            stopwatch.Stop();
+
+            Assert.Less(sparseBytes * 50, bulkBytes);
+            Debug.Log($"{instanceCount} instances, {movingInstanceCount} moving: {sparseBytes / frames} B/frame scattered vs {bulkBytes / frames} B/frame bulk, " +
+                      $"staging {stopwatch.Elapsed.TotalMilliseconds / frames:F3} ms/frame."
+            );
+        }
+
+        private static AAAASparseBufferUploader<AAAAInstanceData> CreateUploader() =>
+            new(null, AAAASparseBufferUpload.InstanceDataKernelIndex,
+                AAAASparseBufferUpload.ShaderID._ScatterInstanceRecords, AAAASparseBufferUpload.ShaderID._ScatterInstanceDestination, "Test"
+            );
+    }
+}
@@ -0,0 +1,156 @@
+using System;
+using DELTation.AAAARP.Lighting;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAASphericalHarmonicsTests
+    {
+        private const int Resolution = AAAASphericalHarmonics.ProjectionResolution;
+
+        [Test] [Category("AAAA RP")]
+        public void TexelSolidAngles_CoverTheSphere()
+        {
+            float texelSize = 2.0f / Resolution;
+            double solidAngleSum = 0.0;
+
+            for (int y = 0; y < Resolution; y++)
+            {
+                for (int x = 0; x < Resolution; x++)
+                {
+                    float2 uv = (math.float2(x, y) + 0.5f) * texelSize - 1.0f;
+                    solidAngleSum += 6 * AAAASphericalHarmonics.GetCubemapTexelSolidAngle(uv, texelSize);
+                }
+            }
+
+            Assert.That(solidAngleSum, Is.EqualTo(4.0 * math.PI).Within(0.01 * 4.0 * math.PI));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void ConstantEnvironment_IrradianceEqualsRadiance()
+        {
+            var radiance = math.float3(1.0f, 0.5f, 0.25f);
+            float3[] coefficients = Project(_ => radiance);
+
+            var random = new Random(42);
+            for (int i = 0; i < 64; i++)
+            {
+                float3 irradiance = AAAASphericalHarmonics.EvaluateIrradiance(coefficients, random.NextFloat3Direction());
+                Assert.That(math.all(math.abs(irradiance - radiance) < 1e-3f), Is.True, $"{irradiance} vs {radiance}");
+            }
+        }
+
+        // Up to band 2, SH9 represents the environment exactly, so only the discretization of the cubemap is left.
+        [Test] [Category("AAAA RP")]
+        public void BandLimitedEnvironment_MatchesBruteForceConvolution([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            float3 constant = random.NextFloat3(1.0f, 2.0f);
+            float3 linearAxis = random.NextFloat3Direction();
+            float3 linearColor = random.NextFloat3(0.0f, 0.5f);
+            float3x3 quadraticMatrix = RandomSymmetricMatrix(ref random);
+            float3 quadraticColor = random.NextFloat3(0.0f, 0.5f);
+
+            Func<float3, float3> radiance = d =>
+                constant + linearColor * math.dot(linearAxis, d) + quadraticColor * math.dot(d, math.mul(quadraticMatrix, d));
+            float3[] coefficients = Project(radiance);
+
+            for (int i = 0; i < 32; i++)
+            {
+                float3 normal = random.NextFloat3Direction();
+                float3 expected = ConvolveBruteForce(radiance, normal);
+                float3 actual = AAAASphericalHarmonics.EvaluateIrradiance(coefficients, normal);
+                Assert.That(math.all(math.abs(actual - expected) < 1e-3f), Is.True, $"Normal {normal}: {actual} vs {expected}");
+            }
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void SkyEnvironment_IsCloseToBruteForceConvolution()
+        {
+            Func<float3, float3> radiance = d => math.float3(0.2f, 0.3f, 0.5f) + math.float3(2.0f, 1.8f, 1.5f) * math.max(0.0f, d.y);
+            float3[] coefficients = Project(radiance);
+
+            var random = new Random(42);
+            double errorSum = 0.0;
+            double irradianceSum = 0.0;
+
+            for (int i = 0; i < 64; i++)
+            {
+                float3 normal = random.NextFloat3Direction();
+                float3 expected = ConvolveBruteForce(radiance, normal);
+                float3 actual = AAAASphericalHarmonics.EvaluateIrradiance(coefficients, normal);
+                errorSum += math.csum(math.abs(actual - expected));
+                irradianceSum += math.csum(expected);
+            }
+
+            double relativeError = errorSum / irradianceSum;
+            Debug.Log($"SH9 diffuse irradiance of a sky: {relativeError:P2} mean relative error.");
+            Assert.That(relativeError, Is.LessThan(0.02));
+        }
+
+        private static float3[] Project(Func<float3, float3> radiance)
+        {
+            var texels = new NativeArray<float3>(6 * Resolution * Resolution, Allocator.Persistent);
+            float texelSize = 2.0f / Resolution;
+
+            for (int texelIndex = 0; texelIndex < texels.Length; texelIndex++)
+            {
+                int sideIndex = texelIndex / (Resolution * Resolution);
+                int sideTexelIndex = texelIndex % (Resolution * Resolution);
+                float2 uv = (math.float2(sideTexelIndex % Resolution, sideTexelIndex / Resolution) + 0.5f) * texelSize - 1.0f;
+                texels[texelIndex] = radiance(AAAASphericalHarmonics.GetCubemapSampleDirection(sideIndex, uv));
+            }
+
+            float3[] coefficients = AAAASphericalHarmonics.ProjectIrradiance(texels, Resolution);
+            texels.Dispose();
+            return coefficients;
+        }
+
+        // The same integral as ConvolveDiffuseIrradiance.shader, on a midpoint grid over the hemisphere.
+        private static float3 ConvolveBruteForce(Func<float3, float3> radiance, float3 normal)
+        {
+            const int thetaSteps = 128;
+            const int phiSteps = 256;
+            const double thetaDelta = 0.5 * Math.PI / thetaSteps;
+            const double phiDelta = 2.0 * Math.PI / phiSteps;
+
+            float3 up = math.abs(normal.y) < 0.999f ? math.float3(0, 1, 0) : math.float3(1, 0, 0);
+            float3 right = math.normalize(math.cross(up, normal));
+            up = math.cross(normal, right);
+
+            double3 irradiance = 0.0;
+
+            for (int thetaIndex = 0; thetaIndex < thetaSteps; thetaIndex++)
+            {
+                double theta = (thetaIndex + 0.5) * thetaDelta;
+                math.sincos(theta, out double sinTheta, out double cosTheta);
+
+                for (int phiIndex = 0; phiIndex < phiSteps; phiIndex++)
+                {
+                    double phi = (phiIndex + 0.5) * phiDelta;
+                    math.sincos(phi, out double sinPhi, out double cosPhi);
+
+                    float3 direction = (float) (sinTheta * cosPhi) * right + (float) (sinTheta * sinPhi) * up + (float) cosTheta * normal;
+                    irradiance += (double3) radiance(direction) * (cosTheta * sinTheta * thetaDelta * phiDelta);
+                }
+            }
+
+            return (float3) (irradiance / Math.PI);
+        }
+
+        private static float3x3 RandomSymmetricMatrix(ref Random random)
+        {
+            float3 diagonal = random.NextFloat3(-1.0f, 1.0f);
+            float3 offDiagonal = random.NextFloat3(-1.0f, 1.0f);
+            return new float3x3(
+                diagonal.x, offDiagonal.x, offDiagonal.y,
+                offDiagonal.x, diagonal.y, offDiagonal.z,
+                offDiagonal.y, offDiagonal.z, diagonal.z
+            );
+        }
+    }
+}
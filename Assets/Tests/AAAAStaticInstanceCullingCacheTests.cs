@@ -0,0 +1,261 @@
+using System.Collections.Generic;
+using System.Diagnostics;
+using DELTation.AAAARP;
+using DELTation.AAAARP.Culling;
+using DELTation.AAAARP.Passes;
+using NUnit.Framework;
+using Unity.Collections;
+using Unity.Mathematics;
+using UnityEngine;
+using Debug = UnityEngine.Debug;
+using Random = Unity.Mathematics.Random;
+
+namespace Tests
+{
+    public class AAAAStaticInstanceCullingCacheTests
+    {
+        [Test] [Category("AAAA RP")]
+        public void MovedInstance_StaysDynamicForDynamicFrameCount()
+        {
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var moved = new NativeArray<int>(new[] { 3 }, Allocator.Persistent);
+
+            cache.BeginFrame(1);
+            uint initialVersion = cache.SceneVersion;
+
+            cache.OnInstancesMoved(moved);
+            Assert.IsTrue(cache.IsDynamic(3));
+            Assert.IsFalse(cache.IsDynamic(2));
+            Assert.AreNotEqual(initialVersion, cache.SceneVersion);
+
+            // Moving an instance that is already dynamic does not affect the cached static results.
+            uint dynamicVersion = cache.SceneVersion;
+            cache.OnInstancesMoved(moved);
+            cache.BeginFrame(1 + AAAAStaticInstanceCullingCache.DynamicFrameCount - 1);
+            Assert.IsTrue(cache.IsDynamic(3));
+            Assert.AreEqual(dynamicVersion, cache.SceneVersion);
+
+            cache.BeginFrame(1 + AAAAStaticInstanceCullingCache.DynamicFrameCount);
+            Assert.IsFalse(cache.IsDynamic(3));
+            Assert.AreEqual(0, cache.DynamicInstances.Length);
+            Assert.AreNotEqual(dynamicVersion, cache.SceneVersion);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CachedView_IsReusedUntilSceneEdit()
+        {
+            using var scene = AAAACullingTestScene.CreateScattered(1000, new Random(1));
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var candidates = new NativeList<int>(Allocator.Persistent);
+            GPUCullingContext view = CreateView(float3.zero, quaternion.identity);
+
+            cache.BeginFrame(1);
+            Assert.IsFalse(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+            int[] missCandidates = candidates.AsArray().ToArray();
+
+            candidates.Clear();
+            Assert.IsTrue(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+            CollectionAssert.AreEqual(missCandidates, candidates.AsArray().ToArray());
+
+            cache.BeginFrame(2);
+            candidates.Clear();
+            Assert.IsTrue(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+
+            cache.OnInstanceChanged(0);
+            candidates.Clear();
+            Assert.IsFalse(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+            Assert.AreEqual(1, cache.CachedViewCount);
+
+            cache.OnInstanceRemoved(1);
+            candidates.Clear();
+            Assert.IsFalse(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CachedView_IsInvalidatedByTranslationOutsideMarginAndRotation()
+        {
+            using var scene = AAAACullingTestScene.CreateScattered(1000, new Random(2));
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var candidates = new NativeList<int>(Allocator.Persistent);
+            const float margin = AAAAStaticInstanceCullingCache.TranslationMargin;
+
+            cache.BeginFrame(1);
+            Assert.IsFalse(cache.AppendCandidates(CreateView(float3.zero, quaternion.identity), scene.Instances, scene.InstanceIndices, candidates));
+            Assert.IsTrue(cache.AppendCandidates(CreateView(new float3(margin * 0.25f, 0, 0), quaternion.identity), scene.Instances,
+                    scene.InstanceIndices, candidates
+                )
+            );
+            Assert.IsFalse(cache.AppendCandidates(CreateView(new float3(margin * 2.0f, 0, 0), quaternion.identity), scene.Instances,
+                    scene.InstanceIndices, candidates
+                )
+            );
+            Assert.IsFalse(cache.AppendCandidates(CreateView(new float3(margin * 2.0f, 0, 0), quaternion.RotateY(0.01f)), scene.Instances,
+                    scene.InstanceIndices, candidates
+                )
+            );
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void CachedView_IsEvictedWhenUnused()
+        {
+            using var scene = AAAACullingTestScene.CreateScattered(100, new Random(3));
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var candidates = new NativeList<int>(Allocator.Persistent);
+
+            cache.BeginFrame(1);
+            cache.AppendCandidates(CreateView(float3.zero, quaternion.identity), scene.Instances, scene.InstanceIndices, candidates);
+            cache.AppendCandidates(CreateView(float3.zero, quaternion.RotateY(1.0f)), scene.Instances, scene.InstanceIndices, candidates);
+            Assert.AreEqual(2, cache.CachedViewCount);
+
+            cache.BeginFrame(100);
+            Assert.AreEqual(0, cache.CachedViewCount);
+        }
+
+        [Test] [Category("AAAA RP")]
+        public void Candidates_AreConservativeWithinTranslationMargin([Values(1u, 2u, 3u)] uint seed)
+        {
+            var random = new Random(seed);
+            using var scene = AAAACullingTestScene.CreateScattered(5000, random);
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var candidates = new NativeList<int>(Allocator.Persistent);
+            var moved = new NativeArray<int>(scene.Instances.Length / 10, Allocator.Persistent);
+
+            for (int i = 0; i < moved.Length; i++)
+            {
+                moved[i] = random.NextInt(scene.Instances.Length);
+            }
+
+            quaternion rotation = random.NextQuaternionRotation();
+            float3 position = random.NextFloat3(-10, 10);
+
+            cache.BeginFrame(1);
+            cache.OnInstancesMoved(moved);
+            Assert.IsFalse(cache.AppendCandidates(CreateView(position, rotation), scene.Instances, scene.InstanceIndices, candidates));
+
+            for (int iteration = 0; iteration < 10; iteration++)
+            {
+                float3 offset = random.NextFloat3Direction() * AAAAStaticInstanceCullingCache.TranslationMargin * 0.45f;
+                GPUCullingContext view = CreateView(position + offset, rotation);
+
+                candidates.Clear();
+                Assert.IsTrue(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+
+                var candidateSet = new HashSet<int>();
+                foreach (int instanceIndex in candidates)
+                {
+                    Assert.IsTrue(candidateSet.Add(instanceIndex), "Instances must not be culled twice.");
+                }
+
+                foreach (int instanceIndex in moved)
+                {
+                    Assert.IsTrue(candidateSet.Contains(instanceIndex));
+                }
+
+                for (int instanceIndex = 0; instanceIndex < scene.Instances.Length; instanceIndex++)
+                {
+                    if (IsVisible(view, scene.Instances[instanceIndex]))
+                    {
+                        Assert.IsTrue(candidateSet.Contains(instanceIndex), $"Visible instance {instanceIndex} is missing from the candidates.");
+                    }
+                }
+            }
+
+            moved.Dispose();
+        }
+
+        [Test] [Category("AAAA RP")] [Category("Performance")]
+        public void Benchmark_100KInstances_CachedVsFresh()
+        {
+            const int iterations = 10;
+
+            using var scene = AAAACullingTestScene.CreateScattered(100_000, new Random(42));
+            using var cache = new AAAAStaticInstanceCullingCache();
+            using var candidates = new NativeList<int>(scene.Instances.Length, Allocator.Persistent);
+            GPUCullingContext view = CreateView(float3.zero, quaternion.identity);
+
+            // Warm up Burst compilation.
+            cache.BeginFrame(1);
+            cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates);
+
+            var stopwatch = Stopwatch.StartNew();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                cache.Invalidate();
+                candidates.Clear();
+                cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates);
+            }
+
+            double freshMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+            stopwatch.Restart();
+
+            for (int i = 0; i < iterations; i++)
+            {
+                candidates.Clear();
+                Assert.IsTrue(cache.AppendCandidates(view, scene.Instances, scene.InstanceIndices, candidates));
+            }
+
+            double cachedMs = stopwatch.Elapsed.TotalMilliseconds / iterations;
+
+            Debug.Log($"Static instance culling of {scene.Instances.Length} instances, {candidates.Length} candidates: " +
+                      $"fresh {freshMs:F3} ms, cached {cachedMs:F3} ms."
+            );
+        }
+
+        private static unsafe GPUCullingContext CreateView(float3 position, quaternion rotation)
+        {
+            // Composed explicitly, so that translating the view keeps the rotation part bit-exact.
+            float4x4 viewMatrix = math.mul(float4x4.Scale(1, 1, -1),
+                math.mul(new float4x4(math.conjugate(rotation), float3.zero), float4x4.Translate(-position))
+            );
+            float4x4 projectionMatrix = float4x4.PerspectiveFov(math.radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+            float4x4 viewProjectionMatrix = math.mul(projectionMatrix, viewMatrix);
+
+            var cullingContext = new GPUCullingContext
+            {
+                ViewProjectionMatrix = viewProjectionMatrix,
+                ViewMatrix = viewMatrix,
+                CameraPosition = new float4(position, 1),
+                PassMask = (int) AAAAInstancePassMask.Main,
+                CameraIsPerspective = 1,
+            };
+
+            Plane[] frustumPlanes = GeometryUtility.CalculateFrustumPlanes(viewProjectionMatrix);
+            for (int i = 0; i < frustumPlanes.Length; i++)
+            {
+                cullingContext.FrustumPlanes[i * 4 + 0] = frustumPlanes[i].normal.x;
+                cullingContext.FrustumPlanes[i * 4 + 1] = frustumPlanes[i].normal.y;
+                cullingContext.FrustumPlanes[i * 4 + 2] = frustumPlanes[i].normal.z;
+                cullingContext.FrustumPlanes[i * 4 + 3] = frustumPlanes[i].distance;
+            }
+
+            return cullingContext;
+        }
+
+        private static unsafe bool IsVisible(GPUCullingContext cullingContext, in AAAAInstanceData instanceData)
+        {
+            if ((instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 || ((int) instanceData.PassMask & cullingContext.PassMask) == 0)
+            {
+                return false;
+            }
+
+            AAAACullingMath.TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                out float3 aabbMinWS, out float3 aabbMaxWS
+            );
+            float4 boundingSphere = AAAACullingMath.AABBToBoundingSphere(aabbMinWS, aabbMaxWS);
+
+            for (int i = 0; i < 6; i++)
+            {
+                var plane = new float4(cullingContext.FrustumPlanes[i * 4 + 0], cullingContext.FrustumPlanes[i * 4 + 1],
+                    cullingContext.FrustumPlanes[i * 4 + 2], cullingContext.FrustumPlanes[i * 4 + 3]
+                );
+                if (math.dot(new float4(boundingSphere.xyz, 1), plane) + boundingSphere.w <= 0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+}
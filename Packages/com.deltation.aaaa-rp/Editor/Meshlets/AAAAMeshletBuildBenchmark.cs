@@ -0,0 +1,238 @@
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using DELTation.AAAARP.Meshlets;
+using UnityEditor;
+using UnityEngine;
+using Debug = UnityEngine.Debug;
+using Object = UnityEngine.Object;
+
+namespace DELTation.AAAARP.Editor.Meshlets
+{
+    // Builds meshlet collections for the bundled models without importing them and reports timings and DAG quality.
+    // Batch mode usage:
+    // Unity -batchmode -projectPath <path> -executeMethod DELTation.AAAARP.Editor.Meshlets.AAAAMeshletBuildBenchmark.RunBatchMode
+    //     [-meshletBenchmarkOutput <path.json>]
+    internal static class AAAAMeshletBuildBenchmark
+    {
+        private const string OutputArgument = "-meshletBenchmarkOutput";
+        private const string DefaultOutputPath = "Logs/AAAAMeshletBuildBenchmark.json";
+
+        private static readonly string[] ModelPaths =
+        {
+            "Assets/Content/Models/Bunny/bunny.obj",
+            "Assets/Content/Models/Dragon/dragon.obj",
+            "Assets/Content/Models/Teapot/teapot.obj",
+            "Assets/Scenes/Sponza/sponza.obj",
+        };
+
+        [MenuItem("Tools/AAAA RP/Run Meshlet Build Benchmark")]
+        public static void RunFromMenu()
+        {
+            try
+            {
+                Run(DefaultOutputPath, (path, progress) => EditorUtility.DisplayProgressBar("Meshlet build benchmark", path, progress));
+            }
+            finally
+            {
+                EditorUtility.ClearProgressBar();
+            }
+        }
+
+        public static void RunBatchMode()
+        {
+            string outputPath = DefaultOutputPath;
+            string[] args = Environment.GetCommandLineArgs();
+
+            for (int i = 0; i < args.Length - 1; i++)
+            {
+                if (args[i] == OutputArgument)
+                {
+                    outputPath = args[i + 1];
+                }
+            }
+
+            int exitCode = 0;
+
+            try
+            {
+                Run(outputPath, null);
+            }
+            catch (Exception e)
+            {
+                Debug.LogException(e);
+                exitCode = 1;
+            }
+
+            EditorApplication.Exit(exitCode);
+        }
+
+        private static void Run(string outputPath, Action<string, float> onProgress)
+        {
+            var report = new BenchmarkReport
+            {
+                UnityVersion = Application.unityVersion,
+                Timestamp = DateTime.UtcNow.ToString("o"),
+            };
+
+            for (int modelIndex = 0; modelIndex < ModelPaths.Length; modelIndex++)
+            {
+                string modelPath = ModelPaths[modelIndex];
+                onProgress?.Invoke(modelPath, (float) modelIndex / ModelPaths.Length);
+
+                Mesh[] meshes = AssetDatabase.LoadAllAssetsAtPath(modelPath).OfType<Mesh>().ToArray();
+                if (meshes.Length == 0)
+                {
+                    Debug.LogWarning($"Meshlet build benchmark: no meshes found at {modelPath}, skipping.");
+                    continue;
+                }
+
+                report.Models.Add(BenchmarkModel(modelPath, meshes));
+            }
+
+            string directory = Path.GetDirectoryName(outputPath);
+            if (!string.IsNullOrEmpty(directory))
+            {
+                Directory.CreateDirectory(directory);
+            }
+
+            const bool prettyPrint = true;
+            File.WriteAllText(outputPath, JsonUtility.ToJson(report, prettyPrint));
+            Debug.Log($"Meshlet build benchmark finished for {report.Models.Count} models, results written to {outputPath}.");
+        }
+
+        private static ModelReport BenchmarkModel(string modelPath, Mesh[] meshes)
+        {
+            var modelReport = new ModelReport
+            {
+                Path = modelPath,
+            };
+
+            var statistics = new AAAAMeshletCollectionBuilder.BuildStatistics();
+            var levelTriangleCounts = new List<long>();
+            var levelNodeCounts = new List<long>();
+            long totalMeshletTriangles = 0;
+            long totalMeshletVertices = 0;
+
+            var stopwatch = Stopwatch.StartNew();
+
+            foreach (Mesh mesh in meshes)
+            {
+                for (int subMeshIndex = 0; subMeshIndex < mesh.subMeshCount; subMeshIndex++)
+                {
+                    AAAAMeshletCollectionAsset meshletCollection = ScriptableObject.CreateInstance<AAAAMeshletCollectionAsset>();
+
+                    try
+                    {
+                        // Same settings the model post processor uses.
+                        AAAAMeshletCollectionBuilder.Generate(meshletCollection, new AAAAMeshletCollectionBuilder.Parameters
+                            {
+                                Mesh = mesh,
+                                SourceMeshGUID = AssetDatabase.AssetPathToGUID(modelPath),
+                                SubMeshIndex = subMeshIndex,
+                                LogErrorHandler = Debug.LogError,
+                                TargetError = 0.02f,
+                                TargetErrorSloppy = 0.0f,
+                                MinTriangleReductionPerStep = 0.9f,
+                                MaxMeshLODLevelCount = 0,
+                                Statistics = statistics,
+                            }
+                        );
+
+                        ++modelReport.MeshletCollectionCount;
+                        modelReport.SourceTriangleCount += mesh.GetIndexCount(subMeshIndex) / 3;
+                        AccumulateLevels(meshletCollection, levelTriangleCounts, levelNodeCounts);
+
+                        foreach (AAAAMeshlet meshlet in meshletCollection.Meshlets)
+                        {
+                            totalMeshletTriangles += meshlet.TriangleCount;
+                            totalMeshletVertices += meshlet.VertexCount;
+                        }
+
+                        modelReport.MeshletCount += meshletCollection.Meshlets.Length;
+                    }
+                    finally
+                    {
+                        Object.DestroyImmediate(meshletCollection);
+                    }
+                }
+            }
+
+            stopwatch.Stop();
+
+            double metisMs = statistics.GetStageMilliseconds(AAAAMeshletCollectionBuilder.BuildStage.METIS);
+            modelReport.TotalMs = stopwatch.Elapsed.TotalMilliseconds;
+            modelReport.MeshletBuildMs = statistics.GetStageMilliseconds(AAAAMeshletCollectionBuilder.BuildStage.MeshletBuild);
+            // Grouping is reported without the time spent inside METIS.
+            modelReport.GroupingMs = statistics.GetStageMilliseconds(AAAAMeshletCollectionBuilder.BuildStage.Grouping) - metisMs;
+            modelReport.METISMs = metisMs;
+            modelReport.SimplifyMs = statistics.GetStageMilliseconds(AAAAMeshletCollectionBuilder.BuildStage.Simplify);
+            modelReport.FlattenMs = statistics.GetStageMilliseconds(AAAAMeshletCollectionBuilder.BuildStage.Flatten);
+            modelReport.PeakAllocatedBytes = statistics.PeakAllocatedBytes;
+            modelReport.LevelTriangleCounts = levelTriangleCounts.ToArray();
+            modelReport.LevelNodeCounts = levelNodeCounts.ToArray();
+
+            if (modelReport.MeshletCount > 0)
+            {
+                modelReport.MeshletTriangleFillRate =
+                    (double) totalMeshletTriangles / (modelReport.MeshletCount * AAAAMeshletConfiguration.MaxMeshletTriangles);
+                modelReport.MeshletVertexFillRate = (double) totalMeshletVertices / (modelReport.MeshletCount * AAAAMeshletConfiguration.MaxMeshletVertices);
+            }
+
+            return modelReport;
+        }
+
+        // Level 0 is the least detailed one. Collections of a model may have different level counts, so levels are aligned by index.
+        private static void AccumulateLevels(AAAAMeshletCollectionAsset meshletCollection, List<long> levelTriangleCounts, List<long> levelNodeCounts)
+        {
+            while (levelTriangleCounts.Count < meshletCollection.MeshLODLevelCount)
+            {
+                levelTriangleCounts.Add(0);
+                levelNodeCounts.Add(0);
+            }
+
+            foreach (AAAAMeshLODNode node in meshletCollection.MeshLODNodes)
+            {
+                int levelIndex = (int) node.LevelIndex;
+                ++levelNodeCounts[levelIndex];
+
+                for (uint i = 0; i < node.MeshletCount; i++)
+                {
+                    levelTriangleCounts[levelIndex] += meshletCollection.Meshlets[node.MeshletStartIndex + i].TriangleCount;
+                }
+            }
+        }
+
+        [Serializable]
+        private class BenchmarkReport
+        {
+            public string UnityVersion;
+            public string Timestamp;
+            public List<ModelReport> Models = new();
+        }
+
+        [Serializable]
+        private class ModelReport
+        {
+            public string Path;
+            public int MeshletCollectionCount;
+            public long SourceTriangleCount;
+            public int MeshletCount;
+
+            public double TotalMs;
+            public double MeshletBuildMs;
+            public double GroupingMs;
+            public double METISMs;
+            public double SimplifyMs;
+            public double FlattenMs;
+            public long PeakAllocatedBytes;
+
+            public long[] LevelTriangleCounts;
+            public long[] LevelNodeCounts;
+            public double MeshletTriangleFillRate;
+            public double MeshletVertexFillRate;
+        }
+    }
+}
@@ -36,6 +36,9 @@ namespace DELTation.AAAARP.Editor.Meshlets
             AAAAMeshletCollectionAsset meshletCollection = ScriptableObject.CreateInstance<AAAAMeshletCollectionAsset>();
             meshletCollection.name = name;
 
+            var timer = new Stopwatch();
+            timer.Start();
+
             AAAAMeshletCollectionBuilder.Generate(meshletCollection, new AAAAMeshletCollectionBuilder.Parameters
                 {
                     TargetErrorSloppy = TargetErrorSloppy,
@@ -49,13 +52,11 @@ namespace DELTation.AAAARP.Editor.Meshlets
                 }
             );
 
-            var timer = new Stopwatch();
-            timer.Start();
+            timer.Stop();
 
             ctx.AddObjectToAsset(nameof(AAAAMeshletCollectionAsset), meshletCollection);
             ctx.SetMainObject(meshletCollection);
 
-            timer.Stop();
             Debug.Log($"Building meshlets for {ctx.assetPath} took {timer.ElapsedMilliseconds:F3} ms.", meshletCollection);
         }
 
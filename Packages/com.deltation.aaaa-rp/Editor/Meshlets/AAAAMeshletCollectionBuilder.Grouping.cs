@@ -1,6 +1,7 @@
 ﻿using System;
 using DELTation.AAAARP.MeshOptimizer.Runtime;
 using DELTation.AAAARP.METIS.Runtime;
+using JetBrains.Annotations;
 using Unity.Burst;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
@@ -13,7 +14,8 @@ namespace DELTation.AAAARP.Editor.Meshlets
 {
     internal static partial class AAAAMeshletCollectionBuilder
     {
-        private static NativeArray<NativeList<int>> GroupMeshlets(MeshLODNodeLevel meshLODNodeLevel, int meshletsPerGroup, Allocator allocator)
+        private static NativeArray<NativeList<int>> GroupMeshlets(MeshLODNodeLevel meshLODNodeLevel, int meshletsPerGroup, Allocator allocator,
+            [CanBeNull] BuildStatistics statistics)
         {
             int graphNodeCount = meshLODNodeLevel.Nodes.Length;
             int partitionsCount = Mathf.CeilToInt((float) graphNodeCount / meshletsPerGroup);
@@ -76,9 +78,15 @@ namespace DELTation.AAAARP.Editor.Meshlets
 
             NativeArray<METISOptions> options = AAAAMETIS.CreateOptions(Allocator.Temp);
 
-            METISStatus status = AAAAMETIS.PartGraphKway(graphAdjacencyStructure, Allocator.Temp, partitionsCount, options,
-                out NativeArray<int> vertexPartitioning
-            );
+            METISStatus status;
+            NativeArray<int> vertexPartitioning;
+
+            using (BuildStatistics.Measure(statistics, BuildStage.METIS))
+            {
+                status = AAAAMETIS.PartGraphKway(graphAdjacencyStructure, Allocator.Temp, partitionsCount, options,
+                    out vertexPartitioning
+                );
+            }
             Assert.IsTrue(status == METISStatus.METIS_OK);
 
             adjacencyIndexList.Dispose();
@@ -0,0 +1,75 @@
+using System;
+using System.Diagnostics;
+using JetBrains.Annotations;
+using UnityEngine.Profiling;
+
+namespace DELTation.AAAARP.Editor.Meshlets
+{
+    internal static partial class AAAAMeshletCollectionBuilder
+    {
+        public enum BuildStage
+        {
+            MeshletBuild,
+            Grouping,
+            METIS,
+            Simplify,
+            Flatten,
+            Count,
+        }
+
+        public sealed class BuildStatistics
+        {
+            private readonly long[] _stageTicks = new long[(int) BuildStage.Count];
+            private long _baselineAllocatedBytes;
+
+            public BuildStatistics() => Reset();
+
+            // Sampled at stage boundaries, relative to the last Reset.
+            public long PeakAllocatedBytes { get; private set; }
+
+            public void Reset()
+            {
+                Array.Clear(_stageTicks, 0, _stageTicks.Length);
+                _baselineAllocatedBytes = Profiler.GetTotalAllocatedMemoryLong();
+                PeakAllocatedBytes = 0;
+            }
+
+            public double GetStageMilliseconds(BuildStage stage) => _stageTicks[(int) stage] * 1000.0 / Stopwatch.Frequency;
+
+            public static StageScope Measure([CanBeNull] BuildStatistics statistics, BuildStage stage) => new(statistics, stage);
+
+            private void SampleMemory()
+            {
+                long allocatedBytes = Profiler.GetTotalAllocatedMemoryLong() - _baselineAllocatedBytes;
+                PeakAllocatedBytes = Math.Max(PeakAllocatedBytes, allocatedBytes);
+            }
+
+            public readonly struct StageScope : IDisposable
+            {
+                [CanBeNull]
+                private readonly BuildStatistics _statistics;
+                private readonly BuildStage _stage;
+                private readonly long _startTimestamp;
+
+                public StageScope([CanBeNull] BuildStatistics statistics, BuildStage stage)
+                {
+                    _statistics = statistics;
+                    _stage = stage;
+                    _startTimestamp = statistics != null ? Stopwatch.GetTimestamp() : 0;
+                    _statistics?.SampleMemory();
+                }
+
+                public void Dispose()
+                {
+                    if (_statistics == null)
+                    {
+                        return;
+                    }
+
+                    _statistics._stageTicks[(int) _stage] += Stopwatch.GetTimestamp() - _startTimestamp;
+                    _statistics.SampleMemory();
+                }
+            }
+        }
+    }
+}
@@ -2,6 +2,7 @@ using System;
 using DELTation.AAAARP.Core;
 using DELTation.AAAARP.Meshlets;
 using DELTation.AAAARP.MeshOptimizer.Runtime;
+using JetBrains.Annotations;
 using Unity.Burst;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
@@ -70,10 +71,15 @@ namespace DELTation.AAAARP.Editor.Meshlets
 
             AAAAMeshOptimizer.MeshletGenerationParams meshletGenerationParams = AAAAMeshletCollectionAsset.MeshletGenerationParams;
             const Allocator allocator = Allocator.TempJob;
-            AAAAMeshOptimizer.MeshletBuildResults mainMeshletBuildResults = AAAAMeshOptimizer.BuildMeshlets(allocator,
-                vertexData, vertexPositionOffset, vertexBufferStride, indexDataU32,
-                meshletGenerationParams
-            );
+            AAAAMeshOptimizer.MeshletBuildResults mainMeshletBuildResults;
+
+            using (BuildStatistics.Measure(parameters.Statistics, BuildStage.MeshletBuild))
+            {
+                mainMeshletBuildResults = AAAAMeshOptimizer.BuildMeshlets(allocator,
+                    vertexData, vertexPositionOffset, vertexBufferStride, indexDataU32,
+                    meshletGenerationParams
+                );
+            }
 
             var meshLODLevels = new NativeList<MeshLODNodeLevel>(allocator);
             var topLOD = new MeshLODNodeLevel
@@ -118,6 +124,8 @@ namespace DELTation.AAAARP.Editor.Meshlets
             };
             BuildLodGraph(meshLODLevels, allocator, vertexLayout, meshletGenerationParams, parameters);
 
+            BuildStatistics.StageScope flattenScope = BuildStatistics.Measure(parameters.Statistics, BuildStage.Flatten);
+
             int meshLODNodes = 0;
             int totalMeshlets = 0;
             int totalVertices = 0;
@@ -274,6 +282,8 @@ namespace DELTation.AAAARP.Editor.Meshlets
                 .Complete()
                 ;
 
+            flattenScope.Dispose();
+
             if (uvVertexData.IsCreated)
             {
                 uvVertexData.Dispose();
@@ -317,7 +327,12 @@ namespace DELTation.AAAARP.Editor.Meshlets
 
                 const int meshletsPerGroup = 4;
 
-                NativeArray<NativeList<int>> childMeshletGroups = GroupMeshlets(previousLevel, meshletsPerGroup, Allocator.TempJob);
+                NativeArray<NativeList<int>> childMeshletGroups;
+
+                using (BuildStatistics.Measure(parameters.Statistics, BuildStage.Grouping))
+                {
+                    childMeshletGroups = GroupMeshlets(previousLevel, meshletsPerGroup, Allocator.TempJob, parameters.Statistics);
+                }
 
                 for (int childGroupIndex = 0; childGroupIndex < childMeshletGroups.Length; childGroupIndex++)
                 {
@@ -347,11 +362,17 @@ namespace DELTation.AAAARP.Editor.Meshlets
                     float4 sourceBounds = math.float4(sourceBoundsCenter, sourceBoundsRadius);
 
                     float targetError = simplifyMode == AAAAMeshOptimizer.SimplifyMode.Sloppy ? parameters.TargetErrorSloppy : parameters.TargetError;
-                    AAAAMeshOptimizer.MeshletBuildResults simplifiedMeshlets = AAAAMeshOptimizer.SimplifyMeshlets(allocator,
-                        sourceMeshlets.AsArray(),
-                        vertexLayout,
-                        meshletGenerationParams, simplifyMode, targetError, out float localError
-                    );
+                    AAAAMeshOptimizer.MeshletBuildResults simplifiedMeshlets;
+                    float localError;
+
+                    using (BuildStatistics.Measure(parameters.Statistics, BuildStage.Simplify))
+                    {
+                        simplifiedMeshlets = AAAAMeshOptimizer.SimplifyMeshlets(allocator,
+                            sourceMeshlets.AsArray(),
+                            vertexLayout,
+                            meshletGenerationParams, simplifyMode, targetError, out localError
+                        );
+                    }
                     Assert.IsTrue(localError >= 0.0f);
                     sourceMeshlets.Dispose();
 
@@ -479,6 +500,8 @@ namespace DELTation.AAAARP.Editor.Meshlets
             public float TargetError;
             public float TargetErrorSloppy;
             public float MinTriangleReductionPerStep;
+            [CanBeNull]
+            public BuildStatistics Statistics;
         }
 
         private struct MeshLODNode : IDisposable
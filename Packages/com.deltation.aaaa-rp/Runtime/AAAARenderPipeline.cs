@@ -57,7 +57,7 @@ namespace DELTation.AAAARP
             VolumeManager.instance.Initialize(defaultVolumeProfileSettings.volumeProfile);
 
             _bindlessTextureContainer = new BindlessTextureContainer();
-            _rtPoolSet = new AAAARenderTexturePoolSet(_bindlessTextureContainer);
+            _rtPoolSet = new AAAARenderTexturePoolSet(_bindlessTextureContainer, pipelineAsset.LightingSettings.Shadows);
             _rendererContainer =
                 new AAAARendererContainer(_bindlessTextureContainer, pipelineAsset.MeshLODSettings, _rawBufferClear, pipelineDebugDisplaySettings);
 
@@ -1,25 +1,47 @@
 ﻿using System;
+using DELTation.AAAARP.Data;
 using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.Renderers;
+using Unity.Mathematics;
 using UnityEngine.Experimental.Rendering;
 
 namespace DELTation.AAAARP
 {
     public readonly struct AAAARenderTexturePoolSet : IDisposable
     {
-        public readonly AAAARenderTexturePool ShadowMap;
+        private const int ShadowMapBytesPerTexel = 4;
 
-        internal AAAARenderTexturePoolSet(BindlessTextureContainer bindlessTextureContainer) =>
-            ShadowMap = new AAAARenderTexturePool(bindlessTextureContainer, new AAAARenderTexturePool.Parameters
+        public readonly AAAAShadowAtlas ShadowMap;
+
+        internal AAAARenderTexturePoolSet(BindlessTextureContainer bindlessTextureContainer, AAAALightingSettings.ShadowSettings shadowSettings)
+        {
+            int atlasSize = (int) shadowSettings.AtlasSize;
+            long pageSizeBytes = (long) atlasSize * atlasSize * ShadowMapBytesPerTexel;
+            long budgetBytes = (long) shadowSettings.AtlasMemoryBudgetMB * 1024 * 1024;
+
+            AAAAShadowAtlasAllocator.Settings allocatorSettings = AAAAShadowAtlasAllocator.Settings.Default;
+            allocatorSettings.PageSize = atlasSize;
+            allocatorSettings.MinTileSize = math.min(allocatorSettings.MinTileSize, atlasSize);
+            allocatorSettings.MaxPageCount = (int) math.max(1, budgetBytes / pageSizeBytes);
+
+            AAAAShadowResolutionPolicy.Settings resolutionPolicySettings = AAAAShadowResolutionPolicy.Settings.Default;
+            resolutionPolicySettings.MinResolution = allocatorSettings.MinTileSize;
+            resolutionPolicySettings.MemoryBudgetTexels = (long) allocatorSettings.MaxPageCount * atlasSize * atlasSize;
+            resolutionPolicySettings.RenderBudgetTexels = (long) shadowSettings.RenderBudgetMTexels * 1024 * 1024;
+
+            ShadowMap = new AAAAShadowAtlas(bindlessTextureContainer, new AAAAShadowAtlas.Parameters
                 {
-                    NamePrefix = "ShadowMap",
+                    NamePrefix = "ShadowAtlas",
                     DepthFormat = GraphicsFormat.D32_SFloat,
+                    AllocatorSettings = allocatorSettings,
+                    ResolutionPolicySettings = resolutionPolicySettings,
                 }
             );
+        }
 
         public void OnPreRender()
         {
-            ShadowMap.Reset();
+            ShadowMap.OnPreRender();
         }
 
         public void Dispose()
@@ -13,6 +13,7 @@ using DELTation.AAAARP.Passes.IBL;
 using DELTation.AAAARP.Passes.Lighting;
 using DELTation.AAAARP.Passes.PostProcessing;
 using DELTation.AAAARP.Passes.Shadows;
+using DELTation.AAAARP.Renderers;
 using DELTation.AAAARP.RenderPipelineResources;
 using DELTation.AAAARP.Utils;
 using DELTation.AAAARP.Volumes;
@@ -152,7 +153,7 @@ namespace DELTation.AAAARP
             EnqueuePass(_brdfIntegrationPass);
             EnqueuePass(_preFilterEnvironmentPass);
 
-            EnqueueShadowPasses(shadowsData);
+            EnqueueShadowPasses(frameData.Get<AAAARenderingData>(), shadowsData);
             EnqueuePass(_setupLightingPass);
 
             Camera cullingCameraOverride = DebugHandler?.GetGPUCullingCameraOverride();
@@ -251,8 +252,21 @@ namespace DELTation.AAAARP
             DebugHandler?.Setup(this, renderGraph, context, frameData);
         }
 
-        private void EnqueueShadowPasses(AAAAShadowsData shadowsData)
+        private void EnqueueShadowPasses(AAAARenderingData renderingData, AAAAShadowsData shadowsData)
         {
+            AAAARendererContainer rendererContainer = renderingData.RendererContainer;
+            bool multiView = renderingData.PipelineAsset.LightingSettings.Shadows.MultiViewCulling;
+
+            // Batches are limited by the per-context buffers of the container, which are resized to fit the drawn splits starting from the next frame.
+            // Every context costs a request list, so larger batches are only requested when they pay off: multi-view culling handles
+            // the whole batch in one dispatch, and adaptive request lists keep the extra contexts cheap.
+            if (multiView || rendererContainer.AdaptiveMeshletRenderRequestCapacity)
+            {
+                rendererContainer.RequestCullingContextCapacity(CountDrawnShadowSplits(shadowsData));
+            }
+
+            int maxBatchSize = rendererContainer.CullingContextCapacity;
+
             using (ListPool<DrawShadowsBatchedPass>.Get(out List<DrawShadowsBatchedPass> drawPasses))
             {
                 using (ListPool<GPUCullingPass.CullingViewParameters>.Get(out List<GPUCullingPass.CullingViewParameters> cullingViewParameters))
@@ -263,29 +277,56 @@ namespace DELTation.AAAARP
                         for (int splitIndex = 0; splitIndex < shadowLight.Splits.Length; splitIndex++)
                         {
                             ref readonly AAAAShadowsData.ShadowLightSplit shadowLightSplit = ref shadowLight.Splits.ElementAtRef(splitIndex);
+                            // Either the atlas ran out of space for this split (it is sampled as unshadowed), or the tile is up to date.
+                            if (!shadowLightSplit.ShadowMapAllocation.IsValid || shadowLightSplit.IsCached)
+                            {
+                                continue;
+                            }
+
                             int contextIndex = cullingViewParameters.Count;
                             DrawShadowsBatchedPass drawPass = _shadowPassPool.RequestDrawPass(shadowLightIndex, splitIndex, contextIndex);
                             drawPasses.Add(drawPass);
                             cullingViewParameters.Add(shadowLightSplit.CullingView);
 
-                            if (drawPasses.Count == GPUCullingContext.MaxCullingContextsPerBatch)
+                            if (drawPasses.Count == maxBatchSize)
                             {
-                                FlushShadowPasses(drawPasses, cullingViewParameters);
+                                FlushShadowPasses(drawPasses, cullingViewParameters, multiView);
                             }
                         }
                     }
 
                     if (drawPasses.Count > 0)
                     {
-                        FlushShadowPasses(drawPasses, cullingViewParameters);
+                        FlushShadowPasses(drawPasses, cullingViewParameters, multiView);
+                    }
+                }
+            }
+        }
+
+        private static int CountDrawnShadowSplits(AAAAShadowsData shadowsData)
+        {
+            int splitCount = 0;
+
+            for (int shadowLightIndex = 0; shadowLightIndex < shadowsData.ShadowLights.Length; shadowLightIndex++)
+            {
+                ref readonly AAAAShadowsData.ShadowLight shadowLight = ref shadowsData.ShadowLights.ElementAtRef(shadowLightIndex);
+                for (int splitIndex = 0; splitIndex < shadowLight.Splits.Length; splitIndex++)
+                {
+                    ref readonly AAAAShadowsData.ShadowLightSplit shadowLightSplit = ref shadowLight.Splits.ElementAtRef(splitIndex);
+                    if (shadowLightSplit.ShadowMapAllocation.IsValid && !shadowLightSplit.IsCached)
+                    {
+                        ++splitCount;
                     }
                 }
             }
+
+            return splitCount;
         }
 
-        private void FlushShadowPasses(List<DrawShadowsBatchedPass> drawPasses, List<GPUCullingPass.CullingViewParameters> cullingViewParameters)
+        private void FlushShadowPasses(List<DrawShadowsBatchedPass> drawPasses, List<GPUCullingPass.CullingViewParameters> cullingViewParameters,
+            bool multiView)
         {
-            GPUCullingPass gpuCullingPass = _shadowPassPool.RequestCullingPass(cullingViewParameters);
+            GPUCullingPass gpuCullingPass = _shadowPassPool.RequestCullingPass(cullingViewParameters, multiView);
             EnqueuePass(gpuCullingPass);
 
             foreach (DrawShadowsBatchedPass drawPass in drawPasses)
@@ -303,12 +344,15 @@ namespace DELTation.AAAARP
 
             _shadowPassPool.Dispose();
 
-            _convolveDiffuseIrradiancePass.Dispose();
-            _brdfIntegrationPass.Dispose();
-            _preFilterEnvironmentPass.Dispose();
+            _setupLightingPass.Dispose();
 
             _gpuCullingMainPass.Dispose();
             _gpuCullingFalseNegativePass.Dispose();
+            _vxgiCullingPass.Dispose();
+
+            _convolveDiffuseIrradiancePass.Dispose();
+            _brdfIntegrationPass.Dispose();
+            _preFilterEnvironmentPass.Dispose();
 
             _uberPostProcessingPass.Dispose();
             _smaaPass.Dispose();
@@ -1,5 +1,6 @@
 using System;
 using System.Runtime.InteropServices;
+using DELTation.AAAARP.Core;
 using JetBrains.Annotations;
 using Unity.Mathematics;
 using UnityEngine.Rendering;
@@ -44,6 +45,119 @@ namespace DELTation.AAAARP
         public uint Padding0;
     }
 
+    [GenerateHLSL]
+    public static class AAAAInstanceConfiguration
+    {
+        // Switches the GPU copy of instance data to AAAACompactInstanceData. Regenerate shader includes after changing it.
+        [UsedImplicitly]
+        public const uint UseCompactInstanceData = 0;
+
+        public static bool CompactInstanceDataEnabled => UseCompactInstanceData != 0;
+    }
+
+    // GPU-only layout of AAAAInstanceData: 80 bytes instead of 160.
+    // The inverse transform is derived on load, the AABB is stored in half precision rounded outwards.
+    [GenerateHLSL(PackingRules.Exact, needAccessors = false)]
+    [StructLayout(LayoutKind.Sequential)]
+    public struct AAAACompactInstanceData
+    {
+        public float4 ObjectToWorldRow0;
+        public float4 ObjectToWorldRow1;
+        public float4 ObjectToWorldRow2;
+
+        // (min.x, min.y), (min.z, max.x), (max.y, max.z)
+        public uint AABBPacked0;
+        public uint AABBPacked1;
+        public uint AABBPacked2;
+        public uint TopMeshLODStartIndex;
+
+        public uint TotalMeshLODCount;
+        public uint MaterialIndex;
+        public float LODErrorScale;
+        // MeshLODLevelCount: bits 0-7, PassMask: bits 8-15, Flags: bits 16-23.
+        public uint PackedFields;
+
+        public static AAAACompactInstanceData Pack(in AAAAInstanceData instanceData)
+        {
+            float4x4 m = instanceData.ObjectToWorldMatrix;
+            float3 aabbMin = instanceData.AABBMin.xyz;
+            float3 aabbMax = instanceData.AABBMax.xyz;
+
+            return new AAAACompactInstanceData
+            {
+                ObjectToWorldRow0 = math.float4(m.c0.x, m.c1.x, m.c2.x, m.c3.x),
+                ObjectToWorldRow1 = math.float4(m.c0.y, m.c1.y, m.c2.y, m.c3.y),
+                ObjectToWorldRow2 = math.float4(m.c0.z, m.c1.z, m.c2.z, m.c3.z),
+                AABBPacked0 = PackHalf2(HalfFloor(aabbMin.x), HalfFloor(aabbMin.y)),
+                AABBPacked1 = PackHalf2(HalfFloor(aabbMin.z), HalfCeil(aabbMax.x)),
+                AABBPacked2 = PackHalf2(HalfCeil(aabbMax.y), HalfCeil(aabbMax.z)),
+                TopMeshLODStartIndex = instanceData.TopMeshLODStartIndex,
+                TotalMeshLODCount = instanceData.TotalMeshLODCount,
+                MaterialIndex = instanceData.MaterialIndex,
+                LODErrorScale = instanceData.LODErrorScale,
+                PackedFields = math.min(instanceData.MeshLODLevelCount, 0xFFu) |
+                               ((uint) instanceData.PassMask & 0xFFu) << 8 |
+                               ((uint) instanceData.Flags & 0xFFu) << 16,
+            };
+        }
+
+        // Mirrors UnpackInstanceData in Instances.hlsl.
+        public AAAAInstanceData Unpack()
+        {
+            var objectToWorldMatrix = math.float4x4(ObjectToWorldRow0, ObjectToWorldRow1, ObjectToWorldRow2, math.float4(0, 0, 0, 1));
+            return new AAAAInstanceData
+            {
+                ObjectToWorldMatrix = objectToWorldMatrix,
+                WorldToObjectMatrix = AAAAMathUtils.AffineInverse3D(objectToWorldMatrix),
+                AABBMin = math.float4(math.f16tof32(AABBPacked0), math.f16tof32(AABBPacked0 >> 16), math.f16tof32(AABBPacked1), 0.0f),
+                AABBMax = math.float4(math.f16tof32(AABBPacked1 >> 16), math.f16tof32(AABBPacked2), math.f16tof32(AABBPacked2 >> 16), 0.0f),
+                TopMeshLODStartIndex = TopMeshLODStartIndex,
+                TotalMeshLODCount = TotalMeshLODCount,
+                MaterialIndex = MaterialIndex,
+                MeshLODLevelCount = PackedFields & 0xFFu,
+                LODErrorScale = LODErrorScale,
+                PassMask = (AAAAInstancePassMask) (PackedFields >> 8 & 0xFFu),
+                Flags = (AAAAInstanceFlags) (PackedFields >> 16 & 0xFFu),
+            };
+        }
+
+        private static uint PackHalf2(uint x, uint y) => x | y << 16;
+
+        // Largest half that is not greater than the value.
+        private static uint HalfFloor(float value)
+        {
+            uint half = math.f32tof16(value);
+            return math.f16tof32(half) > value ? PreviousHalf(half) : half;
+        }
+
+        // Smallest half that is not less than the value.
+        private static uint HalfCeil(float value)
+        {
+            uint half = math.f32tof16(value);
+            return math.f16tof32(half) < value ? NextHalf(half) : half;
+        }
+
+        private static uint NextHalf(uint half)
+        {
+            const uint signBit = 0x8000u;
+            if (half == signBit)
+            {
+                return 1u;
+            }
+            return (half & signBit) != 0 ? half - 1 : half + 1;
+        }
+
+        private static uint PreviousHalf(uint half)
+        {
+            const uint signBit = 0x8000u;
+            if (half == 0u)
+            {
+                return signBit | 1u;
+            }
+            return (half & signBit) != 0 ? half + 1 : half - 1;
+        }
+    }
+
     [GenerateHLSL(PackingRules.Exact)]
     [Flags]
     public enum AAAAGeometryFlags
@@ -39,6 +39,11 @@
 #define AAAARENDERERLISTID_ALPHA_TEST (4)
 #define AAAARENDERERLISTID_COUNT (8)
 
+//
+// DELTation.AAAARP.AAAAInstanceConfiguration:  static fields
+//
+#define USE_COMPACT_INSTANCE_DATA (0)
+
 //
 // DELTation.AAAARP.AAAAMaterialData:  static fields
 //
@@ -52,6 +57,23 @@
 #define MAX_MESHLET_INDICES (384)
 #define MESHLET_CONE_WEIGHT (0.25)
 
+// Generated from DELTation.AAAARP.AAAACompactInstanceData
+// PackingRules = Exact
+struct AAAACompactInstanceData
+{
+    float4 ObjectToWorldRow0;
+    float4 ObjectToWorldRow1;
+    float4 ObjectToWorldRow2;
+    uint AABBPacked0;
+    uint AABBPacked1;
+    uint AABBPacked2;
+    uint TopMeshLODStartIndex;
+    uint TotalMeshLODCount;
+    uint MaterialIndex;
+    float LODErrorScale;
+    uint PackedFields;
+};
+
 // Generated from DELTation.AAAARP.AAAAInstanceData
 // PackingRules = Exact
 struct AAAAInstanceData
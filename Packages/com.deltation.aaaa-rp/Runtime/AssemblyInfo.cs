@@ -1,2 +1,3 @@
 ﻿using System.Runtime.CompilerServices;
-[assembly: InternalsVisibleTo("DELTation.AAAARP.Editor")]
\ No newline at end of file
+[assembly: InternalsVisibleTo("DELTation.AAAARP.Editor")]
+[assembly: InternalsVisibleTo("DELTation.AAAARP.Testing.Runtime")]
\ No newline at end of file
@@ -0,0 +1,229 @@
+using System;
+using System.Threading;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using UnityEngine.Assertions;
+using IndexAllocation = DELTation.AAAARP.Core.AAAAIndexAllocator.IndexAllocation;
+
+namespace DELTation.AAAARP.Core
+{
+    // A version of AAAAIndexAllocator that can be shared by parallel jobs, including Burst-compiled ones.
+    // The free list head is tagged with a counter that changes on every update, so that the compare-and-swap loops are not fooled by ABA.
+    // Growing cannot be done concurrently, so the capacity is fixed. There are no safety handles: do not dispose while jobs are using it.
+    public unsafe struct AAAAConcurrentIndexAllocator : IDisposable
+    {
+        private const int InvalidAllocationIndex = AAAAIndexAllocator.InvalidAllocationIndex;
+
+        [NativeDisableUnsafePtrRestriction]
+        private Header* _header;
+        [NativeDisableUnsafePtrRestriction]
+        private Node* _nodes;
+        private readonly int _capacity;
+        private readonly Allocator _allocator;
+
+        public AAAAConcurrentIndexAllocator(int capacity, Allocator allocator)
+        {
+            Assert.IsTrue(capacity > 0);
+
+            _capacity = capacity;
+            _allocator = allocator;
+            _header = (Header*) UnsafeUtility.Malloc(UnsafeUtility.SizeOf<Header>(), UnsafeUtility.AlignOf<Header>(), allocator);
+            _nodes = (Node*) UnsafeUtility.Malloc((long) UnsafeUtility.SizeOf<Node>() * capacity, UnsafeUtility.AlignOf<Node>(), allocator);
+
+            for (int i = 0; i < capacity; i++)
+            {
+                _nodes[i] = new Node
+                {
+                    NextIndex = i + 1 < capacity ? i + 1 : InvalidAllocationIndex,
+                    Generation = 0,
+                };
+            }
+
+            *_header = new Header
+            {
+                TaggedHead = Pack(0, 0),
+                AllocatedCount = 0,
+            };
+        }
+
+        public bool IsCreated => _nodes != null;
+
+        public int Capacity => _capacity;
+
+        // Only exact when no jobs are allocating or freeing.
+        public int AllocatedCount => Volatile.Read(ref _header->AllocatedCount);
+
+        public void Dispose()
+        {
+            if (!IsCreated)
+            {
+                return;
+            }
+
+            UnsafeUtility.Free(_nodes, _allocator);
+            UnsafeUtility.Free(_header, _allocator);
+            _nodes = null;
+            _header = null;
+        }
+
+        public IndexAllocation Allocate()
+        {
+            while (true)
+            {
+                long taggedHead = Volatile.Read(ref _header->TaggedHead);
+                int headIndex = UnpackIndex(taggedHead);
+                if (headIndex == InvalidAllocationIndex)
+                {
+                    return new IndexAllocation { Index = InvalidAllocationIndex, Generation = 0 };
+                }
+
+                // The node may be taken by another thread meanwhile. The tag then differs and the exchange fails.
+                int nextIndex = Volatile.Read(ref _nodes[headIndex].NextIndex);
+                long newTaggedHead = Pack(nextIndex, UnpackTag(taggedHead) + 1);
+
+                if (Interlocked.CompareExchange(ref _header->TaggedHead, newTaggedHead, taggedHead) == taggedHead)
+                {
+                    Interlocked.Increment(ref _header->AllocatedCount);
+                    return new IndexAllocation
+                    {
+                        Index = headIndex,
+                        Generation = _nodes[headIndex].Generation,
+                    };
+                }
+            }
+        }
+
+        // Takes count indices off the free list with a single exchange. Either all of them are allocated, or none when there are not enough free indices.
+        public bool AllocateBatch(int count, NativeArray<IndexAllocation> allocations)
+        {
+            Assert.IsTrue(count >= 0);
+            Assert.IsTrue(count <= allocations.Length);
+
+            if (count == 0)
+            {
+                return true;
+            }
+
+            var pAllocations = (IndexAllocation*) allocations.GetUnsafePtr();
+
+            while (true)
+            {
+                long taggedHead = Volatile.Read(ref _header->TaggedHead);
+                int index = UnpackIndex(taggedHead);
+                int foundCount = 0;
+
+                while (foundCount < count && index != InvalidAllocationIndex)
+                {
+                    pAllocations[foundCount++].Index = index;
+                    index = Volatile.Read(ref _nodes[index].NextIndex);
+                }
+
+                if (foundCount < count)
+                {
+                    // The list may have been modified while walking it.
+                    if (Volatile.Read(ref _header->TaggedHead) == taggedHead)
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                long newTaggedHead = Pack(index, UnpackTag(taggedHead) + 1);
+                if (Interlocked.CompareExchange(ref _header->TaggedHead, newTaggedHead, taggedHead) != taggedHead)
+                {
+                    continue;
+                }
+
+                for (int i = 0; i < count; i++)
+                {
+                    pAllocations[i].Generation = _nodes[pAllocations[i].Index].Generation;
+                }
+
+                Interlocked.Add(ref _header->AllocatedCount, count);
+                return true;
+            }
+        }
+
+        public bool IsValidGeneration(IndexAllocation indexAllocation)
+        {
+            Assert.IsTrue(indexAllocation.Index != InvalidAllocationIndex);
+            return _nodes[indexAllocation.Index].Generation == indexAllocation.Generation;
+        }
+
+        public void Free(IndexAllocation allocation)
+        {
+            Node* node = GetNodeForFree(allocation);
+            PushChain(allocation.Index, node);
+            Interlocked.Decrement(ref _header->AllocatedCount);
+        }
+
+        // Links the freed nodes locally and returns them to the free list with a single exchange.
+        public void FreeBatch(NativeArray<IndexAllocation> allocations)
+        {
+            if (allocations.Length == 0)
+            {
+                return;
+            }
+
+            Node* lastNode = null;
+
+            for (int i = 0; i < allocations.Length; i++)
+            {
+                Node* node = GetNodeForFree(allocations[i]);
+                if (i + 1 < allocations.Length)
+                {
+                    node->NextIndex = allocations[i + 1].Index;
+                }
+
+                lastNode = node;
+            }
+
+            PushChain(allocations[0].Index, lastNode);
+            Interlocked.Add(ref _header->AllocatedCount, -allocations.Length);
+        }
+
+        private Node* GetNodeForFree(IndexAllocation allocation)
+        {
+            Assert.IsTrue(allocation.Index >= 0);
+            Assert.IsTrue(allocation.Index < _capacity);
+
+            Node* node = _nodes + allocation.Index;
+            Assert.IsTrue(node->Generation == allocation.Generation);
+
+            ++node->Generation;
+            return node;
+        }
+
+        private void PushChain(int firstIndex, Node* lastNode)
+        {
+            long taggedHead;
+            long newTaggedHead;
+
+            do
+            {
+                taggedHead = Volatile.Read(ref _header->TaggedHead);
+                Volatile.Write(ref lastNode->NextIndex, UnpackIndex(taggedHead));
+                newTaggedHead = Pack(firstIndex, UnpackTag(taggedHead) + 1);
+            } while (Interlocked.CompareExchange(ref _header->TaggedHead, newTaggedHead, taggedHead) != taggedHead);
+        }
+
+        private static long Pack(int index, uint tag) => (long) tag << 32 | (uint) index;
+
+        private static int UnpackIndex(long taggedHead) => (int) (uint) taggedHead;
+
+        private static uint UnpackTag(long taggedHead) => (uint) ((ulong) taggedHead >> 32);
+
+        private struct Header
+        {
+            public long TaggedHead;
+            public int AllocatedCount;
+        }
+
+        private struct Node
+        {
+            public int NextIndex;
+            public int Generation;
+        }
+    }
+}
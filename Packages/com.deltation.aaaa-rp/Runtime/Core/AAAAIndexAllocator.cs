@@ -6,12 +6,14 @@ using UnityEngine.Rendering;
 
 namespace DELTation.AAAARP.Core
 {
+    // Single-threaded intrusive free list. See AAAAConcurrentIndexAllocator for use from parallel jobs.
     public class AAAAIndexAllocator : IDisposable
     {
         public const int InvalidAllocationIndex = -1;
 
         private readonly bool _autoGrow;
 
+        private int _allocatedCount;
         private int _headIndex;
         private NativeArray<Node> _nodes;
 
@@ -29,6 +31,8 @@ namespace DELTation.AAAARP.Core
 
         public bool IsFull => _headIndex == InvalidAllocationIndex;
 
+        public int AllocatedCount => _allocatedCount;
+
         public void Dispose()
         {
             _nodes.Dispose();
@@ -79,9 +83,55 @@ namespace DELTation.AAAARP.Core
 
             _headIndex = node.NextIndex;
             node.NextIndex = InvalidAllocationIndex;
+            ++_allocatedCount;
             return allocation;
         }
 
+        // Fills allocations with count indices, in the same order as count calls to Allocate would.
+        // Either all of them are allocated, or none when the allocator cannot grow.
+        public unsafe bool AllocateBatch(int count, NativeArray<IndexAllocation> allocations)
+        {
+            Assert.IsTrue(count >= 0);
+            Assert.IsTrue(count <= allocations.Length);
+
+            if (!_autoGrow && _allocatedCount + count > Capacity)
+            {
+                return false;
+            }
+
+            var pAllocations = (IndexAllocation*) allocations.GetUnsafePtr();
+            int allocatedCount = 0;
+
+            while (allocatedCount < count)
+            {
+                if (IsFull)
+                {
+                    ForceGrow(_nodes.Length * 2);
+                }
+
+                var pNodes = (Node*) _nodes.GetUnsafePtr();
+                int headIndex = _headIndex;
+
+                while (allocatedCount < count && headIndex != InvalidAllocationIndex)
+                {
+                    Node* node = pNodes + headIndex;
+                    pAllocations[allocatedCount++] = new IndexAllocation
+                    {
+                        Generation = node->Generation,
+                        Index = headIndex,
+                    };
+
+                    headIndex = node->NextIndex;
+                    node->NextIndex = InvalidAllocationIndex;
+                }
+
+                _headIndex = headIndex;
+            }
+
+            _allocatedCount += count;
+            return true;
+        }
+
         public void ForceGrow(int ensuredCapacity)
         {
             if (ensuredCapacity <= Capacity)
@@ -90,10 +140,15 @@ namespace DELTation.AAAARP.Core
             }
 
             int oldCapacity = Capacity;
+            int oldHeadIndex = _headIndex;
             int newCapacity = AAAAMathUtils.AlignUp(ensuredCapacity, oldCapacity);
             _nodes.ResizeArray(newCapacity);
             _headIndex = oldCapacity;
             InitNodesFrom(_headIndex);
+
+            // Keep the indices that were already free.
+            ref Node lastNode = ref _nodes.ElementAtRef(newCapacity - 1);
+            lastNode.NextIndex = oldHeadIndex;
         }
 
         public bool IsValidGeneration(IndexAllocation indexAllocation)
@@ -119,6 +174,29 @@ namespace DELTation.AAAARP.Core
             node.NextIndex = _headIndex;
             ++node.Generation;
             _headIndex = allocation.Index;
+            --_allocatedCount;
+        }
+
+        public unsafe void FreeBatch(NativeArray<IndexAllocation> allocations)
+        {
+            var pNodes = (Node*) _nodes.GetUnsafePtr();
+            int headIndex = _headIndex;
+
+            foreach (IndexAllocation allocation in allocations)
+            {
+                Assert.IsTrue(allocation.Index >= 0);
+                Assert.IsTrue(allocation.Index < _nodes.Length);
+
+                Node* node = pNodes + allocation.Index;
+                Assert.IsTrue(node->Generation == allocation.Generation);
+
+                node->NextIndex = headIndex;
+                ++node->Generation;
+                headIndex = allocation.Index;
+            }
+
+            _headIndex = headIndex;
+            _allocatedCount -= allocations.Length;
         }
 
         private struct Node
@@ -0,0 +1,138 @@
+using System;
+using Unity.Collections;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Core
+{
+    // Tracks free ranges (holes) inside a linearly growing pool.
+    // The pool itself is owned by the caller, the allocator only remembers which parts of it are dead.
+    public class AAAARangeAllocator : IDisposable
+    {
+        // Sorted by offset, never adjacent (adjacent ranges are always merged).
+        private NativeList<Range> _freeRanges;
+
+        public AAAARangeAllocator(Allocator allocator) => _freeRanges = new NativeList<Range>(allocator);
+
+        public int FreeCount { get; private set; }
+
+        public int FreeRangeCount => _freeRanges.Length;
+
+        public void Dispose()
+        {
+            if (_freeRanges.IsCreated)
+            {
+                _freeRanges.Dispose();
+            }
+        }
+
+        // First-fit. When no hole is big enough, the caller is expected to append to the end of the pool.
+        public bool TryAllocate(int count, out int offset)
+        {
+            Assert.IsTrue(count >= 0);
+
+            if (count == 0)
+            {
+                offset = 0;
+                return true;
+            }
+
+            for (int i = 0; i < _freeRanges.Length; i++)
+            {
+                ref Range range = ref _freeRanges.ElementAtRef(i);
+                if (range.Count < count)
+                {
+                    continue;
+                }
+
+                offset = range.Offset;
+                range.Offset += count;
+                range.Count -= count;
+
+                if (range.Count == 0)
+                {
+                    _freeRanges.RemoveAt(i);
+                }
+
+                FreeCount -= count;
+                return true;
+            }
+
+            offset = -1;
+            return false;
+        }
+
+        public void Free(int offset, int count)
+        {
+            Assert.IsTrue(offset >= 0);
+            Assert.IsTrue(count >= 0);
+
+            if (count == 0)
+            {
+                return;
+            }
+
+            int insertIndex = 0;
+            while (insertIndex < _freeRanges.Length && _freeRanges[insertIndex].Offset < offset)
+            {
+                ++insertIndex;
+            }
+
+            Assert.IsTrue(insertIndex == 0 || _freeRanges[insertIndex - 1].End <= offset, "Double free detected.");
+            Assert.IsTrue(insertIndex == _freeRanges.Length || offset + count <= _freeRanges[insertIndex].Offset, "Double free detected.");
+
+            _freeRanges.InsertRange(insertIndex, 1);
+            _freeRanges[insertIndex] = new Range { Offset = offset, Count = count };
+            FreeCount += count;
+
+            // Merge with the next range.
+            if (insertIndex + 1 < _freeRanges.Length && _freeRanges[insertIndex].End == _freeRanges[insertIndex + 1].Offset)
+            {
+                ref Range range = ref _freeRanges.ElementAtRef(insertIndex);
+                range.Count += _freeRanges[insertIndex + 1].Count;
+                _freeRanges.RemoveAt(insertIndex + 1);
+            }
+
+            // Merge with the previous range.
+            if (insertIndex > 0 && _freeRanges[insertIndex - 1].End == _freeRanges[insertIndex].Offset)
+            {
+                ref Range range = ref _freeRanges.ElementAtRef(insertIndex - 1);
+                range.Count += _freeRanges[insertIndex].Count;
+                _freeRanges.RemoveAt(insertIndex);
+            }
+        }
+
+        // Drops the hole touching the end of the pool (if any) and returns the new pool length.
+        public int TrimTail(int length)
+        {
+            if (_freeRanges.Length == 0)
+            {
+                return length;
+            }
+
+            int lastIndex = _freeRanges.Length - 1;
+            Range lastRange = _freeRanges[lastIndex];
+            if (lastRange.End != length)
+            {
+                return length;
+            }
+
+            _freeRanges.RemoveAt(lastIndex);
+            FreeCount -= lastRange.Count;
+            return lastRange.Offset;
+        }
+
+        public void Clear()
+        {
+            _freeRanges.Clear();
+            FreeCount = 0;
+        }
+
+        private struct Range
+        {
+            public int Offset;
+            public int Count;
+
+            public int End => Offset + Count;
+        }
+    }
+}
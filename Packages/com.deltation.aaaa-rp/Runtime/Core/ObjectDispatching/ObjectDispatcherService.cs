@@ -252,8 +252,9 @@ namespace DELTation.AAAARP.Core.ObjectDispatching
             {
                 if (transformTrackers.Value.Count > 0)
                 {
+                    // Trackers may pass the arrays to jobs.
                     TransformDispatchData changeData =
-                        _dispatcher.GetTransformChangesAndClear(transformTrackers.Key, DefaultTransformTrackingType, Allocator.Temp);
+                        _dispatcher.GetTransformChangesAndClear(transformTrackers.Key, DefaultTransformTrackingType, Allocator.TempJob);
 
                     foreach (IObjectTransformTracker transformTracker in transformTrackers.Value)
                     {
@@ -0,0 +1,685 @@
+using System.Threading;
+using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Passes;
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Jobs;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Culling
+{
+    public sealed partial class AAAACPUCullingPipeline
+    {
+        private static bool IsInstanceVisible(NativeArray<uint> mask, uint instanceID) =>
+            (mask[(int) (instanceID / 32)] & 1u << (int) (instanceID % 32)) != 0;
+
+        private static unsafe void MarkInstanceVisible(NativeArray<uint> mask, uint instanceID)
+        {
+            int* item = (int*) mask.GetUnsafePtr() + instanceID / 32;
+            int instanceMask = 1 << (int) (instanceID % 32);
+            int current;
+
+            do
+            {
+                current = *item;
+                if ((current & instanceMask) != 0)
+                {
+                    return;
+                }
+            } while (Interlocked.CompareExchange(ref *item, current | instanceMask, current) != current);
+        }
+
+        private static unsafe void MarkInstanceInvisible(NativeArray<uint> mask, uint instanceID)
+        {
+            int* item = (int*) mask.GetUnsafePtr() + instanceID / 32;
+            int instanceMask = 1 << (int) (instanceID % 32);
+            int current;
+
+            do
+            {
+                current = *item;
+                if ((current & instanceMask) == 0)
+                {
+                    return;
+                }
+            } while (Interlocked.CompareExchange(ref *item, current & ~instanceMask, current) != current);
+        }
+
+        // GPUCullingDebug::OnCulled
+        private static unsafe void OnCulled(NativeArray<AAAAGPUCullingDebugData> debugData, in BoundingSquareSS boundingSquareSS,
+            AAAAGPUCullingDebugGranularity granularity, AAAAGPUCullingDebugType type)
+        {
+            AAAAGPUCullingDebugData* item = (AAAAGPUCullingDebugData*) debugData.GetUnsafePtr() +
+                                            ScreenUVToDebugBufferItemIndex(boundingSquareSS.CenterUV);
+            uint* counter = null;
+
+            switch (type)
+            {
+                case AAAAGPUCullingDebugType.Frustum:
+                    counter = granularity == AAAAGPUCullingDebugGranularity.Instance ? &item->FrustumCulledInstances : &item->FrustumCulledMeshlets;
+                    break;
+                case AAAAGPUCullingDebugType.Occlusion:
+                    counter = granularity == AAAAGPUCullingDebugGranularity.Instance ? &item->OcclusionCulledInstances : &item->OcclusionCulledMeshlets;
+                    break;
+                case AAAAGPUCullingDebugType.Cone:
+                    if (granularity == AAAAGPUCullingDebugGranularity.Meshlet)
+                    {
+                        counter = &item->ConeCulledMeshlets;
+                    }
+                    break;
+            }
+
+            if (counter != null)
+            {
+                Interlocked.Increment(ref *(int*) counter);
+            }
+        }
+
+        // GPUCullingDebug::OnVisibleMeshlet
+        private static unsafe void OnVisibleMeshlet(NativeArray<AAAAGPUCullingDebugData> debugData, in BoundingSquareSS boundingSquareSS, uint triangleCount)
+        {
+            AAAAGPUCullingDebugData* item = (AAAAGPUCullingDebugData*) debugData.GetUnsafePtr() +
+                                            ScreenUVToDebugBufferItemIndex(boundingSquareSS.CenterUV);
+            Interlocked.Increment(ref *(int*) &item->VisibleMeshlets);
+            Interlocked.Add(ref *(int*) &item->VisibleTriangles, (int) triangleCount);
+        }
+
+        internal struct MeshletListBuildJobData
+        {
+            public int ContextIndex;
+            public uint InstanceID;
+            public uint MeshLODNodeOffset;
+            public uint MeshLODNodeCount;
+            public uint ViewMask;
+        }
+
+        // The contexts of the job's view mask that selected the meshlet's LOD node.
+        private struct SelectedMeshlet
+        {
+            public AAAAMeshletRenderRequestPacked Request;
+            public uint ViewMask;
+        }
+
+        internal struct CullingView
+        {
+            public float4x4 ViewProjectionMatrix;
+            public float4x4 ViewMatrix;
+            public float3 CameraPosition;
+            public float3 ViewForwardDirWS;
+            public float4 CullingSphereLS;
+            public float4 FrustumPlane0;
+            public float4 FrustumPlane1;
+            public float4 FrustumPlane2;
+            public float4 FrustumPlane3;
+            public float4 FrustumPlane4;
+            public float4 FrustumPlane5;
+            public AAAAInstancePassMask PassMask;
+            public bool IsPerspective;
+
+            public static unsafe CullingView Create(GPUCullingContext cullingContext)
+            {
+                float* frustumPlanes = cullingContext.FrustumPlanes;
+                return new CullingView
+                {
+                    ViewProjectionMatrix = cullingContext.ViewProjectionMatrix,
+                    ViewMatrix = cullingContext.ViewMatrix,
+                    CameraPosition = cullingContext.CameraPosition.xyz,
+                    ViewForwardDirWS = GetViewForwardDir(cullingContext.ViewMatrix),
+                    CullingSphereLS = cullingContext.CullingSphereLS,
+                    FrustumPlane0 = LoadPlane(frustumPlanes, 0),
+                    FrustumPlane1 = LoadPlane(frustumPlanes, 1),
+                    FrustumPlane2 = LoadPlane(frustumPlanes, 2),
+                    FrustumPlane3 = LoadPlane(frustumPlanes, 3),
+                    FrustumPlane4 = LoadPlane(frustumPlanes, 4),
+                    FrustumPlane5 = LoadPlane(frustumPlanes, 5),
+                    PassMask = (AAAAInstancePassMask) cullingContext.PassMask,
+                    IsPerspective = cullingContext.CameraIsPerspective != 0,
+                };
+            }
+
+            private static unsafe float4 LoadPlane(float* frustumPlanes, int index) =>
+                math.float4(frustumPlanes[index * 4 + 0], frustumPlanes[index * 4 + 1], frustumPlanes[index * 4 + 2], frustumPlanes[index * 4 + 3]);
+
+            private static float DistanceToPlane(float4 plane, float3 position) => math.dot(math.float4(position, 1.0f), plane);
+
+            public bool FrustumVsSphereCulling(float4 boundingSphere)
+            {
+                float3 center = boundingSphere.xyz;
+                float dist01 = math.min(DistanceToPlane(FrustumPlane0, center), DistanceToPlane(FrustumPlane1, center));
+                float dist23 = math.min(DistanceToPlane(FrustumPlane2, center), DistanceToPlane(FrustumPlane3, center));
+                float dist45 = math.min(DistanceToPlane(FrustumPlane4, center), DistanceToPlane(FrustumPlane5, center));
+                return math.min(math.min(dist01, dist23), dist45) + boundingSphere.w > 0;
+            }
+        }
+
+        // OcclusionCulling::IsVisible and CameraHZB::LoadPadBorders.
+        private struct HZBData
+        {
+            [ReadOnly]
+            public NativeArray<float> CameraDepth;
+            [ReadOnly]
+            public NativeArray<float> Texture;
+            public int TextureWidth;
+            [ReadOnly]
+            public NativeArray<float4> MipRects;
+            public int LevelCount;
+
+            public bool IsVisible(in BoundingSquareSS boundingSquareSS, in DepthConventions depthConventions)
+            {
+                float2 depthTextureSize = MipRects[0].zw;
+                float2 minCoords = boundingSquareSS.MinUV * depthTextureSize;
+                float2 maxCoords = boundingSquareSS.MaxUV * depthTextureSize;
+                float2 boundsSizePixels = maxCoords - minCoords;
+                float lodFloat = math.ceil(math.log2(math.cmax(boundsSizePixels) * 0.5f));
+                // Negative LODs end up padded with far depth on the GPU as well.
+                int lod = lodFloat < 0.0f ? -1 : (int) lodFloat;
+
+                float occluderDepth0 = LoadPadBorders((int2) minCoords, lod, depthConventions);
+                float occluderDepth1 = LoadPadBorders((int2) maxCoords, lod, depthConventions);
+                float occluderDepth2 = LoadPadBorders(math.int2((int) minCoords.x, (int) maxCoords.y), lod, depthConventions);
+                float occluderDepth3 = LoadPadBorders(math.int2((int) maxCoords.x, (int) minCoords.y), lod, depthConventions);
+                float maxOccluderDepth = depthConventions.MaxDepth(
+                    depthConventions.MaxDepth(occluderDepth0, occluderDepth1),
+                    depthConventions.MaxDepth(occluderDepth2, occluderDepth3)
+                );
+                return depthConventions.LessEqualDepth(boundingSquareSS.NDCMinZ, maxOccluderDepth);
+            }
+
+            private float LoadPadBorders(int2 pixelCoord, int lod, in DepthConventions depthConventions)
+            {
+                if (lod < 0 || lod >= LevelCount)
+                {
+                    return depthConventions.Far;
+                }
+
+                int2 mipCoord = pixelCoord >> lod;
+                var mipSize = (int2) MipRects[lod].zw;
+                if (math.any(mipCoord <= 0) || math.any(mipCoord >= mipSize - 1))
+                {
+                    return depthConventions.Far;
+                }
+
+                if (lod == 0)
+                {
+                    return CameraDepth[pixelCoord.y * mipSize.x + pixelCoord.x];
+                }
+
+                int2 texel = mipCoord + (int2) MipRects[lod].xy;
+                return Texture[texel.y * TextureWidth + texel.x];
+            }
+        }
+
+        // GPUInstanceCulling.compute
+        [BurstCompile]
+        private struct InstanceCullingJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<CullingView> Views;
+            [ReadOnly]
+            public NativeArray<uint> PrevInstanceVisibilityMask;
+            public HZBData HZB;
+            public Settings Settings;
+            public bool OcclusionCulling;
+
+            [NativeDisableParallelForRestriction]
+            public NativeArray<uint> InstanceVisibilityMask;
+            [NativeDisableParallelForRestriction]
+            public NativeArray<AAAAGPUCullingDebugData> DebugData;
+
+            [WriteOnly]
+            public NativeArray<byte> InstancePassed;
+
+            public void Execute(int index)
+            {
+                int contextIndex = index / InstanceIndices.Length;
+                var instanceID = (uint) InstanceIndices[index % InstanceIndices.Length];
+                InstancePassed[index] = 0;
+
+                if (Settings.PassType == GPUCullingPass.PassType.Main && !IsInstanceVisible(PrevInstanceVisibilityMask, instanceID))
+                {
+                    return;
+                }
+
+                AAAAInstanceData instanceData = Instances[(int) instanceID];
+                CullingView view = Views[contextIndex];
+
+                if ((instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 || (instanceData.PassMask & view.PassMask) == 0)
+                {
+                    return;
+                }
+
+                TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                    out float3 aabbMinWS, out float3 aabbMaxWS
+                );
+                float4 boundingSphereWS = AABBToBoundingSphere(aabbMinWS, aabbMaxWS);
+                BoundingSquareSS boundingSquareSS =
+                    ComputeScreenSpaceBoundingSquare(aabbMinWS, aabbMaxWS, view.ViewProjectionMatrix, Settings.DepthConventions);
+
+                if (Settings.PassType != GPUCullingPass.PassType.Voxelization)
+                {
+                    if (!view.FrustumVsSphereCulling(boundingSphereWS) ||
+                        !LightSphereCulling(view.CullingSphereLS, view.ViewMatrix, boundingSphereWS))
+                    {
+                        MarkInvisible(instanceID);
+                        OnCulled(DebugData, boundingSquareSS, AAAAGPUCullingDebugGranularity.Instance, AAAAGPUCullingDebugType.Frustum);
+                        return;
+                    }
+                }
+
+                if (Settings.PassType == GPUCullingPass.PassType.FalseNegative)
+                {
+                    if (OcclusionCulling && !HZB.IsVisible(boundingSquareSS, Settings.DepthConventions))
+                    {
+                        MarkInvisible(instanceID);
+                        OnCulled(DebugData, boundingSquareSS, AAAAGPUCullingDebugGranularity.Instance, AAAAGPUCullingDebugType.Occlusion);
+                        return;
+                    }
+
+                    if (IsInstanceVisible(InstanceVisibilityMask, instanceID))
+                    {
+                        return;
+                    }
+                }
+
+                InstancePassed[index] = 1;
+            }
+
+            private void MarkInvisible(uint instanceID)
+            {
+                // Basic passes do not bind the visibility mask.
+                if (Settings.PassType != GPUCullingPass.PassType.Basic)
+                {
+                    MarkInstanceInvisible(InstanceVisibilityMask, instanceID);
+                }
+            }
+        }
+
+        // Same job split as GPUInstanceCulling.compute, ordered by context and then by instance.
+        // In multi-view mode, each instance emits its jobs once to the first context, with a bit for every context that passed it.
+        [BurstCompile]
+        private struct EmitMeshletListBuildJobsJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            public int ContextCount;
+            public bool MultiView;
+            [ReadOnly]
+            public NativeArray<byte> InstancePassed;
+
+            public NativeList<MeshletListBuildJobData> Jobs;
+
+            public void Execute()
+            {
+                Jobs.Clear();
+
+                if (MultiView)
+                {
+                    for (int i = 0; i < InstanceIndices.Length; i++)
+                    {
+                        uint viewMask = 0;
+
+                        for (int contextIndex = 0; contextIndex < ContextCount; contextIndex++)
+                        {
+                            if (InstancePassed[contextIndex * InstanceIndices.Length + i] != 0)
+                            {
+                                viewMask |= 1u << contextIndex;
+                            }
+                        }
+
+                        if (viewMask != 0)
+                        {
+                            EmitJobs(0, (uint) InstanceIndices[i], viewMask);
+                        }
+                    }
+
+                    return;
+                }
+
+                for (int contextIndex = 0; contextIndex < ContextCount; contextIndex++)
+                {
+                    for (int i = 0; i < InstanceIndices.Length; i++)
+                    {
+                        if (InstancePassed[contextIndex * InstanceIndices.Length + i] != 0)
+                        {
+                            EmitJobs(contextIndex, (uint) InstanceIndices[i], 1u << contextIndex);
+                        }
+                    }
+                }
+            }
+
+            private void EmitJobs(int contextIndex, uint instanceID, uint viewMask)
+            {
+                const uint maxNodesPerJob = AAAAMeshletListBuildJob.MaxLODNodesPerThreadGroup;
+
+                uint totalMeshLODCount = Instances[(int) instanceID].TotalMeshLODCount;
+                uint jobCount = (totalMeshLODCount + maxNodesPerJob - 1) / maxNodesPerJob;
+
+                for (uint jobIndex = 0; jobIndex < jobCount; ++jobIndex)
+                {
+                    uint offset = jobIndex * maxNodesPerJob;
+                    Jobs.Add(new MeshletListBuildJobData
+                        {
+                            ContextIndex = contextIndex,
+                            InstanceID = instanceID,
+                            MeshLODNodeOffset = offset,
+                            MeshLODNodeCount = math.min(totalMeshLODCount - offset, maxNodesPerJob),
+                            ViewMask = viewMask,
+                        }
+                    );
+                }
+            }
+        }
+
+        // MeshletListBuild.compute
+        [BurstCompile]
+        private struct MeshletListBuildJob : IJobParallelForDefer
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<AAAAMeshLODNode> MeshLODNodes;
+            [ReadOnly]
+            public NativeArray<GPULODSelectionContext> LODSelectionContexts;
+            [ReadOnly]
+            public NativeArray<MeshletListBuildJobData> Jobs;
+            public Settings Settings;
+
+            public NativeStream.Writer SelectedMeshlets;
+
+            public void Execute(int index)
+            {
+                MeshletListBuildJobData job = Jobs[index];
+                AAAAInstanceData instanceData = Instances[(int) job.InstanceID];
+
+                // Each context of the view mask selects LODs with its own LOD selection context.
+                float3 instanceBoundsCenter = (instanceData.AABBMin.xyz + instanceData.AABBMax.xyz) * 0.5f;
+                var distancesToViewSq = new NativeArray<float>(GPUCullingContext.MaxCullingContextsPerBatch, Allocator.Temp);
+                var conservativeDistanceScales = new NativeArray<float>(GPUCullingContext.MaxCullingContextsPerBatch, Allocator.Temp);
+
+                for (uint viewMask = job.ViewMask; viewMask != 0; viewMask &= viewMask - 1)
+                {
+                    int viewIndex = math.tzcnt(viewMask);
+                    GPULODSelectionContext lodSelectionContext = LODSelectionContexts[viewIndex];
+                    float distanceToViewSq = GetLODDistanceSq(lodSelectionContext, instanceBoundsCenter);
+                    distancesToViewSq[viewIndex] = distanceToViewSq;
+                    conservativeDistanceScales[viewIndex] = GetConservativeLODDistanceScale(lodSelectionContext, instanceBoundsCenter, distanceToViewSq);
+                }
+
+                uint from = instanceData.TopMeshLODStartIndex + job.MeshLODNodeOffset;
+                uint nodeCount = math.min(AAAAMeshletListBuildJob.MaxLODNodesPerThreadGroup, job.MeshLODNodeCount);
+
+                SelectedMeshlets.BeginForEachIndex(index);
+
+                for (uint i = 0; i < nodeCount; i++)
+                {
+                    AAAAMeshLODNode meshLODNode = MeshLODNodes[(int) (from + i)];
+                    float4 boundsWS = TransformBoundingSphere(meshLODNode.Bounds, instanceData.ObjectToWorldMatrix);
+                    float4 parentBoundsWS = TransformBoundingSphere(meshLODNode.ParentBounds, instanceData.ObjectToWorldMatrix);
+                    uint nodeViewMask = 0;
+
+                    for (uint viewMask = job.ViewMask; viewMask != 0; viewMask &= viewMask - 1)
+                    {
+                        int viewIndex = math.tzcnt(viewMask);
+                        if (ShouldPushMeshletRenderRequests(LODSelectionContexts[viewIndex], meshLODNode, instanceData, boundsWS, parentBoundsWS,
+                                distancesToViewSq[viewIndex], conservativeDistanceScales[viewIndex]
+                            ))
+                        {
+                            nodeViewMask |= 1u << viewIndex;
+                        }
+                    }
+
+                    if (nodeViewMask == 0)
+                    {
+                        continue;
+                    }
+
+                    for (uint meshletIndex = 0; meshletIndex < meshLODNode.MeshletCount; meshletIndex++)
+                    {
+                        SelectedMeshlets.Write(new SelectedMeshlet
+                            {
+                                Request = new AAAAMeshletRenderRequestPacked
+                                {
+                                    InstanceID_LOD = job.InstanceID,
+                                    MeshletID = meshLODNode.MeshletStartIndex + meshletIndex,
+                                },
+                                ViewMask = nodeViewMask,
+                            }
+                        );
+                    }
+                }
+
+                SelectedMeshlets.EndForEachIndex();
+            }
+
+            private bool ShouldPushMeshletRenderRequests(in GPULODSelectionContext lodSelectionContext, in AAAAMeshLODNode meshLODNode,
+                in AAAAInstanceData instanceData, float4 boundsWS, float4 parentBoundsWS, float distanceToViewSq, float conservativeDistanceScale)
+            {
+                uint forcedMeshLODNodeDepth = Settings.PassType == GPUCullingPass.PassType.Voxelization ? 1 : Settings.ForcedMeshLODNodeDepth;
+
+                if (forcedMeshLODNodeDepth != uint.MaxValue)
+                {
+                    bool isLeaf = meshLODNode.LevelIndex == instanceData.MeshLODLevelCount - 1;
+                    return meshLODNode.LevelIndex == forcedMeshLODNodeDepth || meshLODNode.LevelIndex < forcedMeshLODNodeDepth && isLeaf;
+                }
+
+                float error = meshLODNode.Error * GetLODScreenBoundRadiusSq(lodSelectionContext, boundsWS, conservativeDistanceScale);
+                float parentError = meshLODNode.ParentError >= 0
+                    ? meshLODNode.ParentError * GetLODScreenBoundRadiusSq(lodSelectionContext, parentBoundsWS, conservativeDistanceScale)
+                    : float.PositiveInfinity;
+                float threshold = Settings.MeshLODErrorThreshold * distanceToViewSq * instanceData.LODErrorScale;
+                return parentError > threshold && error <= threshold;
+            }
+        }
+
+        [BurstCompile]
+        private struct GatherInitialRequestsJob : IJob
+        {
+            public NativeStream.Reader SelectedMeshlets;
+
+            public NativeList<AAAAMeshletRenderRequestPacked> InitialRequests;
+            public NativeList<int> InitialRequestContextIndices;
+            public NativeArray<int> InitialRequestCounts;
+            public NativeList<int> MeshletRendererListIDs;
+
+            public void Execute()
+            {
+                InitialRequests.Clear();
+                InitialRequestContextIndices.Clear();
+
+                for (int i = 0; i < InitialRequestCounts.Length; i++)
+                {
+                    InitialRequestCounts[i] = 0;
+                }
+
+                for (int jobIndex = 0; jobIndex < SelectedMeshlets.ForEachCount; jobIndex++)
+                {
+                    int count = SelectedMeshlets.BeginForEachIndex(jobIndex);
+
+                    // The meshlets of a job go to every context in its view mask that selected their LOD node.
+                    for (int i = 0; i < count; i++)
+                    {
+                        SelectedMeshlet selectedMeshlet = SelectedMeshlets.Read<SelectedMeshlet>();
+
+                        for (uint remainingViews = selectedMeshlet.ViewMask; remainingViews != 0; remainingViews &= remainingViews - 1)
+                        {
+                            int viewIndex = math.tzcnt(remainingViews);
+                            InitialRequests.Add(selectedMeshlet.Request);
+                            InitialRequestContextIndices.Add(viewIndex);
+                            ++InitialRequestCounts[viewIndex];
+                        }
+                    }
+
+                    SelectedMeshlets.EndForEachIndex();
+                }
+
+                MeshletRendererListIDs.ResizeUninitialized(InitialRequests.Length);
+            }
+        }
+
+        // GPUMeshletCulling.compute
+        [BurstCompile]
+        private struct MeshletCullingJob : IJobParallelForDefer
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<AAAAMeshlet> Meshlets;
+            [ReadOnly]
+            public NativeArray<AAAAMaterialData> Materials;
+            [ReadOnly]
+            public NativeArray<CullingView> Views;
+            public HZBData HZB;
+            public Settings Settings;
+            public bool OcclusionCulling;
+
+            [ReadOnly]
+            public NativeArray<AAAAMeshletRenderRequestPacked> Requests;
+            [ReadOnly]
+            public NativeArray<int> RequestContextIndices;
+
+            [NativeDisableParallelForRestriction]
+            public NativeArray<uint> InstanceVisibilityMask;
+            [NativeDisableParallelForRestriction]
+            public NativeArray<AAAAGPUCullingDebugData> DebugData;
+
+            [WriteOnly]
+            public NativeArray<int> RendererListIDs;
+
+            public void Execute(int index)
+            {
+                AAAAMeshletRenderRequestPacked request = Requests[index];
+                AAAAInstanceData instanceData = Instances[(int) request.InstanceID_LOD];
+                AAAAMaterialData materialData = Materials[(int) instanceData.MaterialIndex];
+                AAAARendererListID rendererListID = GetRendererListID(instanceData, materialData);
+                AAAAMeshlet meshlet = Meshlets[(int) request.MeshletID];
+
+                if (Settings.PassType != GPUCullingPass.PassType.Voxelization &&
+                    !Culling(Views[RequestContextIndices[index]], instanceData, rendererListID, meshlet))
+                {
+                    RendererListIDs[index] = -1;
+                    return;
+                }
+
+                RendererListIDs[index] = (int) rendererListID;
+
+                if (Settings.PassType is GPUCullingPass.PassType.Main or GPUCullingPass.PassType.FalseNegative)
+                {
+                    MarkInstanceVisible(InstanceVisibilityMask, request.InstanceID_LOD);
+                }
+            }
+
+            private bool Culling(in CullingView view, in AAAAInstanceData instanceData, AAAARendererListID rendererListID, in AAAAMeshlet meshlet)
+            {
+                float4 boundingSphereWS = TransformBoundingSphere(meshlet.BoundingSphere, instanceData.ObjectToWorldMatrix);
+                BoundingSquareSS boundingSquareSS = ComputeScreenSpaceBoundingSquare(boundingSphereWS, view.ViewProjectionMatrix, Settings.DepthConventions);
+
+                if (!view.FrustumVsSphereCulling(boundingSphereWS) ||
+                    !LightSphereCulling(view.CullingSphereLS, view.ViewMatrix, boundingSphereWS))
+                {
+                    OnCulled(DebugData, boundingSquareSS, AAAAGPUCullingDebugGranularity.Meshlet, AAAAGPUCullingDebugType.Frustum);
+                    return false;
+                }
+
+                if ((rendererListID & AAAARendererListID.CullOff) == 0 &&
+                    !ConeCulling(view.CameraPosition, view.ViewForwardDirWS, view.IsPerspective, instanceData, meshlet))
+                {
+                    OnCulled(DebugData, boundingSquareSS, AAAAGPUCullingDebugGranularity.Meshlet, AAAAGPUCullingDebugType.Cone);
+                    return false;
+                }
+
+                if (OcclusionCulling && !HZB.IsVisible(boundingSquareSS, Settings.DepthConventions))
+                {
+                    OnCulled(DebugData, boundingSquareSS, AAAAGPUCullingDebugGranularity.Meshlet, AAAAGPUCullingDebugType.Occlusion);
+                    return false;
+                }
+
+                OnVisibleMeshlet(DebugData, boundingSquareSS, meshlet.TriangleCount);
+                return true;
+            }
+
+            private AAAARendererListID GetRendererListID(in AAAAInstanceData instanceData, in AAAAMaterialData materialData)
+            {
+                if (Settings.PassType == GPUCullingPass.PassType.Voxelization)
+                {
+                    return AAAARendererListID.Default;
+                }
+
+                AAAARendererListID rendererListID = materialData.RendererListID;
+
+                if ((instanceData.Flags & AAAAInstanceFlags.FlipWindingOrder) != 0 &&
+                    (rendererListID & AAAARendererListID.CullOff) == 0)
+                {
+                    rendererListID ^= AAAARendererListID.CullFront;
+                }
+
+                return rendererListID;
+            }
+        }
+
+        // FixupGPUMeshletCullingIndirectDispatchArgs.compute computes the same ranges, but relative to each context's base instance.
+        [BurstCompile]
+        private struct CompactRenderRequestsJob : IJob
+        {
+            [ReadOnly]
+            public NativeList<AAAAMeshletRenderRequestPacked> Requests;
+            [ReadOnly]
+            public NativeList<int> RequestContextIndices;
+            [ReadOnly]
+            public NativeList<int> RendererListIDs;
+
+            public NativeArray<int> RendererListCounts;
+            public NativeArray<int> RendererListStarts;
+            public NativeList<AAAAMeshletRenderRequestPacked> RenderRequests;
+
+            public void Execute()
+            {
+                const int rendererListCount = (int) AAAARendererListID.Count;
+
+                for (int i = 0; i < RendererListCounts.Length; i++)
+                {
+                    RendererListCounts[i] = 0;
+                }
+
+                for (int i = 0; i < Requests.Length; i++)
+                {
+                    int rendererListID = RendererListIDs[i];
+                    if (rendererListID >= 0)
+                    {
+                        ++RendererListCounts[RequestContextIndices[i] * rendererListCount + rendererListID];
+                    }
+                }
+
+                int totalCount = 0;
+
+                for (int i = 0; i < RendererListCounts.Length; i++)
+                {
+                    RendererListStarts[i] = totalCount;
+                    totalCount += RendererListCounts[i];
+                }
+
+                RenderRequests.ResizeUninitialized(totalCount);
+
+                var writeOffsets = new NativeArray<int>(RendererListStarts, Allocator.Temp);
+
+                for (int i = 0; i < Requests.Length; i++)
+                {
+                    int rendererListID = RendererListIDs[i];
+                    if (rendererListID >= 0)
+                    {
+                        int listIndex = RequestContextIndices[i] * rendererListCount + rendererListID;
+                        RenderRequests[writeOffsets[listIndex]++] = Requests[i];
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,302 @@
+using System;
+using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Passes;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Culling
+{
+    // CPU reference of GPUInstanceCulling -> MeshletListBuild -> GPUMeshletCulling.
+    // Consumes the same data as the compute shaders and produces the same render request lists and debug counters.
+    // Unlike the GPU, the order of requests inside a renderer list is deterministic.
+    public sealed partial class AAAACPUCullingPipeline : IDisposable
+    {
+        private const int InstanceCullingBatchSize = 64;
+        private const int MeshletListBuildBatchSize = 16;
+        private const int MeshletCullingBatchSize = 256;
+
+        private NativeArray<AAAAGPUCullingDebugData> _debugData;
+        private readonly NativeArray<float> _dummyDepth;
+        private readonly NativeArray<float4> _dummyMipRects;
+        private readonly NativeArray<uint> _dummyVisibilityMask;
+        private NativeList<int> _initialRequestContextIndices;
+        private NativeList<int> _initialRequestCounts;
+        private NativeList<AAAAMeshletRenderRequestPacked> _initialRequests;
+        private NativeList<uint> _instanceVisibilityMask;
+        private NativeList<MeshletListBuildJobData> _meshletListBuildJobs;
+        private NativeList<int> _meshletRendererListIDs;
+        private NativeList<int> _rendererListCounts;
+        private NativeList<int> _rendererListStarts;
+        private NativeList<AAAAMeshletRenderRequestPacked> _renderRequests;
+
+        public AAAACPUCullingPipeline(Allocator allocator = Allocator.Persistent)
+        {
+            const int debugDataLength = (int) (AAAAGPUCullingDebugData.GPUCullingDebugBufferDimension * AAAAGPUCullingDebugData.GPUCullingDebugBufferDimension);
+            _debugData = new NativeArray<AAAAGPUCullingDebugData>(debugDataLength, allocator);
+            _dummyDepth = new NativeArray<float>(1, allocator);
+            _dummyMipRects = new NativeArray<float4>(1, allocator);
+            _dummyVisibilityMask = new NativeArray<uint>(1, allocator);
+            _initialRequestContextIndices = new NativeList<int>(allocator);
+            _initialRequestCounts = new NativeList<int>(allocator);
+            _initialRequests = new NativeList<AAAAMeshletRenderRequestPacked>(allocator);
+            _instanceVisibilityMask = new NativeList<uint>(allocator);
+            _meshletListBuildJobs = new NativeList<MeshletListBuildJobData>(allocator);
+            _meshletRendererListIDs = new NativeList<int>(allocator);
+            _rendererListCounts = new NativeList<int>(allocator);
+            _rendererListStarts = new NativeList<int>(allocator);
+            _renderRequests = new NativeList<AAAAMeshletRenderRequestPacked>(allocator);
+        }
+
+        public int CullingContextCount { get; private set; }
+
+        // All the results below are valid once the handle returned from Schedule is complete.
+
+        // Grouped by culling context, then by renderer list. Use GetRendererListRange to find a specific list.
+        public NativeArray<AAAAMeshletRenderRequestPacked> RenderRequests => _renderRequests.AsArray();
+
+        public NativeArray<AAAAGPUCullingDebugData> DebugData => _debugData;
+
+        // Same layout as OcclusionCullingResources.FrameResources.InstanceVisibilityMask.
+        public NativeArray<uint> InstanceVisibilityMask => _instanceVisibilityMask.AsArray();
+
+        // Instance culling output, the counterpart of the _Jobs buffer written by GPUInstanceCulling.compute.
+        internal NativeArray<MeshletListBuildJobData> MeshletListBuildJobs => _meshletListBuildJobs.AsArray();
+
+        public void Dispose()
+        {
+            _debugData.Dispose();
+            _dummyDepth.Dispose();
+            _dummyMipRects.Dispose();
+            _dummyVisibilityMask.Dispose();
+            _initialRequestContextIndices.Dispose();
+            _initialRequestCounts.Dispose();
+            _initialRequests.Dispose();
+            _instanceVisibilityMask.Dispose();
+            _meshletListBuildJobs.Dispose();
+            _meshletRendererListIDs.Dispose();
+            _rendererListCounts.Dispose();
+            _rendererListStarts.Dispose();
+            _renderRequests.Dispose();
+        }
+
+        // Number of meshlets produced by LOD selection, before meshlet culling.
+        public int GetInitialMeshletCount(int contextIndex) => _initialRequestCounts[contextIndex];
+
+        public RendererListRange GetRendererListRange(int contextIndex, AAAARendererListID rendererListID)
+        {
+            int index = contextIndex * (int) AAAARendererListID.Count + (int) rendererListID;
+            return new RendererListRange
+            {
+                StartIndex = _rendererListStarts[index],
+                Count = _rendererListCounts[index],
+            };
+        }
+
+        public void Run(in Inputs inputs, in Settings settings) => Schedule(inputs, settings).Complete();
+
+        public JobHandle Schedule(in Inputs inputs, in Settings settings, JobHandle dependency = default)
+        {
+            Assert.IsTrue(inputs.CullingContexts.Length == inputs.LODSelectionContexts.Length);
+            Assert.IsTrue(inputs.CullingContexts.Length <= GPUCullingContext.MaxCullingContextsPerBatch);
+            Assert.IsTrue(!settings.MultiView || settings.PassType == GPUCullingPass.PassType.Basic, "Multi-view culling is only supported by basic passes.");
+            Assert.IsTrue(settings.PassType != GPUCullingPass.PassType.Main || inputs.PrevInstanceVisibilityMask.Length * 32 >= inputs.Instances.Length,
+                "Main pass requires the previous instance visibility mask."
+            );
+
+            int contextCount = inputs.CullingContexts.Length;
+            int instanceCount = inputs.InstanceIndices.Length;
+            CullingContextCount = contextCount;
+
+            dependency.Complete();
+
+            _renderRequests.Clear();
+            ResizeAndClear(ref _initialRequestCounts, contextCount);
+            ResizeAndClear(ref _rendererListCounts, contextCount * (int) AAAARendererListID.Count);
+            ResizeAndClear(ref _rendererListStarts, contextCount * (int) AAAARendererListID.Count);
+
+            for (int i = 0; i < _debugData.Length; i++)
+            {
+                _debugData[i] = default;
+            }
+
+            // GPUCullingPass clears the current visibility mask before every non-basic pass.
+            ResizeAndClear(ref _instanceVisibilityMask, (inputs.Instances.Length + 31) / 32);
+
+            if (contextCount == 0 || instanceCount == 0)
+            {
+                return default;
+            }
+
+            var views = new NativeArray<CullingView>(contextCount, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            for (int i = 0; i < contextCount; i++)
+            {
+                views[i] = CullingView.Create(inputs.CullingContexts[i]);
+            }
+
+            bool hasHZB = inputs.HZB.MipRects.IsCreated && inputs.HZB.MipRects.Length > 0;
+            var hzb = new HZBData
+            {
+                CameraDepth = inputs.HZB.CameraDepth.IsCreated ? inputs.HZB.CameraDepth : _dummyDepth,
+                Texture = inputs.HZB.Texture.IsCreated ? inputs.HZB.Texture : _dummyDepth,
+                TextureWidth = inputs.HZB.TextureWidth,
+                MipRects = hasHZB ? inputs.HZB.MipRects : _dummyMipRects,
+                LevelCount = hasHZB ? inputs.HZB.MipRects.Length : 0,
+            };
+            bool occlusionCulling = settings.PassType == GPUCullingPass.PassType.FalseNegative && !settings.DisableOcclusionCulling;
+            Assert.IsTrue(!occlusionCulling || hasHZB, "False negative pass requires HZB data.");
+
+            var instancePassed = new NativeArray<byte>(contextCount * instanceCount, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+
+            JobHandle handle = new InstanceCullingJob
+                {
+                    Instances = inputs.Instances,
+                    InstanceIndices = inputs.InstanceIndices,
+                    Views = views,
+                    PrevInstanceVisibilityMask = inputs.PrevInstanceVisibilityMask.IsCreated ? inputs.PrevInstanceVisibilityMask : _dummyVisibilityMask,
+                    HZB = hzb,
+                    Settings = settings,
+                    OcclusionCulling = occlusionCulling,
+                    InstanceVisibilityMask = _instanceVisibilityMask.AsArray(),
+                    DebugData = _debugData,
+                    InstancePassed = instancePassed,
+                }
+                .Schedule(contextCount * instanceCount, InstanceCullingBatchSize);
+
+            handle = new EmitMeshletListBuildJobsJob
+                {
+                    Instances = inputs.Instances,
+                    InstanceIndices = inputs.InstanceIndices,
+                    ContextCount = contextCount,
+                    MultiView = settings.MultiView,
+                    InstancePassed = instancePassed,
+                    Jobs = _meshletListBuildJobs,
+                }
+                .Schedule(handle);
+            handle = instancePassed.Dispose(handle);
+
+            handle = NativeStream.ScheduleConstruct(out NativeStream selectedMeshlets, _meshletListBuildJobs, handle, Allocator.TempJob);
+
+            handle = new MeshletListBuildJob
+                {
+                    Instances = inputs.Instances,
+                    MeshLODNodes = inputs.MeshLODNodes,
+                    LODSelectionContexts = inputs.LODSelectionContexts,
+                    Jobs = _meshletListBuildJobs.AsDeferredJobArray(),
+                    Settings = settings,
+                    SelectedMeshlets = selectedMeshlets.AsWriter(),
+                }
+                .Schedule(_meshletListBuildJobs, MeshletListBuildBatchSize, handle);
+
+            handle = new GatherInitialRequestsJob
+                {
+                    SelectedMeshlets = selectedMeshlets.AsReader(),
+                    InitialRequests = _initialRequests,
+                    InitialRequestContextIndices = _initialRequestContextIndices,
+                    InitialRequestCounts = _initialRequestCounts.AsArray(),
+                    MeshletRendererListIDs = _meshletRendererListIDs,
+                }
+                .Schedule(handle);
+            handle = selectedMeshlets.Dispose(handle);
+
+            handle = new MeshletCullingJob
+                {
+                    Instances = inputs.Instances,
+                    Meshlets = inputs.Meshlets,
+                    Materials = inputs.Materials,
+                    Views = views,
+                    HZB = hzb,
+                    Settings = settings,
+                    OcclusionCulling = occlusionCulling,
+                    Requests = _initialRequests.AsDeferredJobArray(),
+                    RequestContextIndices = _initialRequestContextIndices.AsDeferredJobArray(),
+                    InstanceVisibilityMask = _instanceVisibilityMask.AsArray(),
+                    DebugData = _debugData,
+                    RendererListIDs = _meshletRendererListIDs.AsDeferredJobArray(),
+                }
+                .Schedule(_initialRequests, MeshletCullingBatchSize, handle);
+            handle = views.Dispose(handle);
+
+            handle = new CompactRenderRequestsJob
+                {
+                    Requests = _initialRequests,
+                    RequestContextIndices = _initialRequestContextIndices,
+                    RendererListIDs = _meshletRendererListIDs,
+                    RendererListCounts = _rendererListCounts.AsArray(),
+                    RendererListStarts = _rendererListStarts.AsArray(),
+                    RenderRequests = _renderRequests,
+                }
+                .Schedule(handle);
+
+            return handle;
+        }
+
+        private static void ResizeAndClear<T>(ref NativeList<T> list, int length) where T : unmanaged
+        {
+            list.Clear();
+            list.Resize(length, NativeArrayOptions.ClearMemory);
+        }
+
+        public struct Inputs
+        {
+            public NativeArray<AAAAInstanceData> Instances;
+            public NativeArray<int> InstanceIndices;
+            public NativeArray<AAAAMeshLODNode> MeshLODNodes;
+            public NativeArray<AAAAMeshlet> Meshlets;
+            public NativeArray<AAAAMaterialData> Materials;
+            public NativeArray<GPUCullingContext> CullingContexts;
+            public NativeArray<GPULODSelectionContext> LODSelectionContexts;
+
+            // Only read by the main pass.
+            public NativeArray<uint> PrevInstanceVisibilityMask;
+
+            // Only read by the false negative pass.
+            public HZBInput HZB;
+        }
+
+        // Texels are laid out row by row, exactly as in the GPU textures.
+        public struct HZBInput
+        {
+            // Mip 0, sized as MipRects[0].zw.
+            public NativeArray<float> CameraDepth;
+            // The packed mip chain, mips 1+ are addressed through MipRects.
+            public NativeArray<float> Texture;
+            public int TextureWidth;
+            // Same as _CameraHZBMipRects: xy - offset, zw - size.
+            public NativeArray<float4> MipRects;
+        }
+
+        public struct Settings
+        {
+            public GPUCullingPass.PassType PassType;
+            public bool DisableOcclusionCulling;
+            public float MeshLODErrorThreshold;
+            // uint.MaxValue disables forced depth.
+            public uint ForcedMeshLODNodeDepth;
+            public AAAACullingMath.DepthConventions DepthConventions;
+            // Same as GPUCullingPass.MultiView: instances are culled once against all contexts, and each context still selects its own LODs.
+            public bool MultiView;
+
+            public static Settings Create(GPUCullingPass.PassType passType, float meshLODErrorThreshold) =>
+                new()
+                {
+                    PassType = passType,
+                    MeshLODErrorThreshold = meshLODErrorThreshold,
+                    ForcedMeshLODNodeDepth = uint.MaxValue,
+                    DepthConventions = new AAAACullingMath.DepthConventions
+                    {
+                        ReversedZ = SystemInfo.usesReversedZBuffer,
+                        UVStartsAtTop = SystemInfo.graphicsUVStartsAtTop,
+                    },
+                };
+        }
+
+        public struct RendererListRange
+        {
+            public int StartIndex;
+            public int Count;
+        }
+    }
+}
@@ -0,0 +1,244 @@
+using System.Runtime.CompilerServices;
+using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Passes;
+using Unity.Mathematics;
+using static Unity.Mathematics.math;
+
+namespace DELTation.AAAARP.Culling
+{
+    // Burst-friendly ports of the culling helpers from ShaderLibrary/Math.hlsl, Core.hlsl and VisibilityBuffer/*.hlsl.
+    // Keep them in sync with the shader code, the CPU culling pipeline relies on them to match the GPU results.
+    public static class AAAACullingMath
+    {
+        // FLT_MIN, used by SafeNormalize in the shader library and by the LOD distance falloff.
+        private const float FloatMinNormal = 1.175494351e-38f;
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        public static float3 TransformPoint(float4x4 matrix, float3 position) => mul(matrix, float4(position, 1.0f)).xyz;
+
+        [MethodImpl(MethodImplOptions.AggressiveInlining)]
+        public static float3 SafeNormalize(float3 value) => value * rsqrt(max(FloatMinNormal, dot(value, value)));
+
+        public static float4 TransformBoundingSphere(float4 boundingSphereOS, float4x4 objectToWorldMatrix)
+        {
+            float3 centerWS = mul(objectToWorldMatrix, float4(boundingSphereOS.xyz, 1)).xyz;
+            float3 offsetWS = mul(objectToWorldMatrix, float4(boundingSphereOS.w, 0, 0, 0)).xyz;
+            return float4(centerWS, length(offsetWS));
+        }
+
+        public static void TransformAABB(float3 aabbMinOS, float3 aabbMaxOS, float4x4 objectToWorldMatrix, out float3 aabbMinWS, out float3 aabbMaxWS)
+        {
+            aabbMinWS = float.MaxValue;
+            aabbMaxWS = -float.MaxValue;
+
+            for (int i = 0; i < 8; i++)
+            {
+                float3 cornerOS = select(aabbMinOS, aabbMaxOS, bool3((i & 4) != 0, (i & 2) != 0, (i & 1) != 0));
+                float3 cornerWS = TransformPoint(objectToWorldMatrix, cornerOS);
+                aabbMinWS = min(aabbMinWS, cornerWS);
+                aabbMaxWS = max(aabbMaxWS, cornerWS);
+            }
+        }
+
+        public static float4 AABBToBoundingSphere(float3 aabbMin, float3 aabbMax)
+        {
+            float3 center = (aabbMax + aabbMin) * 0.5f;
+            float3 extents = (aabbMax - aabbMin) * 0.5f;
+            return float4(center, length(extents));
+        }
+
+        public static bool LightSphereCulling(float4 cullingSphereLS, float4x4 worldToLightMatrix, float4 casterBoundingSphereWS)
+        {
+            if (cullingSphereLS.w <= 0.0f)
+            {
+                return true;
+            }
+
+            // com.unity.render-pipelines.core/Runtime/GPUDriven/FrustumPlanes.cs
+            float3 casterCenterLS = mul(float3x3(worldToLightMatrix), casterBoundingSphereWS.xyz);
+            float casterRadius = casterBoundingSphereWS.w;
+
+            float3 receiverToCasterLS = casterCenterLS - cullingSphereLS.xyz;
+
+            float intersectionMaxDistance = casterRadius + cullingSphereLS.w;
+            float zSqAtSphereIntersection = intersectionMaxDistance * intersectionMaxDistance - dot(receiverToCasterLS.xy, receiverToCasterLS.xy);
+
+            if (zSqAtSphereIntersection < 0.0f)
+            {
+                return false;
+            }
+
+            if (receiverToCasterLS.z < 0.0f && receiverToCasterLS.z * receiverToCasterLS.z > zSqAtSphereIntersection)
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        // Matches GetViewForwardDir: the negated third row of the view matrix.
+        public static float3 GetViewForwardDir(float4x4 viewMatrix) => -float3(viewMatrix.c0.z, viewMatrix.c1.z, viewMatrix.c2.z);
+
+        public static bool ConeCulling(float3 cameraPositionWS, float3 viewForwardDirWS, bool isPerspective, in AAAAInstanceData instanceData,
+            in AAAAMeshlet meshlet)
+        {
+            float3 coneApexWS = TransformPoint(instanceData.ObjectToWorldMatrix, meshlet.ConeApexCutoff.xyz);
+            float3 coneAxisWS = SafeNormalize(mul(meshlet.ConeAxis.xyz, float3x3(instanceData.WorldToObjectMatrix)));
+            float3 viewDirWS = isPerspective ? normalize(coneApexWS - cameraPositionWS) : viewForwardDirWS;
+            float dotResult = dot(viewDirWS, coneAxisWS);
+            return !(dotResult >= meshlet.ConeApexCutoff.w);
+        }
+
+        public static float3 ComputeNormalizedDeviceCoordinatesWithZ(float3 position, float4x4 viewProjectionMatrix, bool uvStartsAtTop)
+        {
+            float4 positionCS = mul(viewProjectionMatrix, float4(position, 1.0f));
+            if (uvStartsAtTop)
+            {
+                positionCS.y = -positionCS.y;
+            }
+            positionCS *= rcp(positionCS.w);
+            positionCS.xy = positionCS.xy * 0.5f + 0.5f;
+            return positionCS.xyz;
+        }
+
+        public static BoundingSquareSS ComputeScreenSpaceBoundingSquare(float3 aabbMin, float3 aabbMax, float4x4 viewProjectionMatrix,
+            in DepthConventions depthConventions)
+        {
+            BoundingSquareSS result;
+            result.NDCMinZ = depthConventions.Far;
+            result.MinUV = 1;
+            result.MaxUV = 0;
+
+            for (int i = 0; i < 8; i++)
+            {
+                float3 corner = select(aabbMin, aabbMax, bool3((i & 4) != 0, (i & 2) != 0, (i & 1) != 0));
+                float3 ndc = ComputeNormalizedDeviceCoordinatesWithZ(corner, viewProjectionMatrix, depthConventions.UVStartsAtTop);
+
+                result.MinUV = min(result.MinUV, ndc.xy);
+                result.MaxUV = max(result.MaxUV, ndc.xy);
+                result.NDCMinZ = depthConventions.MinDepth(result.NDCMinZ, ndc.z);
+            }
+
+            result.MinUV = saturate(result.MinUV);
+            result.MaxUV = saturate(result.MaxUV);
+
+            return result;
+        }
+
+        public static BoundingSquareSS ComputeScreenSpaceBoundingSquare(float4 boundingSphere, float4x4 viewProjectionMatrix,
+            in DepthConventions depthConventions) =>
+            ComputeScreenSpaceBoundingSquare(boundingSphere.xyz - boundingSphere.w, boundingSphere.xyz + boundingSphere.w, viewProjectionMatrix,
+                depthConventions
+            );
+
+        public static int ScreenUVToDebugBufferItemIndex(float2 uv)
+        {
+            const uint dimension = AAAAGPUCullingDebugData.GPUCullingDebugBufferDimension;
+            var cellIndices = (uint2) (clamp(uv, 0, 0.999f) * dimension);
+            return (int) (cellIndices.x * dimension + cellIndices.y);
+        }
+
+        // MeshletListBuild.compute: GetNormalizedScreenCoordinates.
+        public static float2 GetNormalizedScreenCoordinates(float4x4 viewProjectionMatrix, float3 positionWS)
+        {
+            float4 centerCS = mul(viewProjectionMatrix, float4(positionWS, 1.0f));
+            return centerCS.xy / centerCS.w * 0.5f + 0.5f;
+        }
+
+        // MeshletListBuild.compute: GetScreenBoundRadiusSq.
+        public static float GetScreenBoundRadiusSq(float4x4 viewProjectionMatrix, float3 cameraUp, float3 cameraRight, float2 screenSizePixels,
+            float4 boundsWS)
+        {
+            float2 p0 = GetNormalizedScreenCoordinates(viewProjectionMatrix, boundsWS.xyz);
+            float2 p1 = GetNormalizedScreenCoordinates(viewProjectionMatrix, boundsWS.xyz + cameraUp * boundsWS.w);
+            float2 p2 = GetNormalizedScreenCoordinates(viewProjectionMatrix, boundsWS.xyz + cameraRight * boundsWS.w);
+
+            float2 v0 = (p1 - p0) * screenSizePixels;
+            float2 v1 = (p2 - p0) * screenSizePixels;
+            return max(dot(v0, v0), dot(v1, v1));
+        }
+
+        // MeshletListBuild.compute: GetLODDistanceSq.
+        public static float GetLODDistanceSq(in GPULODSelectionContext lodSelectionContext, float3 instanceBoundsCenter) =>
+            lodSelectionContext.FixedDistanceSq > 0.0f
+                ? lodSelectionContext.FixedDistanceSq
+                : lengthsq(lodSelectionContext.CameraPosition.xyz - instanceBoundsCenter);
+
+        // MeshletListBuild.compute: GetConservativeLODDistanceScale.
+        public static float GetConservativeLODDistanceScale(in GPULODSelectionContext lodSelectionContext, float3 instanceBoundsCenter,
+            float distanceToViewSq)
+        {
+            if (lodSelectionContext.Conservative == 0)
+            {
+                return 0.0f;
+            }
+
+            float conservativeDistanceSq = lengthsq(lodSelectionContext.ConservativeCameraPosition.xyz - instanceBoundsCenter);
+            return distanceToViewSq / max(conservativeDistanceSq, FloatMinNormal);
+        }
+
+        // MeshletListBuild.compute: GetLODScreenBoundRadiusSq.
+        // conservativeDistanceScale moves the error of the conservative view to the distance falloff of the view itself.
+        public static float GetLODScreenBoundRadiusSq(in GPULODSelectionContext lodSelectionContext, float4 boundsWS, float conservativeDistanceScale)
+        {
+            float radiusSq = GetScreenBoundRadiusSq(lodSelectionContext.ViewProjectionMatrix, lodSelectionContext.CameraUp.xyz,
+                lodSelectionContext.CameraRight.xyz, lodSelectionContext.ScreenSizePixels, boundsWS
+            ) / lodSelectionContext.ErrorScale;
+
+            if (lodSelectionContext.Conservative != 0)
+            {
+                radiusSq = max(radiusSq, GetScreenBoundRadiusSq(lodSelectionContext.ConservativeViewProjectionMatrix,
+                        lodSelectionContext.ConservativeCameraUp.xyz, lodSelectionContext.ConservativeCameraRight.xyz,
+                        lodSelectionContext.ConservativeScreenSizePixels, boundsWS
+                    ) * conservativeDistanceScale
+                );
+            }
+
+            return radiusSq;
+        }
+
+        public const int MortonBitsPerAxis = 10;
+
+        // Interleaves the bits of a position normalized to [0, 1] into a 30-bit Morton code.
+        public static uint EncodeMorton3(float3 normalizedPosition)
+        {
+            const float maxCoordinate = (1 << MortonBitsPerAxis) - 1;
+            var coordinates = (uint3) (saturate(normalizedPosition) * maxCoordinate);
+            return (ExpandBits(coordinates.x) << 2) | (ExpandBits(coordinates.y) << 1) | ExpandBits(coordinates.z);
+        }
+
+        // Inserts two zero bits between each of the lower 10 bits.
+        private static uint ExpandBits(uint value)
+        {
+            value = (value * 0x00010001u) & 0xFF0000FFu;
+            value = (value * 0x00000101u) & 0x0F00F00Fu;
+            value = (value * 0x00000011u) & 0xC30C30C3u;
+            value = (value * 0x00000005u) & 0x49249249u;
+            return value;
+        }
+
+        public struct BoundingSquareSS
+        {
+            public float2 MinUV;
+            public float2 MaxUV;
+            public float NDCMinZ;
+
+            public float2 CenterUV => (MinUV + MaxUV) * 0.5f;
+        }
+
+        // Depth.hlsl and UNITY_UV_STARTS_AT_TOP depend on the graphics API, so they are passed in explicitly.
+        public struct DepthConventions
+        {
+            public bool ReversedZ;
+            public bool UVStartsAtTop;
+
+            public float Far => ReversedZ ? 0.0f : 1.0f;
+
+            public float MinDepth(float l, float r) => ReversedZ ? max(l, r) : min(l, r);
+
+            public float MaxDepth(float l, float r) => ReversedZ ? min(l, r) : max(l, r);
+
+            public bool LessEqualDepth(float l, float r) => ReversedZ ? l >= r : l <= r;
+        }
+    }
+}
@@ -0,0 +1,388 @@
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Culling
+{
+    public sealed partial class AAAASceneBVH
+    {
+        [BurstCompile]
+        private struct CreatePrimitivesJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+
+            [WriteOnly]
+            public NativeArray<Primitive> Primitives;
+
+            public void Execute(int index)
+            {
+                int instanceIndex = InstanceIndices[index];
+                Primitives[index] = CreatePrimitive(Instances[instanceIndex], instanceIndex);
+            }
+        }
+
+        [BurstCompile]
+        private struct ComputeCenterBoundsJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<Primitive> Primitives;
+
+            [WriteOnly]
+            public NativeArray<float3> CenterBounds;
+
+            public void Execute()
+            {
+                float3 min = float.MaxValue;
+                float3 max = -float.MaxValue;
+
+                foreach (Primitive primitive in Primitives)
+                {
+                    min = math.min(min, primitive.BoundingSphereWS.xyz);
+                    max = math.max(max, primitive.BoundingSphereWS.xyz);
+                }
+
+                CenterBounds[0] = min;
+                CenterBounds[1] = max;
+            }
+        }
+
+        // The Morton code goes to the upper half of the key, the primitive index to the lower one.
+        [BurstCompile]
+        private struct ComputeSortKeysJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<Primitive> Primitives;
+            [ReadOnly]
+            public NativeArray<float3> CenterBounds;
+
+            [WriteOnly]
+            public NativeArray<ulong> SortKeys;
+
+            public void Execute(int index)
+            {
+                float3 min = CenterBounds[0];
+                float3 extents = math.max(CenterBounds[1] - min, 1e-6f);
+                uint mortonCode = EncodeMorton3((Primitives[index].BoundingSphereWS.xyz - min) / extents);
+                SortKeys[index] = ((ulong) mortonCode << 32) | (uint) index;
+            }
+        }
+
+        [BurstCompile]
+        private struct BuildHierarchyJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<ulong> SortKeys;
+            [ReadOnly]
+            public NativeArray<Primitive> UnsortedPrimitives;
+
+            public NativeList<Primitive> Primitives;
+            public NativeList<Node> Nodes;
+            public NativeArray<int> InstanceToPrimitive;
+
+            public void Execute()
+            {
+                for (int i = 0; i < InstanceToPrimitive.Length; i++)
+                {
+                    InstanceToPrimitive[i] = -1;
+                }
+
+                int primitiveCount = SortKeys.Length;
+                Primitives.ResizeUninitialized(primitiveCount);
+                Nodes.Clear();
+
+                for (int i = 0; i < primitiveCount; i++)
+                {
+                    Primitive primitive = UnsortedPrimitives[(int) (SortKeys[i] & 0xFFFFFFFFu)];
+                    Primitives[i] = primitive;
+                    InstanceToPrimitive[primitive.InstanceIndex] = i;
+                }
+
+                if (primitiveCount == 0)
+                {
+                    return;
+                }
+
+                // Children are always appended after their parents, which is the order the refit relies on.
+                var stack = new NativeList<int>(64, Allocator.Temp);
+                Nodes.Add(CreateNode(0, primitiveCount));
+                stack.Add(0);
+
+                while (stack.Length > 0)
+                {
+                    int nodeIndex = stack[stack.Length - 1];
+                    stack.RemoveAtSwapBack(stack.Length - 1);
+
+                    Node node = Nodes[nodeIndex];
+                    if (node.PrimitiveCount <= MaxLeafSize)
+                    {
+                        continue;
+                    }
+
+                    int first = node.FirstPrimitive;
+                    int last = first + node.PrimitiveCount - 1;
+                    int split = FindSplit(first, last);
+
+                    node.LeftChild = Nodes.Length;
+                    Nodes.Add(CreateNode(first, split - first + 1));
+                    node.RightChild = Nodes.Length;
+                    Nodes.Add(CreateNode(split + 1, last - split));
+                    Nodes[nodeIndex] = node;
+
+                    stack.Add(node.RightChild);
+                    stack.Add(node.LeftChild);
+                }
+            }
+
+            private static Node CreateNode(int firstPrimitive, int primitiveCount) =>
+                new()
+                {
+                    LeftChild = -1,
+                    RightChild = -1,
+                    FirstPrimitive = firstPrimitive,
+                    PrimitiveCount = primitiveCount,
+                };
+
+            private uint GetMortonCode(int index) => (uint) (SortKeys[index] >> 32);
+
+            // Karras, "Maximizing Parallelism in the Construction of BVHs, Octrees, and k-d Trees": the last primitive
+            // that shares more leading bits with the first one than the last one does.
+            private int FindSplit(int first, int last)
+            {
+                uint firstCode = GetMortonCode(first);
+                uint lastCode = GetMortonCode(last);
+
+                if (firstCode == lastCode)
+                {
+                    return (first + last) >> 1;
+                }
+
+                int commonPrefix = math.lzcnt(firstCode ^ lastCode);
+                int split = first;
+                int step = last - first;
+
+                do
+                {
+                    step = (step + 1) >> 1;
+                    int newSplit = split + step;
+
+                    if (newSplit < last && math.lzcnt(firstCode ^ GetMortonCode(newSplit)) > commonPrefix)
+                    {
+                        split = newSplit;
+                    }
+                } while (step > 1);
+
+                return split;
+            }
+        }
+
+        [BurstCompile]
+        private struct UpdatePrimitivesJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<int> InstanceToPrimitive;
+
+            // The same instance may be listed more than once, it always writes the same value.
+            [NativeDisableParallelForRestriction]
+            public NativeArray<Primitive> Primitives;
+
+            public void Execute(int index)
+            {
+                int instanceIndex = InstanceIndices[index];
+                int primitiveIndex = instanceIndex < InstanceToPrimitive.Length ? InstanceToPrimitive[instanceIndex] : -1;
+                if (primitiveIndex >= 0)
+                {
+                    Primitives[primitiveIndex] = CreatePrimitive(Instances[instanceIndex], instanceIndex);
+                }
+            }
+        }
+
+        [BurstCompile]
+        private struct RefitNodesJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<Primitive> Primitives;
+
+            public NativeArray<Node> Nodes;
+            [WriteOnly]
+            public NativeReference<float> Cost;
+
+            public void Execute()
+            {
+                float weightedArea = 0.0f;
+
+                for (int nodeIndex = Nodes.Length - 1; nodeIndex >= 0; nodeIndex--)
+                {
+                    Node node = Nodes[nodeIndex];
+                    node.AABBMin = float.MaxValue;
+                    node.AABBMax = -float.MaxValue;
+                    node.PassMask = 0;
+
+                    if (node.IsLeaf)
+                    {
+                        for (int i = node.FirstPrimitive; i < node.FirstPrimitive + node.PrimitiveCount; i++)
+                        {
+                            Primitive primitive = Primitives[i];
+                            if (primitive.PassMask == 0)
+                            {
+                                continue;
+                            }
+
+                            node.AABBMin = math.min(node.AABBMin, primitive.BoundingSphereWS.xyz - primitive.BoundingSphereWS.w);
+                            node.AABBMax = math.max(node.AABBMax, primitive.BoundingSphereWS.xyz + primitive.BoundingSphereWS.w);
+                            node.PassMask |= primitive.PassMask;
+                        }
+                    }
+                    else
+                    {
+                        Node leftChild = Nodes[node.LeftChild];
+                        Node rightChild = Nodes[node.RightChild];
+                        node.AABBMin = math.min(leftChild.AABBMin, rightChild.AABBMin);
+                        node.AABBMax = math.max(leftChild.AABBMax, rightChild.AABBMax);
+                        node.PassMask = leftChild.PassMask | rightChild.PassMask;
+                    }
+
+                    Nodes[nodeIndex] = node;
+
+                    if (node.PassMask != 0)
+                    {
+                        weightedArea += SurfaceArea(node) * (node.IsLeaf ? node.PrimitiveCount : 1);
+                    }
+                }
+
+                float rootArea = Nodes.Length > 0 && Nodes[0].PassMask != 0 ? SurfaceArea(Nodes[0]) : 0.0f;
+                Cost.Value = rootArea > 0.0f ? weightedArea / rootArea : 0.0f;
+            }
+
+            private static float SurfaceArea(in Node node)
+            {
+                float3 size = node.AABBMax - node.AABBMin;
+                return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+            }
+        }
+
+        [BurstCompile]
+        private struct QueryJob : IJob
+        {
+            private const int Outside = 0;
+            private const int Intersecting = 1;
+            private const int Inside = 2;
+
+            [ReadOnly]
+            public NativeArray<Node> Nodes;
+            [ReadOnly]
+            public NativeArray<Primitive> Primitives;
+            public AAAACPUCullingPipeline.CullingView CullingView;
+            public float Margin;
+
+            public NativeList<int> Candidates;
+
+            public void Execute()
+            {
+                int passMask = (int) CullingView.PassMask;
+                bool hasCullingSphere = CullingView.CullingSphereLS.w > 0.0f;
+
+                var stack = new NativeList<int>(64, Allocator.Temp);
+                stack.Add(0);
+
+                while (stack.Length > 0)
+                {
+                    int nodeIndex = stack[stack.Length - 1];
+                    stack.RemoveAtSwapBack(stack.Length - 1);
+
+                    Node node = Nodes[nodeIndex];
+                    if ((node.PassMask & passMask) == 0)
+                    {
+                        continue;
+                    }
+
+                    int frustumResult = TestFrustum(node);
+                    if (frustumResult == Outside)
+                    {
+                        continue;
+                    }
+
+                    if (hasCullingSphere)
+                    {
+                        float3 center = (node.AABBMin + node.AABBMax) * 0.5f;
+                        float radius = math.length(node.AABBMax - center) + Margin;
+                        if (!LightSphereCulling(CullingView.CullingSphereLS, CullingView.ViewMatrix, math.float4(center, radius)))
+                        {
+                            continue;
+                        }
+                    }
+
+                    if (node.IsLeaf || frustumResult == Inside)
+                    {
+                        AppendPrimitives(node.FirstPrimitive, node.PrimitiveCount, passMask, frustumResult != Inside, hasCullingSphere);
+                        continue;
+                    }
+
+                    stack.Add(node.RightChild);
+                    stack.Add(node.LeftChild);
+                }
+            }
+
+            private void AppendPrimitives(int firstPrimitive, int primitiveCount, int passMask, bool testFrustum, bool testCullingSphere)
+            {
+                for (int i = firstPrimitive; i < firstPrimitive + primitiveCount; i++)
+                {
+                    Primitive primitive = Primitives[i];
+                    if ((primitive.PassMask & passMask) == 0)
+                    {
+                        continue;
+                    }
+
+                    float4 boundingSphereWS = primitive.BoundingSphereWS;
+                    boundingSphereWS.w += Margin;
+
+                    if (testFrustum && !CullingView.FrustumVsSphereCulling(boundingSphereWS))
+                    {
+                        continue;
+                    }
+
+                    if (testCullingSphere && !LightSphereCulling(CullingView.CullingSphereLS, CullingView.ViewMatrix, boundingSphereWS))
+                    {
+                        continue;
+                    }
+
+                    Candidates.Add(primitive.InstanceIndex);
+                }
+            }
+
+            private int TestFrustum(in Node node)
+            {
+                int result = Inside;
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane0));
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane1));
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane2));
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane3));
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane4));
+                result = math.min(result, TestPlane(node, CullingView.FrustumPlane5));
+                return result;
+            }
+
+            private int TestPlane(in Node node, float4 plane)
+            {
+                bool3 positiveNormal = plane.xyz >= 0.0f;
+                float3 farthestCorner = math.select(node.AABBMin, node.AABBMax, positiveNormal);
+                float3 nearestCorner = math.select(node.AABBMax, node.AABBMin, positiveNormal);
+
+                if (math.dot(plane.xyz, farthestCorner) + plane.w + Margin < 0.0f)
+                {
+                    return Outside;
+                }
+
+                return math.dot(plane.xyz, nearestCorner) + plane.w + Margin > 0.0f ? Inside : Intersecting;
+            }
+        }
+    }
+}
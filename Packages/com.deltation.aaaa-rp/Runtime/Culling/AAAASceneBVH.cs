@@ -0,0 +1,281 @@
+using System;
+using DELTation.AAAARP.Passes;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Culling
+{
+    // Bounding volume hierarchy over the world-space bounding spheres of all instances, used to reject whole groups of instances
+    // before they are sent to the GPU for per-instance culling.
+    // Built as an LBVH: primitives are sorted by the Morton codes of their centers and ranges are split at the highest differing bit.
+    // Transform changes only refit the node bounds. The tree is rebuilt when instances are added or when refits degrade its SAH cost.
+    public sealed partial class AAAASceneBVH : IDisposable
+    {
+        public const int MaxLeafSize = 4;
+        public const float RebuildCostRatio = 1.5f;
+        private const int BatchSize = 64;
+
+        private readonly Allocator _allocator;
+        private float _builtCost;
+        private NativeReference<float> _cost;
+        private NativeList<int> _instanceToPrimitive;
+        private bool _needsRebuild = true;
+        private bool _needsRefit;
+        private NativeList<Node> _nodes;
+        private NativeList<int> _pendingRefitInstances;
+        private NativeList<Primitive> _primitives;
+
+        public AAAASceneBVH(Allocator allocator = Allocator.Persistent)
+        {
+            _allocator = allocator;
+            _nodes = new NativeList<Node>(allocator);
+            _primitives = new NativeList<Primitive>(allocator);
+            _instanceToPrimitive = new NativeList<int>(allocator);
+            _pendingRefitInstances = new NativeList<int>(allocator);
+            _cost = new NativeReference<float>(allocator);
+        }
+
+        public int NodeCount => _nodes.Length;
+        public int PrimitiveCount => _primitives.Length;
+        public int BuildCount { get; private set; }
+
+        // Surface areas of all nodes weighted by their primitive counts, relative to the root.
+        public float Cost => _cost.Value;
+
+        public void Dispose()
+        {
+            if (_nodes.IsCreated)
+            {
+                _nodes.Dispose();
+            }
+
+            if (_primitives.IsCreated)
+            {
+                _primitives.Dispose();
+            }
+
+            if (_instanceToPrimitive.IsCreated)
+            {
+                _instanceToPrimitive.Dispose();
+            }
+
+            if (_pendingRefitInstances.IsCreated)
+            {
+                _pendingRefitInstances.Dispose();
+            }
+
+            if (_cost.IsCreated)
+            {
+                _cost.Dispose();
+            }
+        }
+
+        public void OnInstancesMoved(NativeArray<int> instanceIndices)
+        {
+            _pendingRefitInstances.AddRange(instanceIndices);
+            _needsRefit |= instanceIndices.Length > 0;
+        }
+
+        public void OnInstanceChanged(int instanceIndex)
+        {
+            if (GetPrimitiveIndex(instanceIndex) < 0)
+            {
+                _needsRebuild = true;
+                return;
+            }
+
+            _pendingRefitInstances.Add(instanceIndex);
+            _needsRefit = true;
+        }
+
+        // Removed instances stay in the tree as empty primitives until the next rebuild.
+        public void OnInstanceRemoved(int instanceIndex)
+        {
+            int primitiveIndex = GetPrimitiveIndex(instanceIndex);
+            if (primitiveIndex < 0)
+            {
+                return;
+            }
+
+            _primitives[primitiveIndex] = Primitive.Removed;
+            _instanceToPrimitive[instanceIndex] = -1;
+            _needsRefit = true;
+        }
+
+        public void Invalidate() => _needsRebuild = true;
+
+        private int GetPrimitiveIndex(int instanceIndex) =>
+            instanceIndex < _instanceToPrimitive.Length ? _instanceToPrimitive[instanceIndex] : -1;
+
+        public void Update(NativeArray<AAAAInstanceData> instances, NativeArray<int> instanceIndices)
+        {
+            if (_needsRebuild)
+            {
+                Build(instances, instanceIndices);
+                return;
+            }
+
+            if (!_needsRefit)
+            {
+                return;
+            }
+
+            Refit(instances);
+
+            if (_cost.Value > _builtCost * RebuildCostRatio)
+            {
+                Build(instances, instanceIndices);
+            }
+        }
+
+        public void Build(NativeArray<AAAAInstanceData> instances, NativeArray<int> instanceIndices)
+        {
+            int primitiveCount = instanceIndices.Length;
+            var unsortedPrimitives = new NativeArray<Primitive>(primitiveCount, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var sortKeys = new NativeArray<ulong>(primitiveCount, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            var centerBounds = new NativeArray<float3>(2, Allocator.TempJob);
+
+            _instanceToPrimitive.Resize(instances.Length, NativeArrayOptions.UninitializedMemory);
+
+            JobHandle handle = new CreatePrimitivesJob
+                {
+                    Instances = instances,
+                    InstanceIndices = instanceIndices,
+                    Primitives = unsortedPrimitives,
+                }
+                .Schedule(primitiveCount, BatchSize);
+            handle = new ComputeCenterBoundsJob
+                {
+                    Primitives = unsortedPrimitives,
+                    CenterBounds = centerBounds,
+                }
+                .Schedule(handle);
+            handle = new ComputeSortKeysJob
+                {
+                    Primitives = unsortedPrimitives,
+                    CenterBounds = centerBounds,
+                    SortKeys = sortKeys,
+                }
+                .Schedule(primitiveCount, BatchSize, handle);
+            handle = sortKeys.SortJob().Schedule(handle);
+            handle = new BuildHierarchyJob
+                {
+                    SortKeys = sortKeys,
+                    UnsortedPrimitives = unsortedPrimitives,
+                    Primitives = _primitives,
+                    Nodes = _nodes,
+                    InstanceToPrimitive = _instanceToPrimitive.AsArray(),
+                }
+                .Schedule(handle);
+            handle = new RefitNodesJob
+                {
+                    Primitives = _primitives.AsDeferredJobArray(),
+                    Nodes = _nodes.AsDeferredJobArray(),
+                    Cost = _cost,
+                }
+                .Schedule(handle);
+
+            handle = unsortedPrimitives.Dispose(handle);
+            handle = sortKeys.Dispose(handle);
+            centerBounds.Dispose(handle).Complete();
+
+            _builtCost = _cost.Value;
+            _pendingRefitInstances.Clear();
+            _needsRebuild = false;
+            _needsRefit = false;
+            ++BuildCount;
+        }
+
+        public void Refit(NativeArray<AAAAInstanceData> instances)
+        {
+            JobHandle handle = new UpdatePrimitivesJob
+                {
+                    Instances = instances,
+                    InstanceIndices = _pendingRefitInstances.AsArray(),
+                    InstanceToPrimitive = _instanceToPrimitive.AsArray(),
+                    Primitives = _primitives.AsArray(),
+                }
+                .Schedule(_pendingRefitInstances.Length, BatchSize);
+            new RefitNodesJob
+                {
+                    Primitives = _primitives.AsArray(),
+                    Nodes = _nodes.AsArray(),
+                    Cost = _cost,
+                }
+                .Schedule(handle).Complete();
+
+            _pendingRefitInstances.Clear();
+            _needsRefit = false;
+        }
+
+        // Appends the instances whose bounding spheres, inflated by the margin, pass the frustum and light sphere tests of the view.
+        // These are the same tests GPUInstanceCulling.compute performs, so no instance the GPU would accept is rejected.
+        public void Query(in GPUCullingContext cullingContext, float margin, NativeList<int> candidates) =>
+            Query(AAAACPUCullingPipeline.CullingView.Create(cullingContext), margin, candidates);
+
+        internal void Query(in AAAACPUCullingPipeline.CullingView cullingView, float margin, NativeList<int> candidates)
+        {
+            if (_nodes.Length == 0)
+            {
+                return;
+            }
+
+            new QueryJob
+                {
+                    Nodes = _nodes.AsArray(),
+                    Primitives = _primitives.AsArray(),
+                    CullingView = cullingView,
+                    Margin = margin,
+                    Candidates = candidates,
+                }
+                .Run();
+        }
+
+        private static Primitive CreatePrimitive(in AAAAInstanceData instanceData, int instanceIndex)
+        {
+            TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                out float3 aabbMinWS, out float3 aabbMaxWS
+            );
+
+            return new Primitive
+            {
+                BoundingSphereWS = AABBToBoundingSphere(aabbMinWS, aabbMaxWS),
+                InstanceIndex = instanceIndex,
+                // Disabled instances are never visible, so they are treated the same as the ones without any passes.
+                PassMask = (instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 ? 0 : (int) instanceData.PassMask,
+            };
+        }
+
+        private struct Primitive
+        {
+            public float4 BoundingSphereWS;
+            public int InstanceIndex;
+            public int PassMask;
+
+            public static Primitive Removed => new()
+            {
+                BoundingSphereWS = float4.zero,
+                InstanceIndex = -1,
+                PassMask = 0,
+            };
+        }
+
+        // Internal nodes reference their children and the contiguous range of primitives of the whole subtree.
+        private struct Node
+        {
+            // Encloses the bounding spheres of the primitives, not just their boxes.
+            public float3 AABBMin;
+            public float3 AABBMax;
+            public int LeftChild;
+            public int RightChild;
+            public int FirstPrimitive;
+            public int PrimitiveCount;
+            // Union of the pass masks in the subtree, zero if nothing in it can be visible.
+            public int PassMask;
+
+            public bool IsLeaf => LeftChild < 0;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Culling
+{
+    public sealed partial class AAAAStaticInstanceCullingCache
+    {
+        // Same tests as GPUInstanceCulling.compute, with the bounding spheres inflated by TranslationMargin.
+        [BurstCompile]
+        private struct StaticInstanceCullingJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<int> LastMovedFrames;
+            public int FrameIndex;
+            public AAAACPUCullingPipeline.CullingView CullingView;
+
+            [WriteOnly]
+            public NativeArray<bool> Passed;
+
+            public void Execute(int index)
+            {
+                int instanceIndex = InstanceIndices[index];
+
+                if (instanceIndex < LastMovedFrames.Length && IsDynamic(LastMovedFrames[instanceIndex], FrameIndex))
+                {
+                    Passed[index] = false;
+                    return;
+                }
+
+                AAAAInstanceData instanceData = Instances[instanceIndex];
+                if ((instanceData.Flags & AAAAInstanceFlags.Disabled) != 0 || (instanceData.PassMask & CullingView.PassMask) == 0)
+                {
+                    Passed[index] = false;
+                    return;
+                }
+
+                TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                    out float3 aabbMinWS, out float3 aabbMaxWS
+                );
+                float4 boundingSphereWS = AABBToBoundingSphere(aabbMinWS, aabbMaxWS);
+                boundingSphereWS.w += TranslationMargin;
+
+                Passed[index] = CullingView.FrustumVsSphereCulling(boundingSphereWS) &&
+                                LightSphereCulling(CullingView.CullingSphereLS, CullingView.ViewMatrix, boundingSphereWS);
+            }
+        }
+
+        [BurstCompile]
+        private struct RemoveDynamicCandidatesJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<int> LastMovedFrames;
+            public int FrameIndex;
+
+            public NativeList<int> Candidates;
+
+            public void Execute()
+            {
+                int count = 0;
+
+                for (int i = 0; i < Candidates.Length; i++)
+                {
+                    int instanceIndex = Candidates[i];
+                    if (instanceIndex < LastMovedFrames.Length && IsDynamic(LastMovedFrames[instanceIndex], FrameIndex))
+                    {
+                        continue;
+                    }
+
+                    Candidates[count++] = instanceIndex;
+                }
+
+                Candidates.Resize(count, NativeArrayOptions.UninitializedMemory);
+            }
+        }
+
+        [BurstCompile]
+        private struct CompactStaticCandidatesJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<bool> Passed;
+
+            public NativeList<int> StaticCandidates;
+
+            public void Execute()
+            {
+                for (int i = 0; i < InstanceIndices.Length; i++)
+                {
+                    if (Passed[i])
+                    {
+                        StaticCandidates.Add(InstanceIndices[i]);
+                    }
+                }
+            }
+        }
+    }
+}
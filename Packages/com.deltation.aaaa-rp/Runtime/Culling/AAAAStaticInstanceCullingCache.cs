@@ -0,0 +1,351 @@
+using System;
+using System.Collections.Generic;
+using DELTation.AAAARP.Passes;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Culling
+{
+    // Splits instances into static and dynamic ones and caches per-view instance culling results for the static ones.
+    // Instances that moved within the last DynamicFrameCount frames are dynamic and are always culled fresh.
+    // A cached view is reused while the scene does not change, the view keeps its orientation and projection,
+    // and it does not translate further than half of TranslationMargin. Bounds are inflated by the whole margin when caching,
+    // so the cached results stay conservative, the other half is slack for CPU/GPU precision differences.
+    public sealed partial class AAAAStaticInstanceCullingCache : IDisposable
+    {
+        public const int DynamicFrameCount = 30;
+        public const float TranslationMargin = 2.0f;
+        public const int MaxCachedViews = 16;
+        // Views that were not requested for this many frames are released.
+        private const int ViewEvictionFrameCount = 8;
+        private const int NeverMoved = int.MinValue / 2;
+        private const int CullingBatchSize = 64;
+
+        private readonly Allocator _allocator;
+        private readonly List<CachedView> _views = new();
+        private NativeList<int> _dynamicInstances;
+        private int _frameIndex;
+        private NativeList<int> _lastMovedFrames;
+
+        public AAAAStaticInstanceCullingCache(Allocator allocator = Allocator.Persistent)
+        {
+            _allocator = allocator;
+            _dynamicInstances = new NativeList<int>(allocator);
+            _lastMovedFrames = new NativeList<int>(allocator);
+        }
+
+        // Bumped on every change that can affect the cached results: scene edits and instances switching between static and dynamic.
+        public uint SceneVersion { get; private set; }
+
+        public NativeArray<int> DynamicInstances => _dynamicInstances.AsArray();
+
+        public int CachedViewCount => _views.Count;
+
+        public void Dispose()
+        {
+            foreach (CachedView view in _views)
+            {
+                view.Dispose();
+            }
+            _views.Clear();
+
+            if (_dynamicInstances.IsCreated)
+            {
+                _dynamicInstances.Dispose();
+            }
+
+            if (_lastMovedFrames.IsCreated)
+            {
+                _lastMovedFrames.Dispose();
+            }
+        }
+
+        public void BeginFrame(int frameIndex)
+        {
+            if (frameIndex == _frameIndex)
+            {
+                return;
+            }
+
+            _frameIndex = frameIndex;
+
+            bool staticSetChanged = false;
+
+            for (int i = _dynamicInstances.Length - 1; i >= 0; i--)
+            {
+                if (!IsDynamic(_dynamicInstances[i]))
+                {
+                    _dynamicInstances.RemoveAtSwapBack(i);
+                    staticSetChanged = true;
+                }
+            }
+
+            if (staticSetChanged)
+            {
+                ++SceneVersion;
+            }
+
+            for (int i = _views.Count - 1; i >= 0; i--)
+            {
+                CachedView view = _views[i];
+                if (_frameIndex - view.LastUsedFrame > ViewEvictionFrameCount)
+                {
+                    view.Dispose();
+                    _views.RemoveAt(i);
+                }
+            }
+        }
+
+        public bool IsDynamic(int instanceIndex) =>
+            instanceIndex < _lastMovedFrames.Length && IsDynamic(_lastMovedFrames[instanceIndex], _frameIndex);
+
+        private static bool IsDynamic(int lastMovedFrame, int frameIndex) => frameIndex - lastMovedFrame < DynamicFrameCount;
+
+        public void OnInstancesMoved(NativeArray<int> instanceIndices)
+        {
+            bool staticSetChanged = false;
+
+            foreach (int instanceIndex in instanceIndices)
+            {
+                EnsureCapacity(instanceIndex);
+
+                if (!IsDynamic(instanceIndex))
+                {
+                    _dynamicInstances.Add(instanceIndex);
+                    staticSetChanged = true;
+                }
+
+                _lastMovedFrames[instanceIndex] = _frameIndex;
+            }
+
+            if (staticSetChanged)
+            {
+                ++SceneVersion;
+            }
+        }
+
+        // New instances and edits of existing ones: bounds, pass mask, enabled state.
+        public void OnInstanceChanged(int instanceIndex)
+        {
+            EnsureCapacity(instanceIndex);
+
+            // Dynamic instances are never cached.
+            if (!IsDynamic(instanceIndex))
+            {
+                ++SceneVersion;
+            }
+        }
+
+        public void OnInstanceRemoved(int instanceIndex)
+        {
+            if (IsDynamic(instanceIndex))
+            {
+                _dynamicInstances.RemoveAtSwapBack(_dynamicInstances.IndexOf(instanceIndex));
+            }
+            else
+            {
+                ++SceneVersion;
+            }
+
+            if (instanceIndex < _lastMovedFrames.Length)
+            {
+                _lastMovedFrames[instanceIndex] = NeverMoved;
+            }
+        }
+
+        public void Invalidate() => ++SceneVersion;
+
+        // Appends the instances the GPU has to cull for the view: the static ones that may be visible, then all the dynamic ones.
+        // Returns true if the static part came from the cache.
+        public bool AppendCandidates(in GPUCullingContext cullingContext, NativeArray<AAAAInstanceData> instances, NativeArray<int> instanceIndices,
+            NativeList<int> candidates)
+        {
+            bool cacheHit = AcquireView(cullingContext, out CachedView view);
+
+            if (!cacheHit)
+            {
+                CullStaticInstances(view, instances, instanceIndices);
+            }
+
+            AppendCandidates(view, candidates);
+            return cacheHit;
+        }
+
+        // Same as above, but on a cache miss the static instances are culled hierarchically.
+        public bool AppendCandidates(in GPUCullingContext cullingContext, AAAASceneBVH sceneBVH, NativeList<int> candidates)
+        {
+            bool cacheHit = AcquireView(cullingContext, out CachedView view);
+
+            if (!cacheHit)
+            {
+                view.StaticCandidates.Clear();
+                sceneBVH.Query(view.CullingView, TranslationMargin, view.StaticCandidates);
+
+                new RemoveDynamicCandidatesJob
+                    {
+                        LastMovedFrames = _lastMovedFrames.AsArray(),
+                        FrameIndex = _frameIndex,
+                        Candidates = view.StaticCandidates,
+                    }
+                    .Run();
+            }
+
+            AppendCandidates(view, candidates);
+            return cacheHit;
+        }
+
+        private bool AcquireView(in GPUCullingContext cullingContext, out CachedView view)
+        {
+            var cullingView = AAAACPUCullingPipeline.CullingView.Create(cullingContext);
+            if (TryFindView(cullingView, out view))
+            {
+                return true;
+            }
+
+            view.CullingView = cullingView;
+            view.SceneVersion = SceneVersion;
+            return false;
+        }
+
+        private void AppendCandidates(CachedView view, NativeList<int> candidates)
+        {
+            view.LastUsedFrame = _frameIndex;
+
+            candidates.AddRange(view.StaticCandidates.AsArray());
+            candidates.AddRange(_dynamicInstances.AsArray());
+        }
+
+        private bool TryFindView(in AAAACPUCullingPipeline.CullingView cullingView, out CachedView result)
+        {
+            CachedView sameOrientationView = null;
+            CachedView oldestView = null;
+
+            foreach (CachedView view in _views)
+            {
+                if (HasSameOrientation(view.CullingView, cullingView))
+                {
+                    if (view.SceneVersion == SceneVersion && IsWithinTranslationMargin(view.CullingView, cullingView))
+                    {
+                        result = view;
+                        return true;
+                    }
+
+                    sameOrientationView ??= view;
+                }
+
+                if (view.LastUsedFrame != _frameIndex && (oldestView == null || view.LastUsedFrame < oldestView.LastUsedFrame))
+                {
+                    oldestView = view;
+                }
+            }
+
+            result = sameOrientationView;
+
+            if (result == null && _views.Count >= MaxCachedViews)
+            {
+                result = oldestView;
+            }
+
+            if (result == null)
+            {
+                result = new CachedView(_allocator);
+                _views.Add(result);
+            }
+
+            return false;
+        }
+
+        // Translation only changes the plane distances and the position of the light culling sphere.
+        private static bool HasSameOrientation(in AAAACPUCullingPipeline.CullingView cached, in AAAACPUCullingPipeline.CullingView current) =>
+            cached.PassMask == current.PassMask &&
+            cached.IsPerspective == current.IsPerspective &&
+            cached.CullingSphereLS.w == current.CullingSphereLS.w &&
+            math.all(((float3x3) cached.ViewMatrix).c0 == ((float3x3) current.ViewMatrix).c0) &&
+            math.all(((float3x3) cached.ViewMatrix).c1 == ((float3x3) current.ViewMatrix).c1) &&
+            math.all(((float3x3) cached.ViewMatrix).c2 == ((float3x3) current.ViewMatrix).c2) &&
+            math.all(cached.FrustumPlane0.xyz == current.FrustumPlane0.xyz) &&
+            math.all(cached.FrustumPlane1.xyz == current.FrustumPlane1.xyz) &&
+            math.all(cached.FrustumPlane2.xyz == current.FrustumPlane2.xyz) &&
+            math.all(cached.FrustumPlane3.xyz == current.FrustumPlane3.xyz) &&
+            math.all(cached.FrustumPlane4.xyz == current.FrustumPlane4.xyz) &&
+            math.all(cached.FrustumPlane5.xyz == current.FrustumPlane5.xyz);
+
+        private static bool IsWithinTranslationMargin(in AAAACPUCullingPipeline.CullingView cached, in AAAACPUCullingPipeline.CullingView current)
+        {
+            const float maxOffset = TranslationMargin * 0.5f;
+
+            float maxPlaneOffset = math.cmax(math.abs(math.float3(
+                        cached.FrustumPlane0.w - current.FrustumPlane0.w,
+                        cached.FrustumPlane1.w - current.FrustumPlane1.w,
+                        cached.FrustumPlane2.w - current.FrustumPlane2.w
+                    )
+                )
+            );
+            maxPlaneOffset = math.max(maxPlaneOffset, math.cmax(math.abs(math.float3(
+                            cached.FrustumPlane3.w - current.FrustumPlane3.w,
+                            cached.FrustumPlane4.w - current.FrustumPlane4.w,
+                            cached.FrustumPlane5.w - current.FrustumPlane5.w
+                        )
+                    )
+                )
+            );
+
+            return maxPlaneOffset <= maxOffset &&
+                   math.distance(cached.CullingSphereLS.xyz, current.CullingSphereLS.xyz) <= maxOffset;
+        }
+
+        private void EnsureCapacity(int instanceIndex)
+        {
+            while (_lastMovedFrames.Length <= instanceIndex)
+            {
+                _lastMovedFrames.Add(NeverMoved);
+            }
+        }
+
+        private void CullStaticInstances(CachedView view, NativeArray<AAAAInstanceData> instances, NativeArray<int> instanceIndices)
+        {
+            var passed = new NativeArray<bool>(instanceIndices.Length, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+
+            JobHandle handle = new StaticInstanceCullingJob
+                {
+                    Instances = instances,
+                    InstanceIndices = instanceIndices,
+                    LastMovedFrames = _lastMovedFrames.AsArray(),
+                    FrameIndex = _frameIndex,
+                    CullingView = view.CullingView,
+                    Passed = passed,
+                }
+                .Schedule(instanceIndices.Length, CullingBatchSize);
+
+            view.StaticCandidates.Clear();
+            handle = new CompactStaticCandidatesJob
+                {
+                    InstanceIndices = instanceIndices,
+                    Passed = passed,
+                    StaticCandidates = view.StaticCandidates,
+                }
+                .Schedule(handle);
+
+            passed.Dispose(handle).Complete();
+        }
+
+        private sealed class CachedView : IDisposable
+        {
+            public AAAACPUCullingPipeline.CullingView CullingView;
+            public int LastUsedFrame;
+            public uint SceneVersion;
+            public NativeList<int> StaticCandidates;
+
+            public CachedView(Allocator allocator) => StaticCandidates = new NativeList<int>(allocator);
+
+            public void Dispose()
+            {
+                if (StaticCandidates.IsCreated)
+                {
+                    StaticCandidates.Dispose();
+                }
+            }
+        }
+    }
+}
@@ -1,4 +1,6 @@
 ﻿using System;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Passes.ClusteredLighting;
 using DELTation.AAAARP.RenderPipelineResources;
 using UnityEngine;
 using UnityEngine.Rendering;
@@ -54,8 +56,27 @@ namespace DELTation.AAAARP.Data
     [Serializable]
     public class AAAAMeshLODSettings
     {
+        public enum MeshletRenderRequestBufferSizing
+        {
+            [Tooltip("Every culling context has room for all leaf meshlets of all instances.")]
+            WorstCase,
+            [Tooltip("The lists are sized from the request counts read back from the GPU. Requests that do not fit are dropped until the lists grow. " +
+                     "Drops follow the order in which the GPU appends the requests, not their size on screen, " +
+                     "so a nearby object can go missing for a few frames while distant ones are still drawn."
+            )]
+            Adaptive,
+        }
+
         [Min(0.0f)]
         public float ErrorThreshold = 50.0f;
+
+        [Tooltip("How the per-context meshlet render request lists are sized.")]
+        public MeshletRenderRequestBufferSizing RenderRequestBufferSizing = MeshletRenderRequestBufferSizing.WorstCase;
+
+        // Scales ErrorThreshold to keep the geometry visible to game cameras within a budget. Driven by GPU counters read back every frame.
+        // Shadow casters are selected with the unscaled threshold.
+        public bool GeometryBudget;
+        public AAAAGeometryBudgetController.Settings GeometryBudgetSettings = AAAAGeometryBudgetController.Settings.Default;
     }
 
     [Serializable]
@@ -92,6 +113,8 @@ namespace DELTation.AAAARP.Data
 
         [Range(16, 1024 * 16)]
         public int MaxPunctualLights = 1024;
+        // Cull lights only for the clusters that the depth buffer says can contain lit surfaces.
+        [EnumButtons] public AAAAClusterDepthCullingMode ClusterDepthCulling = AAAAClusterDepthCullingMode.Conservative;
         public ShadowSettings Shadows = new();
 
         [EnumButtons] public AAAAAmbientOcclusionTechnique AmbientOcclusion = AAAAAmbientOcclusionTechnique.XeGTAO;
@@ -109,18 +132,47 @@ namespace DELTation.AAAARP.Data
             public const float DefaultPunctualDepthBias = 0.05f;
             public const float DefaultSlopeBias = 0.5f;
             public const float DefaultShadowFade = 0.2f;
+            public const int DefaultDirectionalLightNearCascades = 2;
+            public const int DefaultDirectionalLightFarCascadeUpdateInterval = 4;
+            public const float DefaultDirectionalLightFarCascadeGuardBand = 0.1f;
+            public const int MaxDirectionalLightFarCascadeUpdateInterval = 16;
+            public const float MinCasterLODErrorScale = 0.25f;
+            public const float MaxCasterLODErrorScale = 16.0f;
 
             public AAAATextureSize Resolution = AAAATextureSize._1024;
+            public AAAATextureSize AtlasSize = AAAATextureSize._4096;
+            [Range(16, 2048)] public int AtlasMemoryBudgetMB = 128;
+            // Shadow map texels of all splits a camera may render in a frame.
+            [Range(1, 256)] public int RenderBudgetMTexels = 32;
+            // Size punctual light shadow maps by how much of the screen the light covers, instead of always using Resolution.
+            public bool ScreenCoverageResolution = true;
+            [Range(0.25f, 4.0f)] public float ScreenCoverageTexelsPerPixel = 1.0f;
             [Range(16, 512)] public int MaxShadowLightSlices = 128;
             [Min(1.0f)] public float MaxDistance = DefaultMaxDistance;
             [Range(1, MaxCascades)] public int DirectionalLightCascades = MaxCascades;
             [Range(0.0f, 1.0f)] public float DirectionalLightCascadeDistance1 = 0.25f;
             [Range(0.0f, 1.0f)] public float DirectionalLightCascadeDistance2 = 0.5f;
             [Range(0.0f, 1.0f)] public float DirectionalLightCascadeDistance3 = 0.75f;
+            // Cascades past the near ones keep their matrices for a few frames, see AAAAShadowCascadeScheduler. Requires CacheShadowMaps.
+            [Range(1, MaxCascades)] public int DirectionalLightNearCascades = DefaultDirectionalLightNearCascades;
+            [Range(1, MaxDirectionalLightFarCascadeUpdateInterval)]
+            public int DirectionalLightFarCascadeUpdateInterval = DefaultDirectionalLightFarCascadeUpdateInterval;
+            [Range(0.0f, 0.5f)] public float DirectionalLightFarCascadeGuardBand = DefaultDirectionalLightFarCascadeGuardBand;
             [Range(0.0f, 1.0f)] public float ShadowFade = DefaultShadowFade;
             [Range(0.0f, 1.0f)] public float DepthBias = DefaultDepthBias;
             [Range(0.0f, 1.0f)] public float PunctualDepthBias = DefaultPunctualDepthBias;
             [Range(0.0f, 1.0f)] public float SlopeBias = DefaultSlopeBias;
+            public bool MultiViewCulling = true;
+            // Select caster LODs from shadow map texels instead of the main camera pixels.
+            public bool CasterLODFromShadowMapTexels = true;
+            // Larger values select coarser caster LODs.
+            [Range(MinCasterLODErrorScale, MaxCasterLODErrorScale)] public float CasterLODErrorScale = 1.0f;
+            // Never select coarser caster LODs than the main camera does, to avoid self-shadowing where casters and receivers differ.
+            // Cached splits are then rendered again whenever the camera moves.
+            public bool ConservativeCasterLOD;
+            // Reuse the depth of splits whose light, tile and casters did not change since the previous frame.
+            // Unless caster LODs come from shadow map texels alone, camera movement also invalidates them.
+            public bool CacheShadowMaps = true;
         }
 
         [Serializable]
@@ -149,8 +201,25 @@ namespace DELTation.AAAARP.Data
     [Serializable]
     public class AAAAImageBasedLightingSettings
     {
+        public enum DiffuseIrradianceSource
+        {
+            Convolution,
+            SH9,
+        }
+
+        public enum UpdateMode
+        {
+            Immediate,
+            TimeSliced,
+        }
+
+        [EnumButtons] public DiffuseIrradianceSource DiffuseIrradiance = DiffuseIrradianceSource.Convolution;
         public AAAATextureSize DiffuseIrradianceResolution = AAAATextureSize._128;
 
+        // Time-sliced updates spread the convolution over frames and keep showing the previous result until they finish.
+        [EnumButtons] public UpdateMode Updates = UpdateMode.Immediate;
+        [Range(0.1f, 4.0f)] public float TimeSlicedBudgetMs = 0.5f;
+
         public AAAATextureSize BRDFLutResolution = AAAATextureSize._128;
 
         public PreFilteredEnvironmentMapSettings PreFilteredEnvironmentMap = new();
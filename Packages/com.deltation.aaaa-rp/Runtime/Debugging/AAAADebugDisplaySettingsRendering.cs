@@ -146,6 +146,10 @@ namespace DELTation.AAAARP.Debugging
                         { name = "Forced Mesh LOD Node Depth" };
                     public static readonly DebugUI.Widget.NameAndTooltip MeshLODErrorThresholdBias = new()
                         { name = "Mesh LOD Error Threshold Bias" };
+                    public static readonly DebugUI.Widget.NameAndTooltip GeometryBudget = new()
+                        { name = "Geometry Budget", tooltip = "State of the geometry budget configured in the pipeline asset's mesh LOD settings." };
+                    public static readonly DebugUI.Widget.NameAndTooltip GeometryMemory = new()
+                        { name = "Geometry Memory", tooltip = "Live and dead bytes in the shared meshlet geometry pools." };
                 }
 
                 public static class WidgetFactory
@@ -164,6 +168,8 @@ namespace DELTation.AAAARP.Debugging
                                 CreateVisibilityBufferDebugMode(panel),
                                 CreateForcedMeshLODNodeDepth(panel),
                                 CreateMeshLODTargetErrorBias(panel),
+                                CreateGeometryBudgetFoldout(panel),
+                                CreateGeometryMemoryFoldout(panel),
                                 CreateGPUCullingFoldout(panel),
                             },
                         };
@@ -237,6 +243,24 @@ namespace DELTation.AAAARP.Debugging
                         },
                     };
 
+                    private static DebugUI.Widget CreateGeometryMemoryFoldout(SettingsPanel panel) => new DebugUI.Foldout
+                    {
+                        nameAndTooltip = Strings.GeometryMemory,
+                        children =
+                        {
+                            new DebugUI.MessageBox
+                            {
+                                nameAndTooltip = Strings.GeometryMemory,
+                                messageCallback = () =>
+                                {
+                                    StringBuilder.Clear();
+                                    panel._stats.BuildGeometryMemoryString(StringBuilder);
+                                    return StringBuilder.ToString();
+                                },
+                            },
+                        },
+                    };
+
                     private static DebugUI.Widget CreateForcedMeshLODNodeDepth(SettingsPanel panel) => new DebugUI.IntField
                     {
                         nameAndTooltip = Strings.ForcedMeshLODNodeDepth,
@@ -254,6 +278,24 @@ namespace DELTation.AAAARP.Debugging
                         min = () => -1000.0f,
                         max = () => 1000.0f,
                     };
+
+                    private static DebugUI.Widget CreateGeometryBudgetFoldout(SettingsPanel panel) => new DebugUI.Foldout
+                    {
+                        nameAndTooltip = Strings.GeometryBudget,
+                        children =
+                        {
+                            new DebugUI.MessageBox
+                            {
+                                nameAndTooltip = Strings.GeometryBudget,
+                                messageCallback = () =>
+                                {
+                                    StringBuilder.Clear();
+                                    panel._stats.BuildGeometryBudgetString(StringBuilder);
+                                    return StringBuilder.ToString();
+                                },
+                            },
+                        },
+                    };
                 }
             }
 
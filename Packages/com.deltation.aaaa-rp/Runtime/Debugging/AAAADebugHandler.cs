@@ -120,7 +120,7 @@ namespace DELTation.AAAARP.Debugging
                     renderer.EnqueuePass(_gpuCullingDebugViewPass);
                 }
 
-                if (_gpuCullingDebugReadbackPass != null && DisplaySettings.RenderingSettings.DebugGPUCulling)
+                if (_gpuCullingDebugReadbackPass != null)
                 {
                     renderer.EnqueuePass(_gpuCullingDebugReadbackPass);
                 }
@@ -1,5 +1,7 @@
 using System.Collections.Generic;
 using System.Text;
+using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Renderers;
 using UnityEngine;
 
 namespace DELTation.AAAARP.Debugging
@@ -10,6 +12,10 @@ namespace DELTation.AAAARP.Debugging
 
         public readonly Dictionary<Camera, GPUCullingStats> GPUCulling = new();
 
+        public AAAARendererContainer.GeometryMemoryStats GeometryMemory;
+
+        public GeometryBudgetStats GeometryBudget;
+
         public static double TimeNow => Time.timeSinceLevelLoadAsDouble;
 
         public void BuildGPUCullingString(StringBuilder stringBuilder)
@@ -44,6 +50,9 @@ namespace DELTation.AAAARP.Debugging
 
                 BuildField(stringBuilder, nameof(AAAAGPUCullingDebugData.ConeCulledMeshlets), kvp.Value.Data.ConeCulledMeshlets);
 
+                BuildField(stringBuilder, nameof(AAAAGPUCullingDebugData.VisibleMeshlets), kvp.Value.Data.VisibleMeshlets);
+                BuildField(stringBuilder, nameof(AAAAGPUCullingDebugData.VisibleTriangles), kvp.Value.Data.VisibleTriangles);
+
                 any = true;
             }
 
@@ -58,6 +67,63 @@ namespace DELTation.AAAARP.Debugging
             }
         }
 
+        public void BuildGeometryMemoryString(StringBuilder stringBuilder)
+        {
+            stringBuilder.Append("Meshes: ");
+            stringBuilder.Append(GeometryMemory.LiveMeshCount);
+            stringBuilder.Append(" live, ");
+            stringBuilder.Append(GeometryMemory.PendingReleaseMeshCount);
+            stringBuilder.Append(" pending release");
+
+            stringBuilder.Append("\nLive: ");
+            AppendMegabytes(stringBuilder, GeometryMemory.LiveBytes);
+            stringBuilder.Append("\nDead: ");
+            AppendMegabytes(stringBuilder, GeometryMemory.DeadBytes);
+
+            return;
+
+            static void AppendMegabytes(StringBuilder stringBuilder, long bytes)
+            {
+                stringBuilder.Append((bytes / (1024.0 * 1024.0)).ToString("F2"));
+                stringBuilder.Append(" MB");
+            }
+        }
+
+        public void BuildGeometryBudgetString(StringBuilder stringBuilder)
+        {
+            if (!GeometryBudget.Enabled)
+            {
+                stringBuilder.Append("Disabled in the pipeline asset");
+                return;
+            }
+
+            stringBuilder.Append("Visible: ");
+            stringBuilder.Append(GeometryBudget.VisibleMeshlets);
+            stringBuilder.Append(" meshlets, ");
+            stringBuilder.Append(GeometryBudget.VisibleTriangles);
+            stringBuilder.Append(" triangles");
+
+            stringBuilder.Append("\nTarget: ");
+            stringBuilder.Append(GeometryBudget.Settings.TargetMeshletCount);
+            stringBuilder.Append(" meshlets, ");
+            stringBuilder.Append(GeometryBudget.Settings.TargetTriangleCount);
+            stringBuilder.Append(" triangles");
+
+            stringBuilder.Append("\nError Multiplier: ");
+            stringBuilder.Append(GeometryBudget.ErrorMultiplier.ToString("F2"));
+            stringBuilder.Append(GeometryBudget.IsSettled ? " (settled)" : " (adjusting)");
+        }
+
+        public struct GeometryBudgetStats
+        {
+            public bool Enabled;
+            public AAAAGeometryBudgetController.Settings Settings;
+            public float ErrorMultiplier;
+            public bool IsSettled;
+            public uint VisibleMeshlets;
+            public uint VisibleTriangles;
+        }
+
         public struct GPUCullingStats
         {
             public double LastUpdateTime;
@@ -14,6 +14,8 @@ namespace DELTation.AAAARP.Debugging
         public uint OcclusionCulledInstances;
         public uint OcclusionCulledMeshlets;
         public uint ConeCulledMeshlets;
+        public uint VisibleMeshlets;
+        public uint VisibleTriangles;
     }
 
     [GenerateHLSL]
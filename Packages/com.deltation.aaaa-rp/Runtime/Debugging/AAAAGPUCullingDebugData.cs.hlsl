@@ -31,6 +31,8 @@ struct AAAAGPUCullingDebugData
     uint OcclusionCulledInstances;
     uint OcclusionCulledMeshlets;
     uint ConeCulledMeshlets;
+    uint VisibleMeshlets;
+    uint VisibleTriangles;
 };
 
 
@@ -1,4 +1,7 @@
-﻿using DELTation.AAAARP.Data;
+﻿using System.Collections.Generic;
+using DELTation.AAAARP.Data;
+using DELTation.AAAARP.Lighting;
+using DELTation.AAAARP.Passes.IBL;
 using Unity.Mathematics;
 using UnityEngine;
 using UnityEngine.Experimental.Rendering;
@@ -9,7 +12,14 @@ namespace DELTation.AAAARP.FrameData
 {
     public class AAAAImageBasedLightingData : ContextItem
     {
+        // Wraps the time-sliced work of the IBL passes, its GPU time drives the scheduler.
+        public static readonly ProfilingSampler TimeSlicedUpdateSampler = new("IBL Time-Sliced Update");
+
+        private readonly AAAAImageBasedLightingUpdateScheduler _scheduler = new();
+        private readonly List<AAAAImageBasedLightingUpdateScheduler.Slice> _slices = new();
+        private AAAAImageBasedLightingSettings.DiffuseIrradianceSource _previousDiffuseIrradianceSource;
         private Hash128 _previousReflectionProbeHash;
+        private bool _swapBuffers;
 
         public TextureHandle BRDFLut;
         public bool BRDFLutIsDirty;
@@ -17,23 +27,60 @@ namespace DELTation.AAAARP.FrameData
         public TextureHandle DiffuseIrradiance;
         public RenderTextureDescriptor DiffuseIrradianceDesc;
         public bool DiffuseIrradianceIsDirty;
+        public AAAAImageBasedLightingSettings.DiffuseIrradianceSource DiffuseIrradianceSource;
 
         public TextureHandle PreFilteredEnvironmentMap;
         public RenderTextureDescriptor PreFilteredEnvironmentMapDesc;
         public bool PreFilteredEnvironmentMapIsDirty;
 
+        // Time-sliced updates render into the back buffers. They become the front ones once every slice is done.
+        public TextureHandle DiffuseIrradianceBackBuffer;
+        // SH9 is cheap enough to refresh the whole back buffer in the first frame of an update.
+        public bool DiffuseIrradianceBackBufferIsDirty;
+        public readonly List<AAAAImageBasedLightingUpdateScheduler.Slice> DiffuseIrradianceSlices = new();
+
+        public TextureHandle PreFilteredEnvironmentMapBackBuffer;
+        public readonly List<AAAAImageBasedLightingUpdateScheduler.Slice> PreFilteredEnvironmentMapSlices = new();
+
         public static (Texture reflectionProbe, Vector4 hdrDecodeValues) GetDefaultProbe() =>
             (ReflectionProbe.defaultTexture, ReflectionProbe.defaultTextureHDRDecodeValues);
 
         public void Init(AAAAImageBasedLightingSettings settings, RenderGraph renderGraph)
         {
+            bool timeSliced = settings.Updates == AAAAImageBasedLightingSettings.UpdateMode.TimeSliced;
+            DiffuseIrradianceSource = settings.DiffuseIrradiance;
+
+            if (_swapBuffers)
+            {
+                (DiffuseIrradiance, DiffuseIrradianceBackBuffer) = (DiffuseIrradianceBackBuffer, DiffuseIrradiance);
+                (PreFilteredEnvironmentMap, PreFilteredEnvironmentMapBackBuffer) = (PreFilteredEnvironmentMapBackBuffer, PreFilteredEnvironmentMap);
+                _swapBuffers = false;
+            }
+
             Hash128 currentReflectionProbeHash = GetCurrentReflectionProbeHash();
 
-            if (_previousReflectionProbeHash != currentReflectionProbeHash)
+            if (_previousReflectionProbeHash != currentReflectionProbeHash || _previousDiffuseIrradianceSource != DiffuseIrradianceSource)
             {
+                // Until the first immediate update, there is no previous result to keep showing.
+                if (timeSliced && !DiffuseIrradianceIsDirty && !PreFilteredEnvironmentMapIsDirty)
+                {
+                    RestartTimeSlicedUpdate();
+                }
+                else
+                {
+                    DiffuseIrradianceIsDirty = true;
+                    PreFilteredEnvironmentMapIsDirty = true;
+                }
+
+                _previousReflectionProbeHash = currentReflectionProbeHash;
+                _previousDiffuseIrradianceSource = DiffuseIrradianceSource;
+            }
+
+            if (!timeSliced && _scheduler.IsUpdating)
+            {
+                _scheduler.Restart();
                 DiffuseIrradianceIsDirty = true;
                 PreFilteredEnvironmentMapIsDirty = true;
-                _previousReflectionProbeHash = currentReflectionProbeHash;
             }
 
             if (!DiffuseIrradiance.IsValid())
@@ -84,6 +131,73 @@ namespace DELTation.AAAARP.FrameData
 
                 PreFilteredEnvironmentMapIsDirty = true;
             }
+
+            if (timeSliced && !DiffuseIrradianceBackBuffer.IsValid())
+            {
+                DiffuseIrradianceBackBuffer =
+                    renderGraph.CreateSharedTexture(AAAARenderingUtils.CreateTextureDesc(nameof(DiffuseIrradianceBackBuffer), DiffuseIrradianceDesc));
+            }
+
+            if (timeSliced && !PreFilteredEnvironmentMapBackBuffer.IsValid())
+            {
+                PreFilteredEnvironmentMapBackBuffer = renderGraph.CreateSharedTexture(
+                    AAAARenderingUtils.CreateTextureDesc(nameof(PreFilteredEnvironmentMapBackBuffer), PreFilteredEnvironmentMapDesc)
+                );
+            }
+
+            ScheduleTimeSlicedUpdate(settings);
+        }
+
+        private void RestartTimeSlicedUpdate()
+        {
+            _scheduler.Restart();
+
+            if (DiffuseIrradianceSource == AAAAImageBasedLightingSettings.DiffuseIrradianceSource.SH9)
+            {
+                DiffuseIrradianceBackBufferIsDirty = true;
+            }
+            else
+            {
+                _scheduler.AddCubemapMip(AAAAImageBasedLightingUpdateScheduler.Target.DiffuseIrradiance, 0, DiffuseIrradianceDesc.width,
+                    ConvolveDiffuseIrradiancePass.ConvolutionSamplesPerTexel
+                );
+            }
+
+            for (int mipIndex = 0; mipIndex < PreFilteredEnvironmentMapDesc.mipCount; mipIndex++)
+            {
+                _scheduler.AddCubemapMip(AAAAImageBasedLightingUpdateScheduler.Target.PreFilteredEnvironmentMap, mipIndex,
+                    math.max(1, PreFilteredEnvironmentMapDesc.width >> mipIndex), PreFilterEnvironmentPass.SamplesPerTexel
+                );
+            }
+        }
+
+        private void ScheduleTimeSlicedUpdate(AAAAImageBasedLightingSettings settings)
+        {
+            DiffuseIrradianceSlices.Clear();
+            PreFilteredEnvironmentMapSlices.Clear();
+
+            TimeSlicedUpdateSampler.enableRecording = _scheduler.IsUpdating;
+            if (!_scheduler.IsUpdating)
+            {
+                return;
+            }
+
+            // Init runs once per camera, the scheduler only hands out slices to the first camera of a frame.
+            int frameIndex = Time.frameCount;
+            _scheduler.ReportGPUTime(TimeSlicedUpdateSampler.gpuElapsedTime, frameIndex - AAAAImageBasedLightingUpdateScheduler.GPUTimeLatencyFrames);
+            _swapBuffers = _scheduler.ScheduleFrame(frameIndex, settings.TimeSlicedBudgetMs, _slices);
+
+            foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in _slices)
+            {
+                if (slice.Target == AAAAImageBasedLightingUpdateScheduler.Target.DiffuseIrradiance)
+                {
+                    DiffuseIrradianceSlices.Add(slice);
+                }
+                else
+                {
+                    PreFilteredEnvironmentMapSlices.Add(slice);
+                }
+            }
         }
 
         private static Hash128 GetCurrentReflectionProbeHash()
@@ -101,12 +215,20 @@ namespace DELTation.AAAARP.FrameData
             DiffuseIrradiance = TextureHandle.nullHandle;
             DiffuseIrradianceDesc = default;
             DiffuseIrradianceIsDirty = true;
+            DiffuseIrradianceBackBuffer = TextureHandle.nullHandle;
+            DiffuseIrradianceBackBufferIsDirty = false;
+            DiffuseIrradianceSlices.Clear();
 
             BRDFLut = TextureHandle.nullHandle;
             BRDFLutIsDirty = true;
 
             PreFilteredEnvironmentMap = TextureHandle.nullHandle;
             PreFilteredEnvironmentMapIsDirty = true;
+            PreFilteredEnvironmentMapBackBuffer = TextureHandle.nullHandle;
+            PreFilteredEnvironmentMapSlices.Clear();
+
+            _scheduler.Restart();
+            _swapBuffers = false;
         }
     }
-}
\ No newline at end of file
+}
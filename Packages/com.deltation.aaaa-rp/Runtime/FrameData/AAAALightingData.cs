@@ -13,6 +13,7 @@ namespace DELTation.AAAARP.FrameData
         public float AmbientIntensity;
         public TextureHandle DeferredReflections;
         public TextureHandle GTAOTerm;
+        public BufferHandle LightBVHNodesBuffer;
         public AAAALightingConstantBuffer LightingConstantBuffer;
         public BufferHandle PunctualLightsBuffer;
         public TextureHandle SSRResolveResult;
@@ -31,6 +32,16 @@ namespace DELTation.AAAARP.FrameData
                 PunctualLightsBuffer = renderGraph.CreateBuffer(bufferDesc);
             }
 
+            {
+                var bufferDesc = new BufferDesc(AAAALightBVH.GetMaxNodeCount(lightingSettings.MaxPunctualLights),
+                    UnsafeUtility.SizeOf<AAAALightBVHNode>(), GraphicsBuffer.Target.Structured
+                )
+                {
+                    name = nameof(LightBVHNodesBuffer),
+                };
+                LightBVHNodesBuffer = renderGraph.CreateBuffer(bufferDesc);
+            }
+
             GTAOTerm = TextureHandle.nullHandle;
             SSRTraceResult = TextureHandle.nullHandle;
             SSRResolveResult = TextureHandle.nullHandle;
@@ -41,6 +52,7 @@ namespace DELTation.AAAARP.FrameData
             AmbientIntensity = default;
             LightingConstantBuffer = default;
             PunctualLightsBuffer = BufferHandle.nullHandle;
+            LightBVHNodesBuffer = BufferHandle.nullHandle;
             GTAOTerm = TextureHandle.nullHandle;
             SSRTraceResult = TextureHandle.nullHandle;
             SSRResolveResult = TextureHandle.nullHandle;
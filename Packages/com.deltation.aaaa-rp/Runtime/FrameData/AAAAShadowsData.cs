@@ -48,8 +48,34 @@ namespace DELTation.AAAARP.FrameData
                     ResolveValue(volumeComponent.PunctualDepthBias, shadowSettings.PunctualDepthBias),
                 SlopeBias =
                     ResolveValue(volumeComponent.SlopeBias, shadowSettings.SlopeBias),
+                ScreenCoverageResolution = shadowSettings.ScreenCoverageResolution,
+                ScreenCoverageTexelsPerPixel = shadowSettings.ScreenCoverageTexelsPerPixel,
+                CasterLODFromShadowMapTexels =
+                    ResolveValue(volumeComponent.CasterLODFromShadowMapTexels, shadowSettings.CasterLODFromShadowMapTexels),
+                CasterLODErrorScale =
+                    ResolveValue(volumeComponent.CasterLODErrorScale, shadowSettings.CasterLODErrorScale),
+                ConservativeCasterLOD =
+                    ResolveValue(volumeComponent.ConservativeCasterLOD, shadowSettings.ConservativeCasterLOD),
+            };
+            shadowSettingsData.CascadeScheduling = new AAAAShadowCascadeScheduler.Settings
+            {
+                CascadeCount = shadowSettingsData.DirectionalLightCascades,
+                NearCascadeCount =
+                    ResolveValue(volumeComponent.DirectionalLightNearCascades, shadowSettings.DirectionalLightNearCascades),
+                // Without caching, kept cascades would be drawn again anyway.
+                FarCascadeUpdateInterval = shadowSettings.CacheShadowMaps
+                    ? ResolveValue(volumeComponent.DirectionalLightFarCascadeUpdateInterval, shadowSettings.DirectionalLightFarCascadeUpdateInterval)
+                    : 1,
+                GuardBand =
+                    ResolveValue(volumeComponent.DirectionalLightFarCascadeGuardBand, shadowSettings.DirectionalLightFarCascadeGuardBand),
             };
             CollectShadowLights(cullingResults, renderingData, cameraData, shadowSettingsData, ShadowLights);
+            SetCasterLODSelection(shadowSettingsData);
+
+            if (shadowSettings.CacheShadowMaps)
+            {
+                MarkCachedSplits(renderingData.RendererContainer.ShadowCacheInvalidationTracker, cameraData);
+            }
 
             ShadowLightSlicesBuffer = renderingData.RenderGraph.CreateBuffer(
                 new BufferDesc(shadowSettings.MaxShadowLightSlices, UnsafeUtility.SizeOf<AAAAShadowLightSlice>(), GraphicsBuffer.Target.Structured)
@@ -98,6 +124,7 @@ namespace DELTation.AAAARP.FrameData
                         ShadowStrength = light.shadowStrength,
                         VisibleLightIndex = visibleLightIndex,
                         NearPlaneOffset = light.shadowNearPlane,
+                        LightID = light.GetInstanceID(),
                         Splits = new NativeList<ShadowLightSplit>(splitCapacity, Allocator.Temp),
                     }
                 );
@@ -122,7 +149,14 @@ namespace DELTation.AAAARP.FrameData
                 };
                 float3 cameraPosition = camera.transform.position;
                 float shadowDistance = math.min(cameraFarPlane, shadowSettings.MaxDistance);
-                ref readonly AAAARenderTexturePoolSet rtPoolSet = ref renderingData.RtPoolSet;
+                AAAAShadowAtlas shadowAtlas = renderingData.RtPoolSet.ShadowMap;
+                int cameraID = camera.GetInstanceID();
+                AAAAShadowCascadeScheduler cascadeScheduler = renderingData.RendererContainer.ShadowCascadeScheduler;
+
+                var shadowLightResolutions = new NativeArray<int>(shadowLights.Length, Allocator.Temp);
+                SelectShadowLightResolutions(visibleLights, cameraData, shadowSettings, shadowAtlas.ResolutionPolicy, shadowLights,
+                    shadowLightResolutions
+                );
 
                 for (int index = 0; index < shadowLights.Length; index++)
                 {
@@ -132,7 +166,8 @@ namespace DELTation.AAAARP.FrameData
                     if (shadowLight.LightType is LightType.Directional or LightType.Spot or LightType.Point)
                     {
                         Quaternion lightRotation = visibleLight.localToWorldMatrix.rotation;
-                        int shadowMapResolution = (int) ShadowMapResolution;
+                        int shadowMapResolution = shadowLightResolutions[index];
+                        int lightID = shadowLight.LightID;
                         Vector3 lightPosition = visibleLight.localToWorldMatrix.GetPosition();
                         Vector3 lightForward = lightRotation * Vector3.forward;
                         Vector3 lightRight = lightRotation * Vector3.right;
@@ -154,17 +189,36 @@ namespace DELTation.AAAARP.FrameData
                             {
                                 float splitNear = cascadeIndex == 0 ? 0.0f : shadowDistance * cascadeDistances[cascadeIndex - 1];
                                 float splitFar = cascadeIndex == cascadeCount - 1 ? shadowDistance : shadowDistance * cascadeDistances[cascadeIndex];
+                                var cascadeKey = new AAAAShadowAtlasAllocator.Key(cameraID, lightID, cascadeIndex);
+                                AAAAShadowAtlasAllocator.Allocation shadowMapAllocation = shadowAtlas.Allocate(cascadeKey, shadowMapResolution);
+                                int splitResolution = GetSplitResolution(shadowMapAllocation, shadowMapResolution);
 
-                                AAAAShadowUtils.ComputeDirectionalLightShadowMatrices(
-                                    cameraFrustumCorners, cameraPosition, cameraFarPlane,
-                                    shadowMapResolution, lightRotation, splitNear, splitFar,
-                                    out float4x4 lightView, out float4x4 lightProjection
+                                float4x4 lightView = AAAAShadowUtils.ConstructLightView(lightRotation);
+                                AAAAShadowUtils.ComputeDirectionalLightCascadeSphere(cameraFrustumCorners, cameraPosition, lightView, splitNear, splitFar,
+                                    out float3 sliceCenterLS, out float sliceRadius
                                 );
 
+                                if (cascadeScheduler.ShouldFitCascade(cascadeKey, shadowSettings.CascadeScheduling, lightView, sliceCenterLS, sliceRadius,
+                                        splitResolution, out float4x4 lightProjection
+                                    ))
+                                {
+                                    float guardBand = AAAAShadowCascadeScheduler.IsFarCascade(shadowSettings.CascadeScheduling, cascadeIndex)
+                                        ? shadowSettings.CascadeScheduling.GuardBand
+                                        : 0.0f;
+                                    AAAAShadowUtils.ComputeDirectionalLightShadowMatrices(
+                                        cameraFrustumCorners, cameraPosition, cameraFarPlane,
+                                        splitResolution, lightRotation, splitNear, splitFar,
+                                        out lightView, out lightProjection, guardBand
+                                    );
+                                    cascadeScheduler.OnCascadeFitted(cascadeKey, shadowSettings.CascadeScheduling, lightView, lightProjection,
+                                        splitResolution
+                                    );
+                                }
+
                                 Matrix4x4 lightViewProjection = math.mul(lightProjection, lightView);
                                 var shadowLightSplit = new ShadowLightSplit
                                 {
-                                    ShadowMapAllocation = rtPoolSet.ShadowMap.Allocate(shadowMapResolution),
+                                    ShadowMapAllocation = shadowMapAllocation,
                                     CullingView = new GPUCullingPass.CullingViewParameters
                                     {
                                         ViewMatrix = lightView,
@@ -175,7 +229,7 @@ namespace DELTation.AAAARP.FrameData
                                         CameraForward = lightForward,
                                         CameraRight = lightRight,
                                         CameraUp = lightUp,
-                                        PixelSize = new Vector2(shadowMapResolution, shadowMapResolution),
+                                        PixelSize = new Vector2(splitResolution, splitResolution),
                                         IsPerspective = false,
                                         PassMask = AAAAInstancePassMask.Shadows,
                                     },
@@ -193,9 +247,12 @@ namespace DELTation.AAAARP.FrameData
                             );
 
                             Matrix4x4 lightViewProjection = math.mul(lightProjection, lightView);
+                            AAAAShadowAtlasAllocator.Allocation shadowMapAllocation =
+                                shadowAtlas.Allocate(new AAAAShadowAtlasAllocator.Key(cameraID, lightID, 0), shadowMapResolution);
+                            int splitResolution = GetSplitResolution(shadowMapAllocation, shadowMapResolution);
                             shadowLight.Splits.Add(new ShadowLightSplit
                                 {
-                                    ShadowMapAllocation = renderingData.RtPoolSet.ShadowMap.Allocate(shadowMapResolution),
+                                    ShadowMapAllocation = shadowMapAllocation,
                                     CullingView = new GPUCullingPass.CullingViewParameters
                                     {
                                         ViewMatrix = lightView,
@@ -206,7 +263,7 @@ namespace DELTation.AAAARP.FrameData
                                         CameraForward = lightForward,
                                         CameraRight = lightRight,
                                         CameraUp = lightUp,
-                                        PixelSize = new Vector2(shadowMapResolution, shadowMapResolution),
+                                        PixelSize = new Vector2(splitResolution, splitResolution),
                                         IsPerspective = true,
                                         PassMask = AAAAInstancePassMask.Shadows,
                                     },
@@ -224,9 +281,12 @@ namespace DELTation.AAAARP.FrameData
                                 );
 
                                 Matrix4x4 lightViewProjection = math.mul(lightProjection, lightView);
+                                AAAAShadowAtlasAllocator.Allocation shadowMapAllocation =
+                                    shadowAtlas.Allocate(new AAAAShadowAtlasAllocator.Key(cameraID, lightID, faceIndex), shadowMapResolution);
+                                int splitResolution = GetSplitResolution(shadowMapAllocation, shadowMapResolution);
                                 shadowLight.Splits.Add(new ShadowLightSplit
                                     {
-                                        ShadowMapAllocation = renderingData.RtPoolSet.ShadowMap.Allocate(shadowMapResolution),
+                                        ShadowMapAllocation = shadowMapAllocation,
                                         CullingView = new GPUCullingPass.CullingViewParameters
                                         {
                                             ViewMatrix = lightView,
@@ -237,7 +297,7 @@ namespace DELTation.AAAARP.FrameData
                                             CameraForward = tetrahedronFace.Forward,
                                             CameraRight = tetrahedronFace.Right,
                                             CameraUp = tetrahedronFace.Up,
-                                            PixelSize = new Vector2(shadowMapResolution, shadowMapResolution),
+                                            PixelSize = new Vector2(splitResolution, splitResolution),
                                             IsPerspective = true,
                                             PassMask = AAAAInstancePassMask.Shadows,
                                         },
@@ -269,9 +329,142 @@ namespace DELTation.AAAARP.FrameData
                     shadowLight.DepthBias = -(shadowLight.LightType == LightType.Directional ? shadowSettings.DepthBias : shadowSettings.PunctualDepthBias);
                     shadowLight.SlopeBias = AAAAShadowUtils.GetBaseShadowBias(false, 0.0f) * shadowSettings.SlopeBias;
                 }
+
+                shadowLightResolutions.Dispose();
             }
         }
 
+        private void SelectShadowLightResolutions(NativeArray<VisibleLight> visibleLights, AAAACameraData cameraData,
+            in ShadowSettingsData shadowSettings, AAAAShadowResolutionPolicy resolutionPolicy,
+            NativeList<ShadowLight> shadowLights, NativeArray<int> resolutions)
+        {
+            int maxResolution = (int) ShadowMapResolution;
+
+            if (!shadowSettings.ScreenCoverageResolution)
+            {
+                for (int index = 0; index < resolutions.Length; index++)
+                {
+                    resolutions[index] = maxResolution;
+                }
+                return;
+            }
+
+            Camera camera = cameraData.Camera;
+            var viewParameters = new AAAAShadowResolutionPolicy.ViewParameters
+            {
+                Position = camera.transform.position,
+                ScreenSize = math.int2(cameraData.ScaledWidth, cameraData.ScaledHeight),
+                IsOrthographic = camera.orthographic,
+                TanHalfFovY = math.tan(math.radians(camera.fieldOfView) * 0.5f),
+                OrthographicSize = camera.orthographicSize,
+            };
+            int cameraID = camera.GetInstanceID();
+
+            var requests = new NativeArray<AAAAShadowResolutionPolicy.Request>(shadowLights.Length, Allocator.Temp);
+
+            for (int index = 0; index < shadowLights.Length; index++)
+            {
+                ref readonly ShadowLight shadowLight = ref shadowLights.ElementAtRefReadonly(index);
+                ref readonly VisibleLight visibleLight = ref visibleLights.ElementAtRefReadonly(shadowLight.VisibleLightIndex);
+                var request = new AAAAShadowResolutionPolicy.Request
+                {
+                    Key = new AAAAShadowAtlasAllocator.Key(cameraID, shadowLight.LightID, 0),
+                };
+
+                if (shadowLight.LightType == LightType.Directional)
+                {
+                    // Cascades always span the whole view.
+                    request.DesiredResolution = maxResolution;
+                    request.ScreenCoverage = 1.0f;
+                    request.SplitCount = shadowSettings.DirectionalLightCascades;
+                }
+                else
+                {
+                    float projectedDiameter = AAAAShadowResolutionPolicy.GetProjectedDiameter(viewParameters,
+                        visibleLight.localToWorldMatrix.GetPosition(), visibleLight.range
+                    );
+                    request.DesiredResolution = projectedDiameter * shadowSettings.ScreenCoverageTexelsPerPixel;
+                    request.ScreenCoverage = AAAAShadowResolutionPolicy.GetScreenCoverage(viewParameters, projectedDiameter);
+                    request.SplitCount = shadowLight.LightType == LightType.Point ? AAAAShadowUtils.TetrahedronFace.Count : 1;
+                }
+
+                requests[index] = request;
+            }
+
+            resolutionPolicy.SelectResolutions(requests, maxResolution);
+
+            for (int index = 0; index < requests.Length; index++)
+            {
+                resolutions[index] = requests[index].Resolution;
+            }
+
+            requests.Dispose();
+        }
+
+        private void SetCasterLODSelection(in ShadowSettingsData shadowSettings)
+        {
+            if (!shadowSettings.CasterLODFromShadowMapTexels)
+            {
+                return;
+            }
+
+            for (int index = 0; index < ShadowLights.Length; index++)
+            {
+                ref ShadowLight shadowLight = ref ShadowLights.ElementAtRef(index);
+
+                for (int splitIndex = 0; splitIndex < shadowLight.Splits.Length; splitIndex++)
+                {
+                    ref GPUCullingPass.CullingViewParameters cullingView = ref shadowLight.Splits.ElementAtRef(splitIndex).CullingView;
+                    cullingView.LODSelectionMode = GPUCullingPass.LODSelectionMode.ViewPixels;
+                    cullingView.LODErrorScale = shadowSettings.CasterLODErrorScale;
+                    cullingView.ConservativeLOD = shadowSettings.ConservativeCasterLOD;
+                }
+            }
+        }
+
+        private void MarkCachedSplits(AAAAShadowCacheInvalidationTracker shadowCacheInvalidationTracker, AAAACameraData cameraData)
+        {
+            int cameraID = cameraData.Camera.GetInstanceID();
+            float4x4 mainLODView = GetMainLODView(cameraData);
+
+            for (int index = 0; index < ShadowLights.Length; index++)
+            {
+                ref ShadowLight shadowLight = ref ShadowLights.ElementAtRef(index);
+                int lightID = shadowLight.LightID;
+
+                for (int splitIndex = 0; splitIndex < shadowLight.Splits.Length; splitIndex++)
+                {
+                    ref ShadowLightSplit shadowLightSplit = ref shadowLight.Splits.ElementAtRef(splitIndex);
+                    var key = new AAAAShadowAtlasAllocator.Key(cameraID, lightID, splitIndex);
+                    // Caster LOD settings change the rendered depth too.
+                    ref readonly GPUCullingPass.CullingViewParameters cullingView = ref shadowLightSplit.CullingView;
+                    var renderParams = math.float4(shadowLight.DepthBias, shadowLight.SlopeBias,
+                        cullingView.LODSelectionMode == GPUCullingPass.LODSelectionMode.ViewPixels ? cullingView.LODErrorScale : 0.0f,
+                        cullingView.ConservativeLOD ? 1.0f : 0.0f
+                    );
+                    // Shadow map texel LOD alone only depends on the split itself, so the split stays cached while the camera moves.
+                    float4x4 lodView = cullingView.LODSelectionMode == GPUCullingPass.LODSelectionMode.MainView || cullingView.ConservativeLOD
+                        ? mainLODView
+                        : float4x4.zero;
+                    shadowLightSplit.IsCached = !shadowCacheInvalidationTracker.ShouldRenderSplit(key,
+                        shadowLightSplit.CullingView.ViewProjectionMatrix, shadowLightSplit.ShadowMapAllocation, renderParams, lodView
+                    );
+                }
+            }
+        }
+
+        // The main camera view GPUCullingPass selects LOD with, the pixel size is folded in.
+        private static float4x4 GetMainLODView(AAAACameraData cameraData)
+        {
+            Camera camera = cameraData.Camera;
+            float4x4 viewProjectionMatrix = camera.projectionMatrix * camera.worldToCameraMatrix;
+            return math.mul(float4x4.Scale(cameraData.ScaledWidth, cameraData.ScaledHeight, 1.0f), viewProjectionMatrix);
+        }
+
+        // The atlas may give a smaller tile than requested when it runs out of space.
+        private static int GetSplitResolution(in AAAAShadowAtlasAllocator.Allocation allocation, int requestedResolution) =>
+            allocation.IsValid ? allocation.Size : requestedResolution;
+
         public override void Reset()
         {
             ShadowMapResolution = 0;
@@ -290,11 +483,18 @@ namespace DELTation.AAAARP.FrameData
             public float DepthBias;
             public float PunctualDepthBias;
             public float SlopeBias;
+            public bool ScreenCoverageResolution;
+            public float ScreenCoverageTexelsPerPixel;
+            public AAAAShadowCascadeScheduler.Settings CascadeScheduling;
+            public bool CasterLODFromShadowMapTexels;
+            public float CasterLODErrorScale;
+            public bool ConservativeCasterLOD;
         }
 
         public struct ShadowLight
         {
             public int VisibleLightIndex;
+            public int LightID;
             public float NearPlaneOffset;
             public LightType LightType;
             public bool IsSoftShadow;
@@ -311,7 +511,9 @@ namespace DELTation.AAAARP.FrameData
         {
             public Matrix4x4 GPUProjectionMatrix;
             public GPUCullingPass.CullingViewParameters CullingView;
-            public AAAARenderTexturePool.Allocation ShadowMapAllocation;
+            public AAAAShadowAtlasAllocator.Allocation ShadowMapAllocation;
+            // The tile still holds the depth from the previous frame, nothing has to be rendered.
+            public bool IsCached;
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+using System.Collections.Generic;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Spreads the rows of the IBL cubemap faces over frames, so that every frame renders about as many texture samples as fit in the time budget.
+    // The cost of a sample starts from a pessimistic estimate and follows the GPU time measured for the previous slices.
+    // GPU timings arrive a few frames late, while the work of a frame changes with the budget, the estimate and at the end of the update,
+    // so the sample counts of the recent frames are kept to divide each timing by the work of the frame it measured.
+    public sealed class AAAAImageBasedLightingUpdateScheduler
+    {
+        // About 50M samples per ms, which is slow enough for integrated GPUs.
+        public const double InitialMsPerSample = 2e-8;
+        // ProfilingSampler reads GPU time from Recorder, which returns the timings of the frame three frames before the current one.
+        public const int GPUTimeLatencyFrames = 3;
+        private const double MsPerSampleSmoothing = 0.25;
+        private const int CubemapSideCount = 6;
+        private const int ScheduledFrameHistoryLength = 8;
+
+        private readonly ScheduledFrame[] _scheduledFrames = new ScheduledFrame[ScheduledFrameHistoryLength];
+        private readonly List<WorkItem> _workItems = new();
+        private int _currentItemIndex;
+        private int _currentRow;
+        private int _lastScheduledFrameIndex = int.MinValue;
+
+        public double EstimatedMsPerSample { get; private set; } = InitialMsPerSample;
+
+        public bool IsUpdating => _currentItemIndex < _workItems.Count;
+
+        public void Restart()
+        {
+            _workItems.Clear();
+            _currentItemIndex = 0;
+            _currentRow = 0;
+        }
+
+        // Queues all sides of a cubemap mip.
+        public void AddCubemapMip(Target target, int mipIndex, int resolution, double samplesPerTexel)
+        {
+            for (int sideIndex = 0; sideIndex < CubemapSideCount; sideIndex++)
+            {
+                _workItems.Add(new WorkItem
+                    {
+                        Target = target,
+                        MipIndex = mipIndex,
+                        SideIndex = sideIndex,
+                        RowCount = resolution,
+                        SamplesPerRow = resolution * samplesPerTexel,
+                    }
+                );
+            }
+        }
+
+        // GPU time of the slices scheduled in frame frameIndex. Non-positive values mean that there is no measurement yet.
+        // Timings of frames that are no longer remembered, or that were already reported, are ignored.
+        public void ReportGPUTime(double ms, int frameIndex)
+        {
+            ref ScheduledFrame scheduledFrame = ref _scheduledFrames[GetHistoryIndex(frameIndex)];
+            if (ms <= 0.0 || scheduledFrame.FrameIndex != frameIndex || scheduledFrame.SampleCount <= 0.0)
+            {
+                return;
+            }
+
+            EstimatedMsPerSample = math.lerp(EstimatedMsPerSample, ms / scheduledFrame.SampleCount, MsPerSampleSmoothing);
+            // Every camera of a frame reads the same timing.
+            scheduledFrame.SampleCount = 0.0;
+        }
+
+        // Fills the slices to render this frame. At least one row is scheduled, so that the update finishes even with a tiny budget.
+        // Only the first call of a frame schedules anything, the other cameras of the frame get no slices.
+        // Returns true if these are the last slices of the update.
+        public bool ScheduleFrame(int frameIndex, float budgetMs, List<Slice> slices)
+        {
+            slices.Clear();
+
+            if (!IsUpdating || frameIndex == _lastScheduledFrameIndex)
+            {
+                return false;
+            }
+
+            _lastScheduledFrameIndex = frameIndex;
+
+            double budgetSamples = budgetMs / EstimatedMsPerSample;
+            double frameSampleCount = 0.0;
+
+            while (IsUpdating)
+            {
+                WorkItem workItem = _workItems[_currentItemIndex];
+                int remainingRows = workItem.RowCount - _currentRow;
+                int affordableRows = (int) math.min((budgetSamples - frameSampleCount) / workItem.SamplesPerRow, remainingRows);
+
+                if (affordableRows <= 0 && slices.Count > 0)
+                {
+                    break;
+                }
+
+                int rowCount = math.max(1, affordableRows);
+                slices.Add(new Slice
+                    {
+                        Target = workItem.Target,
+                        MipIndex = workItem.MipIndex,
+                        SideIndex = workItem.SideIndex,
+                        FirstRow = _currentRow,
+                        RowCount = rowCount,
+                    }
+                );
+
+                frameSampleCount += rowCount * workItem.SamplesPerRow;
+                _currentRow += rowCount;
+
+                if (_currentRow < workItem.RowCount)
+                {
+                    break;
+                }
+
+                ++_currentItemIndex;
+                _currentRow = 0;
+            }
+
+            _scheduledFrames[GetHistoryIndex(frameIndex)] = new ScheduledFrame
+            {
+                FrameIndex = frameIndex,
+                SampleCount = frameSampleCount,
+            };
+            return !IsUpdating;
+        }
+
+        private static int GetHistoryIndex(int frameIndex)
+        {
+            int index = frameIndex % ScheduledFrameHistoryLength;
+            return index < 0 ? index + ScheduledFrameHistoryLength : index;
+        }
+
+        public enum Target
+        {
+            DiffuseIrradiance,
+            PreFilteredEnvironmentMap,
+        }
+
+        public struct Slice
+        {
+            public Target Target;
+            public int MipIndex;
+            public int SideIndex;
+            public int FirstRow;
+            public int RowCount;
+        }
+
+        private struct ScheduledFrame
+        {
+            public int FrameIndex;
+            public double SampleCount;
+        }
+
+        private struct WorkItem
+        {
+            public Target Target;
+            public int MipIndex;
+            public int SideIndex;
+            public int RowCount;
+            public double SamplesPerRow;
+        }
+    }
+}
@@ -0,0 +1,229 @@
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Lighting
+{
+    public sealed partial class AAAALightBVH
+    {
+        [BurstCompile]
+        private struct BuildJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<AAAAPunctualLightData> Lights;
+
+            public NativeList<AAAALightBVHNode> Nodes;
+
+            public void Execute()
+            {
+                Nodes.Clear();
+
+                int lightCount = Lights.Length;
+                if (lightCount == 0)
+                {
+                    return;
+                }
+
+                NativeArray<uint> mortonCodes = ComputeMortonCodes();
+
+                // Popping the left child first appends the nodes in depth-first order.
+                var firstLights = new NativeList<int>(GetMaxNodeCount(lightCount), Allocator.Temp);
+                var lightCounts = new NativeList<int>(GetMaxNodeCount(lightCount), Allocator.Temp);
+                var parents = new NativeList<int>(GetMaxNodeCount(lightCount), Allocator.Temp);
+                var stack = new NativeList<int3>(64, Allocator.Temp);
+                stack.Add(math.int3(0, lightCount, -1));
+
+                while (stack.Length > 0)
+                {
+                    int3 range = stack[stack.Length - 1];
+                    stack.RemoveAtSwapBack(stack.Length - 1);
+
+                    int nodeIndex = firstLights.Length;
+                    firstLights.Add(range.x);
+                    lightCounts.Add(range.y);
+                    parents.Add(range.z);
+
+                    if (range.y <= MaxLeafSize)
+                    {
+                        continue;
+                    }
+
+                    int first = range.x;
+                    int last = first + range.y - 1;
+                    int split = FindSplit(mortonCodes, first, last);
+
+                    stack.Add(math.int3(split + 1, last - split, nodeIndex));
+                    stack.Add(math.int3(first, split - first + 1, nodeIndex));
+                }
+
+                int nodeCount = firstLights.Length;
+                var aabbMin = new NativeArray<float3>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                var aabbMax = new NativeArray<float3>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                var positionsMin = new NativeArray<float3>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                var positionsMax = new NativeArray<float3>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                var cones = new NativeArray<Cone>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                var subtreeSizes = new NativeArray<int>(nodeCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+
+                for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++)
+                {
+                    float3 nodeMin = float.MaxValue;
+                    float3 nodeMax = -float.MaxValue;
+                    float3 nodePositionsMin = float.MaxValue;
+                    float3 nodePositionsMax = -float.MaxValue;
+                    Cone cone = Cone.Empty;
+
+                    if (lightCounts[nodeIndex] <= MaxLeafSize)
+                    {
+                        for (int i = firstLights[nodeIndex]; i < firstLights[nodeIndex] + lightCounts[nodeIndex]; i++)
+                        {
+                            AAAAPunctualLightData light = Lights[i];
+                            float radius = math.max(0.0f, light.Color_Radius.w);
+                            nodeMin = math.min(nodeMin, light.PositionWS.xyz - radius);
+                            nodeMax = math.max(nodeMax, light.PositionWS.xyz + radius);
+                            nodePositionsMin = math.min(nodePositionsMin, light.PositionWS.xyz);
+                            nodePositionsMax = math.max(nodePositionsMax, light.PositionWS.xyz);
+                            cone = Union(cone, GetLightCone(light));
+                        }
+                    }
+
+                    aabbMin[nodeIndex] = nodeMin;
+                    aabbMax[nodeIndex] = nodeMax;
+                    positionsMin[nodeIndex] = nodePositionsMin;
+                    positionsMax[nodeIndex] = nodePositionsMax;
+                    cones[nodeIndex] = cone;
+                    subtreeSizes[nodeIndex] = 1;
+                }
+
+                // Children always come after their parents, so the bounds of a node are complete by the time it reaches its parent.
+                for (int nodeIndex = nodeCount - 1; nodeIndex > 0; nodeIndex--)
+                {
+                    int parent = parents[nodeIndex];
+                    aabbMin[parent] = math.min(aabbMin[parent], aabbMin[nodeIndex]);
+                    aabbMax[parent] = math.max(aabbMax[parent], aabbMax[nodeIndex]);
+                    positionsMin[parent] = math.min(positionsMin[parent], positionsMin[nodeIndex]);
+                    positionsMax[parent] = math.max(positionsMax[parent], positionsMax[nodeIndex]);
+                    cones[parent] = Union(cones[parent], cones[nodeIndex]);
+                    subtreeSizes[parent] += subtreeSizes[nodeIndex];
+                }
+
+                Nodes.ResizeUninitialized(nodeCount);
+
+                for (int nodeIndex = 0; nodeIndex < nodeCount; nodeIndex++)
+                {
+                    bool isLeaf = lightCounts[nodeIndex] <= MaxLeafSize;
+                    Cone cone = cones[nodeIndex];
+                    float3 positionsCenter = (positionsMin[nodeIndex] + positionsMax[nodeIndex]) * 0.5f;
+
+                    Nodes[nodeIndex] = new AAAALightBVHNode
+                    {
+                        AABBMin_LightCount = math.float4(aabbMin[nodeIndex], isLeaf ? lightCounts[nodeIndex] : 0),
+                        AABBMax_FirstLightOrEscapeIndex =
+                            math.float4(aabbMax[nodeIndex], isLeaf ? firstLights[nodeIndex] : nodeIndex + subtreeSizes[nodeIndex]),
+                        ConeAxis_ConeAngle = math.float4(cone.Axis, math.min(cone.Angle + ConeAngleMargin, math.PI)),
+                        LightPositionsBoundingSphere =
+                            math.float4(positionsCenter, math.length(positionsMax[nodeIndex] - positionsCenter) * (1.0f + PositionsRadiusMargin)),
+                    };
+                }
+            }
+
+            private NativeArray<uint> ComputeMortonCodes()
+            {
+                float3 min = float.MaxValue;
+                float3 max = -float.MaxValue;
+
+                foreach (AAAAPunctualLightData light in Lights)
+                {
+                    min = math.min(min, light.PositionWS.xyz);
+                    max = math.max(max, light.PositionWS.xyz);
+                }
+
+                float3 extents = math.max(max - min, 1e-6f);
+                var mortonCodes = new NativeArray<uint>(Lights.Length, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+
+                for (int i = 0; i < Lights.Length; i++)
+                {
+                    mortonCodes[i] = EncodeMorton3((Lights[i].PositionWS.xyz - min) / extents);
+                }
+
+                return mortonCodes;
+            }
+
+            // Same as AAAASceneBVH: the last light that shares more leading bits with the first one than the last one does.
+            // For unsorted codes, this still returns a split within the range.
+            private static int FindSplit(NativeArray<uint> mortonCodes, int first, int last)
+            {
+                uint firstCode = mortonCodes[first];
+                uint lastCode = mortonCodes[last];
+
+                if (firstCode == lastCode)
+                {
+                    return (first + last) >> 1;
+                }
+
+                int commonPrefix = math.lzcnt(firstCode ^ lastCode);
+                int split = first;
+                int step = last - first;
+
+                do
+                {
+                    step = (step + 1) >> 1;
+                    int newSplit = split + step;
+
+                    if (newSplit < last && math.lzcnt(firstCode ^ mortonCodes[newSplit]) > commonPrefix)
+                    {
+                        split = newSplit;
+                    }
+                } while (step > 1);
+
+                return split;
+            }
+        }
+
+        // Stackless: a rejected internal node skips to its escape index, everything else continues with the next node.
+        [BurstCompile]
+        private struct QueryJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<AAAALightBVHNode> Nodes;
+            [ReadOnly]
+            public NativeArray<AAAAPunctualLightData> Lights;
+            public float4 SphereWS;
+
+            public NativeList<int> LightIndices;
+
+            public void Execute()
+            {
+                int nodeIndex = 0;
+
+                while (nodeIndex < Nodes.Length)
+                {
+                    AAAALightBVHNode node = Nodes[nodeIndex];
+                    int lightCount = (int) node.AABBMin_LightCount.w;
+                    bool isLeaf = lightCount > 0;
+
+                    if (!NodeIntersectsSphere(node, SphereWS))
+                    {
+                        nodeIndex = isLeaf ? nodeIndex + 1 : (int) node.AABBMax_FirstLightOrEscapeIndex.w;
+                        continue;
+                    }
+
+                    if (isLeaf)
+                    {
+                        int firstLight = (int) node.AABBMax_FirstLightOrEscapeIndex.w;
+                        for (int lightIndex = firstLight; lightIndex < firstLight + lightCount; lightIndex++)
+                        {
+                            if (LightIntersectsSphere(Lights[lightIndex], SphereWS))
+                            {
+                                LightIndices.Add(lightIndex);
+                            }
+                        }
+                    }
+
+                    ++nodeIndex;
+                }
+            }
+        }
+    }
+}
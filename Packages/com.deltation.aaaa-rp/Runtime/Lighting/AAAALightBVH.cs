@@ -0,0 +1,188 @@
+using System;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Bounding volume hierarchy over the punctual lights, traversed by ClusterCulling.compute instead of testing every light against every cluster.
+    // Built as an LBVH over the light buffer order. AAAAPunctualLightPacker already sorts lights by their Morton codes, so leaves cover contiguous
+    // ranges of the light buffer and no indirection is needed. Other orders still produce a valid, only looser, tree.
+    // Nodes bound the spheres of influence of their lights and the emission cones of their spot lights.
+    public sealed partial class AAAALightBVH : IDisposable
+    {
+        public const int MaxLeafSize = 4;
+
+        // Cover the rounding of the cone merges and of the bounding sphere radii.
+        private const float ConeAngleMargin = 1e-3f;
+        private const float PositionsRadiusMargin = 1e-4f;
+
+        private NativeList<AAAALightBVHNode> _nodes;
+
+        public AAAALightBVH(Allocator allocator = Allocator.Persistent) => _nodes = new NativeList<AAAALightBVHNode>(allocator);
+
+        public NativeArray<AAAALightBVHNode> Nodes => _nodes.AsArray();
+        public int NodeCount => _nodes.Length;
+
+        public void Dispose()
+        {
+            if (_nodes.IsCreated)
+            {
+                _nodes.Dispose();
+            }
+        }
+
+        public static int GetMaxNodeCount(int lightCount) => math.max(1, 2 * lightCount - 1);
+
+        // Lights are passed as a list, so that the build can be chained after the job that fills them.
+        public JobHandle ScheduleBuild(NativeList<AAAAPunctualLightData> lights, JobHandle dependency = default) =>
+            new BuildJob
+                {
+                    Lights = lights.AsDeferredJobArray(),
+                    Nodes = _nodes,
+                }
+                .Schedule(dependency);
+
+        public void Build(NativeArray<AAAAPunctualLightData> lights) =>
+            new BuildJob
+                {
+                    Lights = lights,
+                    Nodes = _nodes,
+                }
+                .Run();
+
+        // CPU reference of the traversal in ClusterCulling.compute: appends the indices of the lights that touch the world-space sphere.
+        public void Query(NativeArray<AAAAPunctualLightData> lights, float4 sphereWS, NativeList<int> lightIndices) =>
+            new QueryJob
+                {
+                    Nodes = _nodes.AsArray(),
+                    Lights = lights,
+                    SphereWS = sphereWS,
+                    LightIndices = lightIndices,
+                }
+                .Run();
+
+        // Keep in sync with CheckLightBVHNodeVSSphere in ClusterCulling.compute.
+        // Never rejects a node that contains a light LightIntersectsSphere would accept.
+        public static bool NodeIntersectsSphere(in AAAALightBVHNode node, float4 sphereWS)
+        {
+            float3 aabbMin = node.AABBMin_LightCount.xyz;
+            float3 aabbMax = node.AABBMax_FirstLightOrEscapeIndex.xyz;
+            float3 closestOffset = math.clamp(sphereWS.xyz, aabbMin, aabbMax) - sphereWS.xyz;
+            if (math.dot(closestOffset, closestOffset) > sphereWS.w * sphereWS.w)
+            {
+                return false;
+            }
+
+            float coneAngle = node.ConeAxis_ConeAngle.w;
+            if (coneAngle >= math.PI)
+            {
+                return true;
+            }
+
+            float4 positionsSphere = node.LightPositionsBoundingSphere;
+            float3 offset = sphereWS.xyz - positionsSphere.xyz;
+            float distance = math.length(offset);
+            if (distance <= positionsSphere.w + sphereWS.w)
+            {
+                return true;
+            }
+
+            // The direction from any light of the node to the center of the sphere is within positionSpread of the view direction,
+            // and the sphere covers sphereSpread around it.
+            float viewAngle = math.acos(math.clamp(math.dot(node.ConeAxis_ConeAngle.xyz, offset / distance), -1.0f, 1.0f));
+            float positionSpread = math.asin(positionsSphere.w / distance);
+            float sphereSpread = math.asin(sphereWS.w / (distance - positionsSphere.w));
+            if (viewAngle - positionSpread - coneAngle <= sphereSpread)
+            {
+                return true;
+            }
+
+            // The per-light angle test also accepts spheres almost opposite to the cone. Its back test rejects them, unless they are large.
+            return sphereSpread >= math.PI * 0.25f && viewAngle + positionSpread + coneAngle >= math.PI - sphereSpread;
+        }
+
+        // The sphere version of the light tests in ClusterCulling.compute.
+        public static bool LightIntersectsSphere(in AAAAPunctualLightData light, float4 sphereWS)
+        {
+            float lightRadius = light.Color_Radius.w;
+            float3 offset = sphereWS.xyz - light.PositionWS.xyz;
+            float offsetLengthSq = math.dot(offset, offset);
+            if (lightRadius <= 0.0f || offsetLengthSq > (lightRadius + sphereWS.w) * (lightRadius + sphereWS.w))
+            {
+                return false;
+            }
+
+            float angle = light.SpotDirection_Angle.w;
+            if (angle <= 0.0f)
+            {
+                return true;
+            }
+
+            // https://bartwronski.com/2017/04/13/cull-that-cone/
+            float v1Length = math.dot(offset, -light.SpotDirection_Angle.xyz);
+            float distanceClosestPoint = math.cos(angle) * math.sqrt(math.max(0.0f, offsetLengthSq - v1Length * v1Length)) - v1Length * math.sin(angle);
+
+            bool angleCull = distanceClosestPoint > sphereWS.w;
+            bool frontCull = v1Length > sphereWS.w + lightRadius;
+            bool backCull = v1Length < -sphereWS.w;
+            return !(angleCull || frontCull || backCull);
+        }
+
+        private static Cone GetLightCone(in AAAAPunctualLightData light)
+        {
+            float angle = light.SpotDirection_Angle.w;
+            return angle > 0.0f
+                ? new Cone { Axis = -light.SpotDirection_Angle.xyz, Angle = angle }
+                : Cone.All;
+        }
+
+        // Conty Estevez and Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting".
+        private static Cone Union(Cone a, Cone b)
+        {
+            if (a.IsEmpty)
+            {
+                return b;
+            }
+
+            if (b.IsEmpty)
+            {
+                return a;
+            }
+
+            if (b.Angle > a.Angle)
+            {
+                Cone wider = b;
+                b = a;
+                a = wider;
+            }
+
+            float angleBetween = math.acos(math.clamp(math.dot(a.Axis, b.Axis), -1.0f, 1.0f));
+            if (math.min(angleBetween + b.Angle, math.PI) <= a.Angle)
+            {
+                return a;
+            }
+
+            float angle = (a.Angle + angleBetween + b.Angle) * 0.5f;
+            float3 rotationAxis = math.cross(a.Axis, b.Axis);
+            if (angle >= math.PI || math.lengthsq(rotationAxis) < 1e-12f)
+            {
+                return Cone.All;
+            }
+
+            quaternion rotation = quaternion.AxisAngle(math.normalize(rotationAxis), angle - a.Angle);
+            return new Cone { Axis = math.normalize(math.mul(rotation, a.Axis)), Angle = angle };
+        }
+
+        private struct Cone
+        {
+            public float3 Axis;
+            public float Angle;
+
+            public bool IsEmpty => Angle < 0.0f;
+
+            public static Cone Empty => new() { Axis = math.float3(0, 0, 1), Angle = -1.0f };
+            public static Cone All => new() { Axis = math.float3(0, 0, 1), Angle = math.PI };
+        }
+    }
+}
@@ -0,0 +1,21 @@
+using System.Diagnostics.CodeAnalysis;
+using Unity.Mathematics;
+using UnityEngine.Rendering;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Nodes are stored in depth-first order, so the left child of an internal node always follows it.
+    [GenerateHLSL(PackingRules.Exact, needAccessors = false)]
+    [SuppressMessage("ReSharper", "InconsistentNaming")]
+    public struct AAAALightBVHNode
+    {
+        // w: number of lights of a leaf, zero for internal nodes.
+        public float4 AABBMin_LightCount;
+        // w: index of the first light of a leaf, or the index of the node that follows the subtree of an internal node.
+        public float4 AABBMax_FirstLightOrEscapeIndex;
+        // Bounds the emission directions of the spot lights in the subtree. An angle of PI or more means the subtree emits in all directions.
+        public float4 ConeAxis_ConeAngle;
+        // Bounding sphere of the light positions only, the apexes of the cone. Much tighter than the AABB above.
+        public float4 LightPositionsBoundingSphere;
+    }
+}
@@ -0,0 +1,18 @@
+//
+// This file was automatically generated. Please don't edit by hand. Execute Editor command [ Edit > Rendering > Generate Shader Includes ] instead
+//
+
+#ifndef AAAALIGHTBVHNODE_CS_HLSL
+#define AAAALIGHTBVHNODE_CS_HLSL
+// Generated from DELTation.AAAARP.Lighting.AAAALightBVHNode
+// PackingRules = Exact
+struct AAAALightBVHNode
+{
+    float4 AABBMin_LightCount;
+    float4 AABBMax_FirstLightOrEscapeIndex;
+    float4 ConeAxis_ConeAngle;
+    float4 LightPositionsBoundingSphere;
+};
+
+
+#endif
@@ -24,5 +24,6 @@ namespace DELTation.AAAARP.Lighting
 
         public uint DirectionalLightCount;
         public uint PunctualLightCount;
+        public uint LightBVHNodeCount;
     }
 }
\ No newline at end of file
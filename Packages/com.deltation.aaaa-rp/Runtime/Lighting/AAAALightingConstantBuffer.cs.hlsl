@@ -18,6 +18,7 @@ CBUFFER_START(AAAALightingConstantBuffer)
     float4 DirectionalLightShadowParams[4];
     uint DirectionalLightCount;
     uint PunctualLightCount;
+    uint LightBVHNodeCount;
 CBUFFER_END
 
 
@@ -0,0 +1,153 @@
+using DELTation.AAAARP.Core;
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Rendering;
+using static DELTation.AAAARP.Culling.AAAACullingMath;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Converts visible lights to the GPU punctual light layout off the main thread.
+    // Lights are sorted by the Morton code of their position, so neighboring clusters read neighboring lights.
+    public static class AAAAPunctualLightPacker
+    {
+        public const int NoShadowSliceIndex = -1;
+
+        public static JobHandle Schedule(NativeArray<VisibleLight> visibleLights, NativeArray<PunctualLightShadow> shadows, int maxPunctualLights,
+            NativeList<AAAAPunctualLightData> punctualLights, NativeList<int> directionalLightIndices, JobHandle dependency = default) =>
+            new PackJob
+                {
+                    VisibleLights = visibleLights,
+                    Shadows = shadows,
+                    MaxPunctualLights = maxPunctualLights,
+                    MaxDirectionalLights = AAAALightingConstantBuffer.MaxDirectionalLights,
+                    PunctualLights = punctualLights,
+                    DirectionalLightIndices = directionalLightIndices,
+                }
+                .Schedule(dependency);
+
+        public static AAAAPunctualLightData ExtractPunctualLightData(in VisibleLight visibleLight, in PunctualLightShadow shadow)
+        {
+            float4x4 lightLocalToWorld = visibleLight.localToWorldMatrix;
+            var punctualLightData = new AAAAPunctualLightData();
+
+            punctualLightData.Color_Radius.xyz = ((float4) (Vector4) visibleLight.finalColor).xyz;
+            punctualLightData.Color_Radius.w = visibleLight.range;
+
+            punctualLightData.PositionWS.xyz = lightLocalToWorld.c3.xyz;
+            if (visibleLight.lightType == LightType.Spot)
+            {
+                punctualLightData.SpotDirection_Angle.xyz = -lightLocalToWorld.c2.xyz;
+                punctualLightData.SpotDirection_Angle.w = math.radians(visibleLight.spotAngle * 0.5f);
+            }
+
+            AAAAPunctualLightUtils.GetPunctualLightDistanceAttenuation(visibleLight,
+                out punctualLightData.Attenuations.x
+            );
+            float innerSpotAngle = visibleLight.spotAngle * 0.6f;
+            AAAAPunctualLightUtils.GetPunctualLightSpotAngleAttenuation(visibleLight, innerSpotAngle, out punctualLightData.Attenuations.y,
+                out punctualLightData.Attenuations.z
+            );
+
+            punctualLightData.ShadowSliceIndex_ShadowFadeParams.x = shadow.SliceIndex;
+            if (shadow.SliceIndex != NoShadowSliceIndex)
+            {
+                punctualLightData.ShadowSliceIndex_ShadowFadeParams.zw = shadow.FadeParams;
+                punctualLightData.ShadowParams = PackShadowParams(shadow.IsSoftShadow, shadow.ShadowStrength);
+            }
+
+            return punctualLightData;
+        }
+
+        public static float4 PackShadowParams(bool isSoftShadow, float shadowStrength) => math.float4(isSoftShadow ? 1 : 0, shadowStrength, 0, 0);
+
+        // Built on the main thread, since the shadow slices need the shadow atlas.
+        public struct PunctualLightShadow
+        {
+            public int VisibleLightIndex;
+            public int SliceIndex;
+            public float2 FadeParams;
+            public bool IsSoftShadow;
+            public float ShadowStrength;
+
+            public static PunctualLightShadow None => new() { VisibleLightIndex = -1, SliceIndex = NoShadowSliceIndex };
+        }
+
+        [BurstCompile]
+        private struct PackJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<VisibleLight> VisibleLights;
+            [ReadOnly]
+            public NativeArray<PunctualLightShadow> Shadows;
+            public int MaxPunctualLights;
+            public int MaxDirectionalLights;
+
+            public NativeList<AAAAPunctualLightData> PunctualLights;
+            public NativeList<int> DirectionalLightIndices;
+
+            public void Execute()
+            {
+                var visibleToShadow = new NativeArray<int>(VisibleLights.Length, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                for (int i = 0; i < visibleToShadow.Length; i++)
+                {
+                    visibleToShadow[i] = -1;
+                }
+
+                for (int i = 0; i < Shadows.Length; i++)
+                {
+                    visibleToShadow[Shadows[i].VisibleLightIndex] = i;
+                }
+
+                var unsortedLights = new NativeList<AAAAPunctualLightData>(math.min(VisibleLights.Length, MaxPunctualLights), Allocator.Temp);
+                float3 min = float.MaxValue;
+                float3 max = -float.MaxValue;
+
+                DirectionalLightIndices.Clear();
+
+                for (int visibleLightIndex = 0; visibleLightIndex < VisibleLights.Length; visibleLightIndex++)
+                {
+                    ref readonly VisibleLight visibleLight = ref VisibleLights.ElementAtRefReadonly(visibleLightIndex);
+                    LightType lightType = visibleLight.lightType;
+
+                    if (lightType is LightType.Point or LightType.Spot && unsortedLights.Length < MaxPunctualLights)
+                    {
+                        int shadowIndex = visibleToShadow[visibleLightIndex];
+                        PunctualLightShadow shadow = shadowIndex != -1 ? Shadows[shadowIndex] : PunctualLightShadow.None;
+                        AAAAPunctualLightData punctualLightData = ExtractPunctualLightData(visibleLight, shadow);
+                        unsortedLights.Add(punctualLightData);
+
+                        min = math.min(min, punctualLightData.PositionWS.xyz);
+                        max = math.max(max, punctualLightData.PositionWS.xyz);
+                    }
+
+                    if (lightType == LightType.Directional && DirectionalLightIndices.Length < MaxDirectionalLights)
+                    {
+                        DirectionalLightIndices.Add(visibleLightIndex);
+                    }
+                }
+
+                // The Morton code goes to the upper half of the key, the light index to the lower one.
+                int lightCount = unsortedLights.Length;
+                var sortKeys = new NativeArray<ulong>(lightCount, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+                float3 extents = math.max(max - min, 1e-6f);
+
+                for (int i = 0; i < lightCount; i++)
+                {
+                    uint mortonCode = EncodeMorton3((unsortedLights[i].PositionWS.xyz - min) / extents);
+                    sortKeys[i] = ((ulong) mortonCode << 32) | (uint) i;
+                }
+
+                sortKeys.Sort();
+
+                PunctualLights.ResizeUninitialized(lightCount);
+                for (int i = 0; i < lightCount; i++)
+                {
+                    PunctualLights[i] = unsortedLights[(int) (sortKeys[i] & 0xFFFFFFFFu)];
+                }
+            }
+        }
+    }
+}
@@ -16,7 +16,18 @@ namespace DELTation.AAAARP.Lighting
 
         // https://github.com/Unity-Technologies/Graphics/blob/e42df452b62857a60944aed34f02efa1bda50018/Packages/com.unity.render-pipelines.universal/Runtime/UniversalRenderPipelineCore.cs#L1752
         public static void GetPunctualLightSpotAngleAttenuation(in VisibleLight visibleLight, float? innerSpotAngle, out float attenuationX,
-            out float attenuationY)
+            out float attenuationY) =>
+            GetPunctualLightSpotAngleAttenuation(visibleLight, innerSpotAngle.HasValue, innerSpotAngle.GetValueOrDefault(), out attenuationX,
+                out attenuationY
+            );
+
+        // Nullable-free overload that can be called from Burst jobs.
+        public static void GetPunctualLightSpotAngleAttenuation(in VisibleLight visibleLight, float innerSpotAngle, out float attenuationX,
+            out float attenuationY) =>
+            GetPunctualLightSpotAngleAttenuation(visibleLight, true, innerSpotAngle, out attenuationX, out attenuationY);
+
+        private static void GetPunctualLightSpotAngleAttenuation(in VisibleLight visibleLight, bool hasInnerSpotAngle, float innerSpotAngle,
+            out float attenuationX, out float attenuationY)
         {
             if (visibleLight.lightType != LightType.Spot)
             {
@@ -38,8 +49,8 @@ namespace DELTation.AAAARP.Lighting
                 // We need to do a null check for particle lights
                 // This should be changed in the future
                 // Particle lights will use an inline function
-                float cosInnerAngle = innerSpotAngle.HasValue
-                    ? Mathf.Cos(innerSpotAngle.Value * 0.5f * Mathf.Deg2Rad)
+                float cosInnerAngle = hasInnerSpotAngle
+                    ? Mathf.Cos(innerSpotAngle * 0.5f * Mathf.Deg2Rad)
                     : Mathf.Cos(2.0f * Mathf.Atan(Mathf.Tan(spotHalfAngle) * (64.0f - 18.0f) / 64.0f) * 0.5f);
                 float smoothAngleRange = Mathf.Max(0.001f, cosInnerAngle - cosOuterAngle);
                 float invAngleRange = 1.0f / smoothAngleRange;
@@ -0,0 +1,122 @@
+using System;
+using System.Collections.Generic;
+using DELTation.AAAARP.Renderers;
+using JetBrains.Annotations;
+using Unity.Mathematics;
+using UnityEngine;
+using UnityEngine.Experimental.Rendering;
+using UnityEngine.Rendering;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Depth textures backing the pages of AAAAShadowAtlasAllocator.
+    // Pages are created on first use and kept until the pipeline is disposed, so that their bindless indices stay valid.
+    public sealed class AAAAShadowAtlas : IDisposable
+    {
+        private readonly BindlessTextureContainer _bindlessTextureContainer;
+        private readonly Parameters _parameters;
+        private readonly List<RenderTexture> _pageTextures = new();
+
+        internal AAAAShadowAtlas(BindlessTextureContainer bindlessTextureContainer, in Parameters parameters)
+        {
+            _bindlessTextureContainer = bindlessTextureContainer;
+            _parameters = parameters;
+            Allocator = new AAAAShadowAtlasAllocator(parameters.AllocatorSettings);
+            ResolutionPolicy = new AAAAShadowResolutionPolicy(parameters.ResolutionPolicySettings);
+        }
+
+        public AAAAShadowAtlasAllocator Allocator { get; }
+        public AAAAShadowResolutionPolicy ResolutionPolicy { get; }
+
+        public int PageSize => Allocator.PageSize;
+
+        public void Dispose()
+        {
+            foreach (RenderTexture renderTexture in _pageTextures)
+            {
+                CoreUtils.Destroy(renderTexture);
+            }
+
+            _pageTextures.Clear();
+            Allocator.Clear();
+            ResolutionPolicy.Clear();
+        }
+
+        public void OnPreRender()
+        {
+            Allocator.BeginFrame();
+            ResolutionPolicy.BeginFrame();
+        }
+
+        public AAAAShadowAtlasAllocator.Allocation Allocate(in AAAAShadowAtlasAllocator.Key key, int size) => Allocator.Allocate(key, size);
+
+        [MustUseReturnValue]
+        public RenderTexture LookupRenderTexture(int pageIndex)
+        {
+            while (pageIndex >= _pageTextures.Count)
+            {
+                int pageSize = PageSize;
+                var renderTexture = new RenderTexture(pageSize, pageSize, GraphicsFormat.None, _parameters.DepthFormat, 1)
+                {
+                    hideFlags = HideFlags.HideAndDontSave,
+                };
+#if DEBUG
+                renderTexture.name = $"{_parameters.NamePrefix}_{pageSize}x{pageSize}_{_pageTextures.Count:00}";
+#endif
+
+                renderTexture.Create();
+
+                _pageTextures.Add(renderTexture);
+            }
+
+            return _pageTextures[pageIndex];
+        }
+
+        public int GetBindlessSRVIndexOrDefault(in AAAAShadowAtlasAllocator.Allocation allocation, int defaultSRVIndex)
+        {
+            if (!allocation.IsValid)
+            {
+                return defaultSRVIndex;
+            }
+
+            RenderTexture renderTexture = LookupRenderTexture(allocation.PageIndex);
+            if (renderTexture.IsCreated() && renderTexture.GetNativeDepthBufferPtr() != IntPtr.Zero)
+            {
+                return (int) _bindlessTextureContainer.GetOrCreateIndex(renderTexture, renderTexture.GetInstanceID());
+            }
+            return defaultSRVIndex;
+        }
+
+        // Maps [0, 1] shadow coordinates of a full shadow map to the tile's rectangle in the page.
+        public Matrix4x4 GetTileTransform(in AAAAShadowAtlasAllocator.Allocation allocation)
+        {
+            float oneOverPageSize = 1.0f / PageSize;
+            Matrix4x4 tileTransform = Matrix4x4.identity;
+            tileTransform.m00 = allocation.Size * oneOverPageSize;
+            tileTransform.m11 = allocation.Size * oneOverPageSize;
+            tileTransform.m03 = allocation.Position.x * oneOverPageSize;
+            tileTransform.m13 = allocation.Position.y * oneOverPageSize;
+            return tileTransform;
+        }
+
+        // UV rectangle (min.xy, max.xy) the filtering is clamped to, so that soft shadows do not fetch texels of the neighboring tiles.
+        public float4 GetTileBounds(in AAAAShadowAtlasAllocator.Allocation allocation, float marginTexels)
+        {
+            float oneOverPageSize = 1.0f / PageSize;
+            float2 min = (allocation.Position + marginTexels) * oneOverPageSize;
+            float2 max = (allocation.Position + allocation.Size - marginTexels) * oneOverPageSize;
+            return math.float4(min, max);
+        }
+
+        public static Rect GetTileViewport(in AAAAShadowAtlasAllocator.Allocation allocation) =>
+            new(allocation.Position.x, allocation.Position.y, allocation.Size, allocation.Size);
+
+        public struct Parameters
+        {
+            public string NamePrefix;
+            public GraphicsFormat DepthFormat;
+            public AAAAShadowAtlasAllocator.Settings AllocatorSettings;
+            public AAAAShadowResolutionPolicy.Settings ResolutionPolicySettings;
+        }
+    }
+}
@@ -0,0 +1,315 @@
+using System;
+using System.Collections.Generic;
+using Unity.Mathematics;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Places shadow map tiles into a set of atlas pages, each packed by AAAAShadowAtlasPacker.
+    // Tiles are keyed by (camera, light, split) and keep their placement for as long as they are requested every frame with the same size,
+    // so that persistent lights do not move around the atlas. Tiles that have not been requested for a few frames are returned to the packer.
+    // The number of pages is limited by MaxPageCount. When a tile does not fit, the allocator tries, in order:
+    // evicting tiles that were not requested this frame, adding a page, and finally halving the tile size down to MinTileSize.
+    public sealed class AAAAShadowAtlasAllocator
+    {
+        private readonly Dictionary<Key, Entry> _entries = new();
+        private readonly List<Key> _keysToRemove = new();
+        private readonly List<AAAAShadowAtlasPacker> _pages = new();
+        private int _frameIndex;
+
+        public AAAAShadowAtlasAllocator(in Settings settings)
+        {
+            Assert.IsTrue(math.ispow2(settings.PageSize));
+            Assert.IsTrue(math.ispow2(settings.MinTileSize));
+            Assert.IsTrue(settings.MinTileSize <= settings.PageSize);
+            Assert.IsTrue(settings.MaxPageCount > 0);
+
+            AllocatorSettings = settings;
+        }
+
+        public Settings AllocatorSettings { get; }
+
+        public int PageCount => _pages.Count;
+        public int TileCount => _entries.Count;
+
+        public int PageSize => AllocatorSettings.PageSize;
+
+        public AAAAShadowAtlasPacker GetPage(int pageIndex) => _pages[pageIndex];
+
+        // Tiles that have not been requested for RetainFrames frames are freed here.
+        public void BeginFrame()
+        {
+            ++_frameIndex;
+
+            foreach (KeyValuePair<Key, Entry> kvp in _entries)
+            {
+                if (_frameIndex - kvp.Value.LastUsedFrameIndex > AllocatorSettings.RetainFrames)
+                {
+                    _keysToRemove.Add(kvp.Key);
+                }
+            }
+
+            foreach (Key key in _keysToRemove)
+            {
+                Release(key);
+            }
+
+            _keysToRemove.Clear();
+        }
+
+        public void Clear()
+        {
+            _entries.Clear();
+
+            foreach (AAAAShadowAtlasPacker page in _pages)
+            {
+                page.Clear();
+            }
+        }
+
+        public Allocation Allocate(in Key key, int size)
+        {
+            size = math.clamp(size, 1, PageSize);
+
+            if (_entries.TryGetValue(key, out Entry entry))
+            {
+                if (entry.RequestedSize == size)
+                {
+                    // A tile that was shrunk to fit moves back to its full size once there is free space for it.
+                    if (entry.Tile.Size < size && TryPlaceInExistingPages(size, out Entry grownEntry))
+                    {
+                        _pages[entry.PageIndex].Free(entry.Tile);
+                        grownEntry.RequestedSize = size;
+                        entry = grownEntry;
+                    }
+
+                    entry.LastUsedFrameIndex = _frameIndex;
+                    _entries[key] = entry;
+                    return entry.ToAllocation();
+                }
+
+                Release(key);
+            }
+
+            int tileSize = size;
+
+            while (true)
+            {
+                if (TryPlace(tileSize, out entry))
+                {
+                    entry.RequestedSize = size;
+                    entry.LastUsedFrameIndex = _frameIndex;
+                    _entries.Add(key, entry);
+                    return entry.ToAllocation();
+                }
+
+                if (tileSize <= AllocatorSettings.MinTileSize)
+                {
+                    return default;
+                }
+
+                tileSize = math.max(AllocatorSettings.MinTileSize, tileSize / 2);
+            }
+        }
+
+        public bool TryGetAllocation(in Key key, out Allocation allocation)
+        {
+            if (_entries.TryGetValue(key, out Entry entry))
+            {
+                allocation = entry.ToAllocation();
+                return true;
+            }
+
+            allocation = default;
+            return false;
+        }
+
+        public void Release(in Key key)
+        {
+            if (_entries.TryGetValue(key, out Entry entry))
+            {
+                _pages[entry.PageIndex].Free(entry.Tile);
+                _entries.Remove(key);
+            }
+        }
+
+        private bool TryPlace(int size, out Entry entry)
+        {
+            if (TryPlaceInExistingPages(size, out entry))
+            {
+                return true;
+            }
+
+            while (TryEvictLeastRecentlyUsed())
+            {
+                if (TryPlaceInExistingPages(size, out entry))
+                {
+                    return true;
+                }
+            }
+
+            if (_pages.Count < AllocatorSettings.MaxPageCount)
+            {
+                var page = new AAAAShadowAtlasPacker(AllocatorSettings.PageSize, AllocatorSettings.MinTileSize);
+                _pages.Add(page);
+                return TryPlaceInPage(_pages.Count - 1, size, out entry);
+            }
+
+            entry = default;
+            return false;
+        }
+
+        private bool TryPlaceInExistingPages(int size, out Entry entry)
+        {
+            for (int pageIndex = 0; pageIndex < _pages.Count; pageIndex++)
+            {
+                if (TryPlaceInPage(pageIndex, size, out entry))
+                {
+                    return true;
+                }
+            }
+
+            entry = default;
+            return false;
+        }
+
+        private bool TryPlaceInPage(int pageIndex, int size, out Entry entry)
+        {
+            if (_pages[pageIndex].TryAllocate(size, out AAAAShadowAtlasPacker.Tile tile))
+            {
+                entry = new Entry
+                {
+                    PageIndex = pageIndex,
+                    Tile = tile,
+                };
+                return true;
+            }
+
+            entry = default;
+            return false;
+        }
+
+        // Only tiles that were not requested in the current frame can be evicted: the others may already be referenced by passes.
+        private bool TryEvictLeastRecentlyUsed()
+        {
+            bool found = false;
+            Key leastRecentlyUsedKey = default;
+            Entry leastRecentlyUsedEntry = default;
+
+            foreach (KeyValuePair<Key, Entry> kvp in _entries)
+            {
+                Key key = kvp.Key;
+                Entry entry = kvp.Value;
+                if (entry.LastUsedFrameIndex == _frameIndex)
+                {
+                    continue;
+                }
+
+                if (!found || IsUsedLessRecently(entry, key, leastRecentlyUsedEntry, leastRecentlyUsedKey))
+                {
+                    found = true;
+                    leastRecentlyUsedKey = key;
+                    leastRecentlyUsedEntry = entry;
+                }
+            }
+
+            if (found)
+            {
+                Release(leastRecentlyUsedKey);
+            }
+
+            return found;
+        }
+
+        // Ties are broken by the key, so that the result does not depend on the dictionary order.
+        private static bool IsUsedLessRecently(in Entry entry, in Key key, in Entry otherEntry, in Key otherKey)
+        {
+            if (entry.LastUsedFrameIndex != otherEntry.LastUsedFrameIndex)
+            {
+                return entry.LastUsedFrameIndex < otherEntry.LastUsedFrameIndex;
+            }
+
+            return key.CompareTo(otherKey) < 0;
+        }
+
+        [Serializable]
+        public struct Settings
+        {
+            public int PageSize;
+            public int MinTileSize;
+            public int MaxPageCount;
+            // How many frames an unused tile keeps its place.
+            public int RetainFrames;
+
+            public static Settings Default => new()
+            {
+                PageSize = 4096,
+                MinTileSize = 128,
+                MaxPageCount = 2,
+                RetainFrames = 2,
+            };
+        }
+
+        public struct Key : IEquatable<Key>, IComparable<Key>
+        {
+            public int CameraID;
+            public int LightID;
+            public int SplitIndex;
+
+            public Key(int cameraID, int lightID, int splitIndex)
+            {
+                CameraID = cameraID;
+                LightID = lightID;
+                SplitIndex = splitIndex;
+            }
+
+            public bool Equals(Key other) => CameraID == other.CameraID && LightID == other.LightID && SplitIndex == other.SplitIndex;
+
+            public override bool Equals(object obj) => obj is Key other && Equals(other);
+
+            public override int GetHashCode() => HashCode.Combine(CameraID, LightID, SplitIndex);
+
+            public int CompareTo(Key other)
+            {
+                int cameraIDComparison = CameraID.CompareTo(other.CameraID);
+                if (cameraIDComparison != 0)
+                {
+                    return cameraIDComparison;
+                }
+
+                int lightIDComparison = LightID.CompareTo(other.LightID);
+                if (lightIDComparison != 0)
+                {
+                    return lightIDComparison;
+                }
+
+                return SplitIndex.CompareTo(other.SplitIndex);
+            }
+        }
+
+        public struct Allocation
+        {
+            public int PageIndex;
+            // Lower-left corner in texels.
+            public int2 Position;
+            public int Size;
+
+            public bool IsValid => Size > 0;
+        }
+
+        private struct Entry
+        {
+            public int PageIndex;
+            public AAAAShadowAtlasPacker.Tile Tile;
+            public int RequestedSize;
+            public int LastUsedFrameIndex;
+
+            public Allocation ToAllocation() => new()
+            {
+                PageIndex = PageIndex,
+                Position = Tile.Position,
+                Size = Tile.Size,
+            };
+        }
+    }
+}
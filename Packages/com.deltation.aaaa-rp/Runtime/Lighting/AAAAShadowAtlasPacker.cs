@@ -0,0 +1,212 @@
+using System.Collections.Generic;
+using Unity.Mathematics;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Packs square power-of-two tiles into a square page as a quadtree (a 2D buddy allocator).
+    // Level 0 is the whole page, every next level halves the tile size. Tiles are identified by their Morton code within the level,
+    // so the four children of a tile are code * 4 + [0..3] and its parent is code / 4.
+    // Allocation is best-fit: the smallest free tile that is large enough is split. Among equal candidates, the one with the lowest code wins,
+    // which keeps allocations packed towards one corner and leaves large free tiles elsewhere.
+    // Freed tiles merge back with their siblings, so a page that is emptied is always a single free tile again.
+    public sealed class AAAAShadowAtlasPacker
+    {
+        private readonly SortedSet<uint>[] _freeTiles;
+
+        public AAAAShadowAtlasPacker(int pageSize, int minTileSize)
+        {
+            Assert.IsTrue(math.ispow2(pageSize));
+            Assert.IsTrue(math.ispow2(minTileSize));
+            Assert.IsTrue(minTileSize <= pageSize);
+
+            PageSize = pageSize;
+            MinTileSize = minTileSize;
+            LevelCount = math.tzcnt(pageSize) - math.tzcnt(minTileSize) + 1;
+
+            _freeTiles = new SortedSet<uint>[LevelCount];
+            for (int level = 0; level < LevelCount; level++)
+            {
+                _freeTiles[level] = new SortedSet<uint>();
+            }
+
+            Clear();
+        }
+
+        public int PageSize { get; }
+        public int MinTileSize { get; }
+        public int LevelCount { get; }
+
+        public long AllocatedArea { get; private set; }
+        public long PageArea => (long) PageSize * PageSize;
+        public bool IsEmpty => AllocatedArea == 0;
+
+        public float Occupancy => AllocatedArea / (float) PageArea;
+
+        // 0 when all the free space is a single tile, approaching 1 when it is scattered into many small ones.
+        public float Fragmentation
+        {
+            get
+            {
+                long freeArea = PageArea - AllocatedArea;
+                if (freeArea == 0)
+                {
+                    return 0.0f;
+                }
+
+                long largestFreeTileSize = LargestFreeTileSize;
+                return 1.0f - largestFreeTileSize * largestFreeTileSize / (float) freeArea;
+            }
+        }
+
+        public int LargestFreeTileSize
+        {
+            get
+            {
+                for (int level = 0; level < LevelCount; level++)
+                {
+                    if (_freeTiles[level].Count > 0)
+                    {
+                        return GetTileSize(level);
+                    }
+                }
+
+                return 0;
+            }
+        }
+
+        public void Clear()
+        {
+            foreach (SortedSet<uint> freeTiles in _freeTiles)
+            {
+                freeTiles.Clear();
+            }
+
+            _freeTiles[0].Add(0);
+            AllocatedArea = 0;
+        }
+
+        // Sizes are rounded up to a power of two, but never below MinTileSize.
+        public int GetTileSizeForRequest(int size) => math.clamp(math.ceilpow2(math.max(1, size)), MinTileSize, PageSize);
+
+        public bool TryAllocate(int size, out Tile tile)
+        {
+            if (size > PageSize)
+            {
+                tile = default;
+                return false;
+            }
+
+            int level = GetLevel(GetTileSizeForRequest(size));
+
+            int sourceLevel = level;
+            while (sourceLevel >= 0 && _freeTiles[sourceLevel].Count == 0)
+            {
+                --sourceLevel;
+            }
+
+            if (sourceLevel < 0)
+            {
+                tile = default;
+                return false;
+            }
+
+            uint code = _freeTiles[sourceLevel].Min;
+            _freeTiles[sourceLevel].Remove(code);
+
+            // Keep the first child, the other three become free.
+            for (int childLevel = sourceLevel + 1; childLevel <= level; childLevel++)
+            {
+                code *= 4;
+                _freeTiles[childLevel].Add(code + 1);
+                _freeTiles[childLevel].Add(code + 2);
+                _freeTiles[childLevel].Add(code + 3);
+            }
+
+            tile = CreateTile(level, code);
+            AllocatedArea += (long) tile.Size * tile.Size;
+            return true;
+        }
+
+        public void Free(in Tile tile)
+        {
+            Assert.IsTrue(tile.IsValid);
+            Assert.IsTrue(tile.Level < LevelCount);
+
+            int level = tile.Level;
+            uint code = tile.Code;
+            AllocatedArea -= (long) tile.Size * tile.Size;
+
+            while (level > 0)
+            {
+                uint firstSibling = code & ~3u;
+                SortedSet<uint> freeTiles = _freeTiles[level];
+                bool siblingsAreFree = true;
+
+                for (uint sibling = firstSibling; sibling < firstSibling + 4; sibling++)
+                {
+                    if (sibling != code && !freeTiles.Contains(sibling))
+                    {
+                        siblingsAreFree = false;
+                        break;
+                    }
+                }
+
+                if (!siblingsAreFree)
+                {
+                    break;
+                }
+
+                for (uint sibling = firstSibling; sibling < firstSibling + 4; sibling++)
+                {
+                    freeTiles.Remove(sibling);
+                }
+
+                code /= 4;
+                --level;
+            }
+
+            bool added = _freeTiles[level].Add(code);
+            Assert.IsTrue(added, "The tile was freed twice.");
+        }
+
+        private int GetLevel(int tileSize) => math.tzcnt(PageSize) - math.tzcnt(tileSize);
+
+        private int GetTileSize(int level) => PageSize >> level;
+
+        private Tile CreateTile(int level, uint code)
+        {
+            int size = GetTileSize(level);
+            return new Tile
+            {
+                Level = level,
+                Code = code,
+                Size = size,
+                Position = (int2) DecodeMorton2D(code) * size,
+            };
+        }
+
+        private static uint2 DecodeMorton2D(uint code) => math.uint2(CompactBits(code), CompactBits(code >> 1));
+
+        private static uint CompactBits(uint x)
+        {
+            x &= 0x55555555;
+            x = (x ^ (x >> 1)) & 0x33333333;
+            x = (x ^ (x >> 2)) & 0x0F0F0F0F;
+            x = (x ^ (x >> 4)) & 0x00FF00FF;
+            x = (x ^ (x >> 8)) & 0x0000FFFF;
+            return x;
+        }
+
+        public struct Tile
+        {
+            public int Level;
+            public uint Code;
+            public int Size;
+            // Lower-left corner in texels.
+            public int2 Position;
+
+            public bool IsValid => Size > 0;
+        }
+    }
+}
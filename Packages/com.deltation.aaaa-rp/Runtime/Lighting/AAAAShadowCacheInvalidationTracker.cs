@@ -0,0 +1,315 @@
+using System;
+using System.Collections.Generic;
+using DELTation.AAAARP.Culling;
+using Unity.Collections;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Decides which shadow splits can keep the depth rendered in a previous frame.
+    // A split is re-rendered when its view-projection or render parameters change (e.g., the light moved), when its atlas tile moved,
+    // when the view its caster LOD follows changed (e.g., the main camera moved with conservative caster LOD), when it was not requested
+    // in the previous frame, or when a shadow caster whose world bounds touch the split's frustum was added, removed or moved.
+    // Caster changes are recorded as dirty regions (the old and the new bounds) tagged with a sequence number. Each cached split remembers
+    // up to which sequence number it has been validated, so the splits of several cameras can consume the same regions independently.
+    public sealed class AAAAShadowCacheInvalidationTracker : IDisposable
+    {
+        // When there are more pending dirty regions, the oldest half is dropped and the splits that have not seen them are re-rendered.
+        public const int MaxDirtyRegions = 4096;
+
+        private readonly Dictionary<AAAAShadowAtlasAllocator.Key, CachedSplit> _cachedSplits = new();
+        private readonly List<AAAAShadowAtlasAllocator.Key> _keysToRemove = new();
+        private NativeList<CasterBounds> _casterBounds;
+        private NativeList<DirtyRegion> _dirtyRegions;
+        // Sequence number of _dirtyRegions[0].
+        private uint _firstDirtyRegionSequence;
+        private int _frameIndex;
+
+        public AAAAShadowCacheInvalidationTracker(Allocator allocator = Allocator.Persistent)
+        {
+            _casterBounds = new NativeList<CasterBounds>(allocator);
+            _dirtyRegions = new NativeList<DirtyRegion>(allocator);
+        }
+
+        public int CachedSplitCount => _cachedSplits.Count;
+        public int PendingDirtyRegionCount => _dirtyRegions.Length;
+
+        private uint NextSequence => _firstDirtyRegionSequence + (uint) _dirtyRegions.Length;
+
+        public void Dispose()
+        {
+            if (_casterBounds.IsCreated)
+            {
+                _casterBounds.Dispose();
+            }
+
+            if (_dirtyRegions.IsCreated)
+            {
+                _dirtyRegions.Dispose();
+            }
+
+            _cachedSplits.Clear();
+        }
+
+        public void BeginFrame(int frameIndex)
+        {
+            if (frameIndex == _frameIndex)
+            {
+                return;
+            }
+
+            _frameIndex = frameIndex;
+
+            uint oldestValidatedSequence = NextSequence;
+
+            foreach (KeyValuePair<AAAAShadowAtlasAllocator.Key, CachedSplit> kvp in _cachedSplits)
+            {
+                // The tile may have been given to another split in between.
+                if (_frameIndex - kvp.Value.LastUsedFrameIndex > 1)
+                {
+                    _keysToRemove.Add(kvp.Key);
+                }
+                else
+                {
+                    oldestValidatedSequence = math.min(oldestValidatedSequence, kvp.Value.ValidatedSequence);
+                }
+            }
+
+            foreach (AAAAShadowAtlasAllocator.Key key in _keysToRemove)
+            {
+                _cachedSplits.Remove(key);
+            }
+
+            _keysToRemove.Clear();
+
+            // Regions every cached split has already seen are no longer needed.
+            DropDirtyRegions((int) (oldestValidatedSequence - _firstDirtyRegionSequence));
+        }
+
+        // Anything that affects all shadow casters at once: material edits, mesh LOD settings, etc.
+        public void InvalidateAll() => _cachedSplits.Clear();
+
+        public void OnCasterChanged(int instanceIndex, in AAAAInstanceData instanceData)
+        {
+            GetCasterBounds(instanceData, out float3 aabbMinWS, out float3 aabbMaxWS);
+            OnCasterChanged(instanceIndex, aabbMinWS, aabbMaxWS, CastsShadows(instanceData));
+        }
+
+        public void OnCastersMoved(NativeArray<int> instanceIndices, NativeArray<AAAAInstanceData> instances)
+        {
+            foreach (int instanceIndex in instanceIndices)
+            {
+                OnCasterChanged(instanceIndex, instances[instanceIndex]);
+            }
+        }
+
+        public void OnCasterChanged(int instanceIndex, float3 aabbMinWS, float3 aabbMaxWS, bool castsShadows)
+        {
+            EnsureCapacity(instanceIndex);
+
+            CasterBounds oldBounds = _casterBounds[instanceIndex];
+            if (oldBounds.IsValid)
+            {
+                AddDirtyRegion(oldBounds.AABBMin, oldBounds.AABBMax);
+            }
+
+            if (castsShadows)
+            {
+                AddDirtyRegion(aabbMinWS, aabbMaxWS);
+                _casterBounds[instanceIndex] = new CasterBounds
+                {
+                    AABBMin = aabbMinWS,
+                    AABBMax = aabbMaxWS,
+                    IsValid = true,
+                };
+            }
+            else
+            {
+                _casterBounds[instanceIndex] = default;
+            }
+        }
+
+        public void OnCasterRemoved(int instanceIndex)
+        {
+            if (instanceIndex >= _casterBounds.Length)
+            {
+                return;
+            }
+
+            CasterBounds oldBounds = _casterBounds[instanceIndex];
+            if (oldBounds.IsValid)
+            {
+                AddDirtyRegion(oldBounds.AABBMin, oldBounds.AABBMax);
+            }
+
+            _casterBounds[instanceIndex] = default;
+        }
+
+        public bool ShouldRenderSplit(in AAAAShadowAtlasAllocator.Key key, in float4x4 viewProjectionMatrix,
+            in AAAAShadowAtlasAllocator.Allocation allocation, float4 renderParams) =>
+            ShouldRenderSplit(key, viewProjectionMatrix, allocation, renderParams, float4x4.zero);
+
+        // Returns false if the split's depth from the previous frame can be reused. Either way, the split counts as validated up to now.
+        // renderParams holds anything else that changes the rendered depth, e.g., the biases.
+        // lodViewMatrix identifies a view other than the split itself that caster LOD selection depends on, zero if there is none.
+        public bool ShouldRenderSplit(in AAAAShadowAtlasAllocator.Key key, in float4x4 viewProjectionMatrix,
+            in AAAAShadowAtlasAllocator.Allocation allocation, float4 renderParams, in float4x4 lodViewMatrix)
+        {
+            if (!allocation.IsValid)
+            {
+                _cachedSplits.Remove(key);
+                return true;
+            }
+
+            bool shouldRender = !_cachedSplits.TryGetValue(key, out CachedSplit cachedSplit) ||
+                                !cachedSplit.Matches(viewProjectionMatrix, allocation, renderParams, lodViewMatrix) ||
+                                IsInvalidatedByCasters(cachedSplit);
+
+            if (shouldRender)
+            {
+                cachedSplit = new CachedSplit
+                {
+                    ViewProjectionMatrix = viewProjectionMatrix,
+                    FrustumPlanes = FrustumPlanes.Create(viewProjectionMatrix),
+                    Allocation = allocation,
+                    RenderParams = renderParams,
+                    LODViewMatrix = lodViewMatrix,
+                };
+            }
+
+            cachedSplit.ValidatedSequence = NextSequence;
+            cachedSplit.LastUsedFrameIndex = _frameIndex;
+            _cachedSplits[key] = cachedSplit;
+            return shouldRender;
+        }
+
+        private bool IsInvalidatedByCasters(in CachedSplit cachedSplit)
+        {
+            if (cachedSplit.ValidatedSequence < _firstDirtyRegionSequence)
+            {
+                return true;
+            }
+
+            int firstRegionIndex = (int) (cachedSplit.ValidatedSequence - _firstDirtyRegionSequence);
+            for (int i = firstRegionIndex; i < _dirtyRegions.Length; i++)
+            {
+                DirtyRegion dirtyRegion = _dirtyRegions[i];
+                if (cachedSplit.FrustumPlanes.Intersects(dirtyRegion.AABBMin, dirtyRegion.AABBMax))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        private void AddDirtyRegion(float3 aabbMin, float3 aabbMax)
+        {
+            if (_dirtyRegions.Length == MaxDirtyRegions)
+            {
+                DropDirtyRegions(MaxDirtyRegions / 2);
+            }
+
+            _dirtyRegions.Add(new DirtyRegion
+                {
+                    AABBMin = aabbMin,
+                    AABBMax = aabbMax,
+                }
+            );
+        }
+
+        private void DropDirtyRegions(int count)
+        {
+            if (count <= 0)
+            {
+                return;
+            }
+
+            _dirtyRegions.RemoveRange(0, count);
+            _firstDirtyRegionSequence += (uint) count;
+        }
+
+        private void EnsureCapacity(int instanceIndex)
+        {
+            if (instanceIndex >= _casterBounds.Length)
+            {
+                _casterBounds.Resize(instanceIndex + 1, NativeArrayOptions.ClearMemory);
+            }
+        }
+
+        private static bool CastsShadows(in AAAAInstanceData instanceData) =>
+            (instanceData.PassMask & AAAAInstancePassMask.Shadows) != 0 && (instanceData.Flags & AAAAInstanceFlags.Disabled) == 0;
+
+        private static void GetCasterBounds(in AAAAInstanceData instanceData, out float3 aabbMinWS, out float3 aabbMaxWS) =>
+            AAAACullingMath.TransformAABB(instanceData.AABBMin.xyz, instanceData.AABBMax.xyz, instanceData.ObjectToWorldMatrix,
+                out aabbMinWS, out aabbMaxWS
+            );
+
+        private struct CasterBounds
+        {
+            public float3 AABBMin;
+            public float3 AABBMax;
+            public bool IsValid;
+        }
+
+        private struct DirtyRegion
+        {
+            public float3 AABBMin;
+            public float3 AABBMax;
+        }
+
+        private struct CachedSplit
+        {
+            public float4x4 ViewProjectionMatrix;
+            public FrustumPlanes FrustumPlanes;
+            public AAAAShadowAtlasAllocator.Allocation Allocation;
+            public float4 RenderParams;
+            public float4x4 LODViewMatrix;
+            public uint ValidatedSequence;
+            public int LastUsedFrameIndex;
+
+            public bool Matches(in float4x4 viewProjectionMatrix, in AAAAShadowAtlasAllocator.Allocation allocation, float4 renderParams,
+                in float4x4 lodViewMatrix) =>
+                ViewProjectionMatrix.Equals(viewProjectionMatrix) &&
+                Allocation.PageIndex == allocation.PageIndex && math.all(Allocation.Position == allocation.Position) &&
+                Allocation.Size == allocation.Size &&
+                RenderParams.Equals(renderParams) &&
+                LODViewMatrix.Equals(lodViewMatrix);
+        }
+
+        // The near plane is left out: casters in front of it still cast shadows (directional shadows are rendered without depth clipping).
+        private struct FrustumPlanes
+        {
+            public float4 Left;
+            public float4 Right;
+            public float4 Bottom;
+            public float4 Top;
+            public float4 Far;
+
+            public static FrustumPlanes Create(in float4x4 viewProjectionMatrix)
+            {
+                float4x4 m = math.transpose(viewProjectionMatrix);
+                return new FrustumPlanes
+                {
+                    Left = m.c3 + m.c0,
+                    Right = m.c3 - m.c0,
+                    Bottom = m.c3 + m.c1,
+                    Top = m.c3 - m.c1,
+                    Far = m.c3 - m.c2,
+                };
+            }
+
+            public bool Intersects(float3 aabbMin, float3 aabbMax) =>
+                IsInFront(Left, aabbMin, aabbMax) && IsInFront(Right, aabbMin, aabbMax) &&
+                IsInFront(Bottom, aabbMin, aabbMax) && IsInFront(Top, aabbMin, aabbMax) &&
+                IsInFront(Far, aabbMin, aabbMax);
+
+            // Tests the AABB corner furthest along the plane normal.
+            private static bool IsInFront(float4 plane, float3 aabbMin, float3 aabbMax)
+            {
+                float3 corner = math.select(aabbMin, aabbMax, plane.xyz > 0.0f);
+                return math.dot(plane.xyz, corner) + plane.w >= 0.0f;
+            }
+        }
+    }
+}
@@ -0,0 +1,131 @@
+using System.Collections.Generic;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Decides which directional light cascades are fitted to the camera again in the current frame.
+    // Near cascades are fitted every frame. Far cascades keep the texel-snapped matrices they were last fitted with and are refitted round-robin,
+    // one cascade every few frames, or earlier when the camera moved or turned far enough for the slice of the view frustum to leave them.
+    // Far cascades are fitted with a guard band to leave room for such movement. Shading transforms world positions with the kept matrices,
+    // so it keeps reading the old shadow map until the next refit. Together with AAAAShadowCacheInvalidationTracker, kept matrices mean
+    // the cascade is not redrawn unless its casters change.
+    public sealed class AAAAShadowCascadeScheduler
+    {
+        private readonly Dictionary<AAAAShadowAtlasAllocator.Key, FittedCascade> _fittedCascades = new();
+        private readonly List<AAAAShadowAtlasAllocator.Key> _keysToRemove = new();
+        private int _frameIndex;
+
+        public int FittedCascadeCount => _fittedCascades.Count;
+
+        public void BeginFrame(int frameIndex)
+        {
+            if (frameIndex == _frameIndex)
+            {
+                return;
+            }
+
+            _frameIndex = frameIndex;
+
+            foreach (KeyValuePair<AAAAShadowAtlasAllocator.Key, FittedCascade> kvp in _fittedCascades)
+            {
+                if (_frameIndex - kvp.Value.LastUsedFrameIndex > 1)
+                {
+                    _keysToRemove.Add(kvp.Key);
+                }
+            }
+
+            foreach (AAAAShadowAtlasAllocator.Key key in _keysToRemove)
+            {
+                _fittedCascades.Remove(key);
+            }
+
+            _keysToRemove.Clear();
+        }
+
+        public static bool IsFarCascade(in Settings settings, int cascadeIndex) =>
+            settings.FarCascadeUpdateInterval > 1 && cascadeIndex >= settings.NearCascadeCount;
+
+        // Returns true if the cascade has to be fitted again. Otherwise, returns the projection it was last fitted with.
+        // centerLS and radius are the light view space bounding sphere of the cascade's slice in the current frame.
+        public bool ShouldFitCascade(in AAAAShadowAtlasAllocator.Key key, in Settings settings, in float4x4 lightView, float3 centerLS, float radius,
+            int resolution, out float4x4 lightProjection)
+        {
+            lightProjection = default;
+
+            if (!IsFarCascade(settings, key.SplitIndex) || !_fittedCascades.TryGetValue(key, out FittedCascade fittedCascade))
+            {
+                return true;
+            }
+
+            fittedCascade.LastUsedFrameIndex = _frameIndex;
+            _fittedCascades[key] = fittedCascade;
+
+            // Far cascades take turns, so that at most one of them is fitted per frame.
+            int farCascadeCount = math.max(1, settings.CascadeCount - settings.NearCascadeCount);
+            int slot = (key.SplitIndex - settings.NearCascadeCount) % farCascadeCount;
+            int interval = math.max(settings.FarCascadeUpdateInterval, farCascadeCount);
+            bool isDue = _frameIndex % interval == slot || _frameIndex - fittedCascade.FittedFrameIndex >= interval;
+
+            if (isDue || fittedCascade.Resolution != resolution || !fittedCascade.LightView.Equals(lightView) ||
+                !fittedCascade.Covers(centerLS, radius))
+            {
+                return true;
+            }
+
+            lightProjection = fittedCascade.LightProjection;
+            return false;
+        }
+
+        public void OnCascadeFitted(in AAAAShadowAtlasAllocator.Key key, in Settings settings, in float4x4 lightView, in float4x4 lightProjection,
+            int resolution)
+        {
+            if (!IsFarCascade(settings, key.SplitIndex))
+            {
+                _fittedCascades.Remove(key);
+                return;
+            }
+
+            // Orthographic projection: NDC = scale * positionLS + offset. Depth is left out, the fit extrudes it far beyond the slice.
+            float2 scale = math.float2(lightProjection.c0.x, lightProjection.c1.y);
+            float2 offset = lightProjection.c3.xy;
+            float2 bound0 = (-1.0f - offset) / scale;
+            float2 bound1 = (1.0f - offset) / scale;
+
+            _fittedCascades[key] = new FittedCascade
+            {
+                LightView = lightView,
+                LightProjection = lightProjection,
+                BoundsMinLS = math.min(bound0, bound1),
+                BoundsMaxLS = math.max(bound0, bound1),
+                Resolution = resolution,
+                FittedFrameIndex = _frameIndex,
+                LastUsedFrameIndex = _frameIndex,
+            };
+        }
+
+        public struct Settings
+        {
+            public int CascadeCount;
+            // Cascades below this index are fitted every frame.
+            public int NearCascadeCount;
+            // Frames between two fits of a far cascade. 1 fits all cascades every frame.
+            public int FarCascadeUpdateInterval;
+            // How much the far cascades are enlarged, relative to the radius of their slice.
+            public float GuardBand;
+        }
+
+        private struct FittedCascade
+        {
+            public float4x4 LightView;
+            public float4x4 LightProjection;
+            public float2 BoundsMinLS;
+            public float2 BoundsMaxLS;
+            public int Resolution;
+            public int FittedFrameIndex;
+            public int LastUsedFrameIndex;
+
+            public bool Covers(float3 centerLS, float radius) =>
+                math.all(centerLS.xy - radius >= BoundsMinLS) && math.all(centerLS.xy + radius <= BoundsMaxLS);
+        }
+    }
+}
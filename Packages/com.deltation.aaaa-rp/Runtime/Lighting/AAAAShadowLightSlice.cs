@@ -9,6 +9,8 @@ namespace DELTation.AAAARP.Lighting
         public float4x4 WorldToShadowCoords;
         public float4 BoundingSphere;
         public float4 AtlasSize;
+        // UV rectangle of the split's tile in the atlas page: min.xy, max.xy.
+        public float4 AtlasTileBounds;
         public int BindlessShadowMapIndex;
         public int Padding0;
         public int Padding1;
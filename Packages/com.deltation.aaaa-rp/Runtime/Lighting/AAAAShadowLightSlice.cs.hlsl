@@ -11,6 +11,7 @@ struct AAAAShadowLightSlice
     float4x4 WorldToShadowCoords;
     float4 BoundingSphere;
     float4 AtlasSize;
+    float4 AtlasTileBounds;
     int BindlessShadowMapIndex;
     int Padding0;
     int Padding1;
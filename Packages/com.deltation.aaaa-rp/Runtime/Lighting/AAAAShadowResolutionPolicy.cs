@@ -0,0 +1,244 @@
+using System;
+using System.Collections.Generic;
+using Unity.Collections;
+using Unity.Mathematics;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // Picks a power-of-two shadow map resolution (tier) per light from how many screen pixels the light covers.
+    // The desired resolution is typically the projected diameter of the light's bounds (see GetProjectedDiameter). A light only moves to another tier
+    // once the desired resolution leaves the current tier by more than Hysteresis, so that lights on a tier boundary do not pop back and forth.
+    // When the selected tiers exceed the budget (the smaller of the atlas capacity and the texels rendered per frame),
+    // the lights with the most texels relative to their need are halved first.
+    public sealed class AAAAShadowResolutionPolicy
+    {
+        private readonly Dictionary<AAAAShadowAtlasAllocator.Key, Entry> _entries = new();
+        private readonly List<AAAAShadowAtlasAllocator.Key> _keysToRemove = new();
+        private int _frameIndex;
+
+        public AAAAShadowResolutionPolicy(in Settings settings)
+        {
+            Assert.IsTrue(math.ispow2(settings.MinResolution));
+            Assert.IsTrue(settings.Hysteresis >= 0.0f);
+
+            PolicySettings = settings;
+        }
+
+        public Settings PolicySettings { get; }
+
+        public int TrackedLightCount => _entries.Count;
+
+        public long BudgetTexels => math.min(PolicySettings.MemoryBudgetTexels, PolicySettings.RenderBudgetTexels);
+
+        public void BeginFrame()
+        {
+            ++_frameIndex;
+
+            foreach (KeyValuePair<AAAAShadowAtlasAllocator.Key, Entry> kvp in _entries)
+            {
+                if (_frameIndex - kvp.Value.LastUsedFrameIndex > PolicySettings.RetainFrames)
+                {
+                    _keysToRemove.Add(kvp.Key);
+                }
+            }
+
+            foreach (AAAAShadowAtlasAllocator.Key key in _keysToRemove)
+            {
+                _entries.Remove(key);
+            }
+
+            _keysToRemove.Clear();
+        }
+
+        public void Clear() => _entries.Clear();
+
+        // Fills Request.Resolution. Requests of one camera are expected to be passed in a single call, since they share the budget.
+        public void SelectResolutions(NativeArray<Request> requests, int maxResolution)
+        {
+            Assert.IsTrue(math.ispow2(maxResolution));
+
+            int minResolution = math.min(PolicySettings.MinResolution, maxResolution);
+            long totalTexels = 0;
+
+            for (int index = 0; index < requests.Length; index++)
+            {
+                Request request = requests[index];
+                int resolution = GetTier(request.DesiredResolution, minResolution, maxResolution);
+
+                if (_entries.TryGetValue(request.Key, out Entry entry))
+                {
+                    resolution = ApplyHysteresis(request.DesiredResolution, resolution, math.clamp(entry.Resolution, minResolution, maxResolution));
+                }
+
+                request.Resolution = resolution;
+                requests[index] = request;
+                totalTexels += request.GetTexelCount();
+            }
+
+            long budgetTexels = BudgetTexels;
+
+            while (totalTexels > budgetTexels)
+            {
+                int index = FindMostOverservedRequest(requests, minResolution);
+                if (index == -1)
+                {
+                    break;
+                }
+
+                Request request = requests[index];
+                totalTexels -= request.GetTexelCount();
+                request.Resolution /= 2;
+                totalTexels += request.GetTexelCount();
+                requests[index] = request;
+            }
+
+            foreach (Request request in requests)
+            {
+                _entries[request.Key] = new Entry
+                {
+                    Resolution = request.Resolution,
+                    LastUsedFrameIndex = _frameIndex,
+                };
+            }
+        }
+
+        public static int GetTier(float desiredResolution, int minResolution, int maxResolution)
+        {
+            int resolution = (int) math.min(math.ceil(desiredResolution), maxResolution);
+            return math.clamp(math.ceilpow2(resolution), minResolution, maxResolution);
+        }
+
+        private int ApplyHysteresis(float desiredResolution, int resolution, int previousResolution)
+        {
+            if (resolution > previousResolution && desiredResolution <= previousResolution * (1.0f + PolicySettings.Hysteresis))
+            {
+                return previousResolution;
+            }
+
+            if (resolution < previousResolution && desiredResolution >= previousResolution / 2 * (1.0f - PolicySettings.Hysteresis))
+            {
+                return previousResolution;
+            }
+
+            return resolution;
+        }
+
+        // Ties are broken by the screen coverage and then by the key, so that the result does not depend on the request order.
+        private static int FindMostOverservedRequest(NativeArray<Request> requests, int minResolution)
+        {
+            int bestIndex = -1;
+            float bestRatio = 0.0f;
+
+            for (int index = 0; index < requests.Length; index++)
+            {
+                Request request = requests[index];
+                if (request.Resolution <= minResolution)
+                {
+                    continue;
+                }
+
+                float ratio = request.Resolution / math.max(request.DesiredResolution, 1.0f);
+                if (bestIndex == -1 || ratio > bestRatio || (ratio == bestRatio && IsLessImportant(request, requests[bestIndex])))
+                {
+                    bestIndex = index;
+                    bestRatio = ratio;
+                }
+            }
+
+            return bestIndex;
+        }
+
+        private static bool IsLessImportant(in Request request, in Request otherRequest)
+        {
+            if (request.ScreenCoverage != otherRequest.ScreenCoverage)
+            {
+                return request.ScreenCoverage < otherRequest.ScreenCoverage;
+            }
+
+            return request.Key.CompareTo(otherRequest.Key) < 0;
+        }
+
+        // Diameter in pixels of the bounding sphere as seen by the camera, clamped to the screen size.
+        public static float GetProjectedDiameter(in ViewParameters view, float3 centerWS, float radius)
+        {
+            float maxDiameter = math.cmax(view.ScreenSize);
+            float pixelsPerUnit;
+
+            if (view.IsOrthographic)
+            {
+                pixelsPerUnit = view.ScreenSize.y * 0.5f / view.OrthographicSize;
+                return math.min(2.0f * radius * pixelsPerUnit, maxDiameter);
+            }
+
+            float distance = math.distance(view.Position, centerWS);
+            if (distance <= radius)
+            {
+                return maxDiameter;
+            }
+
+            // Tangent of the angle the sphere's silhouette is seen at.
+            float tanAngle = radius / math.sqrt(distance * distance - radius * radius);
+            pixelsPerUnit = view.ScreenSize.y * 0.5f / view.TanHalfFovY;
+            return math.min(2.0f * tanAngle * pixelsPerUnit, maxDiameter);
+        }
+
+        // Fraction of the screen covered by a disc of the given diameter.
+        public static float GetScreenCoverage(in ViewParameters view, float projectedDiameter)
+        {
+            float radius = projectedDiameter * 0.5f;
+            return math.saturate(math.PI * radius * radius / ((float) view.ScreenSize.x * view.ScreenSize.y));
+        }
+
+        [Serializable]
+        public struct Settings
+        {
+            public int MinResolution;
+            // Relative distance past a tier boundary required to switch tiers.
+            public float Hysteresis;
+            public long MemoryBudgetTexels;
+            public long RenderBudgetTexels;
+            // How many frames a light that was not requested keeps its previous tier.
+            public int RetainFrames;
+
+            public static Settings Default => new()
+            {
+                MinResolution = 128,
+                Hysteresis = 0.25f,
+                MemoryBudgetTexels = 2L * 4096 * 4096,
+                RenderBudgetTexels = 32L * 1024 * 1024,
+                RetainFrames = 2,
+            };
+        }
+
+        public struct ViewParameters
+        {
+            public float3 Position;
+            public int2 ScreenSize;
+            public bool IsOrthographic;
+            public float TanHalfFovY;
+            public float OrthographicSize;
+        }
+
+        public struct Request
+        {
+            // Per light: the split index is not used.
+            public AAAAShadowAtlasAllocator.Key Key;
+            // In texels. Values above the max resolution request the max resolution.
+            public float DesiredResolution;
+            public float ScreenCoverage;
+            public int SplitCount;
+
+            // Output.
+            public int Resolution;
+
+            public long GetTexelCount() => (long) Resolution * Resolution * SplitCount;
+        }
+
+        private struct Entry
+        {
+            public int Resolution;
+            public int LastUsedFrameIndex;
+        }
+    }
+}
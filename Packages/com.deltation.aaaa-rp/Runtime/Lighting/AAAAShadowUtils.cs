@@ -13,11 +13,39 @@ namespace DELTation.AAAARP.Lighting
     {
         public static void ComputeDirectionalLightShadowMatrices(NativeArray<float3> cameraFrustumCorners, float3 cameraPosition, float cameraFarPlane,
             int resolution, quaternion lightRotation, float splitNear, float splitFar,
-            out float4x4 lightView, out float4x4 lightProjection)
+            out float4x4 lightView, out float4x4 lightProjection, float guardBand = 0.0f)
         {
             // From Wicked Engine: https://github.com/turanszkij/WickedEngine/blob/84adc794752a4b12d2551fef383d4872726a9255/WickedEngine/wiRenderer.cpp#L2735
             lightView = ConstructLightView(lightRotation);
+            ComputeDirectionalLightCascadeSphere(cameraFrustumCorners, cameraPosition, lightView, splitNear, splitFar, out float3 center, out float radius);
 
+            // Leave room for the camera to move before the cascade has to be fitted again.
+            radius *= 1.0f + guardBand;
+
+            // Fit AABB onto bounding sphere:
+            float3 aabbMin = center - radius;
+            float3 aabbMax = center + radius;
+
+            // Snap cascade to texel grid:
+            float3 extent = aabbMax - aabbMin;
+            float3 texelSize = extent / resolution;
+            aabbMin = floor(aabbMin / texelSize) * texelSize;
+            aabbMax = floor(aabbMax / texelSize) * texelSize;
+            center = (aabbMin + aabbMax) * 0.5f;
+
+            // Extrude bounds to avoid early shadow clipping:
+            float extrusion = abs(center.z - aabbMin.z);
+            extrusion = max(extrusion, min(1500.0f, cameraFarPlane) * 0.5f);
+            aabbMin.z = center.z - extrusion;
+            aabbMax.z = center.z + extrusion;
+
+            lightProjection = float4x4.OrthoOffCenter(aabbMin.x, aabbMax.x, aabbMin.y, aabbMax.y, aabbMin.z, aabbMax.z);
+        }
+
+        // Light view space bounding sphere of the part of the camera frustum between splitNear and splitFar.
+        public static void ComputeDirectionalLightCascadeSphere(NativeArray<float3> cameraFrustumCorners, float3 cameraPosition, float4x4 lightView,
+            float splitNear, float splitFar, out float3 center, out float radius)
+        {
             float perspectiveNearPlane = distance(cameraFrustumCorners[0], cameraPosition);
             float perspectiveFarPlane = distance(cameraFrustumCorners[1], cameraPosition);
             float splitNearNormalized = (splitNear - perspectiveNearPlane) / (perspectiveFarPlane - perspectiveNearPlane);
@@ -36,7 +64,7 @@ namespace DELTation.AAAARP.Lighting
             };
 
             // Compute cascade bounding sphere center:
-            float3 center = float3.zero;
+            center = float3.zero;
             foreach (float3 corner in corners)
             {
                 center += corner;
@@ -44,30 +72,11 @@ namespace DELTation.AAAARP.Lighting
             center /= corners.Length;
 
             // Compute cascade bounding sphere radius:
-            float radius = 0;
+            radius = 0;
             foreach (float3 corner in corners)
             {
                 radius = max(radius, length(corner - center));
             }
-
-            // Fit AABB onto bounding sphere:
-            float3 aabbMin = center - radius;
-            float3 aabbMax = center + radius;
-
-            // Snap cascade to texel grid:
-            float3 extent = aabbMax - aabbMin;
-            float3 texelSize = extent / resolution;
-            aabbMin = floor(aabbMin / texelSize) * texelSize;
-            aabbMax = floor(aabbMax / texelSize) * texelSize;
-            center = (aabbMin + aabbMax) * 0.5f;
-
-            // Extrude bounds to avoid early shadow clipping:
-            float extrusion = abs(center.z - aabbMin.z);
-            extrusion = max(extrusion, min(1500.0f, cameraFarPlane) * 0.5f);
-            aabbMin.z = center.z - extrusion;
-            aabbMax.z = center.z + extrusion;
-
-            lightProjection = float4x4.OrthoOffCenter(aabbMin.x, aabbMax.x, aabbMin.y, aabbMax.y, aabbMin.z, aabbMax.z);
         }
 
         public static void ComputeSpotLightShadowMatrices(quaternion lightRotation, float3 lightPosition, float outerSpotAngle, float nearPlane, float farPlane,
@@ -82,7 +91,7 @@ namespace DELTation.AAAARP.Lighting
             lightProjection = float4x4.PerspectiveFov(radians(outerSpotAngle), aspect, nearPlane, farPlane);
         }
 
-        private static float4x4 ConstructLightView(quaternion lightRotation)
+        public static float4x4 ConstructLightView(quaternion lightRotation)
         {
             quaternion invLightRotation = inverse(lightRotation);
             float3 lightForward = normalize(rotate(invLightRotation, float3(0, 0, 1)));
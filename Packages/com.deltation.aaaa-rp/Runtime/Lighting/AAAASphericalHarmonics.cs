@@ -0,0 +1,104 @@
+using System;
+using DELTation.AAAARP.Utils;
+using Unity.Collections;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Lighting
+{
+    // CPU reference of ProjectSH9.compute and ShaderLibrary/IBL/SphericalHarmonics.hlsl.
+    // Coefficients are RGB irradiance divided by PI, the same quantity ConvolveDiffuseIrradiance.shader stores in the cubemap.
+    public static class AAAASphericalHarmonics
+    {
+        public const int CoefficientCount = 9;
+
+        // Samples per side of the cubemap in ProjectSH9.compute.
+        public const int ProjectionResolution = 32;
+
+        public static float GetBasis(int coefficientIndex, float3 d) =>
+            coefficientIndex switch
+            {
+                0 => 0.282095f,
+                1 => 0.488603f * d.y,
+                2 => 0.488603f * d.z,
+                3 => 0.488603f * d.x,
+                4 => 1.092548f * d.x * d.y,
+                5 => 1.092548f * d.y * d.z,
+                6 => 0.315392f * (3.0f * d.z * d.z - 1.0f),
+                7 => 1.092548f * d.x * d.z,
+                8 => 0.546274f * (d.x * d.x - d.y * d.y),
+                _ => throw new ArgumentOutOfRangeException(nameof(coefficientIndex)),
+            };
+
+        public static float GetIrradianceScale(int coefficientIndex) =>
+            coefficientIndex == 0 ? 1.0f : coefficientIndex < 4 ? 2.0f / 3.0f : 0.25f;
+
+        // uv is in [-1, 1].
+        public static float3 GetCubemapSampleDirection(int sideIndex, float2 uv)
+        {
+            CubemapUtils.SideOrientation sideOrientation = CubemapUtils.GetSideOrientations()[sideIndex];
+            float3 forward = sideOrientation.Forward.xyz;
+            float3 up = sideOrientation.Up.xyz;
+            float3 right = math.cross(forward, up);
+            return math.normalize(forward + right * uv.x + up * uv.y);
+        }
+
+        public static float GetCubemapTexelSolidAngle(float2 uv, float texelSize)
+        {
+            float distanceSq = 1.0f + math.dot(uv, uv);
+            return texelSize * texelSize / (distanceSq * math.sqrt(distanceSq));
+        }
+
+        // Texels hold the radiance of the cubemap sides in CubemapUtils order, each side row by row, resolution x resolution.
+        public static float3[] ProjectIrradiance(NativeArray<float3> texels, int resolution)
+        {
+            int texelsPerSide = resolution * resolution;
+            if (texels.Length != CubemapUtils.SideCount * texelsPerSide)
+            {
+                throw new ArgumentException("Texel count does not match the resolution.", nameof(texels));
+            }
+
+            var coefficients = new float3[CoefficientCount];
+            float texelSize = 2.0f / resolution;
+            float solidAngleSum = 0.0f;
+
+            for (int texelIndex = 0; texelIndex < texels.Length; texelIndex++)
+            {
+                int sideIndex = texelIndex / texelsPerSide;
+                int sideTexelIndex = texelIndex % texelsPerSide;
+                float2 uv = (math.float2(sideTexelIndex % resolution, sideTexelIndex / resolution) + 0.5f) * texelSize - 1.0f;
+
+                float3 direction = GetCubemapSampleDirection(sideIndex, uv);
+                float solidAngle = GetCubemapTexelSolidAngle(uv, texelSize);
+
+                for (int i = 0; i < CoefficientCount; i++)
+                {
+                    coefficients[i] += texels[texelIndex] * (GetBasis(i, direction) * solidAngle);
+                }
+
+                solidAngleSum += solidAngle;
+            }
+
+            float normalization = 4.0f * math.PI / solidAngleSum;
+
+            for (int i = 0; i < CoefficientCount; i++)
+            {
+                coefficients[i] *= normalization * GetIrradianceScale(i);
+            }
+
+            return coefficients;
+        }
+
+        // Unlike the shader, does not clamp negative values.
+        public static float3 EvaluateIrradiance(float3[] coefficients, float3 normal)
+        {
+            float3 irradiance = 0.0f;
+
+            for (int i = 0; i < CoefficientCount; i++)
+            {
+                irradiance += coefficients[i] * GetBasis(i, normal);
+            }
+
+            return irradiance;
+        }
+    }
+}
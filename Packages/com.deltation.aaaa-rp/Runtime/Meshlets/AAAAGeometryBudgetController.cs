@@ -0,0 +1,138 @@
+using System;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Meshlets
+{
+    // Scales the mesh LOD error threshold to keep the visible geometry within a budget.
+    // The error is measured in log space (log(measured / target)), so that overshooting by 2x and undershooting by 2x are symmetric.
+    // A PID step in velocity form adjusts the log of the multiplier, which makes clamping and holding the output free of integrator windup.
+    // Hysteresis: once the error is within SettleBand the output is held, and it is released only when the error leaves ReleaseBand.
+    public sealed class AAAAGeometryBudgetController
+    {
+        private float _logErrorMultiplier;
+        private float _previousError;
+        private float _previousPreviousError;
+        private int _sampleCount;
+
+        public AAAAGeometryBudgetController() : this(Settings.Default) { }
+
+        public AAAAGeometryBudgetController(in Settings settings)
+        {
+            ControllerSettings = settings;
+            Reset();
+        }
+
+        public Settings ControllerSettings { get; set; }
+
+        // Multiplies the mesh LOD error threshold. Values above 1 select coarser LODs.
+        public float ErrorMultiplier => math.exp(_logErrorMultiplier);
+
+        public bool IsSettled { get; private set; }
+
+        public void Reset()
+        {
+            _logErrorMultiplier = 0.0f;
+            _previousError = 0.0f;
+            _previousPreviousError = 0.0f;
+            _sampleCount = 0;
+            IsSettled = false;
+        }
+
+        // Call once per readback of the visible geometry counters. Returns the new multiplier.
+        public float Update(uint visibleMeshlets, uint visibleTriangles)
+        {
+            Settings settings = ControllerSettings;
+            float error = float.NegativeInfinity;
+
+            if (settings.TargetMeshletCount > 0)
+            {
+                error = math.max(error, ComputeError(visibleMeshlets, settings.TargetMeshletCount));
+            }
+
+            if (settings.TargetTriangleCount > 0)
+            {
+                error = math.max(error, ComputeError(visibleTriangles, settings.TargetTriangleCount));
+            }
+
+            // No budget is set.
+            if (float.IsNegativeInfinity(error))
+            {
+                return ErrorMultiplier;
+            }
+
+            if (_sampleCount == 0)
+            {
+                _previousError = _previousPreviousError = error;
+            }
+
+            ++_sampleCount;
+
+            float absError = math.abs(error);
+            if (IsSettled ? absError <= settings.ReleaseBand : absError <= settings.SettleBand)
+            {
+                IsSettled = true;
+                PushError(error);
+                return ErrorMultiplier;
+            }
+
+            IsSettled = false;
+
+            float step = settings.ProportionalGain * (error - _previousError) +
+                         settings.IntegralGain * error +
+                         settings.DerivativeGain * (error - 2.0f * _previousError + _previousPreviousError);
+            step = math.clamp(step, -settings.MaxLogStep, settings.MaxLogStep);
+            _logErrorMultiplier = math.clamp(_logErrorMultiplier + step,
+                math.log(settings.MinErrorMultiplier), math.log(settings.MaxErrorMultiplier)
+            );
+
+            PushError(error);
+            return ErrorMultiplier;
+        }
+
+        private void PushError(float error)
+        {
+            _previousPreviousError = _previousError;
+            _previousError = error;
+        }
+
+        private static float ComputeError(uint measured, uint target) =>
+            // An empty view is treated as being far below the budget rather than infinitely below it.
+            math.log(math.max(measured, 1u) / (float) target);
+
+        [Serializable]
+        public struct Settings
+        {
+            // Zero disables the corresponding budget. When both are set, the one that is exceeded more wins.
+            public uint TargetMeshletCount;
+            public uint TargetTriangleCount;
+
+            public float ProportionalGain;
+            public float IntegralGain;
+            public float DerivativeGain;
+
+            // Relative to the target in log space, e.g. 0.05 is roughly 5%.
+            public float SettleBand;
+            public float ReleaseBand;
+
+            // Limits the change of the log multiplier per update, so that a single noisy readback cannot swing LODs.
+            public float MaxLogStep;
+            // The default minimum of 1 only ever coarsens LODs: scenes under the budget keep their authored quality.
+            public float MinErrorMultiplier;
+            public float MaxErrorMultiplier;
+
+            public static Settings Default => new()
+            {
+                TargetMeshletCount = 0,
+                TargetTriangleCount = 2_000_000,
+                ProportionalGain = 0.1f,
+                IntegralGain = 0.15f,
+                DerivativeGain = 0.02f,
+                SettleBand = 0.05f,
+                ReleaseBand = 0.15f,
+                MaxLogStep = 0.25f,
+                MinErrorMultiplier = 1.0f,
+                MaxErrorMultiplier = 16.0f,
+            };
+        }
+    }
+}
@@ -31,6 +31,7 @@ namespace DELTation.AAAARP.Meshlets
         public uint InstanceID;
         public uint MeshLODNodeOffset;
         public uint MeshLODNodeCount;
-        public uint Padding0;
+        // Culling contexts that receive the selected meshlets, one bit per context.
+        public uint ViewMask;
     }
 }
\ No newline at end of file
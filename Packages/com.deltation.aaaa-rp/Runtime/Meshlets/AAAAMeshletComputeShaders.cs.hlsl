@@ -27,7 +27,7 @@ struct AAAAMeshletListBuildJob
     uint InstanceID;
     uint MeshLODNodeOffset;
     uint MeshLODNodeCount;
-    uint Padding0;
+    uint ViewMask;
 };
 
 //
@@ -45,9 +45,9 @@ uint GetMeshLODNodeCount(AAAAMeshletListBuildJob value)
 {
     return value.MeshLODNodeCount;
 }
-uint GetPadding0(AAAAMeshletListBuildJob value)
+uint GetViewMask(AAAAMeshletListBuildJob value)
 {
-    return value.Padding0;
+    return value.ViewMask;
 }
 
 #endif
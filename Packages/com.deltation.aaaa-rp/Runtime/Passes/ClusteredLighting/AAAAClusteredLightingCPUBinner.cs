@@ -0,0 +1,255 @@
+using DELTation.AAAARP.Lighting;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Mathematics;
+using static DELTation.AAAARP.Passes.ClusteredLighting.AAAAClusteredLightingConstantBuffer;
+
+namespace DELTation.AAAARP.Passes.ClusteredLighting
+{
+    // CPU reference of BuildClusterGrid.compute, MarkActiveClusters.compute and ClusterCulling.compute,
+    // used to validate the GPU light lists and to measure their memory.
+    // Matrices follow the Unity conventions on the CPU: view space looks down -Z and the projection is OpenGL-style (Camera.projectionMatrix).
+    public static class AAAAClusteredLightingCPUBinner
+    {
+        public static void BuildClusterBounds(in float4x4 projectionMatrix, float2 screenSize, float nearPlane, float farPlane,
+            NativeArray<AAAAClusterBounds> clusterBounds)
+        {
+            float4x4 inverseProjectionMatrix = math.inverse(projectionMatrix);
+            float2 tileSizeInPixels = math.ceil(screenSize / math.float2(ClustersX, ClustersY));
+
+            for (int flatClusterIndex = 0; flatClusterIndex < TotalClusters; flatClusterIndex++)
+            {
+                int3 clusterIndex = UnflattenClusterIndex(flatClusterIndex);
+                float2 minPointSS = clusterIndex.xy * tileSizeInPixels;
+                float2 maxPointSS = math.min(screenSize, (clusterIndex.xy + 1) * tileSizeInPixels);
+                float3 minPointVS = ScreenCoordsToViewSpace(inverseProjectionMatrix, minPointSS, screenSize);
+                float3 maxPointVS = ScreenCoordsToViewSpace(inverseProjectionMatrix, maxPointSS, screenSize);
+                float tileNear = ClusterIndexToViewSpaceZ(clusterIndex.z, nearPlane, farPlane);
+                float tileFar = ClusterIndexToViewSpaceZ(clusterIndex.z + 1, nearPlane, farPlane);
+
+                float3 minPointNear = minPointVS * (tileNear / minPointVS.z);
+                float3 minPointFar = minPointVS * (tileFar / minPointVS.z);
+                float3 maxPointNear = maxPointVS * (tileNear / maxPointVS.z);
+                float3 maxPointFar = maxPointVS * (tileFar / maxPointVS.z);
+
+                clusterBounds[flatClusterIndex] = new AAAAClusterBounds
+                {
+                    Min = math.float4(math.min(math.min(minPointNear, minPointFar), math.min(maxPointNear, maxPointFar)), 0.0f),
+                    Max = math.float4(math.max(math.max(minPointNear, minPointFar), math.max(maxPointNear, maxPointFar)), 0.0f),
+                };
+            }
+        }
+
+        // Depth slice range margin, see MarkActiveClusters.compute.
+        private const float DepthRangeMargin = 0.001f;
+
+        // linearEyeDepth holds the distance along the view direction of each pixel, row by row. Empty pixels are at the far plane.
+        // Appends the active clusters in the order of their flat indices, while the GPU appends them in any order.
+        public static void ComputeActiveClusters(NativeArray<float> linearEyeDepth, int2 screenSize, float nearPlane, float farPlane,
+            AAAAClusterDepthCullingMode depthCullingMode, NativeList<int> activeClusterIndices)
+        {
+            var tileSliceRanges = new NativeArray<int2>(ClustersX * ClustersY, Allocator.Temp);
+
+            for (int tileY = 0; tileY < ClustersY; tileY++)
+            {
+                for (int tileX = 0; tileX < ClustersX; tileX++)
+                {
+                    var sliceRange = math.int2(0, ClustersZ - 1);
+
+                    if (depthCullingMode != AAAAClusterDepthCullingMode.Off)
+                    {
+                        GetTilePixelRange(math.int2(tileX, tileY), screenSize, out int2 firstPixel, out int2 endPixel);
+                        float minEyeDepth = float.MaxValue;
+                        float maxEyeDepth = 0.0f;
+
+                        for (int y = firstPixel.y; y < endPixel.y; y++)
+                        {
+                            for (int x = firstPixel.x; x < endPixel.x; x++)
+                            {
+                                float eyeDepth = linearEyeDepth[y * screenSize.x + x];
+                                minEyeDepth = math.min(minEyeDepth, eyeDepth);
+                                maxEyeDepth = math.max(maxEyeDepth, eyeDepth);
+                            }
+                        }
+
+                        minEyeDepth *= 1.0f - DepthRangeMargin;
+                        maxEyeDepth *= 1.0f + DepthRangeMargin;
+
+                        sliceRange.y = math.min(ViewSpaceZToClusterIndex(-maxEyeDepth, nearPlane, farPlane), ClustersZ - 1);
+                        if (depthCullingMode == AAAAClusterDepthCullingMode.Opaque)
+                        {
+                            sliceRange.x = math.min(ViewSpaceZToClusterIndex(-minEyeDepth, nearPlane, farPlane), sliceRange.y);
+                        }
+                    }
+
+                    tileSliceRanges[tileY * ClustersX + tileX] = sliceRange;
+                }
+            }
+
+            activeClusterIndices.Clear();
+
+            for (int flatClusterIndex = 0; flatClusterIndex < TotalClusters; flatClusterIndex++)
+            {
+                int3 clusterIndex = UnflattenClusterIndex(flatClusterIndex);
+                int2 sliceRange = tileSliceRanges[clusterIndex.y * ClustersX + clusterIndex.x];
+                if (sliceRange.x <= clusterIndex.z && clusterIndex.z <= sliceRange.y)
+                {
+                    activeClusterIndices.Add(flatClusterIndex);
+                }
+            }
+
+            tileSliceRanges.Dispose();
+        }
+
+        // Bins lights for all clusters.
+        public static uint BinLights(NativeArray<AAAAClusterBounds> clusterBounds, NativeArray<AAAAPunctualLightData> punctualLights,
+            in float4x4 viewMatrix, int lightIndexListCapacity,
+            NativeArray<AAAAClusteredLightingGridCell> lightGrid, NativeList<uint> lightIndexList)
+        {
+            var allClusterIndices = new NativeArray<int>(TotalClusters, Allocator.Temp, NativeArrayOptions.UninitializedMemory);
+            for (int flatClusterIndex = 0; flatClusterIndex < TotalClusters; flatClusterIndex++)
+            {
+                allClusterIndices[flatClusterIndex] = flatClusterIndex;
+            }
+
+            uint totalCount = BinLights(clusterBounds, punctualLights, viewMatrix, allClusterIndices, lightIndexListCapacity, lightGrid, lightIndexList);
+            allClusterIndices.Dispose();
+            return totalCount;
+        }
+
+        // Counts, prefix sums and fills like the GPU does. Clusters that do not fit into lightIndexListCapacity keep only the indices that fit.
+        // Clusters missing from activeClusterIndices get empty cells.
+        // Returns the number of indices all clusters asked for, including the ones that did not fit.
+        public static uint BinLights(NativeArray<AAAAClusterBounds> clusterBounds, NativeArray<AAAAPunctualLightData> punctualLights,
+            in float4x4 viewMatrix, NativeArray<int> activeClusterIndices, int lightIndexListCapacity,
+            NativeArray<AAAAClusteredLightingGridCell> lightGrid, NativeList<uint> lightIndexList)
+        {
+            uint totalCount = 0;
+
+            for (int flatClusterIndex = 0; flatClusterIndex < TotalClusters; flatClusterIndex++)
+            {
+                lightGrid[flatClusterIndex] = default;
+            }
+
+            foreach (int flatClusterIndex in activeClusterIndices)
+            {
+                uint visibleLightCount = 0;
+
+                for (int lightIndex = 0; lightIndex < punctualLights.Length; lightIndex++)
+                {
+                    if (IsLightVisible(punctualLights[lightIndex], viewMatrix, clusterBounds[flatClusterIndex]))
+                    {
+                        ++visibleLightCount;
+                    }
+                }
+
+                lightGrid[flatClusterIndex] = new AAAAClusteredLightingGridCell
+                {
+                    Count = visibleLightCount,
+                };
+                totalCount += visibleLightCount;
+            }
+
+            var capacity = (uint) lightIndexListCapacity;
+            uint offset = 0;
+
+            for (int flatClusterIndex = 0; flatClusterIndex < TotalClusters; flatClusterIndex++)
+            {
+                AAAAClusteredLightingGridCell cell = lightGrid[flatClusterIndex];
+                uint requestedCount = cell.Count;
+                cell.Offset = math.min(offset, capacity);
+                cell.Count = math.min(requestedCount, capacity - cell.Offset);
+                lightGrid[flatClusterIndex] = cell;
+                offset += requestedCount;
+            }
+
+            lightIndexList.Clear();
+            lightIndexList.Resize((int) math.min(totalCount, capacity), NativeArrayOptions.ClearMemory);
+
+            foreach (int flatClusterIndex in activeClusterIndices)
+            {
+                AAAAClusteredLightingGridCell cell = lightGrid[flatClusterIndex];
+                uint storedLightCount = 0;
+
+                for (int lightIndex = 0; lightIndex < punctualLights.Length && storedLightCount < cell.Count; lightIndex++)
+                {
+                    if (IsLightVisible(punctualLights[lightIndex], viewMatrix, clusterBounds[flatClusterIndex]))
+                    {
+                        lightIndexList[(int) (cell.Offset + storedLightCount)] = (uint) lightIndex;
+                        ++storedLightCount;
+                    }
+                }
+            }
+
+            return totalCount;
+        }
+
+        public static bool IsLightVisible(in AAAAPunctualLightData punctualLightData, in float4x4 viewMatrix, in AAAAClusterBounds clusterBounds)
+        {
+            float lightRadius = punctualLightData.Color_Radius.w;
+            float3 lightCenterVS = math.transform(viewMatrix, punctualLightData.PositionWS.xyz);
+            float3 closestPoint = math.clamp(lightCenterVS, clusterBounds.Min.xyz, clusterBounds.Max.xyz);
+            float squaredDistance = math.distancesq(lightCenterVS, closestPoint);
+            if (!(lightRadius > 0 && squaredDistance <= lightRadius * lightRadius))
+            {
+                return false;
+            }
+
+            float angle = punctualLightData.SpotDirection_Angle.w;
+            if (angle <= 0.0f)
+            {
+                return true;
+            }
+
+            // https://bartwronski.com/2017/04/13/cull-that-cone/
+            float3 center = (clusterBounds.Max.xyz + clusterBounds.Min.xyz) * 0.5f;
+            float radius = math.length((clusterBounds.Max.xyz - clusterBounds.Min.xyz) * 0.5f);
+            float3 lightDirectionVS = math.normalize(math.rotate(viewMatrix, punctualLightData.SpotDirection_Angle.xyz));
+            float3 v = center - lightCenterVS;
+            float vLengthSq = math.dot(v, v);
+            float v1Length = math.dot(v, -lightDirectionVS);
+            float distanceClosestPoint = math.cos(angle) * math.sqrt(vLengthSq - v1Length * v1Length) - v1Length * math.sin(angle);
+
+            bool angleCull = distanceClosestPoint > radius;
+            bool frontCull = v1Length > radius + lightRadius;
+            bool backCull = v1Length < -radius;
+            return !(angleCull || frontCull || backCull);
+        }
+
+        public static long GetCompactLayoutByteSize(int lightIndexCount) =>
+            (long) TotalClusters * UnsafeUtility.SizeOf<AAAAClusteredLightingGridCell>() + (long) lightIndexCount * sizeof(uint);
+
+        // Every cluster reserves maxLightsPerCluster slots.
+        public static long GetFixedLayoutByteSize(int maxLightsPerCluster) =>
+            (long) TotalClusters * (UnsafeUtility.SizeOf<AAAAClusteredLightingGridCell>() + maxLightsPerCluster * sizeof(uint));
+
+        // zVS is negative in front of the camera. The result is not clamped to the last slice.
+        public static int ViewSpaceZToClusterIndex(float zVS, float nearPlane, float farPlane) =>
+            (int) (math.max(math.log2(-zVS / nearPlane) / math.log2(farPlane / nearPlane), 0) * ClustersZ);
+
+        // Lighting finds the cluster of a pixel from its screen UV, so the tile is widened by a pixel on each side to cover rounding.
+        private static void GetTilePixelRange(int2 tileIndex, int2 screenSize, out int2 firstPixel, out int2 endPixel)
+        {
+            float2 tileCount = math.float2(ClustersX, ClustersY);
+            firstPixel = (int2) math.max(0, math.floor(tileIndex * (float2) screenSize / tileCount) - 1);
+            endPixel = (int2) math.min(screenSize, math.ceil((tileIndex + 1) * (float2) screenSize / tileCount) + 1);
+        }
+
+        private static float3 ScreenCoordsToViewSpace(in float4x4 inverseProjectionMatrix, float2 screenCoords, float2 screenSize)
+        {
+            float2 ndc = screenCoords / screenSize * 2 - 1;
+            float4 positionVS = math.mul(inverseProjectionMatrix, math.float4(ndc, -1.0f, 1.0f));
+            return positionVS.xyz / positionVS.w;
+        }
+
+        private static int3 UnflattenClusterIndex(int flatClusterIndex)
+        {
+            int z = flatClusterIndex / (ClustersX * ClustersY);
+            int xy = flatClusterIndex % (ClustersX * ClustersY);
+            return math.int3(xy % ClustersX, xy / ClustersX, z);
+        }
+
+        private static float ClusterIndexToViewSpaceZ(int zClusterIndex, float nearPlane, float farPlane) =>
+            -nearPlane * math.pow(math.max(0, farPlane / nearPlane), (float) zClusterIndex / ClustersZ);
+    }
+}
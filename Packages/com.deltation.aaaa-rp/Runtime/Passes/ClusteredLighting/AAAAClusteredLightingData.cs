@@ -9,13 +9,16 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
     public class AAAAClusteredLightingData : ContextItem
     {
         public BufferHandle LightGridBuffer;
+        public int LightIndexListCapacity;
         public BufferHandle LightIndexListBuffer;
 
-        public void Init(RenderGraph renderGraph)
+        public void Init(RenderGraph renderGraph, int lightIndexListCapacity)
         {
+            LightIndexListCapacity = lightIndexListCapacity;
+
             {
                 var bufferDesc = new BufferDesc(
-                    TotalClusters, UnsafeUtility.SizeOf<AAAAClusteredLightingGridCell>(), GraphicsBuffer.Target.Raw
+                    TotalClusters, UnsafeUtility.SizeOf<AAAAClusteredLightingGridCell>(), GraphicsBuffer.Target.Raw | GraphicsBuffer.Target.CopyDestination
                 )
                 {
                     name = nameof(LightGridBuffer),
@@ -25,7 +28,7 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
 
             {
                 var bufferDesc = new BufferDesc(
-                    TotalClusters * MaxLightsPerCluster, sizeof(uint), GraphicsBuffer.Target.Structured
+                    lightIndexListCapacity, sizeof(uint), GraphicsBuffer.Target.Structured
                 )
                 {
                     name = nameof(LightIndexListBuffer),
@@ -37,6 +40,7 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
         public override void Reset()
         {
             LightGridBuffer = BufferHandle.nullHandle;
+            LightIndexListCapacity = 0;
             LightIndexListBuffer = BufferHandle.nullHandle;
         }
     }
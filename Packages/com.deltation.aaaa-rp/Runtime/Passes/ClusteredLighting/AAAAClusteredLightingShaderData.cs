@@ -3,11 +3,25 @@ using UnityEngine.Rendering;
 
 namespace DELTation.AAAARP.Passes.ClusteredLighting
 {
+    // Which clusters lights are culled for. The rest of the clusters get empty light lists.
+    [GenerateHLSL]
+    public enum AAAAClusterDepthCullingMode
+    {
+        // All clusters.
+        Off,
+        // Clusters from the near plane to the farthest depth of the tile. Surfaces in front of the depth buffer (e.g., transparents) are still lit.
+        Conservative,
+        // Clusters between the nearest and the farthest depth of the tile. Only surfaces written to the depth buffer are lit correctly.
+        Opaque,
+    }
+
     [GenerateHLSL(PackingRules.Exact, false)]
     public static class AAAAClusteredLightingComputeShaders
     {
         public const int BuildClusterGridThreadGroupSize = 32;
         public const int ClusterCullingThreadGroupSize = 32;
+        public const int ClusterPrefixSumThreadGroupSize = 256;
+        public const int MarkActiveClustersThreadGroupSize = 64;
     }
 
     [GenerateHLSL(PackingRules.Exact, false, generateCBuffer: true)]
@@ -18,8 +32,6 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
         public const int ClustersZ = 24;
 
         public const int TotalClusters = ClustersX * ClustersY * ClustersZ;
-
-        public const int MaxLightsPerCluster = 128;
     }
 
     [GenerateHLSL(PackingRules.Exact, false)]
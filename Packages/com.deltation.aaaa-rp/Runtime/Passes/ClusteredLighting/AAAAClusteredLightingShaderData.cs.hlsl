@@ -4,11 +4,20 @@
 
 #ifndef AAAACLUSTEREDLIGHTINGSHADERDATA_CS_HLSL
 #define AAAACLUSTEREDLIGHTINGSHADERDATA_CS_HLSL
+//
+// DELTation.AAAARP.Passes.ClusteredLighting.AAAAClusterDepthCullingMode:  static fields
+//
+#define AAAACLUSTERDEPTHCULLINGMODE_OFF (0)
+#define AAAACLUSTERDEPTHCULLINGMODE_CONSERVATIVE (1)
+#define AAAACLUSTERDEPTHCULLINGMODE_OPAQUE (2)
+
 //
 // DELTation.AAAARP.Passes.ClusteredLighting.AAAAClusteredLightingComputeShaders:  static fields
 //
 #define BUILD_CLUSTER_GRID_THREAD_GROUP_SIZE (32)
 #define CLUSTER_CULLING_THREAD_GROUP_SIZE (32)
+#define CLUSTER_PREFIX_SUM_THREAD_GROUP_SIZE (256)
+#define MARK_ACTIVE_CLUSTERS_THREAD_GROUP_SIZE (64)
 
 //
 // DELTation.AAAARP.Passes.ClusteredLighting.AAAAClusteredLightingConstantBuffer:  static fields
@@ -17,7 +26,6 @@
 #define CLUSTERS_Y (9)
 #define CLUSTERS_Z (24)
 #define TOTAL_CLUSTERS (3456)
-#define MAX_LIGHTS_PER_CLUSTER (128)
 
 // Generated from DELTation.AAAARP.Passes.ClusteredLighting.AAAAClusterBounds
 // PackingRules = Exact
@@ -1,28 +1,40 @@
 ﻿using System.Diagnostics.CodeAnalysis;
 using DELTation.AAAARP.Core;
+using DELTation.AAAARP.Data;
 using DELTation.AAAARP.FrameData;
 using DELTation.AAAARP.RenderPipelineResources;
 using DELTation.AAAARP.Utils;
+using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using Unity.Mathematics;
 using UnityEngine;
-using UnityEngine.Assertions;
 using UnityEngine.Rendering;
 using UnityEngine.Rendering.RenderGraphModule;
 
 namespace DELTation.AAAARP.Passes.ClusteredLighting
 {
+    // Light lists are built in three steps: count the lights of each cluster, prefix sum the counts into offsets, then fill the lists.
+    // The index list holds exactly the visible lights and is sized from the totals read back from previous frames.
+    // Lights are culled only for the active clusters: the ones the depth range of their screen tile overlaps (see AAAAClusterDepthCullingMode).
     public sealed class ClusteredLightingPass : AAAARenderPass<ClusteredLightingPass.PassData>
     {
+        // Until the first readback arrives, the index list has room for this many lights per cluster on average.
+        private const int InitialLightsPerCluster = 32;
+
         private readonly ComputeShader _buildClusterGridCS;
         private readonly ComputeShader _clusterCullingCS;
+        private readonly AAAAReadbackCapacityPolicy _lightIndexListCapacityPolicy = new();
+        private readonly ComputeShader _markActiveClustersCS;
         private readonly AAAARawBufferClear _rawBufferClear;
+        private bool _hasReportedLightIndexCounts;
+        private uint _reportedLightIndexCountPeak;
 
         public ClusteredLightingPass(AAAARenderPassEvent renderPassEvent, AAAARenderPipelineRuntimeShaders runtimeShaders, AAAARawBufferClear rawBufferClear) :
             base(renderPassEvent)
         {
             _buildClusterGridCS = runtimeShaders.BuildClusterGridCS;
             _clusterCullingCS = runtimeShaders.ClusterCullingCS;
+            _markActiveClustersCS = runtimeShaders.MarkActiveClustersCS;
             _rawBufferClear = rawBufferClear;
         }
 
@@ -30,12 +42,19 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
         {
             AAAARenderingData renderingData = frameData.Get<AAAARenderingData>();
             AAAACameraData cameraData = frameData.Get<AAAACameraData>();
+            AAAAResourceData resourceData = frameData.Get<AAAAResourceData>();
             AAAAClusteredLightingData clusteredLightingData = frameData.GetOrCreate<AAAAClusteredLightingData>();
-            clusteredLightingData.Init(renderingData.RenderGraph);
+            clusteredLightingData.Init(renderingData.RenderGraph,
+                GetLightIndexListCapacity(renderingData.PipelineAsset.LightingSettings.MaxPunctualLights)
+            );
 
             {
                 passData.LightGridBuffer = builder.WriteBuffer(clusteredLightingData.LightGridBuffer);
                 passData.LightIndexListBuffer = builder.WriteBuffer(clusteredLightingData.LightIndexListBuffer);
+                passData.LightIndexListCapacity = clusteredLightingData.LightIndexListCapacity;
+                passData.Pass = this;
+                passData.CameraDepth = builder.ReadTexture(resourceData.CameraScaledDepthBuffer);
+                passData.DepthCullingMode = GetDepthCullingMode(renderingData.PipelineAsset.LightingSettings, cameraData);
             }
 
             {
@@ -55,6 +74,32 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
                 passData.LightIndexCounterBuffer = builder.CreateTransientBuffer(bufferDesc);
             }
 
+            {
+                var bufferDesc = new BufferDesc(1, sizeof(uint), GraphicsBuffer.Target.Raw | GraphicsBuffer.Target.CopyDestination)
+                {
+                    name = nameof(PassData.ActiveClusterCounterBuffer),
+                };
+                passData.ActiveClusterCounterBuffer = builder.CreateTransientBuffer(bufferDesc);
+            }
+
+            {
+                var bufferDesc = new BufferDesc(AAAAClusteredLightingConstantBuffer.TotalClusters, sizeof(uint), GraphicsBuffer.Target.Raw)
+                {
+                    name = nameof(PassData.ActiveClusterListBuffer),
+                };
+                passData.ActiveClusterListBuffer = builder.CreateTransientBuffer(bufferDesc);
+            }
+
+            {
+                var bufferDesc = new BufferDesc(UnsafeUtility.SizeOf<IndirectDispatchArgs>() / sizeof(uint), sizeof(uint),
+                    GraphicsBuffer.Target.IndirectArguments | GraphicsBuffer.Target.Raw
+                )
+                {
+                    name = nameof(PassData.ClusterCullingIndirectDispatchArgsBuffer),
+                };
+                passData.ClusterCullingIndirectDispatchArgsBuffer = builder.CreateTransientBuffer(bufferDesc);
+            }
+
             float2 scaledResolution = math.float2(cameraData.ScaledWidth, cameraData.ScaledHeight);
             float2 tileCount = math.float2(AAAAClusteredLightingConstantBuffer.ClustersX, AAAAClusteredLightingConstantBuffer.ClustersY);
             passData.TileSizeInPixels = math.float4(math.ceil(scaledResolution / tileCount), 0, 0);
@@ -66,6 +111,11 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
         {
             {
                 _rawBufferClear.FastZeroClear(context.cmd, data.LightIndexCounterBuffer, 1);
+                _rawBufferClear.FastZeroClear(context.cmd, data.ActiveClusterCounterBuffer, 1);
+                // Inactive clusters are not visited by the culling kernels.
+                _rawBufferClear.FastZeroClear(context.cmd, data.LightGridBuffer,
+                    AAAAClusteredLightingConstantBuffer.TotalClusters * UnsafeUtility.SizeOf<AAAAClusteredLightingGridCell>() / sizeof(uint)
+                );
             }
 
             using (new ProfilingScope(context.cmd, Profiling.BuildClusterGrid))
@@ -79,49 +129,180 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
                 );
             }
 
-            using (new ProfilingScope(context.cmd, Profiling.ClusterCulling))
+            using (new ProfilingScope(context.cmd, Profiling.MarkActiveClusters))
             {
-                const int kernelIndex = 0;
-                const int threadGroupSize = AAAAClusteredLightingComputeShaders.ClusterCullingThreadGroupSize;
+                {
+                    const int kernelIndex = KernelIndices.MarkActiveClusters;
+                    context.cmd.SetComputeIntParam(_markActiveClustersCS, ShaderIDs.MarkActiveClusters._DepthCullingMode, (int) data.DepthCullingMode);
+                    context.cmd.SetComputeTextureParam(_markActiveClustersCS, kernelIndex, ShaderIDs.MarkActiveClusters._CameraDepth, data.CameraDepth);
+                    context.cmd.SetComputeBufferParam(_markActiveClustersCS, kernelIndex, ShaderIDs._ActiveClusterCounter,
+                        data.ActiveClusterCounterBuffer
+                    );
+                    context.cmd.SetComputeBufferParam(_markActiveClustersCS, kernelIndex, ShaderIDs._ActiveClusterList, data.ActiveClusterListBuffer);
+
+                    // One group per screen tile.
+                    context.cmd.DispatchCompute(_markActiveClustersCS, kernelIndex,
+                        AAAAClusteredLightingConstantBuffer.ClustersX, AAAAClusteredLightingConstantBuffer.ClustersY, 1
+                    );
+                }
+
+                {
+                    const int kernelIndex = KernelIndices.FixupIndirectArgs;
+                    context.cmd.SetComputeBufferParam(_markActiveClustersCS, kernelIndex, ShaderIDs._ActiveClusterCounter,
+                        data.ActiveClusterCounterBuffer
+                    );
+                    context.cmd.SetComputeBufferParam(_markActiveClustersCS, kernelIndex, ShaderIDs.MarkActiveClusters._IndirectArgs,
+                        data.ClusterCullingIndirectDispatchArgsBuffer
+                    );
+
+                    context.cmd.DispatchCompute(_markActiveClustersCS, kernelIndex, 1, 1, 1);
+                }
+            }
+
+            using (new ProfilingScope(context.cmd, Profiling.CountClusterLights))
+            {
+                const int kernelIndex = KernelIndices.Count;
                 context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ClusterBounds, data.ClusterBoundsBuffer);
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ActiveClusterCounter, data.ActiveClusterCounterBuffer);
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ActiveClusterList, data.ActiveClusterListBuffer);
                 context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs.ClusterCulling._LightIndexCounter, data.LightIndexCounterBuffer);
                 context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs.ClusterCulling._LightGrid, data.LightGridBuffer);
+
+                context.cmd.DispatchCompute(_clusterCullingCS, kernelIndex, data.ClusterCullingIndirectDispatchArgsBuffer, 0);
+            }
+
+            using (new ProfilingScope(context.cmd, Profiling.PrefixSumClusterLights))
+            {
+                const int kernelIndex = KernelIndices.PrefixSum;
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs.ClusterCulling._LightGrid, data.LightGridBuffer);
+                context.cmd.SetComputeIntParam(_clusterCullingCS, ShaderIDs.ClusterCulling._LightIndexListCapacity, data.LightIndexListCapacity);
+
+                context.cmd.DispatchCompute(_clusterCullingCS, kernelIndex, 1, 1, 1);
+            }
+
+            using (new ProfilingScope(context.cmd, Profiling.FillClusterLightLists))
+            {
+                const int kernelIndex = KernelIndices.Fill;
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ClusterBounds, data.ClusterBoundsBuffer);
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ActiveClusterCounter, data.ActiveClusterCounterBuffer);
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs._ActiveClusterList, data.ActiveClusterListBuffer);
+                context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs.ClusterCulling._LightGrid, data.LightGridBuffer);
                 context.cmd.SetComputeBufferParam(_clusterCullingCS, kernelIndex, ShaderIDs.ClusterCulling._LightIndexList, data.LightIndexListBuffer);
 
-                Assert.IsTrue(AAAAClusteredLightingConstantBuffer.TotalClusters % threadGroupSize == 0);
-                context.cmd.DispatchCompute(_clusterCullingCS, kernelIndex,
-                    AAAAClusteredLightingConstantBuffer.TotalClusters / threadGroupSize, 1, 1
-                );
+                context.cmd.DispatchCompute(_clusterCullingCS, kernelIndex, data.ClusterCullingIndirectDispatchArgsBuffer, 0);
             }
 
+            RequestLightIndexCountReadback(context.cmd, data);
+
             context.cmd.SetGlobalBuffer(ShaderIDs.Global._ClusteredLightGrid, data.LightGridBuffer);
             context.cmd.SetGlobalBuffer(ShaderIDs.Global._ClusteredLightIndexList, data.LightIndexListBuffer);
         }
 
+        private static AAAAClusterDepthCullingMode GetDepthCullingMode(AAAALightingSettings lightingSettings, AAAACameraData cameraData)
+        {
+            // Voxelization looks lights up at arbitrary positions, not only at the ones in the depth buffer.
+            if (cameraData.RealtimeGITechnique == AAAARealtimeGITechnique.Voxel)
+            {
+                return AAAAClusterDepthCullingMode.Off;
+            }
+
+            // Depth slices assume a perspective projection.
+            if (cameraData.Camera.orthographic)
+            {
+                return AAAAClusterDepthCullingMode.Off;
+            }
+
+            return lightingSettings.ClusterDepthCulling;
+        }
+
+        private int GetLightIndexListCapacity(int maxPunctualLights)
+        {
+            const int totalClusters = AAAAClusteredLightingConstantBuffer.TotalClusters;
+            int worstCaseCapacity = totalClusters * math.max(1, maxPunctualLights);
+
+            if (_hasReportedLightIndexCounts)
+            {
+                _lightIndexListCapacityPolicy.Update(_reportedLightIndexCountPeak, worstCaseCapacity);
+                _reportedLightIndexCountPeak = 0;
+                _hasReportedLightIndexCounts = false;
+            }
+
+            return _lightIndexListCapacityPolicy.HasSamples
+                ? _lightIndexListCapacityPolicy.GetCapacity(worstCaseCapacity)
+                : math.min(worstCaseCapacity, totalClusters * InitialLightsPerCluster);
+        }
+
+        // The counter holds the number of indices all clusters asked for, including the ones that did not fit.
+        private static void RequestLightIndexCountReadback(CommandBuffer cmd, PassData data)
+        {
+            ClusteredLightingPass pass = data.Pass;
+
+            cmd.RequestAsyncReadback(data.LightIndexCounterBuffer, sizeof(uint), 0, request =>
+                {
+                    if (request.hasError)
+                    {
+                        return;
+                    }
+
+                    NativeArray<uint> lightIndexCount = request.GetData<uint>();
+                    pass._reportedLightIndexCountPeak = math.max(pass._reportedLightIndexCountPeak, lightIndexCount[0]);
+                    pass._hasReportedLightIndexCounts = true;
+                }
+            );
+        }
+
         public class PassData : PassDataBase
         {
+            public BufferHandle ActiveClusterCounterBuffer;
+            public BufferHandle ActiveClusterListBuffer;
+            public TextureHandle CameraDepth;
             public BufferHandle ClusterBoundsBuffer;
+            public BufferHandle ClusterCullingIndirectDispatchArgsBuffer;
+            public AAAAClusterDepthCullingMode DepthCullingMode;
             public BufferHandle LightGridBuffer;
             public BufferHandle LightIndexCounterBuffer;
             public BufferHandle LightIndexListBuffer;
+            public int LightIndexListCapacity;
+            public ClusteredLightingPass Pass;
             public Vector4 TileSizeInPixels;
         }
 
+        private static class KernelIndices
+        {
+            public const int Count = 0;
+            public const int PrefixSum = 1;
+            public const int Fill = 2;
+
+            // MarkActiveClusters.compute
+            public const int MarkActiveClusters = 0;
+            public const int FixupIndirectArgs = 1;
+        }
+
         [SuppressMessage("ReSharper", "InconsistentNaming")]
         private static class ShaderIDs
         {
             public static readonly int _ClusterBounds = Shader.PropertyToID(nameof(_ClusterBounds));
+            public static readonly int _ActiveClusterCounter = Shader.PropertyToID(nameof(_ActiveClusterCounter));
+            public static readonly int _ActiveClusterList = Shader.PropertyToID(nameof(_ActiveClusterList));
 
             public static class BuildClusterGrid
             {
                 public static readonly int _TileSizeInPixels = Shader.PropertyToID(nameof(_TileSizeInPixels));
             }
 
+            public static class MarkActiveClusters
+            {
+                public static readonly int _DepthCullingMode = Shader.PropertyToID(nameof(_DepthCullingMode));
+                public static readonly int _CameraDepth = Shader.PropertyToID(nameof(_CameraDepth));
+                public static readonly int _IndirectArgs = Shader.PropertyToID(nameof(_IndirectArgs));
+            }
+
             public static class ClusterCulling
             {
                 public static readonly int _LightIndexCounter = Shader.PropertyToID(nameof(_LightIndexCounter));
                 public static readonly int _LightGrid = Shader.PropertyToID(nameof(_LightGrid));
                 public static readonly int _LightIndexList = Shader.PropertyToID(nameof(_LightIndexList));
+                public static readonly int _LightIndexListCapacity = Shader.PropertyToID(nameof(_LightIndexListCapacity));
             }
 
             public static class Global
@@ -134,7 +315,10 @@ namespace DELTation.AAAARP.Passes.ClusteredLighting
         private static class Profiling
         {
             public static readonly ProfilingSampler BuildClusterGrid = new(nameof(BuildClusterGrid));
-            public static readonly ProfilingSampler ClusterCulling = new(nameof(ClusterCulling));
+            public static readonly ProfilingSampler MarkActiveClusters = new(nameof(MarkActiveClusters));
+            public static readonly ProfilingSampler CountClusterLights = new(nameof(CountClusterLights));
+            public static readonly ProfilingSampler PrefixSumClusterLights = new(nameof(PrefixSumClusterLights));
+            public static readonly ProfilingSampler FillClusterLightLists = new(nameof(FillClusterLightLists));
         }
     }
 }
\ No newline at end of file
@@ -60,6 +60,9 @@ namespace DELTation.AAAARP.Passes.Debugging
                 aggregateData.OcclusionCulledMeshlets += item.OcclusionCulledMeshlets;
 
                 aggregateData.ConeCulledMeshlets += item.ConeCulledMeshlets;
+
+                aggregateData.VisibleMeshlets += item.VisibleMeshlets;
+                aggregateData.VisibleTriangles += item.VisibleTriangles;
             }
 
             return aggregateData;
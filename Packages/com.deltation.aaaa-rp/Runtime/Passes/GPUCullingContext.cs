@@ -9,7 +9,8 @@ namespace DELTation.AAAARP.Passes
     [StructLayout(LayoutKind.Auto)]
     public unsafe struct GPUCullingContext
     {
-        public const int MaxCullingContextsPerBatch = 8;
+        // Bounded by the width of AAAAMeshletListBuildJob.ViewMask.
+        public const int MaxCullingContextsPerBatch = 32;
 
         public float4x4 ViewProjectionMatrix;
         public float4x4 ViewMatrix;
@@ -24,23 +25,37 @@ namespace DELTation.AAAARP.Passes
         public uint BaseStartInstance;
         public uint MeshletListBuildJobsOffset;
         public uint MeshletRenderRequestsOffset;
+        // Range of _InstanceIndices culled for this context.
+        public uint InstanceIndicesOffset;
+        public uint InstanceIndicesCount;
 
         public uint Padding0;
-        public uint Padding1;
-        public uint Padding2;
     }
 
     [GenerateHLSL(PackingRules.Exact, needAccessors = false)]
     [StructLayout(LayoutKind.Auto)]
     public struct GPULODSelectionContext
     {
+        // The view whose pixels the LOD error is measured in: the main camera or, for shadow contexts, the shadow map.
         public float4x4 ViewProjectionMatrix;
+        // Origin of the distance falloff: the main camera or, for perspective shadow contexts, the light.
         public float4 CameraPosition;
         public float4 CameraUp;
         public float4 CameraRight;
         public float2 ScreenSizePixels;
+        // Divides the projected error, larger values select coarser LODs.
+        public float ErrorScale;
+        // When set, LODs are never coarser than the ones the view below (the main camera) would select.
+        public uint Conservative;
 
+        public float4x4 ConservativeViewProjectionMatrix;
+        public float4 ConservativeCameraPosition;
+        public float4 ConservativeCameraUp;
+        public float4 ConservativeCameraRight;
+        public float2 ConservativeScreenSizePixels;
+
+        // When positive, used instead of the squared distance to CameraPosition. Orthographic views have no origin to measure it from.
+        public float FixedDistanceSq;
         public uint Padding0;
-        public uint Padding1;
     }
 }
\ No newline at end of file
@@ -7,7 +7,7 @@
 //
 // DELTation.AAAARP.Passes.GPUCullingContext:  static fields
 //
-#define MAX_CULLING_CONTEXTS_PER_BATCH (8)
+#define MAX_CULLING_CONTEXTS_PER_BATCH (32)
 
 // Generated from DELTation.AAAARP.Passes.GPUCullingContext
 // PackingRules = Exact
@@ -23,9 +23,9 @@ struct GPUCullingContext
     uint BaseStartInstance;
     uint MeshletListBuildJobsOffset;
     uint MeshletRenderRequestsOffset;
+    uint InstanceIndicesOffset;
+    uint InstanceIndicesCount;
     uint Padding0;
-    uint Padding1;
-    uint Padding2;
 };
 
 // Generated from DELTation.AAAARP.Passes.GPULODSelectionContext
@@ -37,8 +37,15 @@ struct GPULODSelectionContext
     float4 CameraUp;
     float4 CameraRight;
     float2 ScreenSizePixels;
+    float ErrorScale;
+    uint Conservative;
+    float4x4 ConservativeViewProjectionMatrix;
+    float4 ConservativeCameraPosition;
+    float4 ConservativeCameraUp;
+    float4 ConservativeCameraRight;
+    float2 ConservativeScreenSizePixels;
+    float FixedDistanceSq;
     uint Padding0;
-    uint Padding1;
 };
 
 
@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
 using DELTation.AAAARP.Core;
+using DELTation.AAAARP.Culling;
 using DELTation.AAAARP.Debugging;
 using DELTation.AAAARP.FrameData;
 using DELTation.AAAARP.Meshlets;
@@ -20,6 +21,8 @@ namespace DELTation.AAAARP.Passes
 {
     public sealed class GPUCullingPass : AAAARenderPass<GPUCullingPass.PassData>, IDisposable
     {
+        private const float MinLODErrorScale = 0.01f;
+
         public enum PassType
         {
             Basic,
@@ -37,7 +40,9 @@ namespace DELTation.AAAARP.Passes
         private readonly ComputeShader _meshletListBuildCS;
         private readonly PassType _passType;
         private readonly AAAARawBufferClear _rawBufferClear;
-        private NativeList<int> _instanceIndices;
+
+        // Candidates are gathered in Setup and uploaded in Render, so they must outlive the frame's temp allocator.
+        private NativeList<int> _candidateInstanceIndices = new(Allocator.Persistent);
 
         public GPUCullingPass(PassType passType, AAAARenderPassEvent renderPassEvent, AAAARenderPipelineRuntimeShaders runtimeShaders,
             AAAARawBufferClear rawBufferClear,
@@ -49,7 +54,6 @@ namespace DELTation.AAAARP.Passes
             _fixupGPUMeshletCullingIndirectDispatchArgsCS = runtimeShaders.FixupGPUMeshletCullingIndirectDispatchArgsCS;
             _gpuMeshletCullingCS = runtimeShaders.GPUMeshletCullingCS;
             _rawBufferClear = rawBufferClear;
-            _instanceIndices = new NativeList<int>(Allocator.Persistent);
             _debugDisplaySettings = debugDisplaySettings;
 
             Name = AutoName;
@@ -73,12 +77,12 @@ namespace DELTation.AAAARP.Passes
         public override string Name { get; }
         public List<CullingViewParameters> CullingContextParameterList { get; } = new();
 
+        // Cull each instance once against all contexts instead of once per context. Only used by basic passes with several contexts.
+        public bool MultiView { get; set; }
+
         public void Dispose()
         {
-            if (_instanceIndices.IsCreated)
-            {
-                _instanceIndices.Dispose();
-            }
+            _candidateInstanceIndices.Dispose();
         }
 
         protected override void Setup(RenderGraphBuilder builder, PassData passData, ContextContainer frameData)
@@ -86,9 +90,7 @@ namespace DELTation.AAAARP.Passes
             AAAARenderingData renderingData = frameData.Get<AAAARenderingData>();
             AAAARendererContainer rendererContainer = renderingData.RendererContainer;
 
-            _instanceIndices.Clear();
-            rendererContainer.InstanceDataBuffer.GetInstanceIndices(_instanceIndices);
-            passData.InstanceCount = _instanceIndices.Length;
+            passData.InstanceCount = rendererContainer.InstanceDataBuffer.InstanceCount;
 
             if (passData.InstanceCount == 0)
             {
@@ -143,16 +145,22 @@ namespace DELTation.AAAARP.Passes
                 cullingContext.MeshletRenderRequestsOffset = contextIndex * rendererContainer.MeshletRenderRequestByteStridePerContext;
                 cullingContext.ViewParameters = cullingViewParameters;
 
-                // LOD for shadows should be the same as for main view.
+                // By default, LOD for shadows is the same as for main view.
                 // We do not explicitly synchronize LOD selection, just the input parameters.
-                cullingContext.LODSelectionContext = new LODSelectionContext
+                var mainViewLODSelectionContext = new LODSelectionContext
                 {
                     CameraPosition = cameraPosition,
                     CameraRight = cameraRight,
                     CameraUp = cameraUp,
                     PixelSize = pixelSize,
                     GPUViewProjectionMatrix = gpuViewProjectionMatrix,
+                    ErrorScale = (cullingViewParameters.PassMask & AAAAInstancePassMask.Shadows) != 0
+                        ? 1.0f
+                        : rendererContainer.GeometryBudgetLODErrorScale,
                 };
+                cullingContext.LODSelectionContext = cullingViewParameters.LODSelectionMode == LODSelectionMode.ViewPixels
+                    ? CreateViewPixelsLODSelectionContext(cullingViewParameters, mainViewLODSelectionContext)
+                    : mainViewLODSelectionContext;
 
                 Plane[] frustumPlanes = TempCollections.Planes;
                 GeometryUtility.CalculateFrustumPlanes(cullingContext.ViewParameters.ViewProjectionMatrix, frustumPlanes);
@@ -180,14 +188,96 @@ namespace DELTation.AAAARP.Passes
                 CullingContextParameterList.Clear();
             }
 
-            passData.InstanceIndices = builder.CreateTransientBuffer(
-                new BufferDesc(_instanceIndices.Length, sizeof(uint), GraphicsBuffer.Target.Raw)
+            passData.MultiView = MultiView && _passType == PassType.Basic && passData.CullingContextCount > 1;
+
+            // Voxelization does not frustum cull instances, so there is nothing to cache.
+            if (_passType == PassType.Voxelization)
+            {
+                for (int contextIndex = 0; contextIndex < passData.CullingContextCount; contextIndex++)
                 {
-                    name = nameof(PassData.InstanceIndices),
+                    PassData.CullingContext cullingContext = passData.CullingContexts[contextIndex];
+                    cullingContext.InstanceIndicesOffset = 0;
+                    cullingContext.InstanceIndicesCount = passData.InstanceCount;
                 }
-            );
+
+                passData.MaxInstanceIndicesCount = passData.InstanceCount;
+                passData.CandidateInstanceIndices = default;
+                passData.InstanceIndices =
+                    builder.ReadBuffer(renderingData.RenderGraph.ImportBuffer(rendererContainer.InstanceDataBuffer.InstanceIndicesBuffer));
+            }
+            else
+            {
+                AAAAStaticInstanceCullingCache staticInstanceCullingCache = rendererContainer.StaticInstanceCullingCache;
+                AAAASceneBVH sceneBVH = rendererContainer.SceneBVH;
+                NativeList<int> candidateInstanceIndices = _candidateInstanceIndices;
+                candidateInstanceIndices.Clear();
+                GPUCullingContext gpuCullingContext = default;
+
+                passData.MaxInstanceIndicesCount = 0;
+
+                if (passData.MultiView)
+                {
+                    // All contexts share a single range with the union of their candidates.
+                    var contextCandidateInstanceIndices = new NativeList<int>(Allocator.Temp);
+                    var addedInstances = new NativeBitArray(rendererContainer.InstanceDataBuffer.Capacity, Allocator.Temp);
+
+                    for (int contextIndex = 0; contextIndex < passData.CullingContextCount; contextIndex++)
+                    {
+                        ConstantBufferUtils.FillGPUCullingContext(ref gpuCullingContext, passData.CullingContexts[contextIndex]);
+
+                        contextCandidateInstanceIndices.Clear();
+                        staticInstanceCullingCache.AppendCandidates(gpuCullingContext, sceneBVH, contextCandidateInstanceIndices);
+
+                        foreach (int instanceIndex in contextCandidateInstanceIndices)
+                        {
+                            if (!addedInstances.IsSet(instanceIndex))
+                            {
+                                addedInstances.Set(instanceIndex, true);
+                                candidateInstanceIndices.Add(instanceIndex);
+                            }
+                        }
+                    }
+
+                    contextCandidateInstanceIndices.Dispose();
+                    addedInstances.Dispose();
+
+                    for (int contextIndex = 0; contextIndex < passData.CullingContextCount; contextIndex++)
+                    {
+                        PassData.CullingContext cullingContext = passData.CullingContexts[contextIndex];
+                        cullingContext.InstanceIndicesOffset = 0;
+                        cullingContext.InstanceIndicesCount = candidateInstanceIndices.Length;
+                    }
+
+                    passData.MaxInstanceIndicesCount = candidateInstanceIndices.Length;
+                }
+                else
+                {
+                    for (int contextIndex = 0; contextIndex < passData.CullingContextCount; contextIndex++)
+                    {
+                        PassData.CullingContext cullingContext = passData.CullingContexts[contextIndex];
+                        ConstantBufferUtils.FillGPUCullingContext(ref gpuCullingContext, cullingContext);
+
+                        cullingContext.InstanceIndicesOffset = candidateInstanceIndices.Length;
+                        staticInstanceCullingCache.AppendCandidates(gpuCullingContext, sceneBVH, candidateInstanceIndices);
+                        cullingContext.InstanceIndicesCount = candidateInstanceIndices.Length - cullingContext.InstanceIndicesOffset;
+
+                        passData.MaxInstanceIndicesCount = math.max(passData.MaxInstanceIndicesCount, cullingContext.InstanceIndicesCount);
+                    }
+                }
+
+                passData.CandidateInstanceIndices = candidateInstanceIndices.AsArray();
+                passData.InstanceIndices = builder.CreateTransientBuffer(
+                    new BufferDesc(math.max(1, candidateInstanceIndices.Length), sizeof(uint), GraphicsBuffer.Target.Raw)
+                    {
+                        name = "CandidateInstanceIndices",
+                    }
+                );
+            }
 
             GraphicsBuffer meshletRenderRequestsBuffer = rendererContainer.MeshletRenderRequestsBuffer;
+            passData.MeshletRenderRequestsCapacity =
+                rendererContainer.MeshletRenderRequestByteStridePerContext / UnsafeUtility.SizeOf<AAAAMeshletRenderRequestPacked>();
+            passData.RequestCountsListener = rendererContainer.AdaptiveMeshletRenderRequestCapacity ? rendererContainer : null;
 
             passData.InitialMeshletListCountersBuffer =
                 builder.CreateTransientBuffer(
@@ -230,8 +320,10 @@ namespace DELTation.AAAARP.Passes
                     name = nameof(PassData.MeshletListBuildIndirectDispatchArgsBuffer),
                 }
             );
+            // In multi-view mode, all jobs are emitted to the list of the first context.
+            int meshletListBuildJobListCount = passData.MultiView ? 1 : passData.CullingContextCount;
             passData.MeshletListBuildJobsBuffer = builder.CreateTransientBuffer(
-                new BufferDesc(GPUCullingContext.MaxCullingContextsPerBatch * rendererContainer.MaxMeshletListBuildJobCount,
+                new BufferDesc(math.max(1, meshletListBuildJobListCount * rendererContainer.MaxMeshletListBuildJobCount),
                     UnsafeUtility.SizeOf<AAAAMeshletListBuildJob>(),
                     GraphicsBuffer.Target.Structured
                 )
@@ -287,9 +379,50 @@ namespace DELTation.AAAARP.Passes
                 builder.ReadTexture(resourceData.CameraHZBScaled);
             }
 
-            passData.DebugDataBuffer = _debugDisplaySettings is { RenderingSettings: { DebugGPUCulling: true } } && CullingContextParameterList == null
+            // Only the camera's own culling contributes to the debug counters.
+            passData.DebugDataBuffer = _debugDisplaySettings is { RenderingSettings: { DebugGPUCulling: true } } && noOverrides
                 ? builder.ReadBuffer(frameData.Get<AAAADebugData>().GPUCullingDebugBuffer)
                 : default;
+
+            // The geometry budget follows the game camera only: scene view and preview cameras would fight over the same multiplier.
+            // The main pass clears the counters, and the false negative pass adds to them and reads them back.
+            bool countVisibleGeometry = rendererContainer.GeometryBudget && noOverrides && CullingCameraOverride == null &&
+                                        cameraData.Camera.cameraType == CameraType.Game &&
+                                        _passType is PassType.Main or PassType.FalseNegative;
+            passData.VisibleGeometryCountersBuffer = countVisibleGeometry
+                ? builder.WriteBuffer(renderingData.RenderGraph.ImportBuffer(rendererContainer.VisibleGeometryCountersBuffer))
+                : default;
+            passData.ClearVisibleGeometryCounters = countVisibleGeometry && _passType == PassType.Main;
+            passData.VisibleGeometryListener = countVisibleGeometry && _passType == PassType.FalseNegative ? rendererContainer : null;
+        }
+
+        // The error is measured in the pixels of the view (shadow map texels), and so is the distance falloff: the selection only depends
+        // on the view itself, so cached shadow map tiles stay valid while the main camera moves.
+        // Conservative contexts also keep the detail the main camera would select, so that casters match the receivers.
+        private static LODSelectionContext CreateViewPixelsLODSelectionContext(in CullingViewParameters viewParameters,
+            in LODSelectionContext mainViewLODSelectionContext) =>
+            new()
+            {
+                CameraPosition = viewParameters.CameraPosition,
+                CameraRight = viewParameters.CameraRight,
+                CameraUp = viewParameters.CameraUp,
+                PixelSize = viewParameters.PixelSize,
+                GPUViewProjectionMatrix = viewParameters.GPUViewProjectionMatrix,
+                FixedDistanceSq = viewParameters.IsPerspective ? 0.0f : GetOrthographicLODDistanceSq(viewParameters.ViewProjectionMatrix),
+                ErrorScale = math.max(viewParameters.LODErrorScale, MinLODErrorScale),
+                Conservative = viewParameters.ConservativeLOD,
+                ConservativeGPUViewProjectionMatrix = mainViewLODSelectionContext.GPUViewProjectionMatrix,
+                ConservativeCameraPosition = mainViewLODSelectionContext.CameraPosition,
+                ConservativeCameraUp = mainViewLODSelectionContext.CameraUp,
+                ConservativeCameraRight = mainViewLODSelectionContext.CameraRight,
+                ConservativePixelSize = mainViewLODSelectionContext.PixelSize,
+            };
+
+        // A 90-degree perspective view with the same resolution has texels of the same size at the half extent of the orthographic view.
+        internal static float GetOrthographicLODDistanceSq(in Matrix4x4 viewProjectionMatrix)
+        {
+            var worldToClipX = new Vector3(viewProjectionMatrix.m00, viewProjectionMatrix.m01, viewProjectionMatrix.m02);
+            return 1.0f / worldToClipX.sqrMagnitude;
         }
 
         protected override void Render(PassData data, RenderGraphContext context)
@@ -301,6 +434,11 @@ namespace DELTation.AAAARP.Passes
 
             using (new ProfilingScope(context.cmd, Profiling.InitBuffers))
             {
+                if (data.CandidateInstanceIndices.IsCreated && data.CandidateInstanceIndices.Length > 0)
+                {
+                    context.cmd.SetBufferData(data.InstanceIndices, data.CandidateInstanceIndices);
+                }
+
                 {
                     const Allocator allocator = Allocator.Temp;
                     const NativeArrayOptions arrayOptions = NativeArrayOptions.UninitializedMemory;
@@ -321,6 +459,11 @@ namespace DELTation.AAAARP.Passes
                 _rawBufferClear.FastZeroClear(context.cmd, data.InitialMeshletListCountersBuffer,
                     GPUCullingContext.MaxCullingContextsPerBatch
                 );
+
+                if (data.ClearVisibleGeometryCounters)
+                {
+                    _rawBufferClear.FastZeroClear(context.cmd, data.VisibleGeometryCountersBuffer, AAAARendererContainer.VisibleGeometryCounterCount);
+                }
                 const int rendererListCount = (int) AAAARendererListID.Count;
                 _rawBufferClear.FastZeroClear(context.cmd, data.RendererListMeshletCountsBuffer,
                     rendererListCount * GPUCullingContext.MaxCullingContextsPerBatch
@@ -382,20 +525,20 @@ namespace DELTation.AAAARP.Passes
                 CoreUtils.SetKeyword(context.cmd, _gpuInstanceCullingCS, Keywords.FALSE_NEGATIVE_PASS, _passType == PassType.FalseNegative);
                 CoreUtils.SetKeyword(context.cmd, _gpuInstanceCullingCS, Keywords.VOXELIZATION_PASS, _passType == PassType.Voxelization);
                 CoreUtils.SetKeyword(context.cmd, _gpuInstanceCullingCS, Keywords.DISABLE_OCCLUSION_CULLING, data.DisableOcclusionCulling);
+                CoreUtils.SetKeyword(context.cmd, _gpuInstanceCullingCS, Keywords.MULTI_VIEW, data.MultiView);
                 CoreUtils.SetKeyword(context.cmd, _gpuInstanceCullingCS, Keywords.Debug.DEBUG_GPU_CULLING, data.DebugDataBuffer.IsValid());
 
                 context.cmd.SetComputeConstantBufferParam(_gpuInstanceCullingCS,
                     ShaderID.GPUInstanceCulling._CullingContexts, data.GPUCullingContextBuffer,
                     0, UnsafeUtility.SizeOf<GPUCullingContext>() * data.CullingContextCount
                 );
+                context.cmd.SetComputeIntParam(_gpuInstanceCullingCS,
+                    ShaderID.GPUInstanceCulling._CullingContextCount, data.CullingContextCount
+                );
 
-                context.cmd.SetBufferData(data.InstanceIndices, _instanceIndices.AsArray());
                 context.cmd.SetComputeBufferParam(_gpuInstanceCullingCS, kernelIndex,
                     ShaderID.GPUInstanceCulling._InstanceIndices, data.InstanceIndices
                 );
-                context.cmd.SetComputeIntParam(_gpuInstanceCullingCS,
-                    ShaderID.GPUInstanceCulling._InstanceIndicesCount, data.InstanceCount
-                );
 
                 context.cmd.SetComputeBufferParam(_gpuInstanceCullingCS, kernelIndex,
                     ShaderID.GPUInstanceCulling._Jobs, data.MeshletListBuildJobsBuffer
@@ -416,7 +559,7 @@ namespace DELTation.AAAARP.Passes
 
                 const int groupSize = (int) AAAAMeshletComputeShaders.GPUInstanceCullingThreadGroupSize;
                 context.cmd.DispatchCompute(_gpuInstanceCullingCS, kernelIndex,
-                    AAAAMathUtils.AlignUp(data.InstanceCount, groupSize) / groupSize, data.CullingContextCount, 1
+                    math.max(1, AAAAMathUtils.AlignUp(data.MaxInstanceIndicesCount, groupSize) / groupSize), data.MultiView ? 1 : data.CullingContextCount, 1
                 );
             }
 
@@ -447,11 +590,19 @@ namespace DELTation.AAAARP.Passes
                 context.cmd.SetComputeBufferParam(_meshletListBuildCS, kernelIndex,
                     ShaderID.MeshletListBuild._DestinationMeshlets, data.InitialMeshletListBuffer
                 );
+                context.cmd.SetComputeIntParam(_meshletListBuildCS,
+                    ShaderID.MeshletListBuild._MeshletRenderRequestsCapacity, data.MeshletRenderRequestsCapacity
+                );
                 context.cmd.SetComputeBufferParam(_meshletListBuildCS, kernelIndex,
                     ShaderID.MeshletListBuild._RendererListMeshletCounts, data.RendererListMeshletCountsBuffer
                 );
 
                 context.cmd.DispatchCompute(_meshletListBuildCS, kernelIndex, data.MeshletListBuildIndirectDispatchArgsBuffer, 0);
+
+                if (data.RequestCountsListener != null)
+                {
+                    RequestMeshletRenderRequestCountsReadback(context.cmd, data);
+                }
             }
 
             using (new ProfilingScope(context.cmd, Profiling.FixupMeshletCullingIndirectDispatchArgs))
@@ -472,6 +623,9 @@ namespace DELTation.AAAARP.Passes
                 context.cmd.SetComputeBufferParam(_fixupGPUMeshletCullingIndirectDispatchArgsCS, kernelIndex,
                     ShaderID.FixupMeshletCullingIndirectDispatchArgs._IndirectArgs, data.GPUMeshletCullingIndirectDispatchArgsBuffer
                 );
+                context.cmd.SetComputeIntParam(_fixupGPUMeshletCullingIndirectDispatchArgsCS,
+                    ShaderID.FixupMeshletCullingIndirectDispatchArgs._MeshletRenderRequestsCapacity, data.MeshletRenderRequestsCapacity
+                );
 
                 context.cmd.SetComputeIntParam(_fixupGPUMeshletCullingIndirectDispatchArgsCS,
                     ShaderID.FixupMeshletCullingIndirectDispatchArgs._IndirectDrawArgsOffset, data.IndirectDrawArgsOffset
@@ -495,6 +649,7 @@ namespace DELTation.AAAARP.Passes
                 CoreUtils.SetKeyword(context.cmd, _gpuMeshletCullingCS, Keywords.VOXELIZATION_PASS, _passType == PassType.Voxelization);
                 CoreUtils.SetKeyword(context.cmd, _gpuMeshletCullingCS, Keywords.DISABLE_OCCLUSION_CULLING, data.DisableOcclusionCulling);
                 CoreUtils.SetKeyword(context.cmd, _gpuMeshletCullingCS, Keywords.Debug.DEBUG_GPU_CULLING, data.DebugDataBuffer.IsValid());
+                CoreUtils.SetKeyword(context.cmd, _gpuMeshletCullingCS, Keywords.VISIBLE_GEOMETRY_COUNTERS, data.VisibleGeometryCountersBuffer.IsValid());
 
                 context.cmd.SetComputeConstantBufferParam(_gpuMeshletCullingCS,
                     ShaderID.MeshletCulling._CullingContexts, data.GPUCullingContextBuffer,
@@ -507,6 +662,9 @@ namespace DELTation.AAAARP.Passes
                 context.cmd.SetComputeBufferParam(_gpuMeshletCullingCS, kernelIndex,
                     ShaderID.MeshletCulling._SourceMeshlets, data.InitialMeshletListBuffer
                 );
+                context.cmd.SetComputeIntParam(_gpuMeshletCullingCS,
+                    ShaderID.MeshletCulling._MeshletRenderRequestsCapacity, data.MeshletRenderRequestsCapacity
+                );
 
                 context.cmd.SetComputeBufferParam(_gpuMeshletCullingCS, kernelIndex,
                     ShaderID.MeshletCulling._IndirectDrawArgs, data.IndirectDrawArgsBuffer
@@ -526,10 +684,65 @@ namespace DELTation.AAAARP.Passes
                     );
                 }
 
+                if (data.VisibleGeometryCountersBuffer.IsValid())
+                {
+                    context.cmd.SetComputeBufferParam(_gpuMeshletCullingCS, kernelIndex,
+                        ShaderID.MeshletCulling._VisibleGeometryCounters, data.VisibleGeometryCountersBuffer
+                    );
+                }
+
                 context.cmd.DispatchCompute(_gpuMeshletCullingCS, kernelIndex, data.GPUMeshletCullingIndirectDispatchArgsBuffer, 0);
+
+                if (data.VisibleGeometryListener != null)
+                {
+                    RequestVisibleGeometryCountersReadback(context.cmd, data);
+                }
             }
         }
 
+        private static void RequestVisibleGeometryCountersReadback(CommandBuffer cmd, PassData data)
+        {
+            AAAARendererContainer listener = data.VisibleGeometryListener;
+
+            cmd.RequestAsyncReadback(data.VisibleGeometryCountersBuffer, request =>
+                {
+                    if (request.hasError)
+                    {
+                        return;
+                    }
+
+                    NativeArray<uint> counters = request.GetData<uint>();
+                    listener.ReportVisibleGeometry(counters[0], counters[1]);
+                }
+            );
+        }
+
+        // The counters hold the number of requests each context asked for, including the ones that did not fit.
+        private static void RequestMeshletRenderRequestCountsReadback(CommandBuffer cmd, PassData data)
+        {
+            AAAARendererContainer listener = data.RequestCountsListener;
+            int contextCount = data.CullingContextCount;
+
+            cmd.RequestAsyncReadback(data.InitialMeshletListCountersBuffer, contextCount * sizeof(uint), 0, request =>
+                {
+                    if (request.hasError)
+                    {
+                        return;
+                    }
+
+                    NativeArray<uint> requestCounts = request.GetData<uint>();
+                    uint peakRequestCount = 0;
+
+                    foreach (uint requestCount in requestCounts)
+                    {
+                        peakRequestCount = math.max(peakRequestCount, requestCount);
+                    }
+
+                    listener.ReportMeshletRenderRequestCount(peakRequestCount);
+                }
+            );
+        }
+
         private static class ConstantBufferUtils
         {
             public static unsafe void FillGPUCullingContext(ref GPUCullingContext gpuCullingContext, in PassData.CullingContext cullingContext)
@@ -547,6 +760,8 @@ namespace DELTation.AAAARP.Passes
                     BaseStartInstance = (uint) (cullingContext.MeshletRenderRequestsOffset / UnsafeUtility.SizeOf<AAAAMeshletRenderRequestPacked>()),
                     MeshletListBuildJobsOffset = (uint) cullingContext.MeshletListBuildJobsOffset,
                     MeshletRenderRequestsOffset = (uint) cullingContext.MeshletRenderRequestsOffset,
+                    InstanceIndicesOffset = (uint) cullingContext.InstanceIndicesOffset,
+                    InstanceIndicesCount = (uint) cullingContext.InstanceIndicesCount,
                 };
 
                 fixed (float* pFrustumPlanesDestination = gpuCullingContext.FrustumPlanes)
@@ -570,6 +785,14 @@ namespace DELTation.AAAARP.Passes
                     CameraUp = math.float4(lodSelectionContext.CameraUp, 0),
                     ViewProjectionMatrix = lodSelectionContext.GPUViewProjectionMatrix,
                     ScreenSizePixels = lodSelectionContext.PixelSize,
+                    ErrorScale = lodSelectionContext.ErrorScale,
+                    Conservative = lodSelectionContext.Conservative ? 1u : 0u,
+                    FixedDistanceSq = lodSelectionContext.FixedDistanceSq,
+                    ConservativeViewProjectionMatrix = lodSelectionContext.ConservativeGPUViewProjectionMatrix,
+                    ConservativeCameraPosition = math.float4(lodSelectionContext.ConservativeCameraPosition, 1),
+                    ConservativeCameraUp = math.float4(lodSelectionContext.ConservativeCameraUp, 0),
+                    ConservativeCameraRight = math.float4(lodSelectionContext.ConservativeCameraRight, 0),
+                    ConservativeScreenSizePixels = lodSelectionContext.ConservativePixelSize,
                 };
             }
         }
@@ -587,6 +810,18 @@ namespace DELTation.AAAARP.Passes
             public float4 BoundingSphereWS;
             public bool IsPerspective;
             public AAAAInstancePassMask PassMask;
+            public LODSelectionMode LODSelectionMode;
+            // Only used with LODSelectionMode.ViewPixels.
+            public float LODErrorScale;
+            public bool ConservativeLOD;
+        }
+
+        public enum LODSelectionMode
+        {
+            // LOD error is measured in the pixels of the main camera.
+            MainView,
+            // LOD error is measured in the pixels of the culling view itself, e.g., in shadow map texels.
+            ViewPixels,
         }
 
         public class PassData : PassDataBase
@@ -606,19 +841,31 @@ namespace DELTation.AAAARP.Passes
 
             public BufferHandle InitialMeshletListBuffer;
             public BufferHandle InitialMeshletListCountersBuffer;
+            public int MeshletRenderRequestsCapacity;
 
+            // Per-context instance ranges of InstanceIndices, uploaded in Render. Not created when all contexts share the full instance list.
+            public NativeArray<int> CandidateInstanceIndices;
             public int InstanceCount;
 
             public BufferHandle InstanceIndices;
+            public int MaxInstanceIndicesCount;
 
             public BufferHandle MeshletListBuildIndirectDispatchArgsBuffer;
             public BufferHandle MeshletListBuildJobCountersBuffer;
             public BufferHandle MeshletListBuildJobsBuffer;
+            public bool MultiView;
 
             public BufferHandle OcclusionCullingInstanceVisibilityMask;
             public int OcclusionCullingInstanceVisibilityMaskCount;
 
             public BufferHandle RendererListMeshletCountsBuffer;
+            [CanBeNull]
+            public AAAARendererContainer RequestCountsListener;
+
+            public bool ClearVisibleGeometryCounters;
+            public BufferHandle VisibleGeometryCountersBuffer;
+            [CanBeNull]
+            public AAAARendererContainer VisibleGeometryListener;
 
             public PassData()
             {
@@ -632,6 +879,8 @@ namespace DELTation.AAAARP.Passes
             {
                 public readonly Vector4[] FrustumPlanes = new Vector4[6];
                 public float4 CullingSphereLS;
+                public int InstanceIndicesCount;
+                public int InstanceIndicesOffset;
                 public LODSelectionContext LODSelectionContext;
                 public int MeshletListBuildJobsOffset;
                 public int MeshletRenderRequestsOffset;
@@ -646,6 +895,15 @@ namespace DELTation.AAAARP.Passes
             public Vector3 CameraUp;
             public Vector3 CameraRight;
             public Vector2 PixelSize;
+            public float FixedDistanceSq;
+            public float ErrorScale;
+
+            public bool Conservative;
+            public Matrix4x4 ConservativeGPUViewProjectionMatrix;
+            public Vector3 ConservativeCameraPosition;
+            public Vector3 ConservativeCameraUp;
+            public Vector3 ConservativeCameraRight;
+            public Vector2 ConservativePixelSize;
         }
 
         private static class Profiling
@@ -664,6 +922,8 @@ namespace DELTation.AAAARP.Passes
             public static string FALSE_NEGATIVE_PASS = nameof(FALSE_NEGATIVE_PASS);
             public static string VOXELIZATION_PASS = nameof(VOXELIZATION_PASS);
             public static string DISABLE_OCCLUSION_CULLING = nameof(DISABLE_OCCLUSION_CULLING);
+            public static string MULTI_VIEW = nameof(MULTI_VIEW);
+            public static string VISIBLE_GEOMETRY_COUNTERS = nameof(VISIBLE_GEOMETRY_COUNTERS);
 
             public static class Debug
             {
@@ -682,9 +942,9 @@ namespace DELTation.AAAARP.Passes
             public static class GPUInstanceCulling
             {
                 public static int _CullingContexts = Shader.PropertyToID(nameof(_CullingContexts));
+                public static int _CullingContextCount = Shader.PropertyToID(nameof(_CullingContextCount));
 
                 public static int _InstanceIndices = Shader.PropertyToID(nameof(_InstanceIndices));
-                public static int _InstanceIndicesCount = Shader.PropertyToID(nameof(_InstanceIndicesCount));
 
                 public static int _Jobs = Shader.PropertyToID(nameof(_Jobs));
                 public static int _JobCounters = Shader.PropertyToID(nameof(_JobCounters));
@@ -701,6 +961,7 @@ namespace DELTation.AAAARP.Passes
 
                 public static int _DestinationMeshletsCounter = Shader.PropertyToID(nameof(_DestinationMeshletsCounter));
                 public static int _DestinationMeshlets = Shader.PropertyToID(nameof(_DestinationMeshlets));
+                public static int _MeshletRenderRequestsCapacity = Shader.PropertyToID(nameof(_MeshletRenderRequestsCapacity));
                 public static int _RendererListMeshletCounts = Shader.PropertyToID(nameof(_RendererListMeshletCounts));
             }
 
@@ -711,6 +972,7 @@ namespace DELTation.AAAARP.Passes
 
                 public static int _RequestCounters = Shader.PropertyToID(nameof(_RequestCounters));
                 public static int _IndirectArgs = Shader.PropertyToID(nameof(_IndirectArgs));
+                public static int _MeshletRenderRequestsCapacity = Shader.PropertyToID(nameof(_MeshletRenderRequestsCapacity));
 
                 public static int _IndirectDrawArgsOffset = Shader.PropertyToID(nameof(_IndirectDrawArgsOffset));
                 public static int _RendererListMeshletCounts = Shader.PropertyToID(nameof(_RendererListMeshletCounts));
@@ -723,10 +985,12 @@ namespace DELTation.AAAARP.Passes
 
                 public static int _SourceMeshletsCounters = Shader.PropertyToID(nameof(_SourceMeshletsCounters));
                 public static int _SourceMeshlets = Shader.PropertyToID(nameof(_SourceMeshlets));
+                public static int _MeshletRenderRequestsCapacity = Shader.PropertyToID(nameof(_MeshletRenderRequestsCapacity));
 
                 public static int _IndirectDrawArgs = Shader.PropertyToID(nameof(_IndirectDrawArgs));
                 public static int _IndirectDrawArgsOffset = Shader.PropertyToID(nameof(_IndirectDrawArgsOffset));
                 public static int _DestinationMeshlets = Shader.PropertyToID(nameof(_DestinationMeshlets));
+                public static int _VisibleGeometryCounters = Shader.PropertyToID(nameof(_VisibleGeometryCounters));
             }
         }
     }
@@ -1,8 +1,12 @@
 ﻿using System;
+using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
+using DELTation.AAAARP.Data;
 using DELTation.AAAARP.FrameData;
+using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.RenderPipelineResources;
 using DELTation.AAAARP.Utils;
+using Unity.Mathematics;
 using UnityEngine;
 using UnityEngine.Rendering;
 using UnityEngine.Rendering.RenderGraphModule;
@@ -11,13 +15,23 @@ namespace DELTation.AAAARP.Passes.IBL
 {
     public class ConvolveDiffuseIrradiancePass : AAAARenderPass<ConvolveDiffuseIrradiancePass.PassData>, IDisposable
     {
+        // Keep in sync with the loops in ConvolveDiffuseIrradiance.shader.
+        private const double ConvolutionSampleDelta = 0.025 * 0.1;
+        public const double ConvolutionSamplesPerTexel = 2.0 * Math.PI / ConvolutionSampleDelta * (0.5 * Math.PI / ConvolutionSampleDelta);
+
         private const string TempSideTextureName = nameof(AAAAImageBasedLightingData.DiffuseIrradiance) + "_TempSide";
+        private const int ConvolveShaderPass = 0;
+        private const int EvaluateSH9ShaderPass = 1;
 
         private readonly Material _material;
+        private readonly ComputeShader _projectSH9CS;
         private readonly MaterialPropertyBlock _propertyBlock = new();
 
-        public ConvolveDiffuseIrradiancePass(AAAARenderPassEvent renderPassEvent, AAAARenderPipelineRuntimeShaders runtimeShaders) : base(renderPassEvent) =>
+        public ConvolveDiffuseIrradiancePass(AAAARenderPassEvent renderPassEvent, AAAARenderPipelineRuntimeShaders runtimeShaders) : base(renderPassEvent)
+        {
             _material = CoreUtils.CreateEngineMaterial(runtimeShaders.ConvolveDiffuseIrradiancePS);
+            _projectSH9CS = runtimeShaders.ProjectSH9CS;
+        }
 
         public void Dispose()
         {
@@ -28,20 +42,55 @@ namespace DELTation.AAAARP.Passes.IBL
         {
             AAAAImageBasedLightingData imageBasedLightingData = frameData.Get<AAAAImageBasedLightingData>();
 
-            if (!imageBasedLightingData.DiffuseIrradianceIsDirty)
+            passData.Slices.Clear();
+
+            if (imageBasedLightingData.DiffuseIrradianceIsDirty)
+            {
+                passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.DiffuseIrradiance);
+                imageBasedLightingData.DiffuseIrradianceIsDirty = false;
+            }
+            else if (imageBasedLightingData.DiffuseIrradianceBackBufferIsDirty)
+            {
+                passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.DiffuseIrradianceBackBuffer);
+                imageBasedLightingData.DiffuseIrradianceBackBufferIsDirty = false;
+            }
+            else if (imageBasedLightingData.DiffuseIrradianceSlices.Count > 0)
+            {
+                passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.DiffuseIrradianceBackBuffer);
+                passData.Slices.AddRange(imageBasedLightingData.DiffuseIrradianceSlices);
+            }
+            else
             {
                 passData.CullPass = true;
                 return;
             }
 
             passData.CullPass = false;
-            imageBasedLightingData.DiffuseIrradianceIsDirty = false;
 
             (passData.Source, passData.SourceHDRDecodeValues) = AAAAImageBasedLightingData.GetDefaultProbe();
             passData.Material = _material;
-            passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.DiffuseIrradiance);
 
             RenderTextureDescriptor destinationDesc = imageBasedLightingData.DiffuseIrradianceDesc;
+            passData.Resolution = destinationDesc.width;
+
+            passData.ProjectSH9 = imageBasedLightingData.DiffuseIrradianceSource == AAAAImageBasedLightingSettings.DiffuseIrradianceSource.SH9;
+            if (passData.ProjectSH9)
+            {
+                float sourceMipLevel = math.log2((float) passData.Source.width / AAAASphericalHarmonics.ProjectionResolution);
+                passData.SourceMipLevel = math.clamp(sourceMipLevel, 0.0f, passData.Source.mipmapCount - 1);
+                passData.SH9CoefficientsBuffer = builder.CreateTransientBuffer(
+                    new BufferDesc(AAAASphericalHarmonics.CoefficientCount, sizeof(float) * 4, GraphicsBuffer.Target.Structured)
+                    {
+                        name = nameof(PassData.SH9CoefficientsBuffer),
+                    }
+                );
+            }
+
+            // Slices are rendered straight into the cubemap, so that their rows survive until the next frame.
+            if (passData.Slices.Count > 0)
+            {
+                return;
+            }
 
             var sideDescriptor = new RenderTextureDescriptor(
                 destinationDesc.width, destinationDesc.height,
@@ -66,13 +115,54 @@ namespace DELTation.AAAARP.Passes.IBL
                 return;
             }
 
-            using (new ProfilingScope(context.cmd, Profiling.Convolve))
+            int shaderPass = ConvolveShaderPass;
+
+            if (data.ProjectSH9)
             {
-                ReadOnlySpan<CubemapUtils.SideOrientation> sideOrientations = CubemapUtils.GetSideOrientations();
+                using (new ProfilingScope(context.cmd, Profiling.ProjectSH9))
+                {
+                    const int kernelIndex = 0;
+                    context.cmd.SetComputeTextureParam(_projectSH9CS, kernelIndex, ShaderIDs._Source, data.Source);
+                    context.cmd.SetComputeVectorParam(_projectSH9CS, ShaderIDs._SourceHDRDecodeValues, data.SourceHDRDecodeValues);
+                    context.cmd.SetComputeFloatParam(_projectSH9CS, ShaderIDs._SourceMipLevel, data.SourceMipLevel);
+                    context.cmd.SetComputeBufferParam(_projectSH9CS, kernelIndex, ShaderIDs._SH9Coefficients, data.SH9CoefficientsBuffer);
+                    context.cmd.DispatchCompute(_projectSH9CS, kernelIndex, 1, 1, 1);
+                }
+
+                _propertyBlock.SetBuffer(ShaderIDs._SH9Coefficients, data.SH9CoefficientsBuffer);
+                shaderPass = EvaluateSH9ShaderPass;
+            }
+
+            ReadOnlySpan<CubemapUtils.SideOrientation> sideOrientations = CubemapUtils.GetSideOrientations();
+
+            _propertyBlock.SetTexture(ShaderIDs._Source, data.Source);
+            _propertyBlock.SetVector(ShaderIDs._SourceHDRDecodeValues, data.SourceHDRDecodeValues);
+
+            if (data.Slices.Count > 0)
+            {
+                using (new ProfilingScope(context.cmd, AAAAImageBasedLightingData.TimeSlicedUpdateSampler))
+                {
+                    foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in data.Slices)
+                    {
+                        ref readonly CubemapUtils.SideOrientation sideOrientation = ref sideOrientations[slice.SideIndex];
 
-                _propertyBlock.SetTexture(ShaderIDs._Source, data.Source);
-                _propertyBlock.SetVector(ShaderIDs._SourceHDRDecodeValues, data.SourceHDRDecodeValues);
+                        context.cmd.SetRenderTarget(data.FinalDestination, slice.MipIndex, (CubemapFace) slice.SideIndex);
+                        context.cmd.EnableScissorRect(new Rect(0, slice.FirstRow, data.Resolution >> slice.MipIndex, slice.RowCount));
 
+                        _propertyBlock.SetVector(ShaderIDs._Forward, sideOrientation.Forward);
+                        _propertyBlock.SetVector(ShaderIDs._Up, sideOrientation.Up);
+
+                        AAAABlitter.BlitTriangle(context.cmd, data.Material, shaderPass, _propertyBlock);
+                    }
+
+                    context.cmd.DisableScissorRect();
+                }
+
+                return;
+            }
+
+            using (new ProfilingScope(context.cmd, Profiling.Convolve))
+            {
                 for (int sideIndex = 0; sideIndex < CubemapUtils.SideCount; sideIndex++)
                 {
                     ref readonly CubemapUtils.SideOrientation sideOrientation = ref sideOrientations[sideIndex];
@@ -83,7 +173,6 @@ namespace DELTation.AAAARP.Passes.IBL
                     _propertyBlock.SetVector(ShaderIDs._Up, sideOrientation.Up);
 
                     Material material = data.Material;
-                    const int shaderPass = 0;
                     AAAABlitter.BlitTriangle(context.cmd, material, shaderPass, _propertyBlock);
                 }
             }
@@ -99,19 +188,25 @@ namespace DELTation.AAAARP.Passes.IBL
 
         private static class Profiling
         {
+            public static readonly ProfilingSampler ProjectSH9 = new(nameof(ProjectSH9));
             public static readonly ProfilingSampler Convolve = new(nameof(Convolve));
             public static readonly ProfilingSampler CopyToCubemap = new(nameof(CopyToCubemap));
         }
 
         public class PassData : PassDataBase
         {
+            public readonly List<AAAAImageBasedLightingUpdateScheduler.Slice> Slices = new();
             public readonly TextureHandle[] TempSides = new TextureHandle[CubemapUtils.SideCount];
 
             public bool CullPass;
             public TextureHandle FinalDestination;
             public Material Material;
+            public bool ProjectSH9;
+            public int Resolution;
+            public BufferHandle SH9CoefficientsBuffer;
             public Texture Source;
             public Vector4 SourceHDRDecodeValues;
+            public float SourceMipLevel;
         }
 
         [SuppressMessage("ReSharper", "InconsistentNaming")]
@@ -119,6 +214,8 @@ namespace DELTation.AAAARP.Passes.IBL
         {
             public static readonly int _Source = Shader.PropertyToID(nameof(_Source));
             public static readonly int _SourceHDRDecodeValues = Shader.PropertyToID(nameof(_SourceHDRDecodeValues));
+            public static readonly int _SourceMipLevel = Shader.PropertyToID(nameof(_SourceMipLevel));
+            public static readonly int _SH9Coefficients = Shader.PropertyToID(nameof(_SH9Coefficients));
 
             public static readonly int _Forward = Shader.PropertyToID(nameof(_Forward));
             public static readonly int _Up = Shader.PropertyToID(nameof(_Up));
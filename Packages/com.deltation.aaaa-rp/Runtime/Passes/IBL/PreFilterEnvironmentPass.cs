@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
 using DELTation.AAAARP.FrameData;
+using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.RenderPipelineResources;
 using DELTation.AAAARP.Utils;
 using UnityEngine;
@@ -12,6 +13,9 @@ namespace DELTation.AAAARP.Passes.IBL
 {
     public class PreFilterEnvironmentPass : AAAARenderPass<PreFilterEnvironmentPass.PassData>, IDisposable
     {
+        // Keep in sync with SAMPLE_COUNT in PreFilterEnvironment.shader.
+        public const double SamplesPerTexel = 1024;
+
         private const string TempSideTextureName = nameof(AAAAImageBasedLightingData.PreFilteredEnvironmentMap) + "_TempSide";
 
         private readonly Material _material;
@@ -29,25 +33,41 @@ namespace DELTation.AAAARP.Passes.IBL
         {
             AAAAImageBasedLightingData imageBasedLightingData = frameData.Get<AAAAImageBasedLightingData>();
 
-            if (!imageBasedLightingData.PreFilteredEnvironmentMapIsDirty)
+            passData.Slices.Clear();
+
+            if (imageBasedLightingData.PreFilteredEnvironmentMapIsDirty)
+            {
+                passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.PreFilteredEnvironmentMap);
+                imageBasedLightingData.PreFilteredEnvironmentMapIsDirty = false;
+            }
+            else if (imageBasedLightingData.PreFilteredEnvironmentMapSlices.Count > 0)
+            {
+                passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.PreFilteredEnvironmentMapBackBuffer);
+                passData.Slices.AddRange(imageBasedLightingData.PreFilteredEnvironmentMapSlices);
+            }
+            else
             {
                 passData.CullPass = true;
                 return;
             }
 
             passData.CullPass = false;
-            imageBasedLightingData.PreFilteredEnvironmentMapIsDirty = false;
 
             (passData.Source, passData.SourceHDRDecodeValues) = AAAAImageBasedLightingData.GetDefaultProbe();
             passData.Material = _material;
-            passData.FinalDestination = builder.WriteTexture(imageBasedLightingData.PreFilteredEnvironmentMap);
 
             RenderTextureDescriptor destinationDesc = imageBasedLightingData.PreFilteredEnvironmentMapDesc;
             passData.MipCount = destinationDesc.mipCount;
-
+            passData.Resolution = destinationDesc.width;
 
             passData.TempSides.Clear();
 
+            // Slices are rendered straight into the cubemap, so that their rows survive until the next frame.
+            if (passData.Slices.Count > 0)
+            {
+                return;
+            }
+
             for (int mipIndex = 0; mipIndex < destinationDesc.mipCount; ++mipIndex)
             {
                 var sideDescriptor = new RenderTextureDescriptor(
@@ -75,14 +95,39 @@ namespace DELTation.AAAARP.Passes.IBL
                 return;
             }
 
-            using (new ProfilingScope(context.cmd, Profiling.PreFilter))
+            ReadOnlySpan<CubemapUtils.SideOrientation> sideOrientations = CubemapUtils.GetSideOrientations();
+
+            _propertyBlock.SetTexture(ShaderIDs._Source, data.Source);
+            _propertyBlock.SetVector(ShaderIDs._SourceHDRDecodeValues, data.SourceHDRDecodeValues);
+            _propertyBlock.SetVector(ShaderIDs._SourceResolution, new Vector4(data.Source.width, data.Source.height));
+
+            if (data.Slices.Count > 0)
             {
-                ReadOnlySpan<CubemapUtils.SideOrientation> sideOrientations = CubemapUtils.GetSideOrientations();
+                using (new ProfilingScope(context.cmd, AAAAImageBasedLightingData.TimeSlicedUpdateSampler))
+                {
+                    foreach (AAAAImageBasedLightingUpdateScheduler.Slice slice in data.Slices)
+                    {
+                        ref readonly CubemapUtils.SideOrientation sideOrientation = ref sideOrientations[slice.SideIndex];
+
+                        context.cmd.SetRenderTarget(data.FinalDestination, slice.MipIndex, (CubemapFace) slice.SideIndex);
+                        context.cmd.EnableScissorRect(new Rect(0, slice.FirstRow, data.Resolution >> slice.MipIndex, slice.RowCount));
+
+                        _propertyBlock.SetFloat(ShaderIDs._Roughness, (float) slice.MipIndex / (data.MipCount - 1));
+                        _propertyBlock.SetVector(ShaderIDs._Forward, sideOrientation.Forward);
+                        _propertyBlock.SetVector(ShaderIDs._Up, sideOrientation.Up);
+
+                        const int shaderPass = 0;
+                        AAAABlitter.BlitTriangle(context.cmd, data.Material, shaderPass, _propertyBlock);
+                    }
 
-                _propertyBlock.SetTexture(ShaderIDs._Source, data.Source);
-                _propertyBlock.SetVector(ShaderIDs._SourceHDRDecodeValues, data.SourceHDRDecodeValues);
-                _propertyBlock.SetVector(ShaderIDs._SourceResolution, new Vector4(data.Source.width, data.Source.height));
+                    context.cmd.DisableScissorRect();
+                }
 
+                return;
+            }
+
+            using (new ProfilingScope(context.cmd, Profiling.PreFilter))
+            {
                 for (int mipIndex = 0; mipIndex < data.MipCount; mipIndex++)
                 {
                     float roughness = (float) mipIndex / (data.MipCount - 1);
@@ -128,12 +173,14 @@ namespace DELTation.AAAARP.Passes.IBL
 
         public class PassData : PassDataBase
         {
+            public readonly List<AAAAImageBasedLightingUpdateScheduler.Slice> Slices = new();
             public readonly List<TextureHandle> TempSides = new();
 
             public bool CullPass;
             public TextureHandle FinalDestination;
             public Material Material;
             public int MipCount;
+            public int Resolution;
             public Texture Source;
             public Vector4 SourceHDRDecodeValues;
         }
@@ -1,3 +1,4 @@
+using System;
 using System.Diagnostics.CodeAnalysis;
 using DELTation.AAAARP.Core;
 using DELTation.AAAARP.Data;
@@ -5,6 +6,7 @@ using DELTation.AAAARP.FrameData;
 using DELTation.AAAARP.Lighting;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
+using Unity.Jobs;
 using Unity.Mathematics;
 using UnityEngine;
 using UnityEngine.Rendering;
@@ -12,13 +14,21 @@ using UnityEngine.Rendering.RenderGraphModule;
 
 namespace DELTation.AAAARP.Passes.Lighting
 {
-    public sealed class SetupLightingPass : AAAARenderPass<SetupLightingPass.PassData>
+    public sealed class SetupLightingPass : AAAARenderPass<SetupLightingPass.PassData>, IDisposable
     {
         private const int NoShadowMapIndex = -1;
+        // Covers the 5x5 tent filter footprint.
+        private const float ShadowAtlasTileMarginTexels = 3.0f;
         private readonly GlobalKeywords _globalKeywords;
+        private readonly AAAALightBVH _lightBVH = new();
 
         public SetupLightingPass(AAAARenderPassEvent renderPassEvent) : base(renderPassEvent) => _globalKeywords = GlobalKeywords.Create();
 
+        public void Dispose()
+        {
+            _lightBVH.Dispose();
+        }
+
         protected override void Setup(RenderGraphBuilder builder, PassData passData, ContextContainer frameData)
         {
             AAAARenderingData renderingData = frameData.Get<AAAARenderingData>();
@@ -37,6 +47,9 @@ namespace DELTation.AAAARP.Passes.Lighting
             passData.PunctualLights = punctualLights.AsArray();
             passData.PunctualLightsBuffer = builder.WriteBuffer(lightingData.PunctualLightsBuffer);
 
+            passData.LightBVHNodes = _lightBVH.Nodes;
+            passData.LightBVHNodesBuffer = builder.WriteBuffer(lightingData.LightBVHNodesBuffer);
+
             passData.ShadowLightSlices = shadowLightSlices.AsArray();
             passData.ShadowLightSlicesBuffer = builder.WriteBuffer(shadowsData.ShadowLightSlicesBuffer);
 
@@ -56,73 +69,80 @@ namespace DELTation.AAAARP.Passes.Lighting
             builder.AllowPassCulling(false);
         }
 
-        private static unsafe void FillLightsData(AAAARenderingData renderingData, AAAAShadowsData shadowsData,
+        private unsafe void FillLightsData(AAAARenderingData renderingData, AAAAShadowsData shadowsData,
             ref AAAALightingConstantBuffer lightingConstantBuffer,
             NativeList<AAAAPunctualLightData> punctualLights, NativeList<AAAAShadowLightSlice> shadowLightSlices)
         {
+            NativeArray<VisibleLight> visibleLights = renderingData.CullingResults.visibleLights;
             int maxPunctualLights = renderingData.PipelineAsset.LightingSettings.MaxPunctualLights;
-            lightingConstantBuffer.DirectionalLightCount = 0;
 
-            fixed (AAAALightingConstantBuffer* pConstantBuffer = &lightingConstantBuffer)
+            // Shadow slices need the shadow atlas, so only they are built here. The rest of the punctual light data is packed in a job.
+            var punctualLightShadows =
+                new NativeList<AAAAPunctualLightPacker.PunctualLightShadow>(shadowsData.ShadowLights.Length, Allocator.TempJob);
+
+            for (int shadowLightIndex = 0; shadowLightIndex < shadowsData.ShadowLights.Length; shadowLightIndex++)
             {
-                for (int visibleLightIndex = 0; visibleLightIndex < renderingData.CullingResults.visibleLights.Length; visibleLightIndex++)
+                ref readonly AAAAShadowsData.ShadowLight shadowLight = ref shadowsData.ShadowLights.ElementAtRefReadonly(shadowLightIndex);
+                if (shadowLight.LightType is not (LightType.Point or LightType.Spot))
                 {
-                    ref readonly VisibleLight visibleLight = ref renderingData.CullingResults.visibleLights.ElementAtRefReadonly(visibleLightIndex);
+                    continue;
+                }
 
-                    if (visibleLight.lightType is LightType.Point or LightType.Spot &&
-                        punctualLights.Length < maxPunctualLights)
+                punctualLightShadows.Add(new AAAAPunctualLightPacker.PunctualLightShadow
                     {
-                        AAAAShadowsData.ShadowLight shadowLight = default;
-                        int shadowSplitIndex = -1;
-
-                        if (shadowsData.VisibleToShadowLightMapping.TryGetValue(visibleLightIndex, out int shadowLightIndex))
-                        {
-                            shadowLight = shadowsData.ShadowLights.ElementAtRef(shadowLightIndex);
-                            shadowSplitIndex = shadowLightSlices.Length;
-
-                            foreach (AAAAShadowsData.ShadowLightSplit shadowLightSplit in shadowLight.Splits)
-                            {
-                                shadowLightSlices.Add(BuildShadowLightSlice(renderingData, shadowLightSplit));
-                            }
-                        }
-
-                        AAAAPunctualLightData punctualLightData = ExtractPunctualLightData(visibleLight, shadowLight, shadowSplitIndex);
-                        punctualLights.Add(punctualLightData);
+                        VisibleLightIndex = shadowLight.VisibleLightIndex,
+                        SliceIndex = shadowLightSlices.Length,
+                        FadeParams = shadowLight.FadeParams,
+                        IsSoftShadow = shadowLight.IsSoftShadow,
+                        ShadowStrength = shadowLight.ShadowStrength,
                     }
+                );
+                AddShadowLightSlices(renderingData, shadowLight, shadowLightSlices);
+            }
+
+            var packedPunctualLights = new NativeList<AAAAPunctualLightData>(math.min(visibleLights.Length, maxPunctualLights), Allocator.TempJob);
+            var directionalLightIndices = new NativeList<int>(AAAALightingConstantBuffer.MaxDirectionalLights, Allocator.TempJob);
+            JobHandle handle = AAAAPunctualLightPacker.Schedule(visibleLights, punctualLightShadows.AsArray(), maxPunctualLights,
+                packedPunctualLights, directionalLightIndices
+            );
+            _lightBVH.ScheduleBuild(packedPunctualLights, handle).Complete();
+
+            punctualLights.AddRange(packedPunctualLights.AsArray());
+            lightingConstantBuffer.PunctualLightCount = (uint) punctualLights.Length;
+            lightingConstantBuffer.LightBVHNodeCount = (uint) _lightBVH.NodeCount;
+            lightingConstantBuffer.DirectionalLightCount = (uint) directionalLightIndices.Length;
 
-                    if (visibleLight.lightType == LightType.Directional &&
-                        lightingConstantBuffer.DirectionalLightCount < AAAALightingConstantBuffer.MaxDirectionalLights)
+            fixed (AAAALightingConstantBuffer* pConstantBuffer = &lightingConstantBuffer)
+            {
+                for (int index = 0; index < directionalLightIndices.Length; index++)
+                {
+                    int visibleLightIndex = directionalLightIndices[index];
+                    ref readonly VisibleLight visibleLight = ref visibleLights.ElementAtRefReadonly(visibleLightIndex);
+                    var shadowSliceRangeFadeParams = new float4(0, 0, 0, 0);
+                    bool isSoftShadow = false;
+                    float shadowStrength = 1.0f;
+
+                    if (shadowsData.VisibleToShadowLightMapping.TryGetValue(visibleLightIndex, out int shadowLightIndex))
                     {
-                        int index = (int) lightingConstantBuffer.DirectionalLightCount++;
-                        var shadowSliceRangeFadeParams = new float4(0, 0, 0, 0);
-                        bool isSoftShadow = false;
-                        float shadowStrength = 1.0f;
-
-                        if (shadowsData.VisibleToShadowLightMapping.TryGetValue(visibleLightIndex, out int shadowLightIndex))
-                        {
-                            ref readonly AAAAShadowsData.ShadowLight shadowLight = ref shadowsData.ShadowLights.ElementAtRef(shadowLightIndex);
-
-                            shadowSliceRangeFadeParams.x = shadowLightSlices.Length;
-                            shadowSliceRangeFadeParams.y = shadowLight.Splits.Length;
-                            shadowSliceRangeFadeParams.zw = shadowLight.FadeParams;
-                            isSoftShadow = shadowLight.IsSoftShadow;
-                            shadowStrength = shadowLight.ShadowStrength;
-
-                            foreach (AAAAShadowsData.ShadowLightSplit shadowLightSplit in shadowLight.Splits)
-                            {
-                                shadowLightSlices.Add(BuildShadowLightSlice(renderingData, shadowLightSplit));
-                            }
-                        }
-
-                        UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightColors, index) =
-                            (Vector4) visibleLight.finalColor;
-                        UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightDirections, index) =
-                            math.float4(AAAALightingUtils.ExtractDirection(visibleLight.localToWorldMatrix), 0.0f);
-                        UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightShadowSliceRanges_ShadowFadeParams, index) =
-                            shadowSliceRangeFadeParams;
-                        UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightShadowParams, index) =
-                            PackShadowParams(isSoftShadow, shadowStrength);
+                        ref readonly AAAAShadowsData.ShadowLight shadowLight = ref shadowsData.ShadowLights.ElementAtRef(shadowLightIndex);
+
+                        shadowSliceRangeFadeParams.x = shadowLightSlices.Length;
+                        shadowSliceRangeFadeParams.y = shadowLight.Splits.Length;
+                        shadowSliceRangeFadeParams.zw = shadowLight.FadeParams;
+                        isSoftShadow = shadowLight.IsSoftShadow;
+                        shadowStrength = shadowLight.ShadowStrength;
+
+                        AddShadowLightSlices(renderingData, shadowLight, shadowLightSlices);
                     }
+
+                    UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightColors, index) =
+                        (Vector4) visibleLight.finalColor;
+                    UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightDirections, index) =
+                        math.float4(AAAALightingUtils.ExtractDirection(visibleLight.localToWorldMatrix), 0.0f);
+                    UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightShadowSliceRanges_ShadowFadeParams, index) =
+                        shadowSliceRangeFadeParams;
+                    UnsafeUtility.ArrayElementAsRef<float4>(pConstantBuffer->DirectionalLightShadowParams, index) =
+                        AAAAPunctualLightPacker.PackShadowParams(isSoftShadow, shadowStrength);
                 }
 
                 if (lightingConstantBuffer.DirectionalLightCount == 0)
@@ -134,68 +154,39 @@ namespace DELTation.AAAARP.Passes.Lighting
                 }
             }
 
-            lightingConstantBuffer.PunctualLightCount = (uint) punctualLights.Length;
+            punctualLightShadows.Dispose();
+            packedPunctualLights.Dispose();
+            directionalLightIndices.Dispose();
+        }
+
+        private static void AddShadowLightSlices(AAAARenderingData renderingData, in AAAAShadowsData.ShadowLight shadowLight,
+            NativeList<AAAAShadowLightSlice> shadowLightSlices)
+        {
+            foreach (AAAAShadowsData.ShadowLightSplit shadowLightSplit in shadowLight.Splits)
+            {
+                shadowLightSlices.Add(BuildShadowLightSlice(renderingData, shadowLightSplit));
+            }
         }
 
         private static AAAAShadowLightSlice BuildShadowLightSlice(AAAARenderingData renderingData, in AAAAShadowsData.ShadowLightSplit shadowLightSplit)
         {
-            float2 resolution = shadowLightSplit.CullingView.PixelSize;
             float4 boundingSphere = shadowLightSplit.CullingView.BoundingSphereWS;
-            AAAARenderTexturePool shadowMapPool = renderingData.RtPoolSet.ShadowMap;
+            AAAAShadowAtlas shadowAtlas = renderingData.RtPoolSet.ShadowMap;
+            ref readonly AAAAShadowAtlasAllocator.Allocation allocation = ref shadowLightSplit.ShadowMapAllocation;
+            float2 resolution = shadowAtlas.PageSize;
+            Matrix4x4 worldToShadowCoords = AAAAShadowUtils.GetWorldToShadowCoordsMatrix(shadowLightSplit.CullingView.ViewProjectionMatrix);
             var shadowLightSlice = new AAAAShadowLightSlice
             {
                 BoundingSphere = math.float4(boundingSphere.xyz, boundingSphere.w * boundingSphere.w),
                 AtlasSize = math.float4(1.0f / resolution, resolution),
-                WorldToShadowCoords = AAAAShadowUtils.GetWorldToShadowCoordsMatrix(shadowLightSplit.CullingView.ViewProjectionMatrix),
-                BindlessShadowMapIndex = shadowMapPool.GetBindlessSRVIndexOrDefault(shadowLightSplit.ShadowMapAllocation, NoShadowMapIndex),
+                AtlasTileBounds = shadowAtlas.GetTileBounds(allocation, ShadowAtlasTileMarginTexels),
+                WorldToShadowCoords = shadowAtlas.GetTileTransform(allocation) * worldToShadowCoords,
+                BindlessShadowMapIndex = shadowAtlas.GetBindlessSRVIndexOrDefault(allocation, NoShadowMapIndex),
             };
 
             return shadowLightSlice;
         }
 
-        private static AAAAPunctualLightData ExtractPunctualLightData(in VisibleLight visibleLight, in AAAAShadowsData.ShadowLight shadowLight, int sliceIndex)
-        {
-            Matrix4x4 lightLocalToWorld = visibleLight.localToWorldMatrix;
-            var punctualLightData = new AAAAPunctualLightData();
-
-            punctualLightData.Color_Radius.xyz = ((float4) (Vector4) visibleLight.finalColor).xyz;
-            punctualLightData.Color_Radius.w = visibleLight.range;
-
-            punctualLightData.PositionWS.xyz = lightLocalToWorld.GetPosition();
-            if (visibleLight.lightType == LightType.Spot)
-            {
-                punctualLightData.SpotDirection_Angle.xyz = AAAALightingUtils.ExtractDirection(lightLocalToWorld);
-                punctualLightData.SpotDirection_Angle.w = Mathf.Deg2Rad * visibleLight.spotAngle * 0.5f;
-            }
-            else
-            {
-                punctualLightData.SpotDirection_Angle = default;
-            }
-
-            AAAAPunctualLightUtils.GetPunctualLightDistanceAttenuation(visibleLight,
-                out punctualLightData.Attenuations.x
-            );
-            float innerSpotAngle = visibleLight.spotAngle * 0.6f;
-            AAAAPunctualLightUtils.GetPunctualLightSpotAngleAttenuation(visibleLight, innerSpotAngle, out punctualLightData.Attenuations.y,
-                out punctualLightData.Attenuations.z
-            );
-
-            if (sliceIndex != -1)
-            {
-                punctualLightData.ShadowSliceIndex_ShadowFadeParams.x = sliceIndex;
-                punctualLightData.ShadowSliceIndex_ShadowFadeParams.zw = shadowLight.FadeParams;
-                punctualLightData.ShadowParams = PackShadowParams(shadowLight.IsSoftShadow, shadowLight.ShadowStrength);
-            }
-            else
-            {
-                punctualLightData.ShadowSliceIndex_ShadowFadeParams.x = -1;
-            }
-
-            return punctualLightData;
-        }
-
-        private static float4 PackShadowParams(bool isSoftShadow, float shadowStrength) => math.float4(isSoftShadow ? 1 : 0, shadowStrength, 0, 0);
-
         protected override void Render(PassData data, RenderGraphContext context)
         {
             ConstantBuffer.PushGlobal(context.cmd, data.LightingData.LightingConstantBuffer, ShaderPropertyID.LightingConstantBuffer);
@@ -203,6 +194,9 @@ namespace DELTation.AAAARP.Passes.Lighting
             context.cmd.SetBufferData(data.PunctualLightsBuffer, data.PunctualLights);
             context.cmd.SetGlobalBuffer(ShaderPropertyID._PunctualLights, data.PunctualLightsBuffer);
 
+            context.cmd.SetBufferData(data.LightBVHNodesBuffer, data.LightBVHNodes);
+            context.cmd.SetGlobalBuffer(ShaderPropertyID._LightBVHNodes, data.LightBVHNodesBuffer);
+
             context.cmd.SetBufferData(data.ShadowLightSlicesBuffer, data.ShadowLightSlices);
             context.cmd.SetGlobalBuffer(ShaderPropertyID._ShadowLightSlices, data.ShadowLightSlicesBuffer);
 
@@ -254,6 +248,8 @@ namespace DELTation.AAAARP.Passes.Lighting
             public AAAAAmbientOcclusionTechnique AmbientOcclusionTechnique;
             public TextureHandle BRDFLut;
             public TextureHandle DiffuseIrradianceCubemap;
+            public NativeArray<AAAALightBVHNode> LightBVHNodes;
+            public BufferHandle LightBVHNodesBuffer;
             public AAAALightingData LightingData;
             public TextureHandle PreFilteredEnvironmentMap;
             public float PreFilteredEnvironmentMapMaxLOD;
@@ -271,6 +267,7 @@ namespace DELTation.AAAARP.Passes.Lighting
         {
             public static readonly int LightingConstantBuffer = Shader.PropertyToID(nameof(AAAALightingConstantBuffer));
             public static readonly int _PunctualLights = Shader.PropertyToID(nameof(_PunctualLights));
+            public static readonly int _LightBVHNodes = Shader.PropertyToID(nameof(_LightBVHNodes));
             public static readonly int _ShadowLightSlices = Shader.PropertyToID(nameof(_ShadowLightSlices));
 
             public static readonly int aaaa_DiffuseIrradianceCubemap = Shader.PropertyToID(nameof(aaaa_DiffuseIrradianceCubemap));
@@ -4,6 +4,7 @@ using DELTation.AAAARP.Core;
 using DELTation.AAAARP.FrameData;
 using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.Renderers;
+using DELTation.AAAARP.Utils;
 using Unity.Collections;
 using UnityEngine;
 using UnityEngine.Rendering;
@@ -13,7 +14,10 @@ namespace DELTation.AAAARP.Passes.Shadows
 {
     public class DrawShadowsBatchedPass : AAAARenderPass<DrawShadowsBatchedPass.PassData>
     {
-        public DrawShadowsBatchedPass(AAAARenderPassEvent renderPassEvent) : base(renderPassEvent) { }
+        private readonly Material _clearTileMaterial;
+
+        public DrawShadowsBatchedPass(AAAARenderPassEvent renderPassEvent, Material clearTileMaterial) : base(renderPassEvent) =>
+            _clearTileMaterial = clearTileMaterial;
 
         public int ShadowLightIndex { get; set; }
         public int SplitIndex { get; set; }
@@ -55,9 +59,11 @@ namespace DELTation.AAAARP.Passes.Shadows
             passData.CameraType = cameraData.CameraType;
             passData.ZClip = shadowLightSplit.CullingView.IsPerspective ? 1.0f : 0.0f;
 
-            AAAARenderTexturePool shadowMapPool = renderingData.RtPoolSet.ShadowMap;
-            RenderTexture shadowMap = shadowMapPool.LookupRenderTexture(shadowLightSplit.ShadowMapAllocation);
+            AAAAShadowAtlas shadowAtlas = renderingData.RtPoolSet.ShadowMap;
+            RenderTexture shadowMap = shadowAtlas.LookupRenderTexture(shadowLightSplit.ShadowMapAllocation.PageIndex);
             passData.ShadowMap = shadowMap;
+            passData.Viewport = AAAAShadowAtlas.GetTileViewport(shadowLightSplit.ShadowMapAllocation);
+            passData.ClearTileMaterial = _clearTileMaterial;
 
             builder.AllowPassCulling(false);
         }
@@ -66,8 +72,10 @@ namespace DELTation.AAAARP.Passes.Shadows
         {
             using var _ = new ProfilingScope(context.cmd, Profiling.GetShadowLightPassSampler(ShadowLightIndex, SplitIndex));
 
+            // The other tiles of the page may hold cached depth, so only this tile is cleared.
             context.cmd.SetRenderTarget(data.ShadowMap);
-            context.cmd.ClearRenderTarget(RTClearFlags.Depth, Color.clear, 1.0f, 0);
+            context.cmd.SetViewport(data.Viewport);
+            AAAABlitter.BlitTriangle(context.cmd, data.ClearTileMaterial, 0);
 
             // these values match HDRP defaults (see https://github.com/Unity-Technologies/Graphics/blob/9544b8ed2f98c62803d285096c91b44e9d8cbc47/com.unity.render-pipelines.high-definition/Runtime/Lighting/Shadow/HDShadowAtlas.cs#L197 )
             context.cmd.SetGlobalDepthBias(1.0f, data.SlopeBias);
@@ -99,7 +107,9 @@ namespace DELTation.AAAARP.Passes.Shadows
         {
             public CameraType CameraType;
             public AAAARendererContainer RendererContainer;
+            public Material ClearTileMaterial;
             public RenderTargetIdentifier ShadowMap;
+            public Rect Viewport;
             public AAAAShadowRenderingConstantBuffer ShadowRenderingConstantBuffer;
             public float SlopeBias;
             public float ZClip;
@@ -3,6 +3,8 @@ using System.Collections.Generic;
 using DELTation.AAAARP.Debugging;
 using DELTation.AAAARP.RenderPipelineResources;
 using DELTation.AAAARP.Utils;
+using UnityEngine;
+using UnityEngine.Rendering;
 
 namespace DELTation.AAAARP.Passes.Shadows
 {
@@ -11,6 +13,7 @@ namespace DELTation.AAAARP.Passes.Shadows
         private const string NameTag = "Shadows";
 
         private readonly List<GPUCullingPass> _cullingPasses = new();
+        private readonly Material _clearShadowTileMaterial;
         private readonly AAAARenderPipelineDebugDisplaySettings _debugSettings;
         private readonly List<DrawShadowsBatchedPass> _drawShadowsPasses = new();
         private readonly AAAARawBufferClear _rawBufferClear;
@@ -26,24 +29,27 @@ namespace DELTation.AAAARP.Passes.Shadows
             _shaders = shaders;
             _rawBufferClear = rawBufferClear;
             _renderPassEvent = renderPassEvent;
+            _clearShadowTileMaterial = CoreUtils.CreateEngineMaterial(shaders.ClearShadowTilePS);
         }
 
         public void Dispose()
         {
-            foreach (GPUCullingPass gpuCullingPass in _cullingPasses)
+            _drawShadowsPasses.Clear();
+
+            foreach (GPUCullingPass cullingPass in _cullingPasses)
             {
-                gpuCullingPass.Dispose();
+                cullingPass.Dispose();
             }
 
-            _drawShadowsPasses.Clear();
             _cullingPasses.Clear();
+            CoreUtils.Destroy(_clearShadowTileMaterial);
         }
 
         public DrawShadowsBatchedPass RequestDrawPass(int shadowLightIndex, int splitIndex, int contextIndex)
         {
             while (_drawPassOffset >= _drawShadowsPasses.Count)
             {
-                _drawShadowsPasses.Add(new DrawShadowsBatchedPass(_renderPassEvent));
+                _drawShadowsPasses.Add(new DrawShadowsBatchedPass(_renderPassEvent, _clearShadowTileMaterial));
             }
 
             DrawShadowsBatchedPass pass = _drawShadowsPasses[_drawPassOffset];
@@ -54,7 +60,7 @@ namespace DELTation.AAAARP.Passes.Shadows
             return pass;
         }
 
-        public GPUCullingPass RequestCullingPass(List<GPUCullingPass.CullingViewParameters> cullingContexts)
+        public GPUCullingPass RequestCullingPass(List<GPUCullingPass.CullingViewParameters> cullingContexts, bool multiView)
         {
             while (_cullingPassOffset >= _cullingPasses.Count)
             {
@@ -64,6 +70,7 @@ namespace DELTation.AAAARP.Passes.Shadows
             GPUCullingPass pass = _cullingPasses[_cullingPassOffset];
             pass.CullingContextParameterList.Clear();
             pass.CullingContextParameterList.AddRange(cullingContexts);
+            pass.MultiView = multiView;
             ++_cullingPassOffset;
             return pass;
         }
@@ -25,10 +25,22 @@ namespace DELTation.AAAARP.RenderPipelineResources
         [ResourcePath("Shaders/Utils/RawBufferClear.compute")]
         private ComputeShader _rawBufferClearCS;
 
+        [SerializeField]
+        [ResourcePath("Shaders/Utils/ScatterUpload.compute")]
+        private ComputeShader _scatterUploadCS;
+
+        [SerializeField]
+        [ResourcePath("Shaders/Utils/ClearShadowTile.shader")]
+        private Shader _clearShadowTilePS;
+
         [SerializeField]
         [ResourcePath("Shaders/IBL/ConvolveDiffuseIrradiance.shader")]
         private Shader _convolveDiffuseIrradiancePS;
 
+        [SerializeField]
+        [ResourcePath("Shaders/IBL/ProjectSH9.compute")]
+        private ComputeShader _projectSH9CS;
+
         [SerializeField]
         [ResourcePath("Shaders/IBL/BRDFIntegration.shader")]
         private Shader _brdfIntegrationPS;
@@ -69,6 +81,10 @@ namespace DELTation.AAAARP.RenderPipelineResources
         [ResourcePath("Shaders/ClusteredLighting/ClusterCulling.compute")]
         private ComputeShader _clusterCullingCS;
 
+        [SerializeField]
+        [ResourcePath("Shaders/ClusteredLighting/MarkActiveClusters.compute")]
+        private ComputeShader _markActiveClustersCS;
+
         [SerializeField]
         [ResourcePath("Shaders/Lighting/DeferredLighting.shader")]
         private Shader _deferredLightingPS;
@@ -107,12 +123,30 @@ namespace DELTation.AAAARP.RenderPipelineResources
             set => this.SetValueAndNotify(ref _rawBufferClearCS, value, nameof(_rawBufferClearCS));
         }
 
+        public ComputeShader ScatterUploadCS
+        {
+            get => _scatterUploadCS;
+            set => this.SetValueAndNotify(ref _scatterUploadCS, value, nameof(_scatterUploadCS));
+        }
+
+        public Shader ClearShadowTilePS
+        {
+            get => _clearShadowTilePS;
+            set => this.SetValueAndNotify(ref _clearShadowTilePS, value, nameof(_clearShadowTilePS));
+        }
+
         public Shader ConvolveDiffuseIrradiancePS
         {
             get => _convolveDiffuseIrradiancePS;
             set => this.SetValueAndNotify(ref _convolveDiffuseIrradiancePS, value, nameof(_convolveDiffuseIrradiancePS));
         }
 
+        public ComputeShader ProjectSH9CS
+        {
+            get => _projectSH9CS;
+            set => this.SetValueAndNotify(ref _projectSH9CS, value, nameof(_projectSH9CS));
+        }
+
         public Shader BRDFIntegrationPS
         {
             get => _brdfIntegrationPS;
@@ -179,6 +213,12 @@ namespace DELTation.AAAARP.RenderPipelineResources
             set => this.SetValueAndNotify(ref _clusterCullingCS, value, nameof(_clusterCullingCS));
         }
 
+        public ComputeShader MarkActiveClustersCS
+        {
+            get => _markActiveClustersCS;
+            set => this.SetValueAndNotify(ref _markActiveClustersCS, value, nameof(_markActiveClustersCS));
+        }
+
         public Shader DeferredLightingPS
         {
             get => _deferredLightingPS;
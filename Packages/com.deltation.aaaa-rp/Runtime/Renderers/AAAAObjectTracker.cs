@@ -1,6 +1,7 @@
 ﻿using System;
 using System.Collections.Generic;
 using DELTation.AAAARP.Core.ObjectDispatching;
+using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.Materials;
 using Unity.Collections;
 using Unity.Mathematics;
@@ -16,7 +17,7 @@ namespace DELTation.AAAARP.Renderers
         private readonly TextureTracker _textureTracker;
 
         internal AAAAObjectTracker(InstanceDataBuffer instanceDataBuffer, MaterialDataBuffer materialDataBuffer,
-            BindlessTextureContainer bindlessTextureContainer)
+            BindlessTextureContainer bindlessTextureContainer, AAAAShadowCacheInvalidationTracker shadowCacheInvalidationTracker)
         {
             _authoringTracker = new AuthoringTracker(instanceDataBuffer, ObjectDispatcherService.TypeTrackingFlags.SceneObjects);
             ObjectDispatcherService.RegisterObjectTracker(_authoringTracker);
@@ -24,7 +25,7 @@ namespace DELTation.AAAARP.Renderers
             _textureTracker = new TextureTracker(bindlessTextureContainer, ObjectDispatcherService.TypeTrackingFlags.Assets);
             ObjectDispatcherService.RegisterObjectTracker(_textureTracker);
 
-            _materialTracker = new MaterialTracker(materialDataBuffer, ObjectDispatcherService.TypeTrackingFlags.Assets);
+            _materialTracker = new MaterialTracker(materialDataBuffer, shadowCacheInvalidationTracker, ObjectDispatcherService.TypeTrackingFlags.Assets);
             ObjectDispatcherService.RegisterObjectTracker(_materialTracker);
         }
 
@@ -76,15 +77,22 @@ namespace DELTation.AAAARP.Renderers
         private class MaterialTracker : ObjectTracker<AAAAMaterialAsset>
         {
             private readonly MaterialDataBuffer _materialDataBuffer;
+            private readonly AAAAShadowCacheInvalidationTracker _shadowCacheInvalidationTracker;
 
-            public MaterialTracker(MaterialDataBuffer materialDataBuffer, ObjectDispatcherService.TypeTrackingFlags trackingFlags) : base(trackingFlags) =>
+            public MaterialTracker(MaterialDataBuffer materialDataBuffer, AAAAShadowCacheInvalidationTracker shadowCacheInvalidationTracker,
+                ObjectDispatcherService.TypeTrackingFlags trackingFlags) : base(trackingFlags)
+            {
                 _materialDataBuffer = materialDataBuffer;
+                _shadowCacheInvalidationTracker = shadowCacheInvalidationTracker;
+            }
 
             public override void ProcessData(List<Object> changed, NativeArray<int> changedID, NativeArray<int> destroyedID)
             {
                 if (changed.Count > 0)
                 {
                     _materialDataBuffer.OnMaterialAssetsChanged(changed, changedID);
+                    // Alpha clipping and culling settings affect the shadow casters.
+                    _shadowCacheInvalidationTracker.InvalidateAll();
                 }
             }
         }
@@ -0,0 +1,51 @@
+using System.Collections.Generic;
+using UnityEngine.Assertions;
+
+namespace DELTation.AAAARP.Renderers
+{
+    // Delays freeing resources whose reference count dropped to zero, since the GPU may still be reading them for a few frames.
+    // Each ID is queued at most once: releasing it again restarts the delay, and retaining it cancels the release.
+    internal sealed class AAAAPendingReleaseQueue
+    {
+        private readonly Dictionary<int, int> _lastReleaseFrames = new();
+        private readonly List<int> _expiredIDs = new();
+
+        public AAAAPendingReleaseQueue(int latencyFrames)
+        {
+            Assert.IsTrue(latencyFrames >= 0);
+            LatencyFrames = latencyFrames;
+        }
+
+        public int LatencyFrames { get; }
+
+        public int Count => _lastReleaseFrames.Count;
+
+        public bool Contains(int id) => _lastReleaseFrames.ContainsKey(id);
+
+        public void Release(int id, int frameIndex) => _lastReleaseFrames[id] = frameIndex;
+
+        public bool Cancel(int id) => _lastReleaseFrames.Remove(id);
+
+        // Returns the IDs whose last release is at least LatencyFrames old and forgets them.
+        // The returned list is reused by the next call.
+        public List<int> CollectExpired(int frameIndex)
+        {
+            _expiredIDs.Clear();
+
+            foreach (KeyValuePair<int, int> kvp in _lastReleaseFrames)
+            {
+                if (frameIndex - kvp.Value >= LatencyFrames)
+                {
+                    _expiredIDs.Add(kvp.Key);
+                }
+            }
+
+            foreach (int id in _expiredIDs)
+            {
+                _lastReleaseFrames.Remove(id);
+            }
+
+            return _expiredIDs;
+        }
+    }
+}
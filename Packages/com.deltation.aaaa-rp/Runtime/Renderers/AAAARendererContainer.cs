@@ -3,8 +3,10 @@ using System.Collections.Generic;
 using System.Diagnostics.CodeAnalysis;
 using DELTation.AAAARP.Core;
 using DELTation.AAAARP.Core.ObjectDispatching;
+using DELTation.AAAARP.Culling;
 using DELTation.AAAARP.Data;
 using DELTation.AAAARP.Debugging;
+using DELTation.AAAARP.Lighting;
 using DELTation.AAAARP.Meshlets;
 using DELTation.AAAARP.Passes;
 using DELTation.AAAARP.RenderPipelineResources;
@@ -14,6 +16,7 @@ using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using Unity.Mathematics;
 using UnityEngine;
+using UnityEngine.Assertions;
 using UnityEngine.Rendering;
 
 namespace DELTation.AAAARP.Renderers
@@ -27,27 +30,63 @@ namespace DELTation.AAAARP.Renderers
             ShadowCaster = 1,
         }
 
+        public const int DefaultCullingContextCapacity = 8;
+        // Visible meshlets and visible triangles.
+        public const int VisibleGeometryCounterCount = 2;
+
+        // Geometry of meshes that are no longer referenced is kept alive for a few frames, since the GPU may still be reading it.
+        private const int MeshReleaseLatencyFrames = 3;
+
+        // The capacity follows the largest batch requested each frame exactly. Every context costs a full request list,
+        // so it shrinks back once the larger batches have not been requested for a while.
+        private static readonly AAAAReadbackCapacityPolicy.Settings CullingContextCapacityPolicySettings = new()
+        {
+            Headroom = 0.0f,
+            GrowThreshold = 1.0f,
+            ShrinkThreshold = 1.0f,
+            ShrinkDelay = 120,
+            Granularity = 1,
+            MinCapacity = DefaultCullingContextCapacity,
+        };
+
         private readonly BindlessTextureContainer _bindlessTextureContainer;
 
         [CanBeNull]
         private readonly AAAARenderPipelineDebugDisplaySettings _debugDisplaySettings;
+        private readonly AAAAGeometryBudgetController _geometryBudgetController = new();
         private readonly MaterialDataBuffer _materialDataBuffer;
         private readonly MaterialPropertyBlock _materialPropertyBlock = new();
         private readonly Dictionary<int, MeshMetadata> _meshInstanceIDToMetadata = new();
         private readonly AAAAMeshLODSettings _meshLODSettings;
+        private readonly AAAAReadbackCapacityPolicy _cullingContextCapacityPolicy = new(CullingContextCapacityPolicySettings);
+        private readonly AAAAReadbackCapacityPolicy _meshletRenderRequestCapacityPolicy = new();
 
         private readonly AAAAObjectTracker _objectTracker;
+        private readonly AAAAPendingReleaseQueue _pendingMeshReleases = new(MeshReleaseLatencyFrames);
         private readonly RendererList[] _rendererLists;
+        private int _frameIndex;
+        private bool _hasReportedMeshletRenderRequestCounts;
         private bool _isDirty;
+        private uint _lastVisibleMeshlets;
+        private uint _lastVisibleTriangles;
+        private uint _reportedMeshletRenderRequestPeak;
+        private int _requestedCullingContextCapacity = DefaultCullingContextCapacity;
+        private int _shadowCacheForcedMeshLODNodeDepth;
+        private float _shadowCacheMeshLODErrorThreshold;
+        private int _worstCaseMeshletRenderRequestsPerList;
 
         private NativeList<AAAAMeshlet> _meshletData;
+        private AAAARangeAllocator _meshletDataFreeRanges;
         private GraphicsBuffer _meshletsDataBuffer;
         private NativeList<AAAAMeshLODNode> _meshLODNodes;
         private GraphicsBuffer _meshLODNodesBuffer;
+        private AAAARangeAllocator _meshLODNodesFreeRanges;
         private GraphicsBuffer _sharedIndexBuffer;
         private NativeList<byte> _sharedIndices;
+        private AAAARangeAllocator _sharedIndicesFreeRanges;
         private GraphicsBuffer _sharedVertexBuffer;
         private NativeList<AAAAMeshletVertex> _sharedVertices;
+        private AAAARangeAllocator _sharedVerticesFreeRanges;
 
         internal AAAARendererContainer(BindlessTextureContainer bindlessTextureContainer, AAAAMeshLODSettings meshLODSettings,
             AAAARawBufferClear rawBufferClear,
@@ -58,15 +97,29 @@ namespace DELTation.AAAARP.Renderers
 
             _meshLODSettings = meshLODSettings;
             _debugDisplaySettings = debugDisplaySettings;
-            _materialDataBuffer = new MaterialDataBuffer(_bindlessTextureContainer, Allocator.Persistent);
-            InstanceDataBuffer = new InstanceDataBuffer(this, _materialDataBuffer, Allocator.Persistent);
-            OcclusionCullingResources = new OcclusionCullingResources(rawBufferClear);
+            StaticInstanceCullingCache = new AAAAStaticInstanceCullingCache(Allocator.Persistent);
+            SceneBVH = new AAAASceneBVH(Allocator.Persistent);
+            ShadowCacheInvalidationTracker = new AAAAShadowCacheInvalidationTracker(Allocator.Persistent);
+            ShadowCascadeScheduler = new AAAAShadowCascadeScheduler();
+            _materialDataBuffer = new MaterialDataBuffer(_bindlessTextureContainer, shaders.ScatterUploadCS, Allocator.Persistent);
+            InstanceDataBuffer = new InstanceDataBuffer(this, _materialDataBuffer, shaders.ScatterUploadCS, Allocator.Persistent);
+            OcclusionCullingResources = new OcclusionCullingResources(rawBufferClear, InstanceDataBuffer.Capacity);
+            VisibleGeometryCountersBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw | GraphicsBuffer.Target.CopyDestination,
+                VisibleGeometryCounterCount, sizeof(uint)
+            )
+            {
+                name = "VisibilityBuffer_VisibleGeometryCounters",
+            };
             _meshLODNodes = new NativeList<AAAAMeshLODNode>(Allocator.Persistent);
             _meshletData = new NativeList<AAAAMeshlet>(Allocator.Persistent);
             _sharedVertices = new NativeList<AAAAMeshletVertex>(Allocator.Persistent);
             _sharedIndices = new NativeList<byte>(Allocator.Persistent);
+            _meshLODNodesFreeRanges = new AAAARangeAllocator(Allocator.Persistent);
+            _meshletDataFreeRanges = new AAAARangeAllocator(Allocator.Persistent);
+            _sharedVerticesFreeRanges = new AAAARangeAllocator(Allocator.Persistent);
+            _sharedIndicesFreeRanges = new AAAARangeAllocator(Allocator.Persistent);
 
-            _objectTracker = new AAAAObjectTracker(InstanceDataBuffer, _materialDataBuffer, _bindlessTextureContainer);
+            _objectTracker = new AAAAObjectTracker(InstanceDataBuffer, _materialDataBuffer, _bindlessTextureContainer, ShadowCacheInvalidationTracker);
 
             _rendererLists = new RendererList[(int) AAAARendererListID.Count];
 
@@ -89,8 +142,19 @@ namespace DELTation.AAAARP.Renderers
         public int MeshletRenderRequestByteStridePerContext { get; private set; }
         public int IndirectDrawArgsByteStridePerContext { get; private set; }
 
+        // Number of culling contexts the meshlet render request and indirect draw args buffers have room for.
+        public int CullingContextCapacity { get; private set; } = DefaultCullingContextCapacity;
+
         internal OcclusionCullingResources OcclusionCullingResources { get; }
 
+        internal AAAAStaticInstanceCullingCache StaticInstanceCullingCache { get; }
+
+        internal AAAASceneBVH SceneBVH { get; }
+
+        internal AAAAShadowCacheInvalidationTracker ShadowCacheInvalidationTracker { get; }
+
+        internal AAAAShadowCascadeScheduler ShadowCascadeScheduler { get; }
+
         public int MaxMeshletListBuildJobCount { get; internal set; }
 
         public int MeshLODNodeCount => _meshLODNodes.Length;
@@ -102,8 +166,22 @@ namespace DELTation.AAAARP.Renderers
         private int MaxMeshLODLevelsCount { get; set; }
 
         public int MaxMeshletRenderRequestsPerList { get; private set; }
+
+        // When set, culling passes read back their request counts and MaxMeshletRenderRequestsPerList follows them instead of the worst case.
+        public bool AdaptiveMeshletRenderRequestCapacity =>
+            _meshLODSettings.RenderRequestBufferSizing == AAAAMeshLODSettings.MeshletRenderRequestBufferSizing.Adaptive;
+
         public int RendererListCount => _rendererLists.Length;
 
+        // When set, the mesh LOD error threshold is scaled to keep the visible geometry of game cameras within the budget.
+        public bool GeometryBudget => _meshLODSettings.GeometryBudget;
+
+        // Applied through the LOD selection contexts of game camera views only. Shadow casters keep the authored threshold,
+        // so that the controller adjusting every frame does not invalidate the cached shadow maps.
+        internal float GeometryBudgetLODErrorScale => GeometryBudget ? _geometryBudgetController.ErrorMultiplier : 1.0f;
+
+        internal GraphicsBuffer VisibleGeometryCountersBuffer { get; }
+
         public void Dispose()
         {
             OcclusionCullingResources.Dispose();
@@ -121,6 +199,9 @@ namespace DELTation.AAAARP.Renderers
 
             InstanceDataBuffer?.Dispose();
             _materialDataBuffer?.Dispose();
+            StaticInstanceCullingCache.Dispose();
+            SceneBVH.Dispose();
+            ShadowCacheInvalidationTracker.Dispose();
 
             if (_sharedVertices.IsCreated)
             {
@@ -132,12 +213,22 @@ namespace DELTation.AAAARP.Renderers
                 _sharedIndices.Dispose();
             }
 
+            _meshLODNodesFreeRanges?.Dispose();
+            _meshLODNodesFreeRanges = null;
+            _meshletDataFreeRanges?.Dispose();
+            _meshletDataFreeRanges = null;
+            _sharedVerticesFreeRanges?.Dispose();
+            _sharedVerticesFreeRanges = null;
+            _sharedIndicesFreeRanges?.Dispose();
+            _sharedIndicesFreeRanges = null;
+
             IndirectDrawArgsBuffer?.Dispose();
             _meshLODNodesBuffer?.Dispose();
             _meshletsDataBuffer?.Dispose();
             _sharedVertexBuffer?.Dispose();
             _sharedIndexBuffer?.Dispose();
             MeshletRenderRequestsBuffer?.Dispose();
+            VisibleGeometryCountersBuffer.Dispose();
 
             foreach (RendererList rendererList in _rendererLists)
             {
@@ -161,11 +252,32 @@ namespace DELTation.AAAARP.Renderers
         public void PreRender(ScriptableRenderContext context)
         {
             _bindlessTextureContainer.PreRender();
+            StaticInstanceCullingCache.BeginFrame(_frameIndex);
+            UpdateGeometryBudget();
+            UpdateShadowCacheInvalidationTracker();
+
+            using (new ProfilingScope(Profiling.UpdateSceneBVH))
+            {
+                SceneBVH.Update(InstanceDataBuffer.Instances, InstanceDataBuffer.InstanceIndices);
+            }
+
+            ProcessPendingMeshReleases();
+            UpdateCullingContextCapacity();
 
             if (_isDirty)
             {
                 UploadData();
                 _isDirty = false;
+
+                if (_debugDisplaySettings != null)
+                {
+                    _debugDisplaySettings.DebugStats.GeometryMemory = GetGeometryMemoryStats();
+                }
+            }
+
+            if (MeshletRenderRequestsBuffer != null)
+            {
+                UpdateMeshletRenderRequestCapacity();
             }
 
             CommandBuffer cmd = CommandBufferPool.Get();
@@ -174,6 +286,7 @@ namespace DELTation.AAAARP.Renderers
             {
                 InstanceDataBuffer.PreRender(cmd);
                 _materialDataBuffer.PreRender(cmd);
+                OcclusionCullingResources.EnsureInstanceCapacity(InstanceDataBuffer.Capacity);
                 OcclusionCullingResources.PreRender(cmd);
 
                 cmd.SetGlobalBuffer(ShaderIDs._Meshlets, _meshletsDataBuffer);
@@ -189,12 +302,52 @@ namespace DELTation.AAAARP.Renderers
             CommandBufferPool.Release(cmd);
         }
 
+        // The buffers are resized on the next frame, so batches recorded until then still have to fit into CullingContextCapacity.
+        public void RequestCullingContextCapacity(int contextCount)
+        {
+            contextCount = math.min(contextCount, GPUCullingContext.MaxCullingContextsPerBatch);
+            _requestedCullingContextCapacity = math.max(_requestedCullingContextCapacity, contextCount);
+        }
+
+        private void UpdateCullingContextCapacity()
+        {
+            int capacity = _cullingContextCapacityPolicy.Update((uint) _requestedCullingContextCapacity, GPUCullingContext.MaxCullingContextsPerBatch);
+            _requestedCullingContextCapacity = DefaultCullingContextCapacity;
+
+            if (capacity != CullingContextCapacity)
+            {
+                _isDirty = true;
+            }
+        }
+
+        // Called from async readback callbacks with the largest request count of any context in a culling batch, dropped requests included.
+        internal void ReportMeshletRenderRequestCount(uint peakRequestCount)
+        {
+            _reportedMeshletRenderRequestPeak = math.max(_reportedMeshletRenderRequestPeak, peakRequestCount);
+            _hasReportedMeshletRenderRequestCounts = true;
+        }
+
+        // Called from async readback callbacks with the visible geometry of a game camera.
+        internal void ReportVisibleGeometry(uint visibleMeshlets, uint visibleTriangles)
+        {
+            _lastVisibleMeshlets = visibleMeshlets;
+            _lastVisibleTriangles = visibleTriangles;
+
+            if (GeometryBudget)
+            {
+                _geometryBudgetController.ControllerSettings = _meshLODSettings.GeometryBudgetSettings;
+                _geometryBudgetController.Update(visibleMeshlets, visibleTriangles);
+            }
+        }
+
         public void PostRender()
         {
             using (new ProfilingScope(Profiling.PostRender))
             {
                 OcclusionCullingResources.PostRender();
             }
+
+            ++_frameIndex;
         }
 
         private void UploadData()
@@ -204,7 +357,11 @@ namespace DELTation.AAAARP.Renderers
                 return;
             }
 
-            MaxMeshletRenderRequestsPerList = FindMaxSimultaneousMeshletCount();
+            _worstCaseMeshletRenderRequestsPerList = FindMaxSimultaneousMeshletCount();
+            MaxMeshletRenderRequestsPerList = GetMeshletRenderRequestCapacity();
+            CullingContextCapacity = _cullingContextCapacityPolicy.HasSamples
+                ? _cullingContextCapacityPolicy.GetCapacity(GPUCullingContext.MaxCullingContextsPerBatch)
+                : DefaultCullingContextCapacity;
 
             _meshLODNodesBuffer?.Dispose();
             _meshLODNodesBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, math.max(1, _meshLODNodes.Length),
@@ -230,9 +387,12 @@ namespace DELTation.AAAARP.Renderers
             );
             _sharedVertexBuffer.SetData(_sharedVertices.AsArray());
 
-            while (_sharedIndices.Length % 4 > 0)
+            int paddedIndexCount = AAAAMathUtils.AlignUp(_sharedIndices.Length, sizeof(uint));
+            if (paddedIndexCount > _sharedIndices.Length)
             {
-                _sharedIndices.Add(0);
+                int paddingStartIndex = _sharedIndices.Length;
+                _sharedIndices.Resize(paddedIndexCount, NativeArrayOptions.ClearMemory);
+                _sharedIndicesFreeRanges.Free(paddingStartIndex, paddedIndexCount - paddingStartIndex);
             }
             _sharedIndexBuffer?.Dispose();
             _sharedIndexBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw,
@@ -240,28 +400,56 @@ namespace DELTation.AAAARP.Renderers
             );
             _sharedIndexBuffer.SetData(_sharedIndices.AsArray());
 
+            ResizeMeshletRenderRequestsBuffer();
+
+            IndirectDrawArgsByteStridePerContext = _rendererLists.Length * GraphicsBuffer.IndirectDrawArgs.size;
+            IndirectDrawArgsBuffer?.Dispose();
+            IndirectDrawArgsBuffer =
+                new GraphicsBuffer(GraphicsBuffer.Target.IndirectArguments | GraphicsBuffer.Target.Raw,
+                    CullingContextCapacity * IndirectDrawArgsByteStridePerContext / sizeof(uint),
+                    sizeof(uint)
+                )
+                {
+                    name = "VisibilityBuffer_IndirectDrawArgs",
+                };
+        }
+
+        private void ResizeMeshletRenderRequestsBuffer()
+        {
             MeshletRenderRequestByteStridePerContext = AAAAMathUtils.AlignUp(
                 math.max(1, MaxMeshletRenderRequestsPerList) * UnsafeUtility.SizeOf<AAAAMeshletRenderRequestPacked>(),
                 sizeof(uint)
             );
             MeshletRenderRequestsBuffer?.Dispose();
             MeshletRenderRequestsBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw,
-                GPUCullingContext.MaxCullingContextsPerBatch * MeshletRenderRequestByteStridePerContext / sizeof(uint), sizeof(uint)
+                CullingContextCapacity * MeshletRenderRequestByteStridePerContext / sizeof(uint), sizeof(uint)
             )
             {
                 name = "VisibilityBuffer_MeshletRenderRequests",
             };
+        }
 
-            IndirectDrawArgsByteStridePerContext = _rendererLists.Length * GraphicsBuffer.IndirectDrawArgs.size;
-            IndirectDrawArgsBuffer?.Dispose();
-            IndirectDrawArgsBuffer =
-                new GraphicsBuffer(GraphicsBuffer.Target.IndirectArguments | GraphicsBuffer.Target.Raw,
-                    GPUCullingContext.MaxCullingContextsPerBatch * IndirectDrawArgsByteStridePerContext / sizeof(uint),
-                    sizeof(uint)
-                )
-                {
-                    name = "VisibilityBuffer_IndirectDrawArgs",
-                };
+        private int GetMeshletRenderRequestCapacity() =>
+            AdaptiveMeshletRenderRequestCapacity
+                ? _meshletRenderRequestCapacityPolicy.GetCapacity(_worstCaseMeshletRenderRequestsPerList)
+                : _worstCaseMeshletRenderRequestsPerList;
+
+        // Only the request list is reallocated: unlike UploadData, this does not touch the mesh data.
+        private void UpdateMeshletRenderRequestCapacity()
+        {
+            if (_hasReportedMeshletRenderRequestCounts)
+            {
+                _meshletRenderRequestCapacityPolicy.Update(_reportedMeshletRenderRequestPeak, _worstCaseMeshletRenderRequestsPerList);
+                _reportedMeshletRenderRequestPeak = 0;
+                _hasReportedMeshletRenderRequestCounts = false;
+            }
+
+            int capacity = GetMeshletRenderRequestCapacity();
+            if (capacity != MaxMeshletRenderRequestsPerList)
+            {
+                MaxMeshletRenderRequestsPerList = capacity;
+                ResizeMeshletRenderRequestsBuffer();
+            }
         }
 
         private int FindMaxSimultaneousMeshletCount()
@@ -314,61 +502,212 @@ namespace DELTation.AAAARP.Renderers
 
         private static bool ShouldDraw(CameraType cameraType) => cameraType is CameraType.Game or CameraType.SceneView;
 
+        // Turning the budget off and on again starts from the authored threshold.
+        private void UpdateGeometryBudget()
+        {
+            if (!GeometryBudget)
+            {
+                _geometryBudgetController.Reset();
+            }
+
+            if (_debugDisplaySettings != null)
+            {
+                _debugDisplaySettings.DebugStats.GeometryBudget = new AAAADebugStats.GeometryBudgetStats
+                {
+                    Enabled = GeometryBudget,
+                    Settings = _meshLODSettings.GeometryBudgetSettings,
+                    ErrorMultiplier = _geometryBudgetController.ErrorMultiplier,
+                    IsSettled = _geometryBudgetController.IsSettled,
+                    VisibleMeshlets = _lastVisibleMeshlets,
+                    VisibleTriangles = _lastVisibleTriangles,
+                };
+            }
+        }
+
+        // Cached shadow maps were rendered with the previous LOD selection.
+        private void UpdateShadowCacheInvalidationTracker()
+        {
+            ShadowCacheInvalidationTracker.BeginFrame(_frameIndex);
+            ShadowCascadeScheduler.BeginFrame(_frameIndex);
+
+            int forcedMeshLODNodeDepth = GetForcedMeshLODNodeDepth();
+            float meshLODErrorThreshold = GetMeshLODErrorThreshold();
+            if (forcedMeshLODNodeDepth != _shadowCacheForcedMeshLODNodeDepth || meshLODErrorThreshold != _shadowCacheMeshLODErrorThreshold)
+            {
+                ShadowCacheInvalidationTracker.InvalidateAll();
+                _shadowCacheForcedMeshLODNodeDepth = forcedMeshLODNodeDepth;
+                _shadowCacheMeshLODErrorThreshold = meshLODErrorThreshold;
+            }
+        }
+
         private int GetForcedMeshLODNodeDepth() => _debugDisplaySettings?.RenderingSettings.ForcedMeshLODNodeDepth ?? -1;
 
         private float GetMeshLODErrorThreshold() =>
             math.max(0, _meshLODSettings.ErrorThreshold + (_debugDisplaySettings?.RenderingSettings.MeshLODErrorThresholdBias ?? 0.0f));
 
-        internal MeshMetadata GetOrAllocateMeshLODNodes(AAAAMeshletCollectionAsset meshletCollection)
+        internal MeshMetadata RetainMeshLODNodes(AAAAMeshletCollectionAsset meshletCollection, int referenceCount = 1)
         {
+            Assert.IsTrue(referenceCount > 0);
+
             int meshInstanceID = meshletCollection.GetInstanceID();
 
             if (_meshInstanceIDToMetadata.TryGetValue(meshInstanceID, out MeshMetadata meshMetadata))
             {
+                meshMetadata.ReferenceCount += referenceCount;
+                _meshInstanceIDToMetadata[meshInstanceID] = meshMetadata;
+                _pendingMeshReleases.Cancel(meshInstanceID);
                 return meshMetadata;
             }
 
             MaxMeshLODLevelsCount = Mathf.Max(MaxMeshLODLevelsCount, meshletCollection.MeshLODLevelCount);
 
-            uint triangleOffset = (uint) _sharedIndices.Length;
-            uint vertexOffset = (uint) _sharedVertices.Length;
-            uint meshletOffset = (uint) _meshletData.Length;
             meshMetadata = new MeshMetadata
             {
-                TopMeshLODNodesStartIndex = _meshLODNodes.Length,
+                ReferenceCount = referenceCount,
                 LeafMeshletCount = meshletCollection.LeafMeshletCount,
+                TopMeshLODNodesStartIndex = AllocateRange(_meshLODNodes, _meshLODNodesFreeRanges, meshletCollection.MeshLODNodes.Length),
+                MeshLODNodeCount = meshletCollection.MeshLODNodes.Length,
+                MeshletStartIndex = AllocateRange(_meshletData, _meshletDataFreeRanges, meshletCollection.Meshlets.Length),
+                MeshletCount = meshletCollection.Meshlets.Length,
+                VertexStartIndex = AllocateRange(_sharedVertices, _sharedVerticesFreeRanges, meshletCollection.VertexBuffer.Length),
+                VertexCount = meshletCollection.VertexBuffer.Length,
+                IndexStartIndex = AllocateRange(_sharedIndices, _sharedIndicesFreeRanges, meshletCollection.IndexBuffer.Length),
+                IndexCount = meshletCollection.IndexBuffer.Length,
             };
 
-            foreach (AAAAMeshlet sourceMeshlet in meshletCollection.Meshlets)
+            uint triangleOffset = (uint) meshMetadata.IndexStartIndex;
+            uint vertexOffset = (uint) meshMetadata.VertexStartIndex;
+            uint meshletOffset = (uint) meshMetadata.MeshletStartIndex;
+
+            for (int index = 0; index < meshletCollection.Meshlets.Length; index++)
             {
-                AAAAMeshlet meshlet = sourceMeshlet;
+                AAAAMeshlet meshlet = meshletCollection.Meshlets[index];
                 meshlet.TriangleOffset += triangleOffset;
                 meshlet.VertexOffset += vertexOffset;
 
-                _meshletData.Add(meshlet);
+                _meshletData[meshMetadata.MeshletStartIndex + index] = meshlet;
             }
 
-            foreach (AAAAMeshLODNode sourceNode in meshletCollection.MeshLODNodes)
+            for (int index = 0; index < meshletCollection.MeshLODNodes.Length; index++)
             {
-                AAAAMeshLODNode node = sourceNode;
+                AAAAMeshLODNode node = meshletCollection.MeshLODNodes[index];
                 node.MeshletStartIndex += meshletOffset;
 
-                _meshLODNodes.Add(node);
+                _meshLODNodes[meshMetadata.TopMeshLODNodesStartIndex + index] = node;
             }
 
-            AppendFromManagedArray(_sharedVertices, meshletCollection.VertexBuffer);
-            AppendFromManagedArray(_sharedIndices, meshletCollection.IndexBuffer);
+            CopyFromManagedArray(_sharedVertices, meshMetadata.VertexStartIndex, meshletCollection.VertexBuffer);
+            CopyFromManagedArray(_sharedIndices, meshMetadata.IndexStartIndex, meshletCollection.IndexBuffer);
 
             _meshInstanceIDToMetadata.Add(meshInstanceID, meshMetadata);
             _isDirty = true;
             return meshMetadata;
         }
 
-        private static unsafe void AppendFromManagedArray<T>(NativeList<T> destination, T[] source) where T : unmanaged
+        internal void ReleaseMeshLODNodes(int meshInstanceID)
+        {
+            if (!_meshInstanceIDToMetadata.TryGetValue(meshInstanceID, out MeshMetadata meshMetadata))
+            {
+                return;
+            }
+
+            Assert.IsTrue(meshMetadata.ReferenceCount > 0, "Mesh reference count underflow.");
+
+            --meshMetadata.ReferenceCount;
+            _meshInstanceIDToMetadata[meshInstanceID] = meshMetadata;
+
+            if (meshMetadata.ReferenceCount == 0)
+            {
+                _pendingMeshReleases.Release(meshInstanceID, _frameIndex);
+            }
+        }
+
+        private void ProcessPendingMeshReleases()
+        {
+            foreach (int meshInstanceID in _pendingMeshReleases.CollectExpired(_frameIndex))
+            {
+                // Retaining a mesh cancels its pending release, so this only guards against bookkeeping mistakes.
+                if (!_meshInstanceIDToMetadata.TryGetValue(meshInstanceID, out MeshMetadata meshMetadata) ||
+                    meshMetadata.ReferenceCount > 0)
+                {
+                    continue;
+                }
+
+                FreeRange(_meshLODNodes, _meshLODNodesFreeRanges, meshMetadata.TopMeshLODNodesStartIndex, meshMetadata.MeshLODNodeCount);
+                FreeRange(_meshletData, _meshletDataFreeRanges, meshMetadata.MeshletStartIndex, meshMetadata.MeshletCount);
+                FreeRange(_sharedVertices, _sharedVerticesFreeRanges, meshMetadata.VertexStartIndex, meshMetadata.VertexCount);
+                FreeRange(_sharedIndices, _sharedIndicesFreeRanges, meshMetadata.IndexStartIndex, meshMetadata.IndexCount);
+
+                _meshInstanceIDToMetadata.Remove(meshInstanceID);
+                _isDirty = true;
+            }
+        }
+
+        private GeometryMemoryStats GetGeometryMemoryStats()
         {
-            int offset = destination.Length;
+            int meshLODNodeSize = UnsafeUtility.SizeOf<AAAAMeshLODNode>();
+            int meshletSize = UnsafeUtility.SizeOf<AAAAMeshlet>();
+            int vertexSize = UnsafeUtility.SizeOf<AAAAMeshletVertex>();
+            const int indexSize = sizeof(byte);
+
+            long totalBytes = (long) _meshLODNodes.Length * meshLODNodeSize +
+                              (long) _meshletData.Length * meshletSize +
+                              (long) _sharedVertices.Length * vertexSize +
+                              (long) _sharedIndices.Length * indexSize;
+            long freeBytes = (long) _meshLODNodesFreeRanges.FreeCount * meshLODNodeSize +
+                             (long) _meshletDataFreeRanges.FreeCount * meshletSize +
+                             (long) _sharedVerticesFreeRanges.FreeCount * vertexSize +
+                             (long) _sharedIndicesFreeRanges.FreeCount * indexSize;
+
+            long pendingReleaseBytes = 0;
+            int liveMeshCount = 0;
+
+            foreach (MeshMetadata meshMetadata in _meshInstanceIDToMetadata.Values)
+            {
+                if (meshMetadata.ReferenceCount > 0)
+                {
+                    ++liveMeshCount;
+                    continue;
+                }
+
+                pendingReleaseBytes += (long) meshMetadata.MeshLODNodeCount * meshLODNodeSize +
+                                       (long) meshMetadata.MeshletCount * meshletSize +
+                                       (long) meshMetadata.VertexCount * vertexSize +
+                                       (long) meshMetadata.IndexCount * indexSize;
+            }
+
+            long deadBytes = freeBytes + pendingReleaseBytes;
+            return new GeometryMemoryStats
+            {
+                LiveMeshCount = liveMeshCount,
+                PendingReleaseMeshCount = _meshInstanceIDToMetadata.Count - liveMeshCount,
+                LiveBytes = totalBytes - deadBytes,
+                DeadBytes = deadBytes,
+            };
+        }
+
+        private static int AllocateRange<T>(NativeList<T> pool, AAAARangeAllocator freeRanges, int count) where T : unmanaged
+        {
+            if (freeRanges.TryAllocate(count, out int offset))
+            {
+                return offset;
+            }
+
+            offset = pool.Length;
+            pool.Resize(offset + count, NativeArrayOptions.UninitializedMemory);
+            return offset;
+        }
+
+        private static void FreeRange<T>(NativeList<T> pool, AAAARangeAllocator freeRanges, int offset, int count) where T : unmanaged
+        {
+            freeRanges.Free(offset, count);
+            pool.Resize(freeRanges.TrimTail(pool.Length), NativeArrayOptions.UninitializedMemory);
+        }
+
+        private static unsafe void CopyFromManagedArray<T>(NativeList<T> destination, int offset, T[] source) where T : unmanaged
+        {
+            Assert.IsTrue(offset + source.Length <= destination.Length);
 
-            destination.Resize(offset + source.Length, NativeArrayOptions.UninitializedMemory);
             fixed (T* pSource = source)
             {
                 UnsafeUtility.MemCpy(destination.GetUnsafePtr() + offset, pSource, source.Length * UnsafeUtility.SizeOf<T>());
@@ -377,8 +716,28 @@ namespace DELTation.AAAARP.Renderers
 
         internal struct MeshMetadata
         {
+            public int ReferenceCount;
             public int TopMeshLODNodesStartIndex;
+            public int MeshLODNodeCount;
             public int LeafMeshletCount;
+            public int MeshletStartIndex;
+            public int MeshletCount;
+            public int VertexStartIndex;
+            public int VertexCount;
+            public int IndexStartIndex;
+            public int IndexCount;
+        }
+
+        public struct GeometryMemoryStats
+        {
+            public int LiveMeshCount;
+            public int PendingReleaseMeshCount;
+
+            // Bytes referenced by at least one instance.
+            public long LiveBytes;
+
+            // Bytes in the shared pools that are either free holes or belong to meshes waiting for release.
+            public long DeadBytes;
         }
 
         public struct RendererList : IDisposable
@@ -395,6 +754,7 @@ namespace DELTation.AAAARP.Renderers
         {
             public static readonly ProfilingSampler PreRender = new("Visibility Buffer Container: Pre Render");
             public static readonly ProfilingSampler PostRender = new("Visibility Buffer Container: Post Render");
+            public static readonly ProfilingSampler UpdateSceneBVH = new("Visibility Buffer Container: Update Scene BVH");
         }
 
         [SuppressMessage("ReSharper", "InconsistentNaming")]
@@ -0,0 +1,240 @@
+using DELTation.AAAARP.Core;
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Jobs;
+using Unity.Mathematics;
+using UnityEngine.Jobs;
+
+namespace DELTation.AAAARP.Renderers
+{
+    internal sealed partial class InstanceDataBuffer
+    {
+        private const int UpdateTransformsBatchSize = 64;
+
+        internal static JobHandle ScheduleTransformUpdate(NativeHashMap<int, InstanceMetadata> metadata, NativeArray<AAAAInstanceData> instances,
+            NativeArray<int> transformedIDs, NativeArray<float4x4> localToWorldMatrices, NativeList<int> dirtyInstanceIndices,
+            JobHandle dependency = default)
+        {
+            var instanceIndices = new NativeArray<int>(transformedIDs.Length, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+
+            JobHandle handle = new ResolveInstanceIndicesJob
+                {
+                    Metadata = metadata,
+                    TransformedIDs = transformedIDs,
+                    InstanceIndices = instanceIndices,
+                    DirtyInstanceIndices = dirtyInstanceIndices,
+                }
+                .Schedule(dependency);
+
+            handle = new UpdateTransformsJob
+                {
+                    InstanceIndices = instanceIndices,
+                    LocalToWorldMatrices = localToWorldMatrices,
+                    Instances = instances,
+                }
+                .Schedule(transformedIDs.Length, UpdateTransformsBatchSize, handle);
+
+            return instanceIndices.Dispose(handle);
+        }
+
+        internal static JobHandle ScheduleBulkRegistration(NativeHashMap<int, InstanceMetadata> metadata, NativeArray<int> instanceIDs,
+            NativeArray<AAAAIndexAllocator.IndexAllocation> allocations, NativeArray<RendererRecord> rendererRecords, NativeArray<MeshRecord> meshRecords,
+            NativeList<int> instanceIndices, NativeList<int> instanceIndicesOwners, NativeList<int> dirtyInstanceIndices, JobHandle dependency = default) =>
+            new RegisterNewInstancesJob
+                {
+                    InstanceIDs = instanceIDs,
+                    Allocations = allocations,
+                    RendererRecords = rendererRecords,
+                    MeshRecords = meshRecords,
+                    Metadata = metadata,
+                    InstanceIndices = instanceIndices,
+                    InstanceIndicesOwners = instanceIndicesOwners,
+                    DirtyInstanceIndices = dirtyInstanceIndices,
+                }
+                .Schedule(dependency);
+
+        // Reads the transforms directly instead of going through the managed Transform API per renderer.
+        internal static JobHandle ScheduleBulkInstanceFill(TransformAccessArray transforms, NativeArray<AAAAIndexAllocator.IndexAllocation> allocations,
+            NativeArray<RendererRecord> rendererRecords, NativeArray<MeshRecord> meshRecords, NativeArray<AAAAInstanceData> instances,
+            JobHandle dependency = default) =>
+            new FillNewInstancesJob
+                {
+                    Allocations = allocations,
+                    RendererRecords = rendererRecords,
+                    MeshRecords = meshRecords,
+                    Instances = instances,
+                }
+                .ScheduleReadOnly(transforms, UpdateTransformsBatchSize, dependency);
+
+        internal static JobHandle SchedulePackCompactInstanceData(NativeArray<AAAAInstanceData> instances,
+            NativeArray<AAAACompactInstanceData> compactInstances, int startIndex, int count, JobHandle dependency = default) =>
+            new PackCompactInstanceDataJob
+                {
+                    Instances = instances.GetSubArray(startIndex, count),
+                    CompactInstances = compactInstances.GetSubArray(startIndex, count),
+                }
+                .Schedule(count, UpdateTransformsBatchSize, dependency);
+
+        internal static JobHandle SchedulePackCompactInstanceData(NativeArray<AAAAInstanceData> instances,
+            NativeArray<AAAACompactInstanceData> compactInstances, NativeArray<int> instanceIndices, JobHandle dependency = default) =>
+            new PackCompactInstanceDataAtIndicesJob
+                {
+                    InstanceIndices = instanceIndices,
+                    Instances = instances,
+                    CompactInstances = compactInstances,
+                }
+                .Schedule(instanceIndices.Length, UpdateTransformsBatchSize, dependency);
+
+        // Hash map lookups are kept out of the parallel job, which then only touches the instances it owns.
+        [BurstCompile]
+        private struct ResolveInstanceIndicesJob : IJob
+        {
+            [ReadOnly]
+            public NativeHashMap<int, InstanceMetadata> Metadata;
+            [ReadOnly]
+            public NativeArray<int> TransformedIDs;
+
+            [WriteOnly]
+            public NativeArray<int> InstanceIndices;
+            public NativeList<int> DirtyInstanceIndices;
+
+            public void Execute()
+            {
+                for (int i = 0; i < TransformedIDs.Length; i++)
+                {
+                    if (Metadata.TryGetValue(TransformedIDs[i], out InstanceMetadata metadata))
+                    {
+                        int instanceIndex = metadata.IndexAllocation.Index;
+                        InstanceIndices[i] = instanceIndex;
+                        DirtyInstanceIndices.Add(instanceIndex);
+                    }
+                    else
+                    {
+                        InstanceIndices[i] = -1;
+                    }
+                }
+            }
+        }
+
+        [BurstCompile]
+        private struct UpdateTransformsJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<float4x4> LocalToWorldMatrices;
+
+            // Every instance index appears at most once per batch.
+            [NativeDisableParallelForRestriction]
+            public NativeArray<AAAAInstanceData> Instances;
+
+            public void Execute(int index)
+            {
+                int instanceIndex = InstanceIndices[index];
+                if (instanceIndex < 0)
+                {
+                    return;
+                }
+
+                AAAAInstanceData instanceData = Instances[instanceIndex];
+                UpdateTransform(ref instanceData, LocalToWorldMatrices[index]);
+                Instances[instanceIndex] = instanceData;
+            }
+        }
+
+        [BurstCompile]
+        private struct RegisterNewInstancesJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<int> InstanceIDs;
+            [ReadOnly]
+            public NativeArray<AAAAIndexAllocator.IndexAllocation> Allocations;
+            [ReadOnly]
+            public NativeArray<RendererRecord> RendererRecords;
+            [ReadOnly]
+            public NativeArray<MeshRecord> MeshRecords;
+
+            public NativeHashMap<int, InstanceMetadata> Metadata;
+            public NativeList<int> InstanceIndices;
+            public NativeList<int> InstanceIndicesOwners;
+            public NativeList<int> DirtyInstanceIndices;
+
+            public void Execute()
+            {
+                for (int i = 0; i < InstanceIDs.Length; i++)
+                {
+                    AAAAIndexAllocator.IndexAllocation indexAllocation = Allocations[i];
+                    int instanceID = InstanceIDs[i];
+
+                    Metadata.Add(instanceID, new InstanceMetadata
+                        {
+                            IndexAllocation = indexAllocation,
+                            DenseIndex = InstanceIndices.Length,
+                            MeshInstanceID = MeshRecords[RendererRecords[i].MeshSlot].MeshInstanceID,
+                        }
+                    );
+                    InstanceIndices.Add(indexAllocation.Index);
+                    InstanceIndicesOwners.Add(instanceID);
+                    DirtyInstanceIndices.Add(indexAllocation.Index);
+                }
+            }
+        }
+
+        [BurstCompile]
+        private struct FillNewInstancesJob : IJobParallelForTransform
+        {
+            [ReadOnly]
+            public NativeArray<AAAAIndexAllocator.IndexAllocation> Allocations;
+            [ReadOnly]
+            public NativeArray<RendererRecord> RendererRecords;
+            [ReadOnly]
+            public NativeArray<MeshRecord> MeshRecords;
+
+            // Every allocation is unique.
+            [NativeDisableParallelForRestriction] [WriteOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+
+            public void Execute(int index, TransformAccess transform)
+            {
+                RendererRecord rendererRecord = RendererRecords[index];
+                var instanceData = new AAAAInstanceData();
+                UpdateTransform(ref instanceData, transform.localToWorldMatrix);
+                WriteRecords(ref instanceData, MeshRecords[rendererRecord.MeshSlot], rendererRecord);
+                Instances[Allocations[index].Index] = instanceData;
+            }
+        }
+
+        [BurstCompile]
+        private struct PackCompactInstanceDataJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+            [WriteOnly]
+            public NativeArray<AAAACompactInstanceData> CompactInstances;
+
+            public void Execute(int index)
+            {
+                CompactInstances[index] = AAAACompactInstanceData.Pack(Instances[index]);
+            }
+        }
+
+        [BurstCompile]
+        private struct PackCompactInstanceDataAtIndicesJob : IJobParallelFor
+        {
+            [ReadOnly]
+            public NativeArray<int> InstanceIndices;
+            [ReadOnly]
+            public NativeArray<AAAAInstanceData> Instances;
+
+            // Duplicate indices write identical records.
+            [NativeDisableParallelForRestriction] [WriteOnly]
+            public NativeArray<AAAACompactInstanceData> CompactInstances;
+
+            public void Execute(int index)
+            {
+                int instanceIndex = InstanceIndices[index];
+                CompactInstances[instanceIndex] = AAAACompactInstanceData.Pack(Instances[instanceIndex]);
+            }
+        }
+    }
+}
@@ -3,45 +3,84 @@ using System.Collections.Generic;
 using DELTation.AAAARP.Core;
 using DELTation.AAAARP.Materials;
 using DELTation.AAAARP.Meshlets;
+using DELTation.AAAARP.Utils;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
+using Unity.Jobs;
 using Unity.Mathematics;
 using UnityEngine;
 using UnityEngine.Assertions;
+using UnityEngine.Jobs;
 using UnityEngine.Rendering;
 using Object = UnityEngine.Object;
 
 namespace DELTation.AAAARP.Renderers
 {
-    internal sealed class InstanceDataBuffer : IDisposable
+    internal sealed partial class InstanceDataBuffer : IDisposable
     {
-        public const int Capacity = 512;
+        // Storage grows geometrically past this, GPU buffers follow in PreRender.
+        private const int InitialCapacity = 512;
+        // Scene loads report thousands of new renderers at once. Batches at least this large register new renderers in bulk.
+        internal const int BulkRegistrationThreshold = 256;
+        private readonly BulkRegistrationBatch _bulkRegistrationBatch = new();
+        private readonly List<AAAARendererAuthoring> _bulkRenderers = new();
+        private readonly Func<AAAAMaterialAsset, int> _getOrAllocateMaterial;
+        private readonly AAAASparseBufferUploader<AAAACompactInstanceData> _compactUploader;
         private readonly MaterialDataBuffer _materialDataBuffer;
 
         private readonly AAAARendererContainer _rendererContainer;
+        private readonly AAAASparseBufferUploader<AAAAInstanceData> _uploader;
 
         private NativeArray<AAAAInstanceData> _cpuBuffer;
+        // Staging for the GPU copy when AAAAInstanceConfiguration.UseCompactInstanceData is on.
+        private NativeArray<AAAACompactInstanceData> _compactCPUBuffer;
+        // Instances whose data changed since the last upload. _isDirty forces a full upload instead, e.g. after the GPU buffer is recreated.
+        private NativeList<int> _dirtyInstanceIndices;
         private GraphicsBuffer _gpuBuffer;
         private AAAAIndexAllocator _indexAllocator;
+        // Dense list of allocated instance indices shared by all culling passes. Kept in sync with _instanceIndicesOwners.
+        private NativeList<int> _instanceIndices;
+        private GraphicsBuffer _instanceIndicesGPUBuffer;
+        private bool _instanceIndicesDirty;
+        private NativeList<int> _instanceIndicesOwners;
         private bool _isDirty;
         private NativeHashMap<int, InstanceMetadata> _metadata;
 
-        public InstanceDataBuffer(AAAARendererContainer rendererContainer, MaterialDataBuffer materialDataBuffer, Allocator allocator)
+        public InstanceDataBuffer(AAAARendererContainer rendererContainer, MaterialDataBuffer materialDataBuffer, ComputeShader scatterUploadCS,
+            Allocator allocator)
         {
             _materialDataBuffer = materialDataBuffer;
+            _getOrAllocateMaterial = materialDataBuffer.GetOrAllocateMaterial;
             _rendererContainer = rendererContainer;
-            _cpuBuffer = new NativeArray<AAAAInstanceData>(Capacity, allocator);
-            _gpuBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, Capacity, UnsafeUtility.SizeOf<AAAAInstanceData>())
-            {
-                name = nameof(RendererContainerShaderIDs._InstanceData),
-            };
-            _metadata = new NativeHashMap<int, InstanceMetadata>(Capacity, allocator);
-            _indexAllocator = new AAAAIndexAllocator(Capacity, allocator);
-            _isDirty = true;
+            _uploader = new AAAASparseBufferUploader<AAAAInstanceData>(scatterUploadCS, AAAASparseBufferUpload.InstanceDataKernelIndex,
+                AAAASparseBufferUpload.ShaderID._ScatterInstanceRecords, AAAASparseBufferUpload.ShaderID._ScatterInstanceDestination,
+                nameof(RendererContainerShaderIDs._InstanceData)
+            );
+            _compactUploader = new AAAASparseBufferUploader<AAAACompactInstanceData>(scatterUploadCS, AAAASparseBufferUpload.InstanceDataKernelIndex,
+                AAAASparseBufferUpload.ShaderID._ScatterInstanceRecords, AAAASparseBufferUpload.ShaderID._ScatterInstanceDestination,
+                nameof(RendererContainerShaderIDs._InstanceData)
+            );
+            _cpuBuffer = new NativeArray<AAAAInstanceData>(InitialCapacity, allocator);
+            _metadata = new NativeHashMap<int, InstanceMetadata>(InitialCapacity, allocator);
+            _dirtyInstanceIndices = new NativeList<int>(allocator);
+            const bool autoGrow = true;
+            _indexAllocator = new AAAAIndexAllocator(InitialCapacity, allocator, autoGrow);
+            _instanceIndices = new NativeList<int>(InitialCapacity, allocator);
+            _instanceIndicesOwners = new NativeList<int>(InitialCapacity, allocator);
+            EnsureGPUBuffersCapacity();
         }
 
         public int InstanceCount => _metadata.Count;
 
+        public int Capacity => _cpuBuffer.Length;
+
+        public NativeArray<int> InstanceIndices => _instanceIndices.AsArray();
+
+        public NativeArray<AAAAInstanceData> Instances => _cpuBuffer;
+
+        // Up to date after PreRender. Only the first InstanceCount items are valid.
+        public GraphicsBuffer InstanceIndicesBuffer => _instanceIndicesGPUBuffer;
+
         public void Dispose()
         {
             if (_cpuBuffer.IsCreated)
@@ -49,21 +88,50 @@ namespace DELTation.AAAARP.Renderers
                 _cpuBuffer.Dispose();
             }
 
+            if (_compactCPUBuffer.IsCreated)
+            {
+                _compactCPUBuffer.Dispose();
+            }
+
             _gpuBuffer?.Dispose();
             _gpuBuffer = null;
 
+            _uploader.Dispose();
+            _compactUploader.Dispose();
+
             if (_metadata.IsCreated)
             {
                 _metadata.Dispose();
             }
 
+            if (_dirtyInstanceIndices.IsCreated)
+            {
+                _dirtyInstanceIndices.Dispose();
+            }
+
             _indexAllocator?.Dispose();
             _indexAllocator = null;
+
+            if (_instanceIndices.IsCreated)
+            {
+                _instanceIndices.Dispose();
+            }
+
+            if (_instanceIndicesOwners.IsCreated)
+            {
+                _instanceIndicesOwners.Dispose();
+            }
+
+            _instanceIndicesGPUBuffer?.Dispose();
+            _instanceIndicesGPUBuffer = null;
         }
 
         public void OnRenderersChanged(List<Object> changed, NativeArray<int> changedIDs)
         {
             var invalidIDs = new NativeList<int>(changedIDs.Length, Allocator.Temp);
+            bool bulkRegistration = changedIDs.Length >= BulkRegistrationThreshold;
+            var bulkInstanceIDs = new NativeList<int>(bulkRegistration ? changedIDs.Length : 0, Allocator.Temp);
+            _bulkRenderers.Clear();
 
             for (int index = 0; index < changedIDs.Length; index++)
             {
@@ -82,15 +150,32 @@ namespace DELTation.AAAARP.Renderers
 
                 if (!_metadata.TryGetValue(instanceID, out InstanceMetadata instanceMetadata))
                 {
+                    if (bulkRegistration)
+                    {
+                        _bulkRenderers.Add(rendererAuthoring);
+                        bulkInstanceIDs.Add(instanceID);
+                        continue;
+                    }
+
                     isNew = true;
                     AAAAIndexAllocator.IndexAllocation indexAllocation = _indexAllocator.Allocate();
                     Assert.IsTrue(indexAllocation.Index != AAAAIndexAllocator.InvalidAllocationIndex, "Instance allocation failure. Out of memory.");
 
+                    if (_indexAllocator.Capacity > _cpuBuffer.Length)
+                    {
+                        _cpuBuffer.ResizeArray(_indexAllocator.Capacity);
+                    }
+
                     instanceMetadata = new InstanceMetadata
                     {
                         IndexAllocation = indexAllocation,
+                        DenseIndex = _instanceIndices.Length,
                     };
 
+                    _instanceIndices.Add(indexAllocation.Index);
+                    _instanceIndicesOwners.Add(instanceID);
+                    _instanceIndicesDirty = true;
+
                     _metadata.Add(instanceID, instanceMetadata);
                 }
                 else
@@ -102,65 +187,151 @@ namespace DELTation.AAAARP.Renderers
 
                 if (isNew)
                 {
-                    Transform transform = rendererAuthoring.transform;
-                    float4x4 localToWorldMatrix = transform.localToWorldMatrix;
+                    float4x4 localToWorldMatrix = rendererAuthoring.transform.localToWorldMatrix;
 
-                    instanceData.ObjectToWorldMatrix = localToWorldMatrix;
-                    instanceData.WorldToObjectMatrix = AAAAMathUtils.AffineInverse3D(localToWorldMatrix);
                     instanceData.Flags = AAAAInstanceFlags.None;
-                    UpdateWindingOrderFlag(ref instanceData.Flags, transform.lossyScale);
+                    UpdateTransform(ref instanceData, localToWorldMatrix);
                 }
                 else
                 {
                     _rendererContainer.MaxMeshletListBuildJobCount -= ComputeMeshletListBuildJobCount(instanceData);
                 }
 
-                AAAARendererContainer.MeshMetadata meshMetadata = _rendererContainer.GetOrAllocateMeshLODNodes(mesh);
-
-                instanceData.AABBMin = math.float4(mesh.Bounds.min, 0.0f);
-                instanceData.AABBMax = math.float4(mesh.Bounds.max, 0.0f);
-                instanceData.TopMeshLODStartIndex = (uint) meshMetadata.TopMeshLODNodesStartIndex;
-                instanceData.TotalMeshLODCount = (uint) mesh.MeshLODNodes.Length;
-                instanceData.MaterialIndex = (uint) _materialDataBuffer.GetOrAllocateMaterial(material);
-                instanceData.MeshLODLevelCount = (uint) mesh.MeshLODLevelCount;
-                instanceData.LODErrorScale = rendererAuthoring.LODErrorScale;
-                instanceData.PassMask = ExtractInstancePassMask(rendererAuthoring);
-
-                if (rendererAuthoring.isActiveAndEnabled)
+                // Retain before releasing, so that the geometry is not scheduled for release when the mesh did not change.
+                AAAARendererContainer.MeshMetadata meshMetadata = _rendererContainer.RetainMeshLODNodes(mesh);
+                if (!isNew)
                 {
-                    instanceData.Flags &= ~AAAAInstanceFlags.Disabled;
-                }
-                else
-                {
-                    instanceData.Flags |= AAAAInstanceFlags.Disabled;
+                    _rendererContainer.ReleaseMeshLODNodes(instanceMetadata.MeshInstanceID);
                 }
 
-                instanceMetadata.MeshInstanceID = mesh.GetInstanceID();
+                MeshRecord meshRecord = CreateMeshRecord(mesh, meshMetadata);
+                RendererRecord rendererRecord = CreateRendererRecord(rendererAuthoring, 0, _materialDataBuffer.GetOrAllocateMaterial(material));
+                WriteRecords(ref instanceData, meshRecord, rendererRecord);
+
+                instanceMetadata.MeshInstanceID = meshRecord.MeshInstanceID;
 
                 _rendererContainer.MaxMeshletListBuildJobCount += ComputeMeshletListBuildJobCount(instanceData);
-                _isDirty = true;
+                _rendererContainer.StaticInstanceCullingCache.OnInstanceChanged(instanceMetadata.IndexAllocation.Index);
+                _rendererContainer.SceneBVH.OnInstanceChanged(instanceMetadata.IndexAllocation.Index);
+                _rendererContainer.ShadowCacheInvalidationTracker.OnCasterChanged(instanceMetadata.IndexAllocation.Index, instanceData);
+                _dirtyInstanceIndices.Add(instanceMetadata.IndexAllocation.Index);
 
                 _metadata[instanceID] = instanceMetadata;
             }
 
+            if (_bulkRenderers.Count > 0)
+            {
+                RegisterRenderersBulk(_bulkRenderers, bulkInstanceIDs.AsArray());
+                _bulkRenderers.Clear();
+            }
+
             if (invalidIDs.Length > 0)
             {
                 OnRenderersDestroyed(invalidIDs.AsArray());
             }
 
+            bulkInstanceIDs.Dispose();
             invalidIDs.Dispose();
         }
 
-        private static void UpdateWindingOrderFlag(ref AAAAInstanceFlags flags, float3 scale)
+        // New renderers only: materials and meshes are resolved once per unique asset, the rest runs in Burst jobs.
+        private void RegisterRenderersBulk(List<AAAARendererAuthoring> renderers, NativeArray<int> instanceIDs)
+        {
+            int count = renderers.Count;
+            var transforms = new TransformAccessArray(count);
+            var rendererRecords = new NativeArray<RendererRecord>(count, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            _bulkRegistrationBatch.Gather(renderers, _getOrAllocateMaterial, rendererRecords, transforms);
+
+            List<AAAAMeshletCollectionAsset> meshes = _bulkRegistrationBatch.Meshes;
+            var meshRecords = new NativeArray<MeshRecord>(meshes.Count, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+
+            for (int meshSlot = 0; meshSlot < meshes.Count; meshSlot++)
+            {
+                AAAAMeshletCollectionAsset mesh = meshes[meshSlot];
+                int referenceCount = _bulkRegistrationBatch.MeshReferenceCounts[meshSlot];
+                AAAARendererContainer.MeshMetadata meshMetadata = _rendererContainer.RetainMeshLODNodes(mesh, referenceCount);
+                meshRecords[meshSlot] = CreateMeshRecord(mesh, meshMetadata);
+                _rendererContainer.MaxMeshletListBuildJobCount += referenceCount * ComputeMeshletListBuildJobCount((uint) mesh.MeshLODNodes.Length);
+            }
+
+            var allocations = new NativeArray<AAAAIndexAllocator.IndexAllocation>(count, Allocator.TempJob, NativeArrayOptions.UninitializedMemory);
+            bool allocated = _indexAllocator.AllocateBatch(count, allocations);
+            Assert.IsTrue(allocated, "Instance allocation failure. Out of memory.");
+
+            if (_indexAllocator.Capacity > _cpuBuffer.Length)
+            {
+                _cpuBuffer.ResizeArray(_indexAllocator.Capacity);
+            }
+
+            int dirtyStartIndex = _dirtyInstanceIndices.Length;
+            JobHandle registerHandle = ScheduleBulkRegistration(_metadata, instanceIDs, allocations, rendererRecords, meshRecords,
+                _instanceIndices, _instanceIndicesOwners, _dirtyInstanceIndices
+            );
+            JobHandle fillHandle = ScheduleBulkInstanceFill(transforms, allocations, rendererRecords, meshRecords, _cpuBuffer);
+            JobHandle.CombineDependencies(registerHandle, fillHandle).Complete();
+            _instanceIndicesDirty = true;
+
+            NativeArray<int> newInstanceIndices = _dirtyInstanceIndices.AsArray().GetSubArray(dirtyStartIndex, count);
+            foreach (int instanceIndex in newInstanceIndices)
+            {
+                _rendererContainer.StaticInstanceCullingCache.OnInstanceChanged(instanceIndex);
+                _rendererContainer.SceneBVH.OnInstanceChanged(instanceIndex);
+                _rendererContainer.ShadowCacheInvalidationTracker.OnCasterChanged(instanceIndex, _cpuBuffer[instanceIndex]);
+            }
+
+            allocations.Dispose();
+            meshRecords.Dispose();
+            rendererRecords.Dispose();
+            transforms.Dispose();
+        }
+
+        private static MeshRecord CreateMeshRecord(AAAAMeshletCollectionAsset mesh, in AAAARendererContainer.MeshMetadata meshMetadata) =>
+            new()
+            {
+                AABBMin = math.float4(mesh.Bounds.min, 0.0f),
+                AABBMax = math.float4(mesh.Bounds.max, 0.0f),
+                TopMeshLODStartIndex = (uint) meshMetadata.TopMeshLODNodesStartIndex,
+                TotalMeshLODCount = (uint) mesh.MeshLODNodes.Length,
+                MeshLODLevelCount = (uint) mesh.MeshLODLevelCount,
+                MeshInstanceID = mesh.GetInstanceID(),
+            };
+
+        internal static RendererRecord CreateRendererRecord(AAAARendererAuthoring rendererAuthoring, int meshSlot, int materialIndex) =>
+            new()
+            {
+                MeshSlot = meshSlot,
+                MaterialIndex = (uint) materialIndex,
+                LODErrorScale = rendererAuthoring.LODErrorScale,
+                PassMask = ExtractInstancePassMask(rendererAuthoring),
+                Flags = rendererAuthoring.isActiveAndEnabled ? AAAAInstanceFlags.None : AAAAInstanceFlags.Disabled,
+            };
+
+        internal static void WriteRecords(ref AAAAInstanceData instanceData, in MeshRecord meshRecord, in RendererRecord rendererRecord)
         {
-            int negativeDimensionsCount = (int) math.dot(math.float3(scale < 0.0f), math.float3(1, 1, 1));
-            if (negativeDimensionsCount % 2 == 1)
+            instanceData.AABBMin = meshRecord.AABBMin;
+            instanceData.AABBMax = meshRecord.AABBMax;
+            instanceData.TopMeshLODStartIndex = meshRecord.TopMeshLODStartIndex;
+            instanceData.TotalMeshLODCount = meshRecord.TotalMeshLODCount;
+            instanceData.MaterialIndex = rendererRecord.MaterialIndex;
+            instanceData.MeshLODLevelCount = meshRecord.MeshLODLevelCount;
+            instanceData.LODErrorScale = rendererRecord.LODErrorScale;
+            instanceData.PassMask = rendererRecord.PassMask;
+            instanceData.Flags = (instanceData.Flags & ~AAAAInstanceFlags.Disabled) | rendererRecord.Flags;
+        }
+
+        internal static void UpdateTransform(ref AAAAInstanceData instanceData, float4x4 localToWorldMatrix)
+        {
+            instanceData.ObjectToWorldMatrix = localToWorldMatrix;
+            instanceData.WorldToObjectMatrix = AAAAMathUtils.AffineInverse3D(localToWorldMatrix);
+
+            // An odd number of negative scale axes mirrors the mesh, which is the same as a negative determinant.
+            if (math.determinant((float3x3) localToWorldMatrix) < 0.0f)
             {
-                flags |= AAAAInstanceFlags.FlipWindingOrder;
+                instanceData.Flags |= AAAAInstanceFlags.FlipWindingOrder;
             }
             else
             {
-                flags &= ~AAAAInstanceFlags.FlipWindingOrder;
+                instanceData.Flags &= ~AAAAInstanceFlags.FlipWindingOrder;
             }
         }
 
@@ -190,27 +361,21 @@ namespace DELTation.AAAARP.Renderers
 
         public void OnRendererTransformsChanged(NativeArray<int> transformedID, NativeArray<float4x4> localToWorldMatrices)
         {
-            for (int index = 0; index < transformedID.Length; index++)
-            {
-                int instanceID = transformedID[index];
-                if (!_metadata.TryGetValue(instanceID, out InstanceMetadata metadata))
-                {
-                    continue;
-                }
-
-                ref AAAAInstanceData instanceData = ref _cpuBuffer.ElementAtRef(metadata.IndexAllocation.Index);
-                instanceData.ObjectToWorldMatrix = localToWorldMatrices[index];
-                instanceData.WorldToObjectMatrix = AAAAMathUtils.AffineInverse3D(localToWorldMatrices[index]);
-
-                float3 scale = ((Matrix4x4) instanceData.ObjectToWorldMatrix).lossyScale;
-                UpdateWindingOrderFlag(ref instanceData.Flags, scale);
-
-                _isDirty = true;
-            }
+            int movedStartIndex = _dirtyInstanceIndices.Length;
+            ScheduleTransformUpdate(_metadata, _cpuBuffer, transformedID, localToWorldMatrices, _dirtyInstanceIndices).Complete();
+
+            NativeArray<int> movedInstanceIndices =
+                _dirtyInstanceIndices.AsArray().GetSubArray(movedStartIndex, _dirtyInstanceIndices.Length - movedStartIndex);
+            _rendererContainer.StaticInstanceCullingCache.OnInstancesMoved(movedInstanceIndices);
+            _rendererContainer.SceneBVH.OnInstancesMoved(movedInstanceIndices);
+            _rendererContainer.ShadowCacheInvalidationTracker.OnCastersMoved(movedInstanceIndices, _cpuBuffer);
         }
 
         private static int ComputeMeshletListBuildJobCount(in AAAAInstanceData instanceData) =>
-            Mathf.CeilToInt((float) instanceData.TotalMeshLODCount / AAAAMeshletListBuildJob.MaxLODNodesPerThreadGroup);
+            ComputeMeshletListBuildJobCount(instanceData.TotalMeshLODCount);
+
+        private static int ComputeMeshletListBuildJobCount(uint totalMeshLODCount) =>
+            Mathf.CeilToInt((float) totalMeshLODCount / AAAAMeshletListBuildJob.MaxLODNodesPerThreadGroup);
 
         public void OnRenderersDestroyed(NativeArray<int> destroyedIDs)
         {
@@ -227,17 +392,31 @@ namespace DELTation.AAAARP.Renderers
                 Assert.IsTrue(_indexAllocator.IsValidGeneration(metadata.IndexAllocation), "Detected stale index allocation.");
 
                 _indexAllocator.Free(metadata.IndexAllocation);
+                _rendererContainer.StaticInstanceCullingCache.OnInstanceRemoved(metadata.IndexAllocation.Index);
+                _rendererContainer.SceneBVH.OnInstanceRemoved(metadata.IndexAllocation.Index);
+                _rendererContainer.ShadowCacheInvalidationTracker.OnCasterRemoved(metadata.IndexAllocation.Index);
+                _rendererContainer.ReleaseMeshLODNodes(metadata.MeshInstanceID);
+                // The freed record is no longer referenced by the instance indices, so it does not need an upload.
+                RemoveInstanceIndex(metadata.DenseIndex);
                 _metadata.Remove(instanceID);
-                _isDirty = true;
             }
         }
 
-        public void GetInstanceIndices(NativeList<int> indices)
+        private void RemoveInstanceIndex(int denseIndex)
         {
-            foreach (KVPair<int, InstanceMetadata> kvp in _metadata)
+            int lastDenseIndex = _instanceIndices.Length - 1;
+
+            if (denseIndex != lastDenseIndex)
             {
-                indices.Add(kvp.Value.IndexAllocation.Index);
+                int movedInstanceID = _instanceIndicesOwners[lastDenseIndex];
+                InstanceMetadata movedMetadata = _metadata[movedInstanceID];
+                movedMetadata.DenseIndex = denseIndex;
+                _metadata[movedInstanceID] = movedMetadata;
             }
+
+            _instanceIndices.RemoveAtSwapBack(denseIndex);
+            _instanceIndicesOwners.RemoveAtSwapBack(denseIndex);
+            _instanceIndicesDirty = true;
         }
 
         internal void GetInstanceMetadata(NativeList<InstanceMetadata> indices)
@@ -250,19 +429,158 @@ namespace DELTation.AAAARP.Renderers
 
         public void PreRender(CommandBuffer cmd)
         {
-            if (_isDirty)
+            EnsureGPUBuffersCapacity();
+
+            UploadInstanceData(cmd);
+            _dirtyInstanceIndices.Clear();
+            _isDirty = false;
+
+            cmd.SetGlobalBuffer(RendererContainerShaderIDs._InstanceData, _gpuBuffer);
+
+            if (_instanceIndicesDirty)
             {
-                cmd.SetBufferData(_gpuBuffer, _cpuBuffer);
-                _isDirty = false;
+                cmd.SetBufferData(_instanceIndicesGPUBuffer, _instanceIndices.AsArray());
+                _instanceIndicesDirty = false;
             }
+        }
 
-            cmd.SetGlobalBuffer(RendererContainerShaderIDs._InstanceData, _gpuBuffer);
+        private void UploadInstanceData(CommandBuffer cmd)
+        {
+            if (!AAAAInstanceConfiguration.CompactInstanceDataEnabled)
+            {
+                _uploader.Upload(cmd, _gpuBuffer, _cpuBuffer, _dirtyInstanceIndices, _isDirty);
+                return;
+            }
+
+            if (!_compactCPUBuffer.IsCreated || _compactCPUBuffer.Length != _cpuBuffer.Length)
+            {
+                if (_compactCPUBuffer.IsCreated)
+                {
+                    _compactCPUBuffer.Dispose();
+                }
+
+                _compactCPUBuffer = new NativeArray<AAAACompactInstanceData>(_cpuBuffer.Length, Allocator.Persistent);
+            }
+
+            JobHandle packHandle = _isDirty
+                ? SchedulePackCompactInstanceData(_cpuBuffer, _compactCPUBuffer, 0, _cpuBuffer.Length)
+                : SchedulePackCompactInstanceData(_cpuBuffer, _compactCPUBuffer, _dirtyInstanceIndices.AsArray());
+            packHandle.Complete();
+            _compactUploader.Upload(cmd, _gpuBuffer, _compactCPUBuffer, _dirtyInstanceIndices, _isDirty);
+        }
+
+        private void EnsureGPUBuffersCapacity()
+        {
+            if (_gpuBuffer == null || _gpuBuffer.count < _cpuBuffer.Length)
+            {
+                int stride = AAAAInstanceConfiguration.CompactInstanceDataEnabled
+                    ? UnsafeUtility.SizeOf<AAAACompactInstanceData>()
+                    : UnsafeUtility.SizeOf<AAAAInstanceData>();
+                _gpuBuffer?.Dispose();
+                _gpuBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, _cpuBuffer.Length, stride)
+                {
+                    name = nameof(RendererContainerShaderIDs._InstanceData),
+                };
+                _isDirty = true;
+            }
+
+            if (_instanceIndicesGPUBuffer == null || _instanceIndicesGPUBuffer.count < _cpuBuffer.Length)
+            {
+                _instanceIndicesGPUBuffer?.Dispose();
+                _instanceIndicesGPUBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Raw, _cpuBuffer.Length, sizeof(uint))
+                {
+                    name = "InstanceDataBuffer_InstanceIndices",
+                };
+                _instanceIndicesDirty = true;
+            }
         }
 
         internal struct InstanceMetadata
         {
             public AAAAIndexAllocator.IndexAllocation IndexAllocation;
+            public int DenseIndex;
+            public int MeshInstanceID;
+        }
+
+        // The parts of AAAAInstanceData that come from the mesh asset, shared by all renderers of the mesh.
+        internal struct MeshRecord
+        {
+            public float4 AABBMin;
+            public float4 AABBMax;
+            public uint TopMeshLODStartIndex;
+            public uint TotalMeshLODCount;
+            public uint MeshLODLevelCount;
             public int MeshInstanceID;
         }
+
+        // The parts of AAAAInstanceData that come from the renderer component.
+        internal struct RendererRecord
+        {
+            public int MeshSlot;
+            public uint MaterialIndex;
+            public float LODErrorScale;
+            public AAAAInstancePassMask PassMask;
+            public AAAAInstanceFlags Flags;
+        }
+
+        // Collects what the bulk registration jobs need from the managed side. Every unique mesh and material is looked up once.
+        internal sealed class BulkRegistrationBatch
+        {
+            private readonly Dictionary<AAAAMaterialAsset, int> _materialIndices = new();
+            private readonly Dictionary<AAAAMeshletCollectionAsset, int> _meshSlots = new();
+
+            public List<AAAAMeshletCollectionAsset> Meshes { get; } = new();
+            public List<int> MeshReferenceCounts { get; } = new();
+
+            public void Gather(List<AAAARendererAuthoring> renderers, Func<AAAAMaterialAsset, int> getOrAllocateMaterial,
+                NativeArray<RendererRecord> rendererRecords, TransformAccessArray transforms)
+            {
+                _materialIndices.Clear();
+                _meshSlots.Clear();
+                Meshes.Clear();
+                MeshReferenceCounts.Clear();
+
+                // Renderers of the same prefab usually come in runs, which skips most of the dictionary lookups.
+                AAAAMeshletCollectionAsset lastMesh = null;
+                AAAAMaterialAsset lastMaterial = null;
+                int meshSlot = -1;
+                int materialIndex = -1;
+
+                for (int i = 0; i < renderers.Count; i++)
+                {
+                    AAAARendererAuthoring rendererAuthoring = renderers[i];
+                    AAAAMeshletCollectionAsset mesh = rendererAuthoring.Mesh;
+                    AAAAMaterialAsset material = rendererAuthoring.Material;
+
+                    if (!ReferenceEquals(mesh, lastMesh))
+                    {
+                        if (!_meshSlots.TryGetValue(mesh, out meshSlot))
+                        {
+                            meshSlot = Meshes.Count;
+                            _meshSlots.Add(mesh, meshSlot);
+                            Meshes.Add(mesh);
+                            MeshReferenceCounts.Add(0);
+                        }
+
+                        lastMesh = mesh;
+                    }
+
+                    if (!ReferenceEquals(material, lastMaterial))
+                    {
+                        if (!_materialIndices.TryGetValue(material, out materialIndex))
+                        {
+                            materialIndex = getOrAllocateMaterial(material);
+                            _materialIndices.Add(material, materialIndex);
+                        }
+
+                        lastMaterial = material;
+                    }
+
+                    ++MeshReferenceCounts[meshSlot];
+                    rendererRecords[i] = CreateRendererRecord(rendererAuthoring, meshSlot, materialIndex);
+                    transforms.Add(rendererAuthoring.transform);
+                }
+            }
+        }
     }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 using System;
 using System.Collections.Generic;
 using DELTation.AAAARP.Materials;
+using DELTation.AAAARP.Utils;
 using Unity.Collections;
 using Unity.Collections.LowLevel.Unsafe;
 using Unity.Mathematics;
@@ -14,15 +15,21 @@ namespace DELTation.AAAARP.Renderers
     {
         private readonly BindlessTextureContainer _bindlessTextureContainer;
         private readonly Dictionary<AAAAMaterialAsset, int> _materialToIndex = new();
+        private readonly AAAASparseBufferUploader<AAAAMaterialData> _uploader;
 
+        private NativeList<int> _dirtyMaterialIndices;
         private bool _isDirty = true;
         private NativeList<AAAAMaterialData> _materialData;
         private GraphicsBuffer _materialDataBuffer;
 
-        public MaterialDataBuffer(BindlessTextureContainer bindlessTextureContainer, Allocator allocator)
+        public MaterialDataBuffer(BindlessTextureContainer bindlessTextureContainer, ComputeShader scatterUploadCS, Allocator allocator)
         {
             _bindlessTextureContainer = bindlessTextureContainer;
             _materialData = new NativeList<AAAAMaterialData>(allocator);
+            _dirtyMaterialIndices = new NativeList<int>(allocator);
+            _uploader = new AAAASparseBufferUploader<AAAAMaterialData>(scatterUploadCS, AAAASparseBufferUpload.MaterialDataKernelIndex,
+                AAAASparseBufferUpload.ShaderID._ScatterMaterialRecords, AAAASparseBufferUpload.ShaderID._ScatterMaterialDestination, "MaterialData"
+            );
         }
 
         public void Dispose()
@@ -32,6 +39,12 @@ namespace DELTation.AAAARP.Renderers
                 _materialData.Dispose();
             }
 
+            if (_dirtyMaterialIndices.IsCreated)
+            {
+                _dirtyMaterialIndices.Dispose();
+            }
+
+            _uploader.Dispose();
             _materialDataBuffer?.Dispose();
         }
 
@@ -44,18 +57,21 @@ namespace DELTation.AAAARP.Renderers
 
         private void UploadData(CommandBuffer cmd)
         {
-            if (_isDirty)
+            if (_materialDataBuffer == null || _materialDataBuffer.count < _materialData.Length)
             {
                 _materialDataBuffer?.Dispose();
                 _materialDataBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured,
-                    math.max(1, _materialData.Length), UnsafeUtility.SizeOf<AAAAMaterialData>()
+                    math.max(1, Mathf.NextPowerOfTwo(_materialData.Length)), UnsafeUtility.SizeOf<AAAAMaterialData>()
                 )
                 {
                     name = "MaterialData",
                 };
-                cmd.SetBufferData(_materialDataBuffer, _materialData.AsArray());
-                _isDirty = false;
+                _isDirty = true;
             }
+
+            _uploader.Upload(cmd, _materialDataBuffer, _materialData.AsArray(), _dirtyMaterialIndices, _isDirty);
+            _dirtyMaterialIndices.Clear();
+            _isDirty = false;
         }
 
         public int GetOrAllocateMaterial(AAAAMaterialAsset material)
@@ -69,7 +85,7 @@ namespace DELTation.AAAARP.Renderers
             _materialData.Add(materialData);
             index = _materialData.Length - 1;
             _materialToIndex.Add(material, index);
-            _isDirty = true;
+            _dirtyMaterialIndices.Add(index);
             return index;
         }
 
@@ -91,7 +107,7 @@ namespace DELTation.AAAARP.Renderers
                 if (_materialToIndex.TryGetValue(material, out int materialIndex))
                 {
                     _materialData[materialIndex] = ConvertAssetToData(material);
-                    _isDirty = true;
+                    _dirtyMaterialIndices.Add(materialIndex);
                 }
             }
         }
@@ -16,19 +16,34 @@ namespace DELTation.AAAARP.Renderers
         private int _frameIndex;
         private bool _isDirty;
 
-        public OcclusionCullingResources(AAAARawBufferClear rawBufferClear)
+        public OcclusionCullingResources(AAAARawBufferClear rawBufferClear, int instanceCapacity)
         {
             _frameResources = new FrameResources[FramesInFlight];
             _rawBufferClear = rawBufferClear;
 
+            EnsureInstanceCapacity(instanceCapacity);
+        }
+
+        public int InstanceVisibilityMaskItemCount { get; private set; }
+
+        // Growing drops the visibility history, the false negative pass recovers the instances in the same frame.
+        public void EnsureInstanceCapacity(int instanceCapacity)
+        {
             const int stride = sizeof(uint);
             const int instancesPerItem = stride * 8;
-            InstanceVisibilityMaskItemCount = AAAAMathUtils.AlignUp(InstanceDataBuffer.Capacity, instancesPerItem) / instancesPerItem;
+            int itemCount = AAAAMathUtils.AlignUp(instanceCapacity, instancesPerItem) / instancesPerItem;
+            if (itemCount <= InstanceVisibilityMaskItemCount)
+            {
+                return;
+            }
+
+            InstanceVisibilityMaskItemCount = itemCount;
 
             for (int index = 0; index < FramesInFlight; index++)
             {
                 ref FrameResources frameResources = ref _frameResources[index];
 
+                frameResources.Dispose();
                 frameResources.InstanceVisibilityMask = new GraphicsBuffer(GraphicsBuffer.Target.Raw, InstanceVisibilityMaskItemCount, stride)
                 {
                     name = $"{nameof(OcclusionCullingResources)}_{nameof(FrameResources.InstanceVisibilityMask)}[{index}]",
@@ -38,8 +53,6 @@ namespace DELTation.AAAARP.Renderers
             _isDirty = true;
         }
 
-        public int InstanceVisibilityMaskItemCount { get; }
-
         public void Dispose()
         {
             for (int index = 0; index < _frameResources.Length; index++)
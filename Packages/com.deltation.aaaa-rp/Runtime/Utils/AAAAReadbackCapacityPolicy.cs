@@ -0,0 +1,121 @@
+using System;
+using Unity.Mathematics;
+
+namespace DELTation.AAAARP.Utils
+{
+    // Sizes a GPU-written list (e.g., meshlet render requests or clustered light indices) from the counts the GPU actually produced,
+    // instead of the worst case. The counts arrive through async readbacks a few frames late, so the capacity keeps headroom above the observed peak.
+    // Growing happens on the first update that comes close to (or over) the capacity. Shrinking waits until the peak has stayed low for
+    // ShrinkDelay updates, so that a camera moving back and forth does not reallocate the buffers every few frames.
+    public sealed class AAAAReadbackCapacityPolicy
+    {
+        private int _capacity;
+        private uint _shrinkWindowPeak;
+        private int _updatesBelowShrinkThreshold;
+
+        public AAAAReadbackCapacityPolicy() : this(Settings.Default) { }
+
+        public AAAAReadbackCapacityPolicy(in Settings settings) => PolicySettings = settings;
+
+        public Settings PolicySettings { get; set; }
+
+        public bool HasSamples => _capacity > 0;
+
+        public void Reset()
+        {
+            _capacity = 0;
+            ResetShrinkWindow();
+        }
+
+        // Until the first readback arrives, nothing is known about the scene, so the worst case is used.
+        public int GetCapacity(int worstCaseCapacity)
+        {
+            worstCaseCapacity = math.max(1, worstCaseCapacity);
+            return HasSamples ? math.min(_capacity, worstCaseCapacity) : worstCaseCapacity;
+        }
+
+        // peakRequestCount is the largest number of entries any single list asked for, including the ones that were dropped.
+        // Returns the capacity to allocate.
+        public int Update(uint peakRequestCount, int worstCaseCapacity)
+        {
+            Settings settings = PolicySettings;
+            worstCaseCapacity = math.max(1, worstCaseCapacity);
+            int requiredCapacity = ComputeRequiredCapacity(peakRequestCount, worstCaseCapacity);
+
+            if (!HasSamples)
+            {
+                _capacity = requiredCapacity;
+                ResetShrinkWindow();
+                return _capacity;
+            }
+
+            _capacity = math.min(_capacity, worstCaseCapacity);
+
+            if (peakRequestCount > _capacity * settings.GrowThreshold)
+            {
+                _capacity = math.max(_capacity, requiredCapacity);
+                ResetShrinkWindow();
+                return _capacity;
+            }
+
+            if (requiredCapacity < _capacity * settings.ShrinkThreshold)
+            {
+                _shrinkWindowPeak = math.max(_shrinkWindowPeak, peakRequestCount);
+
+                if (++_updatesBelowShrinkThreshold >= settings.ShrinkDelay)
+                {
+                    _capacity = ComputeRequiredCapacity(_shrinkWindowPeak, worstCaseCapacity);
+                    ResetShrinkWindow();
+                }
+            }
+            else
+            {
+                ResetShrinkWindow();
+            }
+
+            return _capacity;
+        }
+
+        private int ComputeRequiredCapacity(uint peakRequestCount, int worstCaseCapacity)
+        {
+            Settings settings = PolicySettings;
+            double capacity = math.ceil(peakRequestCount * (1.0 + settings.Headroom));
+            int granularity = math.max(1, settings.Granularity);
+            capacity = math.ceil(capacity / granularity) * granularity;
+            capacity = math.max(capacity, settings.MinCapacity);
+            return (int) math.min(capacity, worstCaseCapacity);
+        }
+
+        private void ResetShrinkWindow()
+        {
+            _shrinkWindowPeak = 0;
+            _updatesBelowShrinkThreshold = 0;
+        }
+
+        [Serializable]
+        public struct Settings
+        {
+            // Extra room on top of the peak, relative to it.
+            public float Headroom;
+            // Grow as soon as the peak takes more than this fraction of the capacity.
+            public float GrowThreshold;
+            // Shrink only when the required capacity is less than this fraction of the current one...
+            public float ShrinkThreshold;
+            // ...for this many consecutive updates.
+            public int ShrinkDelay;
+            // Capacities are rounded up to a multiple of this, so that small fluctuations do not cause reallocations.
+            public int Granularity;
+            public int MinCapacity;
+
+            public static Settings Default => new()
+            {
+                Headroom = 0.25f,
+                GrowThreshold = 0.9f,
+                ShrinkThreshold = 0.5f,
+                ShrinkDelay = 120,
+                Granularity = 1024,
+                MinCapacity = 1024,
+            };
+        }
+    }
+}
@@ -0,0 +1,228 @@
+using System;
+using System.Diagnostics.CodeAnalysis;
+using DELTation.AAAARP.Core;
+using DELTation.AAAARP.Utils;
+using Unity.Burst;
+using Unity.Collections;
+using Unity.Collections.LowLevel.Unsafe;
+using Unity.Jobs;
+using UnityEngine;
+using UnityEngine.Assertions;
+using UnityEngine.Rendering;
+
+[assembly: RegisterGenericJobType(typeof(AAAASparseBufferUploader<DELTation.AAAARP.AAAAInstanceData>.GatherDirtyRecordsJob))]
+[assembly: RegisterGenericJobType(typeof(AAAASparseBufferUploader<DELTation.AAAARP.AAAACompactInstanceData>.GatherDirtyRecordsJob))]
+[assembly: RegisterGenericJobType(typeof(AAAASparseBufferUploader<DELTation.AAAARP.AAAAMaterialData>.GatherDirtyRecordsJob))]
+
+namespace DELTation.AAAARP.Utils
+{
+    [GenerateHLSL]
+    public static class AAAASparseBufferUpload
+    {
+        public const int InstanceDataKernelIndex = 0;
+        public const int MaterialDataKernelIndex = 1;
+        public const int ThreadGroupSize = 64;
+
+        [SuppressMessage("ReSharper", "InconsistentNaming")]
+        internal static class ShaderID
+        {
+            public static readonly int _ScatterItemCount = Shader.PropertyToID(nameof(_ScatterItemCount));
+            public static readonly int _ScatterIndices = Shader.PropertyToID(nameof(_ScatterIndices));
+            public static readonly int _ScatterInstanceRecords = Shader.PropertyToID(nameof(_ScatterInstanceRecords));
+            public static readonly int _ScatterInstanceDestination = Shader.PropertyToID(nameof(_ScatterInstanceDestination));
+            public static readonly int _ScatterMaterialRecords = Shader.PropertyToID(nameof(_ScatterMaterialRecords));
+            public static readonly int _ScatterMaterialDestination = Shader.PropertyToID(nameof(_ScatterMaterialDestination));
+        }
+    }
+
+    // Uploads only the records whose indices were marked dirty: the (index, record) pairs are streamed to the GPU
+    // and scattered into the persistent buffer by a compute kernel.
+    public sealed class AAAASparseBufferUploader<T> : IDisposable where T : unmanaged
+    {
+        public enum UploadMode
+        {
+            None,
+            Scatter,
+            Bulk,
+        }
+
+        // Past this fraction of dirty records a plain copy of the whole buffer is cheaper than the scatter.
+        public const float BulkUploadThreshold = 0.5f;
+
+        private readonly int _destinationID;
+        private readonly int _kernelIndex;
+        private readonly string _name;
+        private readonly int _recordsID;
+        private readonly ComputeShader _scatterCS;
+        private GraphicsBuffer _indicesBuffer;
+        private GraphicsBuffer _recordsBuffer;
+
+        private NativeList<int> _stagingIndices;
+        private NativeList<T> _stagingRecords;
+
+        public AAAASparseBufferUploader(ComputeShader scatterCS, int kernelIndex, int recordsID, int destinationID, string name)
+        {
+            _scatterCS = scatterCS;
+            _kernelIndex = kernelIndex;
+            _recordsID = recordsID;
+            _destinationID = destinationID;
+            _name = name;
+            _stagingIndices = new NativeList<int>(Allocator.Persistent);
+            _stagingRecords = new NativeList<T>(Allocator.Persistent);
+        }
+
+        public int LastUploadedBytes { get; private set; }
+
+        public static int RecordStride => UnsafeUtility.SizeOf<T>();
+
+        internal NativeArray<int> StagingIndices => _stagingIndices.AsArray();
+        internal NativeArray<T> StagingRecords => _stagingRecords.AsArray();
+
+        public void Dispose()
+        {
+            if (_stagingIndices.IsCreated)
+            {
+                _stagingIndices.Dispose();
+            }
+
+            if (_stagingRecords.IsCreated)
+            {
+                _stagingRecords.Dispose();
+            }
+
+            _indicesBuffer?.Dispose();
+            _indicesBuffer = null;
+
+            _recordsBuffer?.Dispose();
+            _recordsBuffer = null;
+        }
+
+        // The dirty indices are sorted in place and may contain duplicates.
+        public UploadMode Upload(CommandBuffer cmd, GraphicsBuffer destination, NativeArray<T> source, NativeList<int> dirtyIndices, bool forceBulk)
+        {
+            UploadMode uploadMode = Prepare(source, dirtyIndices, forceBulk);
+
+            switch (uploadMode)
+            {
+                case UploadMode.None:
+                    break;
+                case UploadMode.Bulk:
+                    cmd.SetBufferData(destination, source);
+                    break;
+                case UploadMode.Scatter:
+                    DispatchScatter(cmd, destination);
+                    break;
+                default:
+                    throw new ArgumentOutOfRangeException();
+            }
+
+            return uploadMode;
+        }
+
+        internal UploadMode Prepare(NativeArray<T> source, NativeList<int> dirtyIndices, bool forceBulk)
+        {
+            _stagingIndices.Clear();
+            _stagingRecords.Clear();
+
+            if (forceBulk || dirtyIndices.Length >= source.Length)
+            {
+                LastUploadedBytes = source.Length * RecordStride;
+                return source.Length > 0 ? UploadMode.Bulk : UploadMode.None;
+            }
+
+            if (dirtyIndices.Length == 0)
+            {
+                LastUploadedBytes = 0;
+                return UploadMode.None;
+            }
+
+            new GatherDirtyRecordsJob
+                {
+                    Source = source,
+                    DirtyIndices = dirtyIndices.AsArray(),
+                    StagingIndices = _stagingIndices,
+                    StagingRecords = _stagingRecords,
+                }
+                .Run();
+
+            if (_stagingIndices.Length > source.Length * BulkUploadThreshold)
+            {
+                LastUploadedBytes = source.Length * RecordStride;
+                return UploadMode.Bulk;
+            }
+
+            LastUploadedBytes = _stagingIndices.Length * (sizeof(int) + RecordStride);
+            return UploadMode.Scatter;
+        }
+
+        private void DispatchScatter(CommandBuffer cmd, GraphicsBuffer destination)
+        {
+            int itemCount = _stagingIndices.Length;
+            EnsureStagingBuffersCapacity(itemCount);
+
+            cmd.SetBufferData(_indicesBuffer, _stagingIndices.AsArray(), 0, 0, itemCount);
+            cmd.SetBufferData(_recordsBuffer, _stagingRecords.AsArray(), 0, 0, itemCount);
+
+            cmd.SetComputeIntParam(_scatterCS, AAAASparseBufferUpload.ShaderID._ScatterItemCount, itemCount);
+            cmd.SetComputeBufferParam(_scatterCS, _kernelIndex, AAAASparseBufferUpload.ShaderID._ScatterIndices, _indicesBuffer);
+            cmd.SetComputeBufferParam(_scatterCS, _kernelIndex, _recordsID, _recordsBuffer);
+            cmd.SetComputeBufferParam(_scatterCS, _kernelIndex, _destinationID, destination);
+
+            int threadGroups = AAAAMathUtils.AlignUp(itemCount, AAAASparseBufferUpload.ThreadGroupSize) / AAAASparseBufferUpload.ThreadGroupSize;
+            Assert.IsTrue(threadGroups <= ComputeUtils.MaxThreadGroups, "Sparse Buffer Upload: too many dirty records for a single dispatch.");
+            cmd.DispatchCompute(_scatterCS, _kernelIndex, threadGroups, 1, 1);
+        }
+
+        private void EnsureStagingBuffersCapacity(int itemCount)
+        {
+            if (_indicesBuffer != null && _indicesBuffer.count >= itemCount)
+            {
+                return;
+            }
+
+            int capacity = Mathf.NextPowerOfTwo(itemCount);
+
+            _indicesBuffer?.Dispose();
+            _indicesBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, capacity, sizeof(int))
+            {
+                name = _name + "_ScatterIndices",
+            };
+
+            _recordsBuffer?.Dispose();
+            _recordsBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, capacity, RecordStride)
+            {
+                name = _name + "_ScatterRecords",
+            };
+        }
+
+        [BurstCompile]
+        internal struct GatherDirtyRecordsJob : IJob
+        {
+            [ReadOnly]
+            public NativeArray<T> Source;
+            public NativeArray<int> DirtyIndices;
+
+            public NativeList<int> StagingIndices;
+            public NativeList<T> StagingRecords;
+
+            public void Execute()
+            {
+                DirtyIndices.Sort();
+
+                int previousIndex = -1;
+
+                foreach (int index in DirtyIndices)
+                {
+                    if (index == previousIndex)
+                    {
+                        continue;
+                    }
+
+                    StagingIndices.Add(index);
+                    StagingRecords.Add(Source[index]);
+                    previousIndex = index;
+                }
+            }
+        }
+    }
+}
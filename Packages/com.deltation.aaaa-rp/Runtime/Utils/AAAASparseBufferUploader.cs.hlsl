@@ -0,0 +1,15 @@
+//
+// This file was automatically generated. Please don't edit by hand. Execute Editor command [ Edit > Rendering > Generate Shader Includes ] instead
+//
+
+#ifndef AAAASPARSEBUFFERUPLOADER_CS_HLSL
+#define AAAASPARSEBUFFERUPLOADER_CS_HLSL
+//
+// DELTation.AAAARP.Utils.AAAASparseBufferUpload:  static fields
+//
+#define INSTANCE_DATA_KERNEL_INDEX (0)
+#define MATERIAL_DATA_KERNEL_INDEX (1)
+#define THREAD_GROUP_SIZE (64)
+
+
+#endif
\ No newline at end of file
@@ -17,10 +17,17 @@ namespace DELTation.AAAARP.Volumes
         public ClampedFloatParameter DirectionalLightCascadeDistance1 = new(0.25f, 0.0f, 1.0f);
         public ClampedFloatParameter DirectionalLightCascadeDistance2 = new(0.5f, 0.0f, 1.0f);
         public ClampedFloatParameter DirectionalLightCascadeDistance3 = new(0.75f, 0.0f, 1.0f);
+        public ClampedIntParameter DirectionalLightNearCascades = new(DefaultDirectionalLightNearCascades, 1, MaxCascades);
+        public ClampedIntParameter DirectionalLightFarCascadeUpdateInterval =
+            new(DefaultDirectionalLightFarCascadeUpdateInterval, 1, MaxDirectionalLightFarCascadeUpdateInterval);
+        public ClampedFloatParameter DirectionalLightFarCascadeGuardBand = new(DefaultDirectionalLightFarCascadeGuardBand, 0.0f, 0.5f);
         public ClampedFloatParameter DepthBias = new(DefaultDepthBias, 0.0f, 1.0f);
         public ClampedFloatParameter PunctualDepthBias = new(DefaultPunctualDepthBias, 0.0f, 1.0f);
         public ClampedFloatParameter SlopeBias = new(DefaultSlopeBias, 0.0f, 1.0f);
         public ClampedFloatParameter ShadowFade = new(DefaultShadowFade, 0.0f, 1.0f);
+        public BoolParameter CasterLODFromShadowMapTexels = new(true);
+        public ClampedFloatParameter CasterLODErrorScale = new(1.0f, MinCasterLODErrorScale, MaxCasterLODErrorScale);
+        public BoolParameter ConservativeCasterLOD = new(false);
 
         public AAAAShadowSettingsComponent() => displayName = "AAAA Shadow Settings";
     }
@@ -77,6 +77,15 @@ struct GPUCullingDebug
     {
         OnCulled((boundingSquareSS.MinUV + boundingSquareSS.MaxUV) * 0.5f, cullingGranularity, cullingType);
     }
+
+    static void OnVisibleMeshlet(const BoundingSquareSS boundingSquareSS, const uint triangleCount)
+    {
+        #ifdef DEBUG_GPU_CULLING
+        const uint itemIndex = ScreenUVToBufferItemIndex((boundingSquareSS.MinUV + boundingSquareSS.MaxUV) * 0.5f);
+        InterlockedAdd(_GPUCullingDebugDataBuffer[itemIndex].VisibleMeshlets, 1);
+        InterlockedAdd(_GPUCullingDebugDataBuffer[itemIndex].VisibleTriangles, triangleCount);
+        #endif
+    }
     #endif
 };
 
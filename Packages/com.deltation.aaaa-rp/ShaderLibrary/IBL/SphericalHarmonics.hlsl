@@ -0,0 +1,74 @@
+#ifndef AAAA_IBL_SPHERICAL_HARMONICS_INCLUDED
+#define AAAA_IBL_SPHERICAL_HARMONICS_INCLUDED
+
+#include "Packages/com.deltation.aaaa-rp/ShaderLibrary/Math.hlsl"
+
+// Keep in sync with AAAASphericalHarmonics.
+
+#define SH9_COEFFICIENT_COUNT 9
+
+// Real spherical harmonics up to band 2.
+void EvaluateSH9Basis(const float3 d, out float basis[SH9_COEFFICIENT_COUNT])
+{
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * d.y;
+    basis[2] = 0.488603f * d.z;
+    basis[3] = 0.488603f * d.x;
+    basis[4] = 1.092548f * d.x * d.y;
+    basis[5] = 1.092548f * d.y * d.z;
+    basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+    basis[7] = 1.092548f * d.x * d.z;
+    basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+}
+
+// Convolution with the clamped cosine lobe, divided by PI to match ConvolveDiffuseIrradiance.shader.
+// https://cseweb.ucsd.edu/~ravir/papers/envmap/envmap.pdf
+float GetSH9IrradianceScale(const uint coefficientIndex)
+{
+    return coefficientIndex == 0 ? 1.0f : coefficientIndex < 4 ? 2.0f / 3.0f : 0.25f;
+}
+
+// Same sides as CubemapUtils. uv is in [-1, 1].
+float3 GetCubemapSampleDirection(const uint sideIndex, const float2 uv)
+{
+    static const float3 forwards[6] = {
+        float3(1, 0, 0), float3(-1, 0, 0),
+        float3(0, 1, 0), float3(0, -1, 0),
+        float3(0, 0, 1), float3(0, 0, -1),
+    };
+    static const float3 ups[6] = {
+        float3(0, 1, 0), float3(0, 1, 0),
+        float3(0, 0, -1), float3(0, 0, 1),
+        float3(0, 1, 0), float3(0, 1, 0),
+    };
+
+    const float3 forward = forwards[sideIndex];
+    const float3 up = ups[sideIndex];
+    const float3 right = cross(forward, up);
+    return normalize(forward + right * uv.x + up * uv.y);
+}
+
+float GetCubemapTexelSolidAngle(const float2 uv, const float texelSize)
+{
+    const float distanceSq = 1.0f + dot(uv, uv);
+    return texelSize * texelSize / (distanceSq * sqrt(distanceSq));
+}
+
+// SH can ring below zero around bright, small sources.
+float3 EvaluateSH9Irradiance(const float4 coefficients[SH9_COEFFICIENT_COUNT], const float3 normal)
+{
+    float basis[SH9_COEFFICIENT_COUNT];
+    EvaluateSH9Basis(normal, basis);
+
+    float3 irradiance = 0.0f;
+
+    UNITY_UNROLL
+    for (uint i = 0; i < SH9_COEFFICIENT_COUNT; ++i)
+    {
+        irradiance += coefficients[i].rgb * basis[i];
+    }
+
+    return max(irradiance, 0.0f);
+}
+
+#endif // AAAA_IBL_SPHERICAL_HARMONICS_INCLUDED
@@ -223,4 +223,24 @@ struct BoundingSquareSS
     float  NDCMinZ;
 };
 
+// Inverse of a matrix whose last row is (0, 0, 0, 1).
+float4x4 AffineInverse3D(const float4x4 m)
+{
+    const float3 r0 = m[0].xyz;
+    const float3 r1 = m[1].xyz;
+    const float3 r2 = m[2].xyz;
+    const float3 t = float3(m[0].w, m[1].w, m[2].w);
+
+    const float3 c12 = cross(r1, r2);
+    const float3x3 inverse3X3 = transpose(float3x3(c12, cross(r2, r0), cross(r0, r1))) / dot(r0, c12);
+    const float3 inverseT = -mul(inverse3X3, t);
+
+    return float4x4(
+        float4(inverse3X3[0], inverseT.x),
+        float4(inverse3X3[1], inverseT.y),
+        float4(inverse3X3[2], inverseT.z),
+        float4(0, 0, 0, 1)
+    );
+}
+
 #endif // AAAA_MATH_INCLUDED
\ No newline at end of file
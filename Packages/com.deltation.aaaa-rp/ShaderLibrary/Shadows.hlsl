@@ -64,8 +64,11 @@ struct CascadedDirectionalLightShadowSample : ShadowSample
     float cascadeIndex;
 };
 
-float SampleShadowMap(const uint index, const float4 atlasSize, const float3 shadowCoords, const bool isSoftShadow)
+float SampleShadowMap(const uint index, const float4 atlasSize, const float4 atlasTileBounds, float3 shadowCoords, const bool isSoftShadow)
 {
+    // Keep the filter footprint inside the tile, the neighboring tiles belong to other splits.
+    shadowCoords.xy = clamp(shadowCoords.xy, atlasTileBounds.xy, atlasTileBounds.zw);
+
     const Texture2D<float>       shadowMap = GetBindlessTexture2DFloat(index);
     const SamplerComparisonState shadowMapSampler = sampler_LinearClampCompare;
 
@@ -183,7 +186,8 @@ CascadedDirectionalLightShadowSample SampleCascadedDirectionalLightShadow(const
             const bool   isPerspective = false;
             const float3 shadowCoords = TransformWorldToShadowCoords(positionWS, selectedCascadeSlice.WorldToShadowCoords, isPerspective);
             shadowSample.shadowAttenuation = SampleShadowMap(NonUniformResourceIndex(bindlessShadowMapIndex),
-                                                             selectedCascadeSlice.AtlasSize, shadowCoords, isSoftShadow);
+                                                             selectedCascadeSlice.AtlasSize, selectedCascadeSlice.AtlasTileBounds,
+                                                             shadowCoords, isSoftShadow);
             ApplyShadowFadeAndStrength(shadowSample.shadowFade, shadowSample.shadowAttenuation, shadowStrength, positionWS, fadeParams);
         }
     }
@@ -206,7 +210,8 @@ ShadowSample SampleSpotLightShadow(const float3 positionWS, const float   sliceI
         const bool   isPerspective = true;
         const float3 shadowCoords = TransformWorldToShadowCoords(positionWS, shadowLightSlice.WorldToShadowCoords, isPerspective);
         shadowSample.shadowAttenuation = SampleShadowMap(NonUniformResourceIndex(bindlessShadowMapIndex),
-                                                         shadowLightSlice.AtlasSize, shadowCoords, isSoftShadow);
+                                                         shadowLightSlice.AtlasSize, shadowLightSlice.AtlasTileBounds,
+                                                         shadowCoords, isSoftShadow);
         ApplyShadowFadeAndStrength(shadowSample.shadowFade, shadowSample.shadowAttenuation, shadowStrength, positionWS, fadeParams);
     }
 
@@ -230,7 +235,8 @@ ShadowSample SamplePointLightShadow(const float3 positionWS, const float3  light
         const bool   isPerspective = true;
         const float3 shadowCoords = TransformWorldToShadowCoords(positionWS, shadowLightSlice.WorldToShadowCoords, isPerspective);
         shadowSample.shadowAttenuation = SampleShadowMap(NonUniformResourceIndex(bindlessShadowMapIndex),
-                                                         shadowLightSlice.AtlasSize, shadowCoords, isSoftShadow);
+                                                         shadowLightSlice.AtlasSize, shadowLightSlice.AtlasTileBounds,
+                                                         shadowCoords, isSoftShadow);
         ApplyShadowFadeAndStrength(shadowSample.shadowFade, shadowSample.shadowAttenuation, shadowStrength, positionWS, fadeParams);
     }
 
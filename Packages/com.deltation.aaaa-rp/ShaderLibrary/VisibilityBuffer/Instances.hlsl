@@ -3,6 +3,53 @@
 
 #include "Packages/com.deltation.aaaa-rp/Runtime/AAAAStructs.cs.hlsl"
 
+#if USE_COMPACT_INSTANCE_DATA
+
+#include "Packages/com.deltation.aaaa-rp/ShaderLibrary/Math.hlsl"
+
+StructuredBuffer<AAAACompactInstanceData> _InstanceData;
+
+// Mirrors AAAACompactInstanceData.Unpack.
+AAAAInstanceData UnpackInstanceData(const AAAACompactInstanceData compactInstanceData)
+{
+    AAAAInstanceData instanceData;
+    instanceData.ObjectToWorldMatrix = float4x4(
+        compactInstanceData.ObjectToWorldRow0,
+        compactInstanceData.ObjectToWorldRow1,
+        compactInstanceData.ObjectToWorldRow2,
+        float4(0, 0, 0, 1)
+    );
+    instanceData.WorldToObjectMatrix = AffineInverse3D(instanceData.ObjectToWorldMatrix);
+    instanceData.AABBMin = float4(
+        f16tof32(compactInstanceData.AABBPacked0),
+        f16tof32(compactInstanceData.AABBPacked0 >> 16),
+        f16tof32(compactInstanceData.AABBPacked1),
+        0.0f
+    );
+    instanceData.AABBMax = float4(
+        f16tof32(compactInstanceData.AABBPacked1 >> 16),
+        f16tof32(compactInstanceData.AABBPacked2),
+        f16tof32(compactInstanceData.AABBPacked2 >> 16),
+        0.0f
+    );
+    instanceData.TopMeshLODStartIndex = compactInstanceData.TopMeshLODStartIndex;
+    instanceData.TotalMeshLODCount = compactInstanceData.TotalMeshLODCount;
+    instanceData.MaterialIndex = compactInstanceData.MaterialIndex;
+    instanceData.MeshLODLevelCount = compactInstanceData.PackedFields & 0xFFu;
+    instanceData.LODErrorScale = compactInstanceData.LODErrorScale;
+    instanceData.PassMask = compactInstanceData.PackedFields >> 8 & 0xFFu;
+    instanceData.Flags = compactInstanceData.PackedFields >> 16 & 0xFFu;
+    instanceData.Padding0 = 0;
+    return instanceData;
+}
+
+AAAAInstanceData PullInstanceData(const uint instanceID)
+{
+    return UnpackInstanceData(_InstanceData[instanceID]);
+}
+
+#else
+
 StructuredBuffer<AAAAInstanceData> _InstanceData;
 
 AAAAInstanceData PullInstanceData(const uint instanceID)
@@ -10,4 +57,6 @@ AAAAInstanceData PullInstanceData(const uint instanceID)
     return _InstanceData[instanceID];
 }
 
+#endif
+
 #endif // AAAA_VISIBILITY_BUFFER_INSTANCES_INCLUDED
\ No newline at end of file
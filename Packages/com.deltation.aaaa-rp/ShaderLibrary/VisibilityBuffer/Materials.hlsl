@@ -14,6 +14,31 @@ AAAAMaterialData PullMaterialData(const uint materialIndex)
     return _MaterialData[materialIndex];
 }
 
+// Meshlet list build and meshlet culling have to agree on the list, since the former reserves space for the latter.
+uint GetRendererListID(const AAAAInstanceData instanceData, const AAAAMaterialData materialData)
+{
+    #ifdef VOXELIZATION_PASS
+    return AAAARENDERERLISTID_DEFAULT;
+    #else
+    uint rendererListID = materialData.RendererListID;
+
+    if (instanceData.Flags & AAAAINSTANCEFLAGS_FLIP_WINDING_ORDER &&
+        !(rendererListID & AAAARENDERERLISTID_CULL_OFF))
+    {
+        if (rendererListID & AAAARENDERERLISTID_CULL_FRONT)
+        {
+            rendererListID &= ~AAAARENDERERLISTID_CULL_FRONT;
+        }
+        else
+        {
+            rendererListID |= AAAARENDERERLISTID_CULL_FRONT;
+        }
+    }
+
+    return rendererListID;
+    #endif
+}
+
 #define MATERIAL_DEFAULT_SAMPLER (sampler_TrilinearRepeat_Aniso16)
 
 struct InterpolatedUV
@@ -1,12 +1,48 @@
 Shader "Hidden/AAAA/IBL/ConvolveDiffuseIrradiance"
 {
     HLSLINCLUDE
-    #pragma target 2.0
     #pragma editor_sync_compilation
 
     #include "Packages/com.deltation.aaaa-rp/ShaderLibrary/Core.hlsl"
     #include "Packages/com.unity.render-pipelines.core/ShaderLibrary/Color.hlsl"
     #include "Packages/com.unity.render-pipelines.core/ShaderLibrary/EntityLighting.hlsl"
+
+    struct Attributes
+    {
+        uint vertexID : SV_VertexID;
+        UNITY_VERTEX_INPUT_INSTANCE_ID
+    };
+
+    struct Varyings
+    {
+        float4 positionCS : SV_POSITION;
+        float3 normal : NORMAL;
+    };
+
+    float4 _Forward;
+    float4 _Up;
+
+    Varyings Vert(Attributes input)
+    {
+        Varyings output;
+        UNITY_SETUP_INSTANCE_ID(input);
+        UNITY_INITIALIZE_VERTEX_OUTPUT_STEREO(output);
+
+        float4 pos = GetFullScreenTriangleVertexPosition(input.vertexID);
+
+        output.positionCS = pos;
+
+        float2 uv = GetFullScreenTriangleTexCoord(input.vertexID);
+        uv -= 0.5f; // [0, 1] -> [-0.5, 0.5]
+        uv *= -1.0f; // flip the vertical coord
+
+        float3 forward = _Forward.xyz;
+        float3 up = _Up.xyz;
+        float3 right = cross(forward, up);
+        output.normal = forward * 0.5f + up * uv.y + right * uv.x;
+
+        return output;
+    }
     ENDHLSL
 
     SubShader
@@ -26,50 +62,14 @@ Shader "Hidden/AAAA/IBL/ConvolveDiffuseIrradiance"
             Cull Off
 
             HLSLPROGRAM
+            #pragma target 2.0
             #pragma vertex Vert
             #pragma fragment Frag
 
-            struct Attributes
-            {
-                uint vertexID : SV_VertexID;
-                UNITY_VERTEX_INPUT_INSTANCE_ID
-            };
-
-            struct Varyings
-            {
-                float4 positionCS : SV_POSITION;
-                float3 normal : NORMAL;
-            };
-
             TEXTURECUBE(_Source);
             SAMPLER(sampler_Source);
             float4 _SourceHDRDecodeValues;
 
-            float4 _Forward;
-            float4 _Up;
-
-            Varyings Vert(Attributes input)
-            {
-                Varyings output;
-                UNITY_SETUP_INSTANCE_ID(input);
-                UNITY_INITIALIZE_VERTEX_OUTPUT_STEREO(output);
-
-                float4 pos = GetFullScreenTriangleVertexPosition(input.vertexID);
-
-                output.positionCS = pos;
-
-                float2 uv = GetFullScreenTriangleTexCoord(input.vertexID);
-                uv -= 0.5f; // [0, 1] -> [-0.5, 0.5]
-                uv *= -1.0f; // flip the vertical coord
-
-                float3 forward = _Forward.xyz;
-                float3 up = _Up.xyz;
-                float3 right = cross(forward, up);
-                output.normal = forward * 0.5f + up * uv.y + right * uv.x;
-
-                return output;
-            }
-
             float4 Frag(const Varyings IN) : SV_Target
             {
                 // https://learnopengl.com/PBR/IBL/Diffuse-irradiance
@@ -104,6 +104,40 @@ Shader "Hidden/AAAA/IBL/ConvolveDiffuseIrradiance"
             }
             ENDHLSL
         }
+
+        Pass
+        {
+            Name "Evaluate SH9 Diffuse Irradiance"
+
+            ZWrite Off
+            ZTest Off
+            ZClip Off
+            Cull Off
+
+            HLSLPROGRAM
+            #pragma target 4.5
+            #pragma vertex Vert
+            #pragma fragment Frag
+
+            #include "Packages/com.deltation.aaaa-rp/ShaderLibrary/IBL/SphericalHarmonics.hlsl"
+
+            // Written by ProjectSH9.compute.
+            StructuredBuffer<float4> _SH9Coefficients;
+
+            float4 Frag(const Varyings IN) : SV_Target
+            {
+                float4 coefficients[SH9_COEFFICIENT_COUNT];
+
+                UNITY_UNROLL
+                for (uint i = 0; i < SH9_COEFFICIENT_COUNT; ++i)
+                {
+                    coefficients[i] = _SH9Coefficients[i];
+                }
+
+                return float4(EvaluateSH9Irradiance(coefficients, normalize(IN.normal)), 1);
+            }
+            ENDHLSL
+        }
     }
 
     Fallback Off
@@ -0,0 +1,55 @@
+Shader "Hidden/AAAA/ClearShadowTile"
+{
+    HLSLINCLUDE
+    #pragma target 2.0
+    #pragma editor_sync_compilation
+
+    #include "Packages/com.deltation.aaaa-rp/ShaderLibrary/Core.hlsl"
+
+    struct Attributes
+    {
+        uint vertexID : SV_VertexID;
+    };
+
+    struct Varyings
+    {
+        float4 positionCS : SV_POSITION;
+    };
+
+    // A full-screen triangle at the far plane. Unlike ClearRenderTarget, it is clipped to the viewport, i.e. to the atlas tile.
+    Varyings Vert(const Attributes input)
+    {
+        Varyings output;
+        output.positionCS = GetFullScreenTriangleVertexPosition(input.vertexID, UNITY_RAW_FAR_CLIP_VALUE);
+        return output;
+    }
+
+    void Frag() {}
+    ENDHLSL
+
+    SubShader
+    {
+        Tags
+        {
+            "RenderPipeline" = "AAAAPipeline"
+        }
+
+        Pass
+        {
+            Name "Clear Shadow Tile"
+
+            ZWrite On
+            ZTest Always
+            ZClip Off
+            Cull Off
+            ColorMask 0
+
+            HLSLPROGRAM
+            #pragma vertex Vert
+            #pragma fragment Frag
+            ENDHLSL
+        }
+    }
+
+    Fallback Off
+}